@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "haptics/turn_angle.h"
+#include "sensor_correction.h"
+
+/**
+ * @brief Angle sensor as a compile-time policy over its backend, the driver of the hardware.
+ *
+ * A backend provides:
+ *  - init(), which sets up the hardware (its configuration is passed to its constructor)
+ *  - read(), the raw angle of the latest reading in [0, 2PI), or negative if there is none
+ *  - sampleMicros(), the micros() at which that reading was sampled
+ *  - takeError(message, size), which describes and clears the last error, returning false if there was none
+ *
+ * AngleSource adds what every sensor shares: the correction of the angle error, counting whole turns, and
+ * the timestamp of the reading. The backend's calls are direct rather than virtual, so they inline into the
+ * motor loop.
+ *
+ * Hardware-free: with ReplayBackend (replay_backend.h), the motor stack runs on the host.
+ */
+template <typename Backend>
+class AngleSource {
+    public:
+        template <typename... Args>
+        explicit AngleSource(Args&&... args) : backend_(std::forward<Args>(args)...) {}
+
+        void init() {
+            backend_.init();
+            primed_ = false;
+        }
+
+        // Corrected angle of the latest reading, in [0, 2PI), or negative if there is none
+        float read() {
+            float raw = backend_.read();
+            return raw < 0 ? raw : correction_.apply(raw);
+        }
+
+        // Reads the sensor and counts whole turns; returns false, keeping the previous angle, if there was no reading
+        bool update() {
+            float radians = read();
+            if (radians < 0) {
+                return false;
+            }
+            float step = radians - angle_.radians;
+            // A jump of most of a turn between two readings is the angle wrapping (as SimpleFOC's Sensor::update())
+            if (primed_ && fabsf(step) > 0.8f * TurnAngle::TURN) {
+                angle_.turns += step > 0 ? -1 : 1;
+            }
+            angle_.radians = radians;
+            sample_micros_ = backend_.sampleMicros();
+            primed_ = true;
+            return true;
+        }
+
+        // Angle as of the last update()
+        const TurnAngle& angle() const { return angle_; }
+        uint32_t sampleMicros() const { return sample_micros_; }
+
+        bool takeError(char* message, size_t size) { return backend_.takeError(message, size); }
+
+        // Correction applied to every reading. Cleared while a calibration measures the raw angle error.
+        SensorCorrection& correction() { return correction_; }
+        Backend& backend() { return backend_; }
+
+    private:
+        Backend backend_;
+        SensorCorrection correction_;
+
+        bool primed_ = false;
+        TurnAngle angle_ = {0, 0};
+        uint32_t sample_micros_ = 0;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "seqlock.h"
+#include "spsc_queue.h"
+
+/**
+ * @brief Lane of a command channel where only the latest value matters, e.g. a config.
+ *
+ * Publishing never blocks and never fails: a value that the consumer hasn't taken yet is replaced,
+ * so a burst of publishes costs the consumer a single take of the last one. Taking never waits
+ * either, as the consumer is the motor task: values alternate between two slots, so the producer
+ * writes the slot the consumer isn't reading, and a take that still catches the producer in its
+ * slot (after two more publishes during the copy) gives up and is retried on the next tick.
+ * Values are counted as published, so the consumer counts the ones it never saw (coalesced).
+ *
+ * One producer task and one consumer task, as for the SeqLocks underneath.
+ */
+template <typename T>
+class LatestValueLane {
+    public:
+        // Producer side
+        void publish(const T& value) {
+            uint32_t published = published_.load(std::memory_order_relaxed) + 1;
+            slots_[published & 1].write(value);
+            published_.store(published, std::memory_order_release);
+        }
+
+        // Consumer side: copies the latest value into out if one was published since the last take.
+        // Returns false if there is none, or if the producer overwrote it during the copy (out is then
+        // unspecified, and the take is retried on the next call).
+        bool take(T& out) {
+            uint32_t published = published_.load(std::memory_order_acquire);
+            if (published == taken_published_) {
+                return false;
+            }
+            // The slot has had a write for each publish of its parity: value n is in it at sequence 2 * ceil(n / 2)
+            uint32_t sequence;
+            if (!slots_[published & 1].tryRead(out, sequence) || sequence != ((published + 1) & ~1u)) {
+                missed_++;
+                return false;
+            }
+            coalesced_ += published - taken_published_ - 1;
+            taken_published_ = published;
+            taken_++;
+            return true;
+        }
+
+        // Consumer side counters
+        uint32_t taken() const { return taken_; }
+        uint32_t coalesced() const { return coalesced_; }
+        // Takes that gave up because the producer overwrote the value
+        uint32_t missed() const { return missed_; }
+
+    private:
+        SeqLock<T> slots_[2];
+        // Values published, written by the producer only
+        std::atomic<uint32_t> published_ = 0;
+        // Written by the consumer only
+        uint32_t taken_published_ = 0;
+        uint32_t taken_ = 0;
+        uint32_t coalesced_ = 0;
+        uint32_t missed_ = 0;
+};
+
+/**
+ * @brief Lane of a command channel where every value counts, in order, e.g. haptic effects.
+ *
+ * Bounded: publishing to a full lane drops the value and counts it, rather than blocking the
+ * producer. The consumer drains the whole lane at once (but at most CAPACITY values, so a producer
+ * that keeps publishing can't keep it busy), so values wait for one consumer tick at most.
+ *
+ * One producer task and one consumer task, as for the SpscQueue underneath.
+ */
+template <typename T, uint16_t CAPACITY>
+class FifoLane {
+    public:
+        // Producer side; returns false if the value was dropped
+        bool publish(const T& value) {
+            if (!queue_.push(value)) {
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        // Consumer side: calls handle(value) for every queued value, oldest first. Returns the number handled.
+        template <typename Handler>
+        uint16_t drain(Handler handle) {
+            T value;
+            uint16_t handled = 0;
+            while (handled < CAPACITY && queue_.pop(value)) {
+                handle(value);
+                handled++;
+            }
+            received_ += handled;
+            return handled;
+        }
+
+        uint32_t received() const { return received_; }
+        uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        SpscQueue<T, CAPACITY> queue_;
+        // Written by the consumer only
+        uint32_t received_ = 0;
+        // Written by the producer only
+        std::atomic<uint32_t> dropped_ = 0;
+};
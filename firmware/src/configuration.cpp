@@ -111,11 +111,22 @@ PB_PersistentConfiguration Configuration::get() {
     return pb_buffer_;
 }
 
-bool Configuration::setMotorCalibrationAndSave(PB_MotorCalibration& motor_calibration) {
+void Configuration::get(PB_PersistentConfiguration& configuration) {
+    SemaphoreGuard lock(mutex_);
+    if (!loaded_) {
+        configuration = {};
+        return;
+    }
+    configuration = pb_buffer_;
+}
+
+bool Configuration::setMotorCalibrationAndSave(PB_MotorCalibration& motor_calibration, PB_SensorCalibration& sensor_calibration) {
     {
         SemaphoreGuard lock(mutex_);
         pb_buffer_.motor = motor_calibration;
         pb_buffer_.has_motor = true;
+        pb_buffer_.sensor = sensor_calibration;
+        pb_buffer_.has_sensor = true;
     }
     return saveToDisk();
 }
@@ -129,6 +140,15 @@ bool Configuration::setStrainCalibrationAndSave(PB_StrainCalibration& strain_cal
     return saveToDisk();
 }
 
+bool Configuration::setCoggingCalibrationAndSave(PB_CoggingCalibration& cogging_calibration) {
+    {
+        SemaphoreGuard lock(mutex_);
+        pb_buffer_.cogging = cogging_calibration;
+        pb_buffer_.has_cogging = true;
+    }
+    return saveToDisk();
+}
+
 void Configuration::setLogger(Logger* logger) {
     logger_ = logger;
 }
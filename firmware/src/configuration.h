@@ -18,8 +18,11 @@ class Configuration {
         bool loadFromDisk();
         bool saveToDisk();
         PB_PersistentConfiguration get();
-        bool setMotorCalibrationAndSave(PB_MotorCalibration& motor_calibration);
+        // Same as get(), copied straight into configuration, without a temporary on the caller's stack
+        void get(PB_PersistentConfiguration& configuration);
+        bool setMotorCalibrationAndSave(PB_MotorCalibration& motor_calibration, PB_SensorCalibration& sensor_calibration);
         bool setStrainCalibrationAndSave(PB_StrainCalibration& strain_calibration);
+        bool setCoggingCalibrationAndSave(PB_CoggingCalibration& cogging_calibration);
 
     private:
         SemaphoreHandle_t mutex_;
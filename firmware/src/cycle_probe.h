@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(ESP_PLATFORM)
+    #include <esp32-hal-cpu.h>
+    #include <xtensa/core-macros.h>
+#else
+    #include <chrono>
+#endif // ESP_PLATFORM
+
+// Cycle-counter probes around the stages of the motor loop (see CycleStats). Off by default: the
+// probes add a few cycles each, and the statistics take about 700 bytes of RAM per stage.
+#ifndef SK_CYCLE_PROBES
+    #define SK_CYCLE_PROBES 0
+#endif // SK_CYCLE_PROBES
+
+/**
+ * @brief Free-running tick counter for timing short stretches of code.
+ *
+ * On the ESP32 this is the CPU's cycle counter (CCOUNT), which is read in a single instruction and
+ * wraps about every 18 s at 240 MHz; durations are taken as unsigned differences, so they are
+ * correct across the wrap. On the host, ticks are nanoseconds of the steady clock.
+ */
+struct CycleClock {
+    static inline uint32_t now() {
+        #if defined(ESP_PLATFORM)
+        return XTHAL_GET_CCOUNT();
+        #else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        #endif // ESP_PLATFORM
+    }
+
+    static inline float ticksPerMicro() {
+        #if defined(ESP_PLATFORM)
+        return getCpuFrequencyMhz();
+        #else
+        return 1000;
+        #endif // ESP_PLATFORM
+    }
+};
+
+/**
+ * @brief Running statistics of a duration in ticks: count, min, max, mean and percentiles.
+ *
+ * Percentiles come from a log-linear histogram: durations below 2^SUB_BITS ticks get a bucket each,
+ * above that every power of two is split into 2^SUB_BITS buckets, so a percentile is within 1/8 of
+ * the true value. Durations of 2^MAX_BITS ticks (70 ms at 240 MHz) and more share the last bucket.
+ * Recording is a count-leading-zeros and a few integer operations, and the size is fixed, so it can
+ * run on every loop iteration.
+ */
+class CycleStats {
+    public:
+        static const uint8_t SUB_BITS = 3;
+        static const uint8_t MAX_BITS = 24;
+        static const uint16_t NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+        void reset() {
+            *this = CycleStats();
+        }
+
+        void record(uint32_t ticks) {
+            buckets_[bucket(ticks)]++;
+            if (count_ == 0 || ticks < min_) {
+                min_ = ticks;
+            }
+            if (ticks > max_) {
+                max_ = ticks;
+            }
+            total_ += ticks;
+            count_++;
+        }
+
+        uint32_t count() const { return count_; }
+        uint32_t minTicks() const { return min_; }
+        uint32_t maxTicks() const { return max_; }
+        float meanTicks() const { return count_ == 0 ? 0 : (float)total_ / count_; }
+
+        // Duration that the given fraction (0-1) of the samples took at most, to the histogram's resolution
+        uint32_t percentileTicks(float fraction) const {
+            if (count_ == 0) {
+                return 0;
+            }
+            uint32_t rank = (uint32_t)(fraction * count_ + 0.5f);
+            rank = rank < 1 ? 1 : (rank > count_ ? count_ : rank);
+            uint32_t seen = 0;
+            for (uint16_t i = 0; i < NUM_BUCKETS; i++) {
+                seen += buckets_[i];
+                if (seen >= rank) {
+                    // The last bucket has no upper end but the longest duration seen
+                    if (i == NUM_BUCKETS - 1) {
+                        return max_;
+                    }
+                    // Middle of the bucket, within the range that was actually seen
+                    uint32_t ticks = bucketLow(i) + (bucketLow(i + 1) - bucketLow(i) - 1) / 2;
+                    return ticks < min_ ? min_ : (ticks > max_ ? max_ : ticks);
+                }
+            }
+            return max_;
+        }
+
+    private:
+        uint32_t buckets_[NUM_BUCKETS] = {};
+        uint32_t count_ = 0;
+        uint32_t min_ = 0;
+        uint32_t max_ = 0;
+        uint64_t total_ = 0;
+
+        static uint16_t bucket(uint32_t ticks) {
+            if (ticks < (1u << SUB_BITS)) {
+                return ticks;
+            }
+            if (ticks >= (1u << MAX_BITS)) {
+                return NUM_BUCKETS - 1;
+            }
+            uint8_t exponent = 31 - __builtin_clz(ticks);
+            uint32_t sub = (ticks >> (exponent - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+            return ((exponent - SUB_BITS + 1) << SUB_BITS) + sub;
+        }
+
+        // Smallest duration that falls in the bucket
+        static uint32_t bucketLow(uint16_t bucket) {
+            if (bucket < (1u << SUB_BITS)) {
+                return bucket;
+            }
+            if (bucket >= NUM_BUCKETS) {
+                return 1u << MAX_BITS;
+            }
+            uint8_t exponent = (bucket >> SUB_BITS) + SUB_BITS - 1;
+            uint32_t sub = bucket & ((1u << SUB_BITS) - 1);
+            return ((1u << SUB_BITS) + sub) << (exponent - SUB_BITS);
+        }
+};
+
+/**
+ * @brief Records the ticks from its construction to its destruction into a CycleStats.
+ */
+class CycleProbe {
+    public:
+        explicit CycleProbe(CycleStats& stats) : stats_(stats), start_(CycleClock::now()) {}
+        ~CycleProbe() {
+            stats_.record(CycleClock::now() - start_);
+        }
+
+        CycleProbe(const CycleProbe&) = delete;
+        CycleProbe& operator=(const CycleProbe&) = delete;
+
+    private:
+        CycleStats& stats_;
+        uint32_t start_;
+};
+
+#define CYCLE_PROBE_CONCAT_(a, b) a##b
+#define CYCLE_PROBE_CONCAT(a, b) CYCLE_PROBE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope into the given CycleStats. Compiles to nothing (and the
+// argument isn't evaluated) unless SK_CYCLE_PROBES is set.
+#if SK_CYCLE_PROBES
+    #define CYCLE_PROBE(stats) CycleProbe CYCLE_PROBE_CONCAT(cycle_probe_, __LINE__)(stats)
+#else
+    #define CYCLE_PROBE(stats) do {} while (0)
+#endif // SK_CYCLE_PROBES
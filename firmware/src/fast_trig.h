@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Fast single-precision sin/cos/atan2 for the FOC loop and the sensor filters.
+ *
+ * sin and cos interpolate linearly in a table of one sine period, so they cost a multiply, a
+ * truncation and two table reads. Their absolute error is at most 2.5e-6 + 8e-8 * |a|, the second
+ * term being the float resolution of the angle (past 1e7 the index overflows). atan2 reduces
+ * to atan(z) for z in [0, 1] and evaluates a degree-11 odd minimax polynomial there; its error is at
+ * most 2e-6 rad anywhere. Both are well below the resolution of the 14-bit angle sensors (3.8e-4 rad).
+ * The bounds are checked exhaustively against libm by software/tools/fast_trig_check.
+ *
+ * Hardware-free and header-only, so it inlines into the hot paths and runs on the host.
+ */
+namespace FastTrig {
+    static constexpr float PI = 3.14159265358979323846f;
+    static constexpr float TWO_PI = 6.28318530717958647692f;
+    static constexpr uint16_t TABLE_SIZE = 1024;
+    static constexpr uint16_t TABLE_MASK = TABLE_SIZE - 1;
+    static constexpr float TABLE_SCALE = TABLE_SIZE / TWO_PI;
+
+    // Sine by its Taylor series, accurate to double precision on [-PI, PI], for building the table
+    constexpr double taylorSin(double x) {
+        double term = x;
+        double sum = x;
+        for (int n = 1; n < 30; n++) {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // sin(i * 2PI / TABLE_SIZE) for a full period, plus a copy of the first entry so interpolation never has to wrap.
+    // A chord falls short of the sine by up to h^2/8 (h the step) mid-step; scaling the entries by 1 + h^2/16
+    // centers that error around zero, which halves it.
+    constexpr std::array<float, TABLE_SIZE + 1> makeSineTable() {
+        const double h = 2 * 3.14159265358979323846 / TABLE_SIZE;
+        std::array<float, TABLE_SIZE + 1> table = {};
+        for (uint16_t i = 0; i <= TABLE_SIZE; i++) {
+            uint16_t j = i % TABLE_SIZE;
+            double x = h * (j < TABLE_SIZE / 2 ? j : (int)j - TABLE_SIZE);
+            table[i] = (float)(taylorSin(x) * (1 + h * h / 16));
+        }
+        return table;
+    }
+
+    inline constexpr std::array<float, TABLE_SIZE + 1> SINE_TABLE = makeSineTable();
+
+    // Table index below a (any sign) and the fraction of the step towards the next one
+    inline int32_t tableIndex(float a, float& fraction) {
+        float x = a * TABLE_SCALE;
+        int32_t i = (int32_t)x;
+        // Truncation rounds negative angles up
+        if (x < i) {
+            i--;
+        }
+        fraction = x - i;
+        return i;
+    }
+
+    inline float interpolate(int32_t i, float fraction) {
+        uint16_t j = i & TABLE_MASK;
+        return SINE_TABLE[j] + (SINE_TABLE[j + 1] - SINE_TABLE[j]) * fraction;
+    }
+}
+
+inline float fastSin(float a) {
+    float fraction;
+    int32_t i = FastTrig::tableIndex(a, fraction);
+    return FastTrig::interpolate(i, fraction);
+}
+
+inline float fastCos(float a) {
+    float fraction;
+    int32_t i = FastTrig::tableIndex(a, fraction);
+    return FastTrig::interpolate(i + FastTrig::TABLE_SIZE / 4, fraction);
+}
+
+// Both at once share the index computation
+inline void fastSinCos(float a, float& s, float& c) {
+    float fraction;
+    int32_t i = FastTrig::tableIndex(a, fraction);
+    s = FastTrig::interpolate(i, fraction);
+    c = FastTrig::interpolate(i + FastTrig::TABLE_SIZE / 4, fraction);
+}
+
+// Angle of (x, y) in [-PI, PI], like atan2f; 0 for (0, 0)
+inline float fastAtan2(float y, float x) {
+    float abs_x = x < 0 ? -x : x;
+    float abs_y = y < 0 ? -y : y;
+    float high = abs_x > abs_y ? abs_x : abs_y;
+    if (high == 0) {
+        return 0;
+    }
+    float z = (abs_x > abs_y ? abs_y : abs_x) / high;
+    float z2 = z * z;
+    // Minimax fit of atan(z) / z in z^2 on [0, 1]
+    float a = z * (0.999977219f + z2 * (-0.332622828f + z2 * (0.193540375f + z2 * (-0.116426479f + z2 * (0.052647348f + z2 * -0.011719134f)))));
+    if (abs_y > abs_x) {
+        a = FastTrig::PI / 2 - a;
+    }
+    if (x < 0) {
+        a = FastTrig::PI - a;
+    }
+    // By the sign bit, so -0 gives -PI like atan2f
+    return std::signbit(y) ? -a : a;
+}
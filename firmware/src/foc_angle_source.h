@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SimpleFOC.h>
+
+#include "angle_source.h"
+#include "cycle_probe.h"
+
+/**
+ * @brief AngleSource as SimpleFOC's Sensor, for the FOC loop.
+ *
+ * SimpleFOC reaches the sensor through the virtual update(), once per loopFOC(); from there the reading is
+ * a direct call into the backend. The Sensor's angle, whole turns and timestamp are the AngleSource's, so
+ * SimpleFOC's velocity and the motor task's angle come from the same reading.
+ */
+template <typename Backend>
+class FocAngleSource final : public Sensor {
+    public:
+        template <typename... Args>
+        explicit FocAngleSource(Args&&... args) : source_(std::forward<Args>(args)...) {}
+
+        void init() override {
+            source_.init();
+            Sensor::init();
+            update();
+        }
+
+        void update() override {
+            #if SK_CYCLE_PROBES
+            // loopFOC() reads the sensor through update(); timing it here separates the read from the rest of the FOC step
+            if (stats != nullptr) {
+                CycleProbe probe(*stats);
+                readSource();
+                return;
+            }
+            #endif // SK_CYCLE_PROBES
+            readSource();
+        }
+
+        // SimpleFOC takes whatever this returns as an angle (Sensor::init() seeds its state from it), so a
+        // read without a reading yet returns the last valid angle, 0 before the first, rather than the
+        // backend's negative sentinel
+        float getSensorAngle() override {
+            readSource();
+            return source_.angle().radians;
+        }
+
+        AngleSource<Backend>& source() { return source_; }
+        const AngleSource<Backend>& source() const { return source_; }
+
+        #if SK_CYCLE_PROBES
+        CycleStats* stats = nullptr;
+        #endif // SK_CYCLE_PROBES
+
+    private:
+        AngleSource<Backend> source_;
+
+        void readSource() {
+            if (source_.update()) {
+                angle_prev = source_.angle().radians;
+                full_rotations = source_.angle().turns;
+                angle_prev_ts = source_.sampleMicros();
+            }
+        }
+};
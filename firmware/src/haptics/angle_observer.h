@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include "turn_angle.h"
+
+/**
+ * @brief Alpha-beta observer estimating shaft angle and velocity from timestamped sensor samples.
+ *
+ * Uses a constant-velocity model: each sample moves the prediction towards the measurement by a
+ * fraction (alpha) of the residual and corrects the velocity by another fraction (beta). The
+ * gains are derived per sample from the time since the previous sample, as a critically damped
+ * second-order tracking loop with the configured bandwidth, so the response is the same at any
+ * loop rate and with jittery sample times.
+ *
+ * predictAngle() extrapolates the estimate to a later instant, which is used to compensate the
+ * latency between a sensor sample and the moment the torque computed from it is applied.
+ *
+ * Angles are TurnAngles, so the estimate is as precise after any number of turns as after the first.
+ *
+ * software/tools/angle_observer_check checks the tracking and latency compensation against a simulated sensor.
+ */
+class AngleObserver {
+    public:
+        // Samples further apart than this restart the observer from the new measurement (e.g. after calibration)
+        static constexpr float MAX_SAMPLE_GAP_SECONDS = 0.05;
+
+        void setBandwidth(float bandwidth_rad_per_sec) {
+            bandwidth_ = bandwidth_rad_per_sec;
+        }
+
+        void reset(const TurnAngle& angle, uint32_t sample_micros) {
+            angle_ = angle;
+            velocity_ = 0;
+            sample_micros_ = sample_micros;
+            initialized_ = true;
+        }
+
+        void update(const TurnAngle& measured_angle, uint32_t sample_micros) {
+            if (!initialized_) {
+                reset(measured_angle, sample_micros);
+                return;
+            }
+            float dt = (int32_t)(sample_micros - sample_micros_) * 1e-6f;
+            if (dt <= 0) {
+                // Duplicate or out-of-order sample
+                return;
+            }
+            if (dt > MAX_SAMPLE_GAP_SECONDS) {
+                reset(measured_angle, sample_micros);
+                return;
+            }
+
+            // Gains of the critically damped loop: alpha = 2*w*dt, beta = (w*dt)^2. Limiting w*dt to 0.5
+            // keeps the discrete filter stable if samples are far apart relative to the bandwidth.
+            float w_dt = bandwidth_ * dt;
+            if (w_dt > 0.5f) {
+                w_dt = 0.5f;
+            }
+            float alpha = 2 * w_dt;
+            float beta = w_dt * w_dt;
+
+            TurnAngle predicted = angle_ + velocity_ * dt;
+            float residual = measured_angle.radiansSince(predicted);
+            angle_ = predicted + alpha * residual;
+            velocity_ += beta * residual / dt;
+            sample_micros_ = sample_micros;
+        }
+
+        // Estimated angle at the given time (may be after the latest sample)
+        TurnAngle predictAngle(uint32_t at_micros) const {
+            return angle_ + velocity_ * ((int32_t)(at_micros - sample_micros_) * 1e-6f);
+        }
+
+        TurnAngle angle() const { return angle_; }
+        float velocity() const { return velocity_; }
+        uint32_t sampleMicros() const { return sample_micros_; }
+
+    private:
+        float bandwidth_ = 0;
+        TurnAngle angle_ = {0, 0};
+        float velocity_ = 0;
+        uint32_t sample_micros_ = 0;
+        bool initialized_ = false;
+};
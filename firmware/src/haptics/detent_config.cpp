@@ -0,0 +1,58 @@
+#include <cmath>
+
+#include "detent_config.h"
+
+static const float DEAD_ZONE_DETENT_PERCENT = 0.2;
+static const float DEAD_ZONE_RAD = 1 * M_PI / 180;
+
+template <typename Policy>
+void CompiledDetentConfig<Policy>::compile(const PB_SmartKnobConfig& config) {
+    CompiledDetentConfig<Policy>& c = *this;
+    c.position_width_radians = Policy::fromFloat(config.position_width_radians);
+    c.inverse_position_width = Policy::inverse(c.position_width_radians);
+
+    float snap_point_radians = config.position_width_radians * config.snap_point;
+    float bias_radians = config.position_width_radians * config.snap_point_bias;
+    c.snap_increase_radians[SNAP_NEGATIVE] = Policy::fromFloat(snap_point_radians + -bias_radians);
+    c.snap_increase_radians[SNAP_ZERO] = Policy::fromFloat(snap_point_radians + bias_radians);
+    c.snap_increase_radians[SNAP_POSITIVE] = Policy::fromFloat(snap_point_radians + bias_radians);
+    c.snap_decrease_radians[SNAP_NEGATIVE] = Policy::fromFloat(-snap_point_radians + -bias_radians);
+    c.snap_decrease_radians[SNAP_ZERO] = Policy::fromFloat(-snap_point_radians + -bias_radians);
+    c.snap_decrease_radians[SNAP_POSITIVE] = Policy::fromFloat(-snap_point_radians + bias_radians);
+
+    c.dead_zone_low_radians = Policy::fromFloat(fmaxf(-config.position_width_radians*DEAD_ZONE_DETENT_PERCENT, -DEAD_ZONE_RAD));
+    c.dead_zone_high_radians = Policy::fromFloat(fminf(config.position_width_radians*DEAD_ZONE_DETENT_PERCENT, DEAD_ZONE_RAD));
+
+    c.detent_p = config.detent_strength_unit * 4;
+    c.endstop_p = config.endstop_strength_unit * 4;
+
+    int32_t num_positions = config.max_position - config.min_position + 1;
+    c.min_position = config.min_position;
+    c.max_position = config.max_position;
+    c.limited = num_positions > 0 && !config.infinite_scroll;
+    c.infinite_scroll = config.infinite_scroll;
+
+    // Malformed runs are ignored from the first error on; the knob keeps the detents decoded before it
+    c.detents.clear();
+    c.detents.decodeRuns(config.detent_runs.bytes, config.detent_runs.size);
+    for (pb_size_t i = 0; i < config.detent_positions_count; i++) {
+        c.detents.add(config.detent_positions[i]);
+    }
+    c.magnetic = !c.detents.empty();
+
+    c.torque_profile.set(config.detent_torque_profile, config.detent_torque_profile_count, config.detent_strength_unit);
+
+    // Maps only apply to bounded ranges; anything the map can't lay out falls back to uniform positions
+    c.position_map.clear();
+    if (config.has_position_map && num_positions > 1 && num_positions <= PositionMap<Policy>::MAX_POSITIONS) {
+        c.position_map.build({
+            .type = (PositionCurve)config.position_map.curve,
+            .shape = config.position_map.shape,
+            .segment_widths = config.position_map.segment_widths,
+            .segment_count = (uint8_t)config.position_map.segment_widths_count,
+        }, num_positions, config.position_width_radians, config.snap_point, config.snap_point_bias, config.min_position, config.infinite_scroll);
+    }
+}
+
+template struct CompiledDetentConfig<FloatPolicy>;
+template struct CompiledDetentConfig<FixedQ16Policy>;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "proto_gen/smartknob.pb.h"
+#include "detent_index.h"
+#include "numeric_policy.h"
+#include "position_map.h"
+#include "torque_profile.h"
+
+static_assert(sizeof(PB_SmartKnobConfig::detent_torque_profile) / sizeof(float) == TorqueProfile::MAX_SAMPLES);
+static_assert(sizeof(PB_SmartKnobConfig::detent_runs.bytes) <= DetentIndex::MAX_RUNS);
+static_assert(sizeof(PB_PositionMap::segment_widths) / sizeof(float) <= UINT8_MAX);
+
+/**
+ * @brief Everything the haptic loop needs from a SmartKnobConfig, precomputed once per SetConfig.
+ *
+ * The per-iteration hot path only has to pick the snap thresholds for the current position's
+ * sign, compare, and evaluate the piecewise-linear detent target from the precomputed
+ * breakpoints; no config-dependent multiplications or list scans remain. The result is checked against
+ * the former per-iteration math on DemoPage's configs by software/tools/detent_config_check.cpp.
+ *
+ * Compiled in place, since the detent index and position map are too large to pass around on a
+ * task's stack.
+ *
+ * Angles are stored in the representation of the numeric Policy (see numeric_policy.h).
+ */
+template <typename Policy>
+struct CompiledDetentConfig {
+    using angle_t = typename Policy::angle_t;
+
+    // Snap-state machine: thresholds are indexed by the sign of the current position, since
+    // snap_point_bias shifts both thresholds towards position 0
+    enum SnapState : uint8_t {
+        SNAP_NEGATIVE = 0,
+        SNAP_ZERO = 1,
+        SNAP_POSITIVE = 2,
+    };
+
+    angle_t position_width_radians;
+    typename Policy::inverse_t inverse_position_width;
+    angle_t snap_increase_radians[3];
+    angle_t snap_decrease_radians[3];
+
+    // Dead zone around the detent center, where the detent target is flat
+    angle_t dead_zone_low_radians;
+    angle_t dead_zone_high_radians;
+
+    float detent_p;
+    float endstop_p;
+
+    int32_t min_position;
+    int32_t max_position;
+    // Position is clamped to [min_position, max_position] (bounds enabled and not infinite scroll)
+    bool limited;
+    bool infinite_scroll;
+
+    // Magnetic detents (detent_runs and detent_positions); only positions in the index have a detent
+    bool magnetic;
+    DetentIndex detents;
+
+    // Sampled detent torque, already scaled by detent strength; replaces the detent PID if not empty
+    TorqueProfile torque_profile;
+
+    // Individual position widths; the uniform values above apply if empty. Indexed by position - min_position.
+    PositionMap<Policy> position_map;
+
+    void compile(const PB_SmartKnobConfig& config);
+
+    static SnapState snapState(int32_t position) {
+        return (SnapState)((position > 0) - (position < 0) + 1);
+    }
+
+    bool isDetent(int32_t position) const {
+        return detents.contains(position);
+    }
+
+    // Sub-position of the given angle from the current detent center, relative to the position's own width
+    float subPosition(angle_t angle_to_detent_center, int32_t position) const {
+        if (position_map.empty()) {
+            return Policy::ratio(angle_to_detent_center, position_width_radians, inverse_position_width);
+        }
+        uint16_t index = position - min_position;
+        return Policy::ratio(angle_to_detent_center, position_map.width(index), position_map.inverseWidth(index));
+    }
+
+    // Input to the torque controller for the given angle from the current detent center
+    angle_t detentTarget(angle_t angle_to_detent_center, int32_t position) const {
+        angle_t low = dead_zone_low_radians;
+        angle_t high = dead_zone_high_radians;
+        if (!position_map.empty()) {
+            high = position_map.deadZone(position - min_position);
+            low = -high;
+        }
+        angle_t clamped = angle_to_detent_center < low ? low
+            : (angle_to_detent_center > high ? high : angle_to_detent_center);
+        return -angle_to_detent_center + clamped;
+    }
+};
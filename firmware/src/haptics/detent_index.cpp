@@ -0,0 +1,135 @@
+#include "detent_index.h"
+
+// Reads one varint; returns false if it's truncated or longer than 64 bits
+static bool readVarint(const uint8_t* bytes, size_t size, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+        if (offset >= size) {
+            return false;
+        }
+        uint8_t b = bytes[offset++];
+        value |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes the bytes of the varint that fit into out, but returns the full size
+static size_t writeVarint(uint64_t value, uint8_t* out, size_t offset, size_t out_size) {
+    size_t size = 0;
+    do {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        if (value != 0) {
+            b |= 0x80;
+        }
+        if (offset + size < out_size) {
+            out[offset + size] = b;
+        }
+        size++;
+    } while (value != 0);
+    return size;
+}
+
+bool DetentIndex::decodeRuns(const uint8_t* bytes, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (run_count_ >= MAX_RUNS) {
+            return false;
+        }
+
+        uint64_t value;
+        if (!readVarint(bytes, size, offset, value)) {
+            return false;
+        }
+        uint64_t extra_length = 0;
+        if ((value & 1) && !readVarint(bytes, size, offset, extra_length)) {
+            return false;
+        }
+        uint64_t delta = value >> 1;
+        if (delta > UINT32_MAX || extra_length > UINT32_MAX) {
+            return false;
+        }
+
+        // Computed in 64 bits, so out of range runs are rejected instead of wrapping around
+        int64_t start = run_count_ == 0
+            ? (int64_t)(delta >> 1) ^ -(int64_t)(delta & 1)
+            : (int64_t)run_end_[run_count_ - 1] + 2 + (int64_t)delta;
+        int64_t end = start + ((value & 1) ? (int64_t)extra_length + 1 : 0);
+        if (start < INT32_MIN || end > INT32_MAX) {
+            return false;
+        }
+
+        run_start_[run_count_] = start;
+        run_end_[run_count_] = end;
+        run_count_++;
+    }
+    return true;
+}
+
+bool DetentIndex::add(int32_t position) {
+    // First run starting after position
+    uint16_t next = 0;
+    while (next < run_count_ && run_start_[next] <= position) {
+        next++;
+    }
+    bool joins_previous = next > 0 && (int64_t)run_end_[next - 1] + 1 >= position;
+    bool joins_next = next < run_count_ && (int64_t)run_start_[next] - 1 == position;
+
+    if (joins_previous && joins_next) {
+        // Fills the only gap between two runs; merge them
+        run_end_[next - 1] = run_end_[next];
+        for (uint16_t i = next; i + 1 < run_count_; i++) {
+            run_start_[i] = run_start_[i + 1];
+            run_end_[i] = run_end_[i + 1];
+        }
+        run_count_--;
+    } else if (joins_previous) {
+        if (position > run_end_[next - 1]) {
+            run_end_[next - 1] = position;
+        }
+    } else if (joins_next) {
+        run_start_[next] = position;
+    } else {
+        if (run_count_ >= MAX_RUNS) {
+            return false;
+        }
+        for (uint16_t i = run_count_; i > next; i--) {
+            run_start_[i] = run_start_[i - 1];
+            run_end_[i] = run_end_[i - 1];
+        }
+        run_start_[next] = position;
+        run_end_[next] = position;
+        run_count_++;
+    }
+    return true;
+}
+
+size_t DetentIndex::encodeRuns(const int32_t* positions, size_t count, uint8_t* out, size_t out_size) {
+    size_t size = 0;
+    size_t i = 0;
+    bool first = true;
+    int32_t previous_end = 0;
+    while (i < count) {
+        int32_t start = positions[i];
+        int32_t end = start;
+        while (++i < count && (int64_t)positions[i] <= (int64_t)end + 1) {
+            end = positions[i];
+        }
+
+        // The first run's start is zigzag encoded, like a sint32
+        uint64_t delta = first
+            ? (uint32_t)(((uint32_t)start << 1) ^ (uint32_t)(start >> 31))
+            : (uint64_t)((int64_t)start - previous_end - 2);
+        bool has_length = end != start;
+        size += writeVarint((delta << 1) | has_length, out, size, out_size);
+        if (has_length) {
+            size += writeVarint((uint64_t)((int64_t)end - start - 1), out, size, out_size);
+        }
+        first = false;
+        previous_end = end;
+    }
+    return size;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Set of magnetic detent positions, stored as sorted runs of consecutive positions.
+ *
+ * Built once per config from SmartKnobConfig.detent_runs (and the legacy detent_positions list);
+ * contains() is a binary search over the runs, so the haptic loop's lookup stays cheap no matter
+ * how many detents the config has.
+ *
+ * Also implements the encoder for detent_runs, so host tools produce exactly what the firmware
+ * decodes. Has no hardware or nanopb dependencies.
+ */
+class DetentIndex {
+    public:
+        // Every run takes at least one byte of detent_runs, so this must be at least its max_size in smartknob.proto
+        static const uint16_t MAX_RUNS = 256;
+
+        void clear() { run_count_ = 0; }
+        bool empty() const { return run_count_ == 0; }
+        uint16_t runCount() const { return run_count_; }
+
+        /**
+         * @brief Add the runs encoded in detent_runs format (see smartknob.proto).
+         *
+         * Must be called on an empty index. Decoding stops at the first malformed run, or when
+         * MAX_RUNS is reached.
+         *
+         * @return false if not all of the runs were added
+         */
+        bool decodeRuns(const uint8_t* bytes, size_t size);
+
+        // Add a single detent position, in any order. Returns false if the index is full.
+        bool add(int32_t position);
+
+        bool contains(int32_t position) const {
+            if (run_count_ == 0) {
+                return false;
+            }
+            // Branchless binary search for the last run starting at or before position (or the
+            // first run if there is none); a fixed number of steps for a given run count
+            const int32_t* base = run_start_;
+            uint16_t length = run_count_;
+            while (length > 1) {
+                uint16_t half = length / 2;
+                base = base[half] <= position ? base + half : base;
+                length -= half;
+            }
+            uint16_t run = base - run_start_;
+            return run_start_[run] <= position && position <= run_end_[run];
+        }
+
+        /**
+         * @brief Encode detent positions in detent_runs format.
+         *
+         * @param positions Detent positions in ascending order (duplicates are allowed)
+         * @param out Buffer of out_size bytes
+         * @return The encoded size in bytes, which may be more than out_size; out then only
+         *         holds the part that fit
+         */
+        static size_t encodeRuns(const int32_t* positions, size_t count, uint8_t* out, size_t out_size);
+
+    private:
+        // Inclusive ranges, ascending and separated by at least one position without a detent
+        int32_t run_start_[MAX_RUNS];
+        int32_t run_end_[MAX_RUNS];
+        uint16_t run_count_ = 0;
+};
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "haptic_controller.h"
+
+// Empirically determined values for the knob with red wires
+/*
+    (absolute) maximum shaft velocity while idle (not exactly at detent center): 0.33
+    (absolute) maximum shaft velocity while at detent center: 0.29
+    Angle difference where motor is unable to move: 0.12 (set to 0.15 for safety)
+        0.12 rad = 6.87 degrees => Let's accept 8 degrees (maybe even 10?)
+*/
+
+// Idle filters are specified as time constants so they behave the same at any loop rate
+// (1s and 2s correspond to the former per-iteration alphas of 0.001 and 0.0005 in the loop that
+// ran loopFOC() and delay(1), so at most 1kHz)
+static const float IDLE_VELOCITY_TIME_CONSTANT_SECONDS = 1;
+static const float IDLE_VELOCITY_RAD_PER_SEC = 0.05;
+static const uint32_t IDLE_CORRECTION_DELAY_MICROS = 500 * 1000;
+static const float IDLE_CORRECTION_MAX_ANGLE_RAD = 8 * M_PI / 180;
+static const float IDLE_CORRECTION_TIME_CONSTANT_SECONDS = 2;
+// Longer gaps between updates (e.g. calibration) are treated as this long, so they don't snap the filters
+static const float IDLE_MAX_UPDATE_INTERVAL_SECONDS = 0.01;
+
+// Don't apply torque above this velocity (helps avoid positive feedback loop/runaway)
+static const float MAX_TORQUE_VELOCITY_RAD_PER_SEC = 60;
+static const float TORQUE_LIMIT = 10;
+
+// Positions one update may snap across; enough for 30 rev/s with 1 degree positions at 2kHz
+static const uint8_t MAX_SNAPS_PER_UPDATE = 16;
+
+static float radians(float degrees) {
+    return degrees * M_PI / 180;
+}
+
+// Smoothing factor of a first-order low-pass filter with the given time constant, for one step of dt
+static float lowPassAlpha(float dt, float time_constant) {
+    return dt / (time_constant + dt);
+}
+
+static bool positionMapChanged(const PB_SmartKnobConfig& first, const PB_SmartKnobConfig& second) {
+    if (first.has_position_map != second.has_position_map) {
+        return true;
+    }
+    const PB_PositionMap& a = first.position_map;
+    const PB_PositionMap& b = second.position_map;
+    return first.has_position_map && (a.curve != b.curve || a.shape != b.shape
+        || a.segment_widths_count != b.segment_widths_count
+        || memcmp(a.segment_widths, b.segment_widths, a.segment_widths_count * sizeof(a.segment_widths[0])) != 0);
+}
+
+template <typename Policy>
+HapticController<Policy>::HapticController() : config_ {} {
+    // Two positions, no detents, until the first config arrives
+    config_.max_position = 1;
+    config_.position_width_radians = 60 * M_PI / 180;
+    compiled_.compile(config_);
+}
+
+template <typename Policy>
+void HapticController<Policy>::begin(const TurnAngle& shaft_angle) {
+    frame_turns_ = shaft_angle.turns;
+    current_detent_center_ = Policy::fromFloat(shaft_angle.radians);
+    detent_center_error_ = 0;
+}
+
+template <typename Policy>
+bool HapticController<Policy>::setConfig(const PB_SmartKnobConfig& new_config, const TurnAngle& shaft_angle) {
+    // Check new config for validity
+    assert(new_config.detent_strength_unit >= 0);
+    assert(new_config.endstop_strength_unit >= 0);
+    assert(new_config.snap_point >= 0.5);
+    assert(new_config.detent_positions_count <= sizeof(new_config.detent_positions) / sizeof(new_config.detent_positions[0]));
+    assert(new_config.snap_point_bias >= 0);
+    assert(new_config.position_width_radians >= 0);
+    if (new_config.min_position < new_config.max_position) {
+        // If the minimum position is greater than the maximum position, the bounds are disabled
+        assert(new_config.initial_position >= new_config.min_position && new_config.initial_position <= new_config.max_position);
+    }
+
+    // Change haptic input mode
+    bool position_updated = false;
+    if (new_config.initial_position != config_.initial_position
+            || new_config.sub_position_unit != config_.sub_position_unit
+            || new_config.position_nonce != config_.position_nonce) {
+        current_position_ = new_config.initial_position;
+        position_updated = true;
+    }
+
+    if (new_config.min_position <= new_config.max_position) {
+        // Only check bounds if min/max indicate bounds are active (min >= max)
+        if (current_position_ < new_config.min_position) {
+            current_position_ = new_config.min_position;
+        } else if (current_position_ > new_config.max_position) {
+            current_position_ = new_config.max_position;
+        }
+    }
+
+    bool layout_changed = new_config.position_width_radians != config_.position_width_radians
+        || positionMapChanged(new_config, config_);
+    config_ = new_config;
+    compiled_.compile(config_);
+
+    if (position_updated || layout_changed) {
+        // Sub-positions are relative to the width of the position they are in
+        float new_sub_position = position_updated ? config_.sub_position_unit : latest_sub_position_unit_;
+        float width = compiled_.position_map.empty() ? config_.position_width_radians
+            : Policy::toFloat(compiled_.position_map.width(current_position_ - compiled_.min_position));
+        current_detent_center_ = toFrame(shaft_angle) + Policy::fromFloat(new_sub_position * width);
+        detent_center_error_ = 0;
+    }
+
+    // Update derivative factor of torque controller based on detent width.
+    // If the D factor is large on coarse detents, the motor ends up making noise because the P&D factors amplify the noise from the sensor.
+    // This is a piecewise linear function so that fine detents (small width) get a higher D factor and coarse detents get a small D factor.
+    // Fine detents need a nonzero D factor to artificially create "clicks" each time a new value is reached (the P factor is small
+    // for fine detents due to the smaller angular errors, and the existing P factor doesn't work well for very small angle changes (easy to
+    // get runaway due to sensor noise & lag)).
+    // TODO: consider eliminating this D factor entirely and just "play" a hardcoded haptic "click" (e.g. a quick burst of torque in each
+    // direction) whenever the position changes when the detent width is too small for the P factor to work well.
+    const float derivative_lower_strength = config_.detent_strength_unit * 0.08;
+    const float derivative_upper_strength = config_.detent_strength_unit * 0.02;
+    const float derivative_position_width_lower = radians(3);
+    const float derivative_position_width_upper = radians(8);
+    const float raw = derivative_lower_strength + (derivative_upper_strength - derivative_lower_strength)/(derivative_position_width_upper - derivative_position_width_lower)*(config_.position_width_radians - derivative_position_width_lower);
+    // When there are intermittent detents (set via detent_positions/detent_runs), disable derivative factor as this adds extra "clicks"
+    // when nearing a detent.
+    pid_.D = compiled_.magnetic ? 0 : std::clamp(
+        raw,
+        std::min(derivative_lower_strength, derivative_upper_strength),
+        std::max(derivative_lower_strength, derivative_upper_strength)
+    );
+
+    return position_updated;
+}
+
+template <typename Policy>
+void HapticController<Policy>::updateIdleCorrection(const HapticInput& input, angle_t shaft_angle) {
+    float dt = std::min((input.now_micros - last_update_micros_) * 1e-6f, IDLE_MAX_UPDATE_INTERVAL_SECONDS);
+    last_update_micros_ = input.now_micros;
+
+    // If we are not moving and we're close to the center (but not exactly there), slowly adjust the centerpoint to match the current position
+    float velocity_alpha = lowPassAlpha(dt, IDLE_VELOCITY_TIME_CONSTANT_SECONDS);
+    idle_check_velocity_ewma_ = input.shaft_velocity * velocity_alpha + idle_check_velocity_ewma_ * (1 - velocity_alpha);
+    if (fabsf(idle_check_velocity_ewma_) > IDLE_VELOCITY_RAD_PER_SEC) {
+        idle_ = false;
+    } else if (!idle_) {
+        idle_ = true;
+        idle_start_micros_ = input.now_micros;
+    }
+    if (idle_ && input.now_micros - idle_start_micros_ > IDLE_CORRECTION_DELAY_MICROS && fabsf(Policy::toFloat(shaft_angle - current_detent_center_)) < IDLE_CORRECTION_MAX_ANGLE_RAD) {
+        current_detent_center_ = Policy::ewma(current_detent_center_, shaft_angle, lowPassAlpha(dt, IDLE_CORRECTION_TIME_CONSTANT_SECONDS));
+        detent_center_error_ = 0;
+    }
+}
+
+template <typename Policy>
+void HapticController<Policy>::moveDetentCenter(angle_t delta) {
+    // Compensated (Kahan) summation: the rounding of each move is carried into the next, so a knob that
+    // keeps turning doesn't add it up into a drift of the detents (integer policies are exact anyway)
+    angle_t corrected = delta - detent_center_error_;
+    angle_t sum = current_detent_center_ + corrected;
+    detent_center_error_ = (sum - current_detent_center_) - corrected;
+    current_detent_center_ = sum;
+}
+
+// Map index and center of a position index that may lie up to one turn beyond either end of an
+// infinite scroll (-count to 2 * count - 1)
+template <typename Policy>
+static uint16_t wrappedIndex(const PositionMap<Policy>& map, int32_t index) {
+    return index < 0 ? index + map.count() : (index >= map.count() ? index - map.count() : index);
+}
+
+template <typename Policy>
+static typename Policy::angle_t unwrappedCenter(const PositionMap<Policy>& map, int32_t index) {
+    int32_t turns = index < 0 ? -1 : (index >= map.count() ? 1 : 0);
+    return map.center(index - turns * map.count()) + turns * map.period();
+}
+
+template <typename Policy>
+int32_t HapticController<Policy>::snapToMap(angle_t& angle_to_detent_center) {
+    const PositionMap<Policy>& map = compiled_.position_map;
+    const int32_t count = map.count();
+    const int32_t index = current_position_ - compiled_.min_position;
+    if (angle_to_detent_center <= map.snapIncrease(index) && angle_to_detent_center >= map.snapDecrease(index)) {
+        return 0;
+    }
+
+    // Look up the position at the shaft angle directly, so a fast spin across many positions takes
+    // one search rather than a snap per position
+    const angle_t angle = map.center(index) + angle_to_detent_center;
+    angle_t wrapped = angle;
+    int32_t turns = 0;
+    if (compiled_.infinite_scroll) {
+        // Beyond either end of the map continues at the other end, one period further (at most one
+        // turn per update, like MAX_SNAPS_PER_UPDATE for uniform detents)
+        angle_t low_edge = -map.width(0) / 2;
+        if (angle >= low_edge + map.period()) {
+            wrapped -= map.period();
+            turns = 1;
+        } else if (angle < low_edge) {
+            wrapped += map.period();
+            turns = -1;
+        }
+    }
+    int32_t target = map.find(wrapped) + turns * count;
+
+    // A snap per position stops at the first position whose threshold lies beyond the angle. That is
+    // usually the position at the angle; hysteresis and snap_point_bias move the thresholds off the
+    // boundaries, so correct by the few positions between. (Thresholds never allow leaving a bounded end.)
+    if (angle_to_detent_center > 0) {
+        target = std::max(target, index + 1);
+        while (target > index + 1 && angle - unwrappedCenter(map, target - 1) <= map.snapIncrease(wrappedIndex(map, target - 1))) {
+            target--;
+        }
+        while (target < 2 * count - 1 && angle - unwrappedCenter(map, target) > map.snapIncrease(wrappedIndex(map, target))) {
+            target++;
+        }
+    } else {
+        target = std::min(target, index - 1);
+        while (target < index - 1 && angle - unwrappedCenter(map, target + 1) >= map.snapDecrease(wrappedIndex(map, target + 1))) {
+            target++;
+        }
+        while (target > -count && angle - unwrappedCenter(map, target) < map.snapDecrease(wrappedIndex(map, target))) {
+            target--;
+        }
+    }
+
+    angle_t shift = unwrappedCenter(map, target) - map.center(index);
+    moveDetentCenter(shift);
+    angle_to_detent_center -= shift;
+    current_position_ = compiled_.min_position + wrappedIndex(map, target);
+    return target - index;
+}
+
+template <typename Policy>
+HapticOutput HapticController<Policy>::update(const HapticInput& input) {
+    const angle_t shaft_angle = toFrame(input.shaft_angle);
+    updateIdleCorrection(input, shaft_angle);
+
+    const CompiledDetentConfig<Policy>& c = compiled_;
+
+    // Check where we are relative to the current nearest detent; update our position if we've moved far enough to snap to another detent
+    angle_t angle_to_detent_center = shaft_angle - current_detent_center_;  // Positive means the physical sensor is to the "right" of the detent center
+
+    // A fast spin can cross more than one position between updates, so keep snapping until the
+    // detent center has caught up (bounded, so a single bad reading can't stall the loop)
+    int32_t steps = 0;
+    for (uint8_t i = 0; i < MAX_SNAPS_PER_UPDATE && c.position_map.empty(); i++) {
+        auto snap_state = CompiledDetentConfig<Policy>::snapState(current_position_);
+        if (angle_to_detent_center > c.snap_increase_radians[snap_state] && (!c.limited || current_position_ < c.max_position)) {
+            moveDetentCenter(c.position_width_radians);
+            angle_to_detent_center -= c.position_width_radians;
+            current_position_++;
+            steps++;
+        } else if (angle_to_detent_center < c.snap_decrease_radians[snap_state] && (!c.limited || current_position_ > c.min_position)) {
+            moveDetentCenter(-c.position_width_radians);
+            angle_to_detent_center += c.position_width_radians;
+            current_position_--;
+            steps--;
+        } else {
+            break;
+        }
+
+        if (c.infinite_scroll) {
+            if (current_position_ > c.max_position) {
+                current_position_ = c.min_position;
+            } else if (current_position_ < c.min_position) {
+                current_position_ = c.max_position;
+            }
+        }
+    }
+
+    if (!c.position_map.empty()) {
+        steps = snapToMap(angle_to_detent_center);
+    }
+
+    // Move the frame along by whole turns, so the angles stay small (for float, a turn is subtracted
+    // exactly from an angle between one and two turns)
+    const angle_t turn = Policy::fromFloat(TurnAngle::TURN);
+    while (current_detent_center_ >= turn) {
+        current_detent_center_ -= turn;
+        frame_turns_++;
+    }
+    while (current_detent_center_ < -turn) {
+        current_detent_center_ += turn;
+        frame_turns_--;
+    }
+
+    latest_sub_position_unit_ = c.subPosition(angle_to_detent_center, current_position_);
+
+    bool out_of_bounds = c.limited && ((angle_to_detent_center > 0 && current_position_ == c.max_position) || (angle_to_detent_center < 0 && current_position_ == c.min_position));
+    pid_.limit = TORQUE_LIMIT;
+    pid_.P = out_of_bounds ? c.endstop_p : c.detent_p;
+
+    // Apply motor torque based on our angle to the nearest detent (detent strength, etc is handled by the PID parameters)
+    float torque = 0;
+    if (fabsf(input.shaft_velocity) <= MAX_TORQUE_VELOCITY_RAD_PER_SEC) {
+        bool detent_disabled = !out_of_bounds && c.magnetic && !c.isDetent(current_position_);
+        if (!out_of_bounds && !c.torque_profile.empty()) {
+            // Sampled detent torque profile replaces the detent PID (endstops still use the PID)
+            torque = detent_disabled ? 0 : c.torque_profile(latest_sub_position_unit_);
+        } else {
+            float pid_input = Policy::toFloat(c.detentTarget(angle_to_detent_center, current_position_));
+            if (detent_disabled) {
+                pid_input = 0;
+            }
+            torque = pid_(pid_input, input.now_micros);
+        }
+    }
+
+    return {
+        .torque = torque,
+        .current_position = current_position_,
+        .position_steps = steps,
+        .sub_position_unit = latest_sub_position_unit_,
+    };
+}
+
+template class HapticController<FloatPolicy>;
+template class HapticController<FixedQ16Policy>;
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+
+#include "proto_gen/smartknob.pb.h"
+#include "detent_config.h"
+#include "numeric_policy.h"
+#include "turn_angle.h"
+#include "torque_pid.h"
+
+/**
+ * @brief Sensor-derived input to a single haptic control iteration.
+ *
+ * Angles and velocities are expected in the knob's logical rotation direction (i.e. with
+ * SK_INVERT_ROTATION already applied by the caller).
+ */
+struct HapticInput {
+    TurnAngle shaft_angle;
+    float shaft_velocity; // radians/second
+    uint32_t now_micros;
+};
+
+struct HapticOutput {
+    float torque;         // In the knob's logical rotation direction
+    int32_t current_position;
+    // Positions moved by this update, signed by direction (unlike the change of current_position,
+    // this also counts across an infinite scroll wrap)
+    int32_t position_steps;
+    float sub_position_unit;
+};
+
+/**
+ * @brief Detent/endstop haptic logic of the motor task, without any hardware dependencies.
+ *
+ * Owns the active SmartKnobConfig, the current position and detent center, and the idle
+ * correction state. The motor task feeds it the latest sensor readings once per loop iteration
+ * and applies the returned torque, which allows the same code to run against a simulated rotor
+ * (software/tools/haptic_plant_sim.cpp).
+ *
+ * The angle math uses the numeric Policy selected for the board (see numeric_policy.h).
+ */
+template <typename Policy = HapticNumericPolicy>
+class HapticController {
+    public:
+        HapticController();
+
+        // Reset the detent center to the given angle, e.g. after motor initialization or calibration
+        void begin(const TurnAngle& shaft_angle);
+
+        // Apply a new config. Returns true if the current position was changed by the config.
+        bool setConfig(const PB_SmartKnobConfig& new_config, const TurnAngle& shaft_angle);
+
+        HapticOutput update(const HapticInput& input);
+
+        const PB_SmartKnobConfig& config() const { return config_; }
+        int32_t currentPosition() const { return current_position_; }
+        float subPositionUnit() const { return latest_sub_position_unit_; }
+        // The knob has been (nearly) still for a while, by a slow filter of its velocity
+        bool idle() const { return idle_; }
+        // Angle the detent torque pulls towards, relative to the controller's frame (see frameAngle())
+        float detentCenter() const { return Policy::toFloat(current_detent_center_); }
+        // The given angle relative to the controller's frame, which starts at a whole turn and follows the
+        // knob by whole turns, so its angles stay small however far the knob turns
+        float frameAngle(const TurnAngle& angle) const { return Policy::toFloat(toFrame(angle)); }
+
+        // Torque controller; gains may be tuned by the owner, but P and D are managed per-config
+        TorquePid& pid() { return pid_; }
+
+    private:
+        using angle_t = typename Policy::angle_t;
+
+        PB_SmartKnobConfig config_;
+        CompiledDetentConfig<Policy> compiled_;
+        TorquePid pid_;
+
+        // Whole turn the angles below are relative to
+        int32_t frame_turns_ = 0;
+        angle_t current_detent_center_ = 0;
+        // Rounding error of current_detent_center_ not yet applied, see moveDetentCenter()
+        angle_t detent_center_error_ = 0;
+        int32_t current_position_ = 0;
+        float latest_sub_position_unit_ = 0;
+
+        uint32_t last_update_micros_ = 0;
+        float idle_check_velocity_ewma_ = 0;
+        bool idle_ = false;
+        uint32_t idle_start_micros_ = 0;
+
+        angle_t toFrame(const TurnAngle& angle) const {
+            return Policy::fromFloat(angle.radians) + (angle.turns - frame_turns_) * Policy::fromFloat(TurnAngle::TURN);
+        }
+        void moveDetentCenter(angle_t delta);
+        void updateIdleCorrection(const HapticInput& input, angle_t shaft_angle);
+        // Snap along the position map; returns the positions moved, as HapticOutput.position_steps
+        int32_t snapToMap(angle_t& angle_to_detent_center);
+};
@@ -0,0 +1,115 @@
+#include <cmath>
+
+#include "haptic_effect.h"
+
+struct HapticEffectShape {
+    uint32_t duration_micros;
+    float default_strength;
+};
+
+// Indexed by HapticEffect
+static const HapticEffectShape EFFECT_SHAPES[HapticEffectPlayer::NUM_EFFECTS] = {
+    {6000, 1.5},   // CLICK: one push in each direction
+    {46000, 1.5},  // DOUBLE_CLICK: two clicks, 40ms apart
+    {80000, 1},    // BUZZ: 250Hz square wave
+    {120000, 1.5}, // RAMP: linearly increasing torque, released at the end
+    {30000, 2},    // BUMP: half-sine pulse in the positive direction
+};
+
+static const uint32_t CLICK_HALF_PERIOD_MICROS = 3000;
+static const uint32_t DOUBLE_CLICK_SECOND_START_MICROS = 40000;
+static const uint32_t BUZZ_HALF_PERIOD_MICROS = 2000;
+
+static float click(uint32_t elapsed_micros) {
+    if (elapsed_micros < CLICK_HALF_PERIOD_MICROS) {
+        return 1;
+    } else if (elapsed_micros < 2 * CLICK_HALF_PERIOD_MICROS) {
+        return -1;
+    }
+    return 0;
+}
+
+bool HapticEffectPlayer::play(HapticEffect effect, float strength, uint32_t now_micros) {
+    if ((uint8_t)effect >= NUM_EFFECTS) {
+        return false;
+    }
+    // A free voice, or else the one that has been playing the longest
+    Voice* voice = &voices_[0];
+    for (Voice& v : voices_) {
+        if (!v.playing) {
+            voice = &v;
+            break;
+        }
+        if (now_micros - v.start_micros > now_micros - voice->start_micros) {
+            voice = &v;
+        }
+    }
+    voice->effect = effect;
+    voice->strength = strength == 0 ? defaultStrength(effect) : strength;
+    voice->start_micros = now_micros;
+    voice->playing = true;
+    return true;
+}
+
+void HapticEffectPlayer::stop() {
+    for (Voice& voice : voices_) {
+        voice.playing = false;
+    }
+}
+
+bool HapticEffectPlayer::playing() const {
+    for (const Voice& voice : voices_) {
+        if (voice.playing) {
+            return true;
+        }
+    }
+    return false;
+}
+
+float HapticEffectPlayer::torque(uint32_t now_micros) {
+    float torque = 0;
+    float limit = 0;
+    for (Voice& voice : voices_) {
+        if (!voice.playing) {
+            continue;
+        }
+        uint32_t elapsed_micros = now_micros - voice.start_micros;
+        if (elapsed_micros >= durationMicros(voice.effect)) {
+            voice.playing = false;
+            continue;
+        }
+        torque += voice.strength * waveform(voice.effect, elapsed_micros);
+        limit = fmaxf(limit, fabsf(voice.strength));
+    }
+    return fminf(fmaxf(torque, -limit), limit);
+}
+
+uint32_t HapticEffectPlayer::durationMicros(HapticEffect effect) {
+    return (uint8_t)effect < NUM_EFFECTS ? EFFECT_SHAPES[(uint8_t)effect].duration_micros : 0;
+}
+
+float HapticEffectPlayer::defaultStrength(HapticEffect effect) {
+    return (uint8_t)effect < NUM_EFFECTS ? EFFECT_SHAPES[(uint8_t)effect].default_strength : 0;
+}
+
+float HapticEffectPlayer::waveform(HapticEffect effect, uint32_t elapsed_micros) {
+    if (elapsed_micros >= durationMicros(effect)) {
+        return 0;
+    }
+    switch (effect) {
+        case HapticEffect::CLICK:
+            return click(elapsed_micros);
+        case HapticEffect::DOUBLE_CLICK:
+            if (elapsed_micros >= DOUBLE_CLICK_SECOND_START_MICROS) {
+                return click(elapsed_micros - DOUBLE_CLICK_SECOND_START_MICROS);
+            }
+            return click(elapsed_micros);
+        case HapticEffect::BUZZ:
+            return (elapsed_micros / BUZZ_HALF_PERIOD_MICROS) % 2 == 0 ? 1 : -1;
+        case HapticEffect::RAMP:
+            return (float)elapsed_micros / durationMicros(effect);
+        case HapticEffect::BUMP:
+            return sinf(M_PI * elapsed_micros / durationMicros(effect));
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// Haptic effects; values match PB_PlayHapticEffect.effect
+enum class HapticEffect : uint8_t {
+    CLICK = 0,
+    DOUBLE_CLICK = 1,
+    BUZZ = 2,
+    RAMP = 3,
+    BUMP = 4,
+};
+
+/**
+ * @brief Plays short haptic effects as time-indexed torque waveforms.
+ *
+ * The motor task samples the playing effects once per haptic iteration and adds them to the detent
+ * torque, so effects never block the motor loop. Up to MAX_VOICES effects play at once, e.g. the
+ * clicks of a quick scroll; their torques add up, but never beyond the strength of the strongest
+ * of them. Starting an effect while all voices are busy replaces the oldest one.
+ *
+ * Time is passed in by the caller, so the waveforms can be evaluated against a simulated clock
+ * (see software/tools/haptic_effect_check.cpp).
+ */
+class HapticEffectPlayer {
+    public:
+        static const uint8_t NUM_EFFECTS = 5;
+        static const uint8_t MAX_VOICES = 4;
+
+        // Start playing an effect, mixed with those already playing. A strength of 0 uses the
+        // effect's default strength. Returns false (and keeps playing the current effects) if the
+        // effect is unknown.
+        bool play(HapticEffect effect, float strength, uint32_t now_micros);
+        void stop();
+        bool playing() const;
+
+        // Mixed torque of the playing effects at the given time, or 0 if no effect is playing
+        float torque(uint32_t now_micros);
+
+        static uint32_t durationMicros(HapticEffect effect);
+        static float defaultStrength(HapticEffect effect);
+
+        // Normalized waveform (peak magnitude 1) of an effect, elapsed_micros after it started
+        static float waveform(HapticEffect effect, uint32_t elapsed_micros);
+
+    private:
+        struct Voice {
+            HapticEffect effect = HapticEffect::CLICK;
+            float strength = 0;
+            uint32_t start_micros = 0;
+            bool playing = false;
+        };
+
+        Voice voices_[MAX_VOICES];
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+#include "turn_angle.h"
+
+/**
+ * @brief Decides when the motor loop may run at a low-power rate, and wakes it on any movement.
+ *
+ * The loop drops to low power once the haptic controller has considered the knob idle (its slow
+ * velocity filter) and the sensor angle has stayed within wake_radians of where it settled, without
+ * interruption, for the configured delay. It wakes on the first sample that is further than that
+ * from the settled angle, or as soon as something else needs the full rate (busy). Fed with every
+ * sensor sample, including those taken at low power, a touch is answered within one sensor sample.
+ *
+ * Also keeps the duty cycle (time at the full rate) and the wake-up latency, measured from the last
+ * sample that still saw the knob at rest to the sample that woke the loop: an upper bound of the
+ * time from the knob starting to move to the loop reacting. Timestamps are passed in, so this runs
+ * on a simulated clock.
+ */
+class IdleGovernor {
+    public:
+        void begin(uint32_t delay_micros, float wake_radians, uint32_t now_micros) {
+            *this = IdleGovernor();
+            delay_micros_ = delay_micros;
+            wake_radians_ = wake_radians;
+            last_update_micros_ = now_micros;
+            still_since_micros_ = now_micros;
+        }
+
+        // Called on every loop iteration; returns true if the loop should run at the low-power rate from now on
+        bool update(uint32_t now_micros, const TurnAngle& angle, bool controller_idle, bool busy) {
+            uint32_t elapsed = now_micros - last_update_micros_;
+            (low_power_ ? low_power_micros_ : full_rate_micros_) += elapsed;
+            last_update_micros_ = now_micros;
+
+            float moved = angle.radiansSince(settled_angle_);
+            bool still = moved <= wake_radians_ && moved >= -wake_radians_;
+            if (low_power_) {
+                if (still && !busy) {
+                    last_still_micros_ = now_micros;
+                    return true;
+                }
+                low_power_ = false;
+                wakeups_++;
+                uint32_t latency = now_micros - last_still_micros_;
+                total_wake_latency_micros_ += latency;
+                if (latency > max_wake_latency_micros_) {
+                    max_wake_latency_micros_ = latency;
+                }
+            }
+
+            if (!still || !controller_idle || busy) {
+                settled_angle_ = angle;
+                still_since_micros_ = now_micros;
+            } else if (now_micros - still_since_micros_ >= delay_micros_) {
+                low_power_ = true;
+                last_still_micros_ = now_micros;
+            }
+            return low_power_;
+        }
+
+        bool lowPower() const { return low_power_; }
+        // Sensor angle the knob settled at; moving further than wake_radians from it wakes the loop
+        const TurnAngle& settledAngle() const { return settled_angle_; }
+
+        uint32_t wakeups() const { return wakeups_; }
+        uint32_t maxWakeLatencyMicros() const { return max_wake_latency_micros_; }
+        float meanWakeLatencyMicros() const { return wakeups_ == 0 ? 0 : (float)total_wake_latency_micros_ / wakeups_; }
+        // Fraction of the time spent at the full loop rate
+        float dutyCycle() const {
+            uint64_t total = full_rate_micros_ + low_power_micros_;
+            return total == 0 ? 1 : (float)full_rate_micros_ / total;
+        }
+
+    private:
+        uint32_t delay_micros_ = 0;
+        float wake_radians_ = 0;
+
+        bool low_power_ = false;
+        TurnAngle settled_angle_ = {0, 0};
+        uint32_t still_since_micros_ = 0;
+        uint32_t last_still_micros_ = 0;
+        uint32_t last_update_micros_ = 0;
+
+        uint64_t full_rate_micros_ = 0;
+        uint64_t low_power_micros_ = 0;
+        uint32_t wakeups_ = 0;
+        uint32_t max_wake_latency_micros_ = 0;
+        uint64_t total_wake_latency_micros_ = 0;
+};
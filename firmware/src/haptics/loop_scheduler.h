@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Running histogram of loop periods, bucketed relative to the nominal period.
+ *
+ * Buckets are NUM_BUCKETS equal slices of [0, 2 * nominal period); the last bucket also collects
+ * everything beyond that. Updating is a handful of integer operations, so it is cheap enough to
+ * run on every motor loop iteration.
+ */
+class LoopTimingHistogram {
+    public:
+        static const uint8_t NUM_BUCKETS = 16;
+
+        void reset(uint32_t nominal_period_micros) {
+            *this = LoopTimingHistogram();
+            nominal_period_micros_ = nominal_period_micros;
+            bucket_width_micros_ = (2 * nominal_period_micros + NUM_BUCKETS - 1) / NUM_BUCKETS;
+            if (bucket_width_micros_ == 0) {
+                bucket_width_micros_ = 1;
+            }
+        }
+
+        void record(uint32_t period_micros, uint32_t missed_ticks) {
+            uint32_t bucket = period_micros / bucket_width_micros_;
+            buckets_[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1]++;
+
+            if (samples_ == 0 || period_micros < min_period_micros_) {
+                min_period_micros_ = period_micros;
+            }
+            if (period_micros > max_period_micros_) {
+                max_period_micros_ = period_micros;
+            }
+            total_period_micros_ += period_micros;
+            samples_++;
+
+            // A tick is overrun if the loop was late by more than half a period, or if ticks were skipped entirely
+            if (missed_ticks > 0 || period_micros > nominal_period_micros_ + nominal_period_micros_ / 2) {
+                overruns_++;
+            }
+            missed_ticks_ += missed_ticks;
+        }
+
+        uint32_t nominalPeriodMicros() const { return nominal_period_micros_; }
+        uint32_t bucketWidthMicros() const { return bucket_width_micros_; }
+        uint32_t bucket(uint8_t i) const { return buckets_[i]; }
+        uint32_t samples() const { return samples_; }
+        uint32_t overruns() const { return overruns_; }
+        uint32_t missedTicks() const { return missed_ticks_; }
+        uint32_t minPeriodMicros() const { return min_period_micros_; }
+        uint32_t maxPeriodMicros() const { return max_period_micros_; }
+        float meanPeriodMicros() const { return samples_ == 0 ? 0 : (float)total_period_micros_ / samples_; }
+
+    private:
+        uint32_t nominal_period_micros_ = 0;
+        uint32_t bucket_width_micros_ = 1;
+        uint32_t buckets_[NUM_BUCKETS] = {};
+        uint32_t samples_ = 0;
+        uint32_t overruns_ = 0;
+        uint32_t missed_ticks_ = 0;
+        uint32_t min_period_micros_ = 0;
+        uint32_t max_period_micros_ = 0;
+        uint64_t total_period_micros_ = 0;
+};
+
+/**
+ * @brief Bookkeeping for a fixed-rate loop driven by an external tick source (e.g. a periodic timer).
+ *
+ * The caller waits for a tick, then calls tick() with the current timestamp and the number of ticks
+ * that were pending. The scheduler records the loop period and decides whether the slower, outer
+ * haptic update is due on this tick. Timestamps are passed in, so this runs on a simulated clock
+ * (software/tools/loop_scheduler_check.cpp).
+ */
+class LoopScheduler {
+    public:
+        void begin(uint32_t rate_hz, uint8_t haptic_divisor) {
+            period_micros_ = 1000000 / rate_hz;
+            haptic_divisor_ = haptic_divisor == 0 ? 1 : haptic_divisor;
+            reset();
+        }
+
+        // Discard timing history, e.g. after the loop was intentionally blocked for a long time
+        void reset() {
+            histogram_.reset(period_micros_);
+            has_last_tick_ = false;
+            haptic_counter_ = 0;
+        }
+
+        // While the knob rests: keep ticking at the nominal period, but only have the haptic update due on every
+        // divisor-th tick, starting with the next one. 0 (or 1) has it due every haptic divisor-th tick again.
+        void setIdleDivisor(uint32_t divisor) {
+            idle_divisor_ = divisor > 1 ? divisor : 0;
+            idle_counter_ = 0;
+        }
+
+        // Returns true if the haptic update should run on this tick
+        bool tick(uint32_t now_micros, uint32_t pending_ticks) {
+            if (has_last_tick_) {
+                histogram_.record(now_micros - last_tick_micros_, pending_ticks > 1 ? pending_ticks - 1 : 0);
+            }
+            last_tick_micros_ = now_micros;
+            has_last_tick_ = true;
+
+            if (idle_divisor_ != 0) {
+                bool haptic_due = idle_counter_ == 0;
+                idle_counter_++;
+                if (idle_counter_ >= idle_divisor_) {
+                    idle_counter_ = 0;
+                }
+                return haptic_due;
+            }
+
+            bool haptic_due = haptic_counter_ == 0;
+            haptic_counter_++;
+            if (haptic_counter_ >= haptic_divisor_) {
+                haptic_counter_ = 0;
+            }
+            return haptic_due;
+        }
+
+        uint32_t periodMicros() const { return period_micros_; }
+        bool idle() const { return idle_divisor_ != 0; }
+        // Time from one tick to the next one that runs the FOC step: a period, or idle divisor periods while idle
+        uint32_t drivePeriodMicros() const { return idle_divisor_ != 0 ? idle_divisor_ * period_micros_ : period_micros_; }
+        uint8_t hapticDivisor() const { return haptic_divisor_; }
+        const LoopTimingHistogram& histogram() const { return histogram_; }
+
+    private:
+        uint32_t period_micros_ = 1000;
+        uint8_t haptic_divisor_ = 1;
+        uint8_t haptic_counter_ = 0;
+        uint32_t idle_divisor_ = 0;
+        uint32_t idle_counter_ = 0;
+
+        bool has_last_tick_ = false;
+        uint32_t last_tick_micros_ = 0;
+
+        LoopTimingHistogram histogram_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Numeric policies for the angle math of the haptic controller.
+ *
+ * The detent math (snap comparisons, detent center tracking, dead zone, sub-position) is written
+ * against a policy so that boards can pick whichever representation is faster on their core.
+ * The torque PID and velocity-based logic stay in float either way.
+ *
+ * A policy provides:
+ *  - angle_t: representation of an angle in radians
+ *  - fromFloat/toFloat: conversion from/to float radians
+ *  - ratio(a, width, inverse_width): a / width, as a float unit value
+ *  - ewma(current, target, alpha): current moved towards target by the fraction alpha
+ *
+ * software/tools/numeric_policy_report prints each policy's error against the float reference and its
+ * cycles per call.
+ */
+
+/** Reference implementation, single-precision float radians. */
+struct FloatPolicy {
+    using angle_t = float;
+    using inverse_t = float;
+
+    static constexpr const char* NAME = "float";
+
+    static angle_t fromFloat(float radians) { return radians; }
+    static float toFloat(angle_t angle) { return angle; }
+
+    static inverse_t inverse(angle_t width) { return width == 0 ? 0 : 1 / width; }
+    static float ratio(angle_t a, angle_t width, inverse_t) { return a / width; }
+
+    static angle_t ewma(angle_t current, angle_t target, float alpha) {
+        return target * alpha + current * (1 - alpha);
+    }
+};
+
+/**
+ * Q16.16 fixed-point radians: 16 integer bits cover +/-32768 rad (~5200 turns, far more than the
+ * haptic controller's frame spans, see TurnAngle), 16 fractional bits give 1.5e-5 rad resolution,
+ * well below the resolution of any of the supported angle sensors.
+ * Divisions are replaced by a multiplication with a Q16.16 reciprocal computed once per config.
+ */
+struct FixedQ16Policy {
+    using angle_t = int32_t;
+    using inverse_t = int64_t;
+
+    static constexpr const char* NAME = "Q16.16";
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr float ONE = 1 << FRACTION_BITS;
+
+    static angle_t fromFloat(float radians) { return (angle_t)lroundf(radians * ONE); }
+    static float toFloat(angle_t angle) { return angle * (1 / ONE); }
+
+    static inverse_t inverse(angle_t width) {
+        return width == 0 ? 0 : ((int64_t)1 << (2 * FRACTION_BITS)) / width;
+    }
+    static float ratio(angle_t a, angle_t, inverse_t inverse_width) {
+        return toFloat((angle_t)(((int64_t)a * inverse_width) >> FRACTION_BITS));
+    }
+
+    static angle_t ewma(angle_t current, angle_t target, float alpha) {
+        int64_t alpha_q32 = (int64_t)(alpha * 4294967296.0f);
+        int64_t diff = (int64_t)target - current;
+        int64_t step = (diff * alpha_q32 + ((int64_t)1 << 31)) >> 32;
+        // Always move at least one LSB, otherwise small differences would be rounded away and the
+        // filter would never settle onto its target
+        if (step == 0 && diff != 0) {
+            step = diff > 0 ? 1 : -1;
+        }
+        return (angle_t)(current + step);
+    }
+};
+
+// Haptic numeric policy: 0=float, 1=Q16.16 fixed-point
+#ifndef SK_HAPTIC_FIXED_POINT
+    #define SK_HAPTIC_FIXED_POINT 0
+#endif // SK_HAPTIC_FIXED_POINT
+
+#if SK_HAPTIC_FIXED_POINT
+using HapticNumericPolicy = FixedQ16Policy;
+#else
+using HapticNumericPolicy = FloatPolicy;
+#endif // SK_HAPTIC_FIXED_POINT
@@ -0,0 +1,112 @@
+#include <cmath>
+
+#include "position_map.h"
+
+// Same dead zone as the uniform detents (see detent_config.cpp), relative to each position's own width
+static const float DEAD_ZONE_DETENT_PERCENT = 0.2;
+static const float DEAD_ZONE_RAD = 1 * M_PI / 180;
+
+// Positions are never narrower than this, whatever the curve; about 5x the resolution of the angle sensors
+static const float MIN_WIDTH_RAD = 0.1 * M_PI / 180;
+
+// Fraction of the total angle before the point u (0 to 1) of the position range
+static float cumulative(const PositionMapCurve& curve, float u, float segment_total) {
+    switch (curve.type) {
+        case PositionCurve::POWER:
+            return powf(u, curve.shape);
+        case PositionCurve::LOGARITHMIC:
+            return logf(1 + curve.shape * u) / logf(1 + curve.shape);
+        case PositionCurve::PIECEWISE: {
+            // Segments cover equal parts of the position range, each with its own relative width
+            float position = u * curve.segment_count;
+            uint8_t segment = position >= curve.segment_count ? curve.segment_count - 1 : (uint8_t)position;
+            float sum = 0;
+            for (uint8_t i = 0; i < segment; i++) {
+                sum += curve.segment_widths[i];
+            }
+            sum += (position - segment) * curve.segment_widths[segment];
+            return sum / segment_total;
+        }
+        default:
+            return u;
+    }
+}
+
+template <typename Policy>
+bool PositionMap<Policy>::build(const PositionMapCurve& curve, uint16_t count, float average_width, float snap_point,
+        float snap_point_bias, int32_t first_position, bool wrap_around) {
+    count_ = 0;
+    if (count < 2 || count > MAX_POSITIONS || average_width <= 0) {
+        return false;
+    }
+
+    float segment_total = 0;
+    switch (curve.type) {
+        case PositionCurve::POWER:
+        case PositionCurve::LOGARITHMIC:
+            if (!(curve.shape > 0)) {
+                return false;
+            }
+            break;
+        case PositionCurve::PIECEWISE:
+            if (curve.segment_count == 0) {
+                return false;
+            }
+            for (uint8_t i = 0; i < curve.segment_count; i++) {
+                if (!(curve.segment_widths[i] > 0)) {
+                    return false;
+                }
+                segment_total += curve.segment_widths[i];
+            }
+            break;
+        default:
+            return false;
+    }
+
+    // Widths are computed in float and converted once, so rounding doesn't accumulate over the positions
+    float total = average_width * count;
+    float widths[MAX_POSITIONS];
+    float previous = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        float next = cumulative(curve, (float)(i + 1) / count, segment_total);
+        widths[i] = fmaxf((next - previous) * total, MIN_WIDTH_RAD);
+        previous = next;
+    }
+
+    float center = 0;
+    float period = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (i > 0) {
+            center += (widths[i - 1] + widths[i]) / 2;
+        }
+        period += widths[i];
+        center_[i] = Policy::fromFloat(center);
+        width_[i] = Policy::fromFloat(widths[i]);
+        inverse_width_[i] = Policy::inverse(width_[i]);
+        dead_zone_[i] = Policy::fromFloat(fminf(widths[i] * DEAD_ZONE_DETENT_PERCENT, DEAD_ZONE_RAD));
+        upper_boundary_[i] = Policy::fromFloat(center + widths[i] / 2);
+
+        // Thresholds sit at the boundaries to the neighbours, moved by the hysteresis beyond a snap_point of
+        // 0.5 and by snap_point_bias (towards position 0, as for uniform detents). Both are scaled by the
+        // distance to the neighbouring center, which is the position width for uniform detents.
+        bool has_next = i + 1 < count || wrap_around;
+        bool has_previous = i > 0 || wrap_around;
+        float gap_up = (widths[i] + widths[(i + 1) % count]) / 2;
+        float gap_down = (widths[i] + widths[(i + count - 1) % count]) / 2;
+        int32_t position = first_position + i;
+        float bias_up = position < 0 ? -snap_point_bias : snap_point_bias;
+        float bias_down = position > 0 ? snap_point_bias : -snap_point_bias;
+        float increase = widths[i] / 2 + gap_up * (snap_point - 0.5f + bias_up);
+        float decrease = -widths[i] / 2 + gap_down * (-(snap_point - 0.5f) + bias_down);
+        // A large bias next to a much wider neighbour could move a threshold past the center; the position
+        // would then snap away at rest
+        snap_increase_[i] = has_next ? Policy::fromFloat(fmaxf(increase, 0)) : NEVER;
+        snap_decrease_[i] = has_previous ? Policy::fromFloat(fminf(decrease, 0)) : -NEVER;
+    }
+    period_ = Policy::fromFloat(period);
+    count_ = count;
+    return true;
+}
+
+template class PositionMap<FloatPolicy>;
+template class PositionMap<FixedQ16Policy>;
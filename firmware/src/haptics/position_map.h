@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "numeric_policy.h"
+
+// Must match the curve values of PositionMap in smartknob.proto
+enum class PositionCurve : uint8_t {
+    UNIFORM = 0,
+    POWER = 1,
+    LOGARITHMIC = 2,
+    PIECEWISE = 3,
+};
+
+struct PositionMapCurve {
+    PositionCurve type;
+    // Exponent of a power curve, steepness of a logarithmic curve
+    float shape;
+    // Relative widths of the positions in each of segment_count equal parts of the range, for a piecewise curve
+    const float* segment_widths;
+    uint8_t segment_count;
+};
+
+/**
+ * @brief Layout of positions with individual widths, as set by SmartKnobConfig.position_map.
+ *
+ * Precomputes everything the haptic loop needs per position (center, width, snap thresholds, dead
+ * zone), so a position's own values are a table lookup, and finding the position at an angle is
+ * a binary search over the boundaries between positions.
+ *
+ * Angles are relative to the center of the first position and stored in the representation of
+ * the numeric Policy (see numeric_policy.h). Has no hardware or nanopb dependencies.
+ */
+template <typename Policy>
+class PositionMap {
+    public:
+        using angle_t = typename Policy::angle_t;
+        using inverse_t = typename Policy::inverse_t;
+
+        static const uint16_t MAX_POSITIONS = 256;
+
+        /**
+         * @brief Lay out count positions along the curve, over the angle that count positions of
+         *        average_width would take.
+         *
+         * Snap thresholds follow the uniform detents: at the boundary between two positions for a
+         * snap_point of 0.5, with hysteresis and bias scaled by the distance between their centers.
+         * Without wrap_around, the first and last position can't be left outwards.
+         *
+         * @return false if the curve is uniform or invalid, or count is out of range (2 to
+         *         MAX_POSITIONS); the map is then empty
+         */
+        bool build(const PositionMapCurve& curve, uint16_t count, float average_width, float snap_point,
+            float snap_point_bias, int32_t first_position, bool wrap_around);
+
+        void clear() { count_ = 0; }
+        bool empty() const { return count_ == 0; }
+        uint16_t count() const { return count_; }
+
+        angle_t center(uint16_t index) const { return center_[index]; }
+        angle_t width(uint16_t index) const { return width_[index]; }
+        inverse_t inverseWidth(uint16_t index) const { return inverse_width_[index]; }
+        // Offsets from the position's center beyond which the position changes
+        angle_t snapIncrease(uint16_t index) const { return snap_increase_[index]; }
+        angle_t snapDecrease(uint16_t index) const { return snap_decrease_[index]; }
+        // Half-width of the flat region around the position's center
+        angle_t deadZone(uint16_t index) const { return dead_zone_[index]; }
+        // Angle of all positions together; one turn of an infinite scroll
+        angle_t period() const { return period_; }
+
+        // Index of the position whose extent contains angle; angles beyond either end give the first or last position
+        uint16_t find(angle_t angle) const {
+            // Branchless binary search over the count - 1 boundaries between positions
+            uint16_t base = 0;
+            uint16_t length = count_;
+            while (length > 1) {
+                uint16_t half = length / 2;
+                base += (upper_boundary_[base + half - 1] <= angle) * half;
+                length -= half;
+            }
+            return base;
+        }
+
+    private:
+        static constexpr angle_t NEVER = std::numeric_limits<angle_t>::max();
+
+        uint16_t count_ = 0;
+        angle_t period_;
+        angle_t center_[MAX_POSITIONS];
+        angle_t width_[MAX_POSITIONS];
+        inverse_t inverse_width_[MAX_POSITIONS];
+        angle_t snap_increase_[MAX_POSITIONS];
+        angle_t snap_decrease_[MAX_POSITIONS];
+        angle_t dead_zone_[MAX_POSITIONS];
+        // Boundary between position i and i + 1
+        angle_t upper_boundary_[MAX_POSITIONS];
+};
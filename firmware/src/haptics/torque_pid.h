@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief PID controller used to turn the angle error to the nearest detent into a torque command.
+ *
+ * Mirrors the math of SimpleFOC's PIDController (trapezoidal integral, output ramp, limit) but takes
+ * the timestamp as an argument instead of calling _micros(), so it can run without any hardware.
+ */
+class TorquePid {
+    public:
+        float P = 0;
+        float I = 0;
+        float D = 0;
+        float output_ramp = 0;
+        float limit = 0;
+
+        float operator()(float error, uint32_t now_micros) {
+            float dt = (now_micros - timestamp_prev_) * 1e-6f;
+            // Quick fix for strange cases (micros overflow, first call)
+            if (dt <= 0 || dt > 0.5f) {
+                dt = 1e-3f;
+            }
+
+            float proportional = P * error;
+            float integral = clampLimit(integral_prev_ + I * dt * 0.5f * (error + error_prev_));
+            float derivative = D * (error - error_prev_) / dt;
+
+            float output = clampLimit(proportional + integral + derivative);
+            if (output_ramp > 0) {
+                // Limit the rate of change of the output
+                float output_rate = (output - output_prev_) / dt;
+                if (output_rate > output_ramp) {
+                    output = output_prev_ + output_ramp * dt;
+                } else if (output_rate < -output_ramp) {
+                    output = output_prev_ - output_ramp * dt;
+                }
+            }
+
+            integral_prev_ = integral;
+            output_prev_ = output;
+            error_prev_ = error;
+            timestamp_prev_ = now_micros;
+            return output;
+        }
+
+        void reset() {
+            integral_prev_ = 0;
+            output_prev_ = 0;
+            error_prev_ = 0;
+        }
+
+    private:
+        float error_prev_ = 0;
+        float output_prev_ = 0;
+        float integral_prev_ = 0;
+        uint32_t timestamp_prev_ = 0;
+
+        float clampLimit(float value) const {
+            return value < -limit ? -limit : (value > limit ? limit : value);
+        }
+};
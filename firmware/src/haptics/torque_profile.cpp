@@ -0,0 +1,32 @@
+#include <cmath>
+
+#include "torque_profile.h"
+
+void TorqueProfile::set(const float* samples, uint32_t count, float scale) {
+    count_ = count > MAX_SAMPLES ? MAX_SAMPLES : count;
+    for (uint8_t i = 0; i < count_; i++) {
+        samples_[i] = samples[i] * scale;
+    }
+    if (count_ > 0) {
+        samples_[count_] = samples_[0];
+    }
+}
+
+float TorqueProfile::operator()(float sub_position_unit) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    // Position within the period, in [0, 1) starting at sub-position -0.5
+    float phase = sub_position_unit + 0.5f;
+    phase -= floorf(phase);
+
+    float x = phase * count_;
+    uint8_t i = (uint8_t)x;
+    if (i >= count_) {
+        // phase rounded up to exactly 1
+        i = count_ - 1;
+    }
+    float fraction = x - i;
+    return samples_[i] + (samples_[i + 1] - samples_[i]) * fraction;
+}
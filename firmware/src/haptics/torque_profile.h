@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Sampled torque curve of a single detent, as set by SmartKnobConfig.detent_torque_profile.
+ *
+ * The samples are evenly spaced over one position width, starting at sub-position -0.5, and the
+ * curve repeats every position. Evaluating it is a linear interpolation between two samples.
+ *
+ * Has no hardware or nanopb dependencies, so host tools can render exactly the curve that the
+ * firmware applies.
+ */
+class TorqueProfile {
+    public:
+        // Must match the max_count of detent_torque_profile in smartknob.proto
+        static const uint8_t MAX_SAMPLES = 32;
+
+        // Set the profile from count samples, each multiplied by scale. Counts above MAX_SAMPLES are truncated.
+        void set(const float* samples, uint32_t count, float scale);
+        void clear() { count_ = 0; }
+        bool empty() const { return count_ == 0; }
+        uint8_t count() const { return count_; }
+
+        // Torque at the given sub-position (fraction of a position width from the detent center)
+        float operator()(float sub_position_unit) const;
+
+    private:
+        // One extra sample, a copy of the first, so interpolation never has to wrap
+        float samples_[MAX_SAMPLES + 1];
+        uint8_t count_ = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Unbounded shaft angle, as whole turns plus the angle within the turn.
+ *
+ * A single float holding the unwrapped angle loses resolution as the knob keeps turning (its
+ * steps pass 1 degree after about 2000 turns), which an always-on scroll wheel gets to. Here the
+ * angle within the turn keeps the full float resolution at any turn count. Math is done on the
+ * difference of two nearby angles (radiansSince()), which is small.
+ */
+struct TurnAngle {
+    static constexpr float TURN = 2 * M_PI;
+
+    int32_t turns;
+    // Angle within the turn, in [0, TURN) when normalized
+    float radians;
+
+    // The same angle with radians wrapped into [0, TURN), carrying whole turns
+    TurnAngle normalized() const {
+        TurnAngle a = *this;
+        if (a.radians >= TURN || a.radians < 0) {
+            float whole = floorf(a.radians / TURN);
+            a.turns += (int32_t)whole;
+            a.radians -= whole * TURN;
+            // Rounding can leave the angle just outside the turn
+            if (a.radians >= TURN) {
+                a.radians -= TURN;
+                a.turns++;
+            } else if (a.radians < 0) {
+                a.radians += TURN;
+                a.turns--;
+            }
+        }
+        return a;
+    }
+
+    TurnAngle operator+(float delta) const {
+        return TurnAngle{turns, radians + delta}.normalized();
+    }
+
+    // Signed angle from origin to this angle; only precise if they are a few turns apart at most
+    float radiansSince(const TurnAngle& origin) const {
+        return (turns - origin.turns) * TURN + (radians - origin.radians);
+    }
+};
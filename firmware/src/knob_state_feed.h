@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+
+#include "proto_gen/smartknob.pb.h"
+#include "seqlock.h"
+
+/**
+ * @brief Latest knob state as published by the motor task, without the (large) config.
+ *
+ * No press nonce: presses are detected from the strain gauge in the interface task, which counts
+ * them into PB_SmartKnobState.press_nonce itself, so the motor task never sees them.
+ */
+struct KnobStateSnapshot {
+    int32_t current_position;
+    float sub_position_unit;
+    // Generation of the config that current_position/sub_position_unit were computed with
+    uint32_t config_generation;
+    uint32_t timestamp_micros;
+};
+
+/**
+ * @brief Lock-free publication of the knob state from the motor task to any number of consumers.
+ *
+ * The motor task writes a small KnobStateSnapshot on every publish tick and the full config only
+ * when it changes. Consumers read the snapshot whenever they like and copy the config only when
+ * its generation differs from the one they already have (see KnobStateReader). The writer never
+ * blocks and never copies per consumer.
+ *
+ * Also carries the status of the latest motor calibration, published while it runs.
+ * software/tools/knob_state_feed_stress checks it with concurrent readers on the host.
+ */
+class KnobStateFeed {
+    public:
+        // Writer side; must only be called from the motor task
+        void publishConfig(const PB_SmartKnobConfig& config) {
+            config_.write(config);
+        }
+
+        void publishState(int32_t current_position, float sub_position_unit, uint32_t timestamp_micros) {
+            state_.write({
+                .current_position = current_position,
+                .sub_position_unit = sub_position_unit,
+                .config_generation = config_.sequence(),
+                .timestamp_micros = timestamp_micros,
+            });
+        }
+
+        void publishCalibrationStatus(const PB_MotorCalibrationStatus& status) {
+            calibration_status_.write(status);
+        }
+
+        // Generation of the latest published config, as carried by snapshots
+        uint32_t configGeneration() const {
+            return config_.sequence();
+        }
+
+        // Reader side; all return the version of the value that was read (0 if never published)
+        uint32_t readState(KnobStateSnapshot& snapshot) const {
+            return state_.read(snapshot);
+        }
+
+        uint32_t readConfig(PB_SmartKnobConfig& config) const {
+            return config_.read(config);
+        }
+
+        uint32_t readCalibrationStatus(PB_MotorCalibrationStatus& status) const {
+            return calibration_status_.read(status);
+        }
+
+    private:
+        SeqLock<KnobStateSnapshot> state_;
+        SeqLock<PB_SmartKnobConfig> config_;
+        SeqLock<PB_MotorCalibrationStatus> calibration_status_;
+};
+
+/**
+ * @brief Per-consumer view of a KnobStateFeed, assembling full PB_SmartKnobStates.
+ *
+ * The PB_SmartKnobState passed to poll() doubles as the config cache, so consumers should keep
+ * polling into the same object.
+ */
+class KnobStateReader {
+    public:
+        KnobStateReader() {}
+        explicit KnobStateReader(const KnobStateFeed& feed) : feed_(&feed) {}
+
+        void setFeed(const KnobStateFeed& feed) {
+            feed_ = &feed;
+            state_version_ = 0;
+            config_generation_ = NO_GENERATION;
+        }
+
+        /**
+         * @brief Update state with the latest published knob state.
+         *
+         * @return true if a new state was published since the last successful poll. Only then is
+         *         state updated, config included; state.config is only copied when the config generation
+         *         changed.
+         */
+        bool poll(PB_SmartKnobState& state) {
+            if (feed_ == nullptr) {
+                return false;
+            }
+
+            KnobStateSnapshot snapshot;
+            uint32_t version = feed_->readState(snapshot);
+            if (version == state_version_) {
+                return false;
+            }
+
+            if (snapshot.config_generation != config_generation_) {
+                // Read into a temporary so that state keeps its old config if this one is dropped
+                PB_SmartKnobConfig config;
+                if (feed_->readConfig(config) != snapshot.config_generation) {
+                    // A newer config was published after this snapshot; the position belongs to
+                    // the old config, so wait for the next snapshot instead of mixing the two
+                    return false;
+                }
+                config_generation_ = snapshot.config_generation;
+                state.config = config;
+                state.has_config = true;
+            }
+
+            state_version_ = version;
+            state.current_position = snapshot.current_position;
+            state.sub_position_unit = snapshot.sub_position_unit;
+            return true;
+        }
+
+        uint32_t configGeneration() const { return config_generation_; }
+
+    private:
+        // Sequence numbers of a SeqLock are always even, so this never matches a published config
+        static const uint32_t NO_GENERATION = 1;
+
+        const KnobStateFeed* feed_ = nullptr;
+        uint32_t state_version_ = 0;
+        uint32_t config_generation_ = NO_GENERATION;
+};
@@ -14,9 +14,9 @@ Configuration config;
 #define INTERFACE_TASK_CORE    0
 
 // Note that ESP-IDF specifies the stack size in bytes, not words
-#define DISPLAY_TASK_STACK_DEPTH      5200
-#define MOTOR_TASK_STACK_DEPTH        4500
-#define INTERFACE_TASK_STACK_DEPTH    4800
+#define DISPLAY_TASK_STACK_DEPTH      5700
+#define MOTOR_TASK_STACK_DEPTH        5300
+#define INTERFACE_TASK_STACK_DEPTH    6100
 #define CONNECTIVITY_TASK_STACK_DEPTH 4500
 
 /*
@@ -47,6 +47,22 @@ Configuration config;
     motor:         476 free -> (4500- 476) = 4024 used
     interface:     588 free -> (4800- 588) = 4212 used
     connectivity: 1008 free -> (4500-1008) = 3492 used
+
+    Not re-measured since: display, motor and interface were raised by 512 bytes when detent_torque_profile
+    grew PB_SmartKnobConfig, then motor by 300 and interface by 800 more when the detent index grew it
+    again, and are kept there until measured again. Stack-resident structs that changed since the 2025-05-21
+    measurement, by sizeof on the 32-bit target: PB_SmartKnobConfig 316 -> 780, PB_SmartKnobState
+    332 -> 800, PB_PersistentConfiguration 36 -> 604, and the new PB_CoggingCalibration (520). On each
+    task's deepest path, against the measurement:
+    display:      run() no longer keeps a state on its stack (-332); KnobStateReader::poll() holds a
+                  config (780) while polling, not while LVGL renders
+    motor:        run() no longer keeps a config and a command (-636); the persistent configuration and
+                  the cogging calibration being saved are members, not on the stack
+    interface:    run() no longer keeps a state (-332); handleState() -> ConfigChange holds 800 + 784,
+                  against 332 + 320 in run() and 332 + 316 + 320 below it when measured (+516)
+    To re-measure, log the high water marks (logStackAndHeapUsage()) after a cogging calibration and a
+    burst of config changes (scrolling quickly through the pages), and record them above. Only the
+    interface task checks for low stacks (monitorStackAndHeapUsage(), under 512 bytes free).
 */
 
 #if SK_DISPLAY
@@ -65,8 +81,9 @@ void setup() {
     display_task.setLogger(&interface_task);
     display_task.begin();
 
-    // Connect display to motor_task's knob state feed
-    motor_task.registerStateListener(display_task.getKnobStateQueue());
+    // Connect display to motor_task's knob state feed, waking it on every publish
+    display_task.setKnobStateFeed(motor_task.knobStateFeed());
+    motor_task.setKnobStateListener(display_task.getHandle());
     #endif // SK_DISPLAY
     
     config.setLogger(&interface_task);
@@ -1,8 +1,9 @@
 #pragma once
+#include <SPI.h>
 #include <sensors/MagneticSensorSPI.h>
 
 /** Configured fro 12bit MA710 and MAQ430 magnetic sensor over SPI interface*/
-MagneticSensorSPIConfig_s MAQ430_SPI = {
+static const MagneticSensorSPIConfig_s MAQ430_SPI = {
   .spi_mode = SPI_MODE3,
   .clock_speed = 1000000,
   .bit_resolution = 12,
@@ -11,3 +12,29 @@ MagneticSensorSPIConfig_s MAQ430_SPI = {
   .command_rw_bit = 0,  // not required
   .command_parity_bit = 17 // parity not implemented
 };
+
+/** AngleSource backend (angle_source.h) for the MAQ430, through SimpleFOC's MagneticSensorSPI */
+class MAQ430Sensor {
+    public:
+        MAQ430Sensor(int cs) : sensor_(MAQ430_SPI, cs) {}
+
+        void init() {
+            SPIClass* spi = new SPIClass(HSPI);
+            spi->begin(PIN_MAQ_SCK, PIN_MAQ_MISO, PIN_MAQ_MOSI, PIN_MAQ_SS);
+            sensor_.init(spi);
+        }
+
+        // Shaft angle in radians, in the range 0 to 2PI
+        float read() {
+            last_update_ = micros();
+            return sensor_.getSensorAngle();
+        }
+        // micros() of the latest reading
+        uint32_t sampleMicros() const { return last_update_; }
+
+        bool takeError(char*, size_t) { return false; }
+
+    private:
+        MagneticSensorSPI sensor_;
+        uint32_t last_update_ = 0;
+};
@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cmath>
+
+#include "cogging_calibration.h"
+
+static const float TWO_PI = 2 * M_PI;
+
+// Time to hold the starting angle, for the position controller to settle
+static const uint32_t SETTLE_MICROS = 300 * 1000;
+// Setpoint speed of the sweeps. Slow enough that the rotor is effectively at rest (inertia and
+// damping torques are negligible) while still taking only seconds per revolution.
+static const float SWEEP_RAD_PER_SEC = 1;
+// Each sweep starts with this much extra travel (not sampled), so the rotor has settled into the sweep
+static const float SWEEP_MARGIN_RAD = 0.3;
+// Stiffness and damping of the position controller, in motor torque units. Stiff enough to hold
+// the rotor on the falling slopes of the cogging torque instead of letting it snap to the next detent.
+static const float POSITION_P = 10;
+static const float POSITION_D = 0.05;
+// The rotor is considered to have slipped (or be blocked/touched) if it is this far from the setpoint
+static const float MAX_TRACKING_ERROR_RAD = 0.2;
+// Number of forward/reverse sweep pairs. Each pass after the first measures with the previous map as feedforward.
+static const uint8_t PASSES = 2;
+// Map samples without a measurement in both directions are interpolated, unless there are more than this many
+static const uint16_t MAX_MISSING_SAMPLES = CoggingMap::SIZE / 4;
+// The last pass may change the map by at most this fraction (rms), or the measurement is rejected
+static const float MAX_MAP_CHANGE = 0.5;
+// A longer gap between updates (e.g. a stalled loop) doesn't advance the setpoint any further than this
+static const float MAX_STEP_SECONDS = 0.01;
+
+// Share of the total measurement time spent settling, for progress reporting (the rest is split evenly between the sweeps)
+static const float SETTLE_PROGRESS = 0.02;
+
+// Nearest map sample, so the torques accumulated for sample i are centered on its angle
+static uint16_t sampleIndex(float mechanical_angle) {
+    int32_t i = lroundf(mechanical_angle * (CoggingMap::SIZE / TWO_PI));
+    return std::clamp<int32_t>(i, 0, CoggingMap::SIZE) % CoggingMap::SIZE;
+}
+
+void CoggingMap::set(const float* torque) {
+    for (uint16_t i = 0; i < SIZE; i++) {
+        table_[i] = torque[i];
+    }
+    table_[SIZE] = table_[0];
+    enabled_ = true;
+}
+
+void CoggingMap::set(const int8_t* samples, uint16_t count, float scale) {
+    if (count != SIZE) {
+        clear();
+        return;
+    }
+    for (uint16_t i = 0; i < SIZE; i++) {
+        table_[i] = samples[i] * scale;
+    }
+    table_[SIZE] = table_[0];
+    enabled_ = true;
+}
+
+float CoggingMap::maxTorque() const {
+    if (!enabled_) {
+        return 0;
+    }
+    float max_torque = 0;
+    for (uint16_t i = 0; i < SIZE; i++) {
+        max_torque = fmaxf(max_torque, fabsf(table_[i]));
+    }
+    return max_torque;
+}
+
+float CoggingMap::quantize(int8_t* samples) const {
+    float max_torque = maxTorque();
+    float scale = max_torque > 0 ? max_torque / 127 : 1;
+    for (uint16_t i = 0; i < SIZE; i++) {
+        samples[i] = enabled_ ? (int8_t)lroundf(table_[i] / scale) : 0;
+    }
+    return scale;
+}
+
+void CoggingCalibration::start(float max_torque, float shaft_angle, uint32_t now_micros) {
+    phase_ = Phase::SETTLE;
+    status_ = Status::RUNNING;
+    max_torque_ = max_torque;
+    pass_ = 0;
+    last_micros_ = now_micros;
+    phase_start_micros_ = now_micros;
+    setpoint_ = shaft_angle;
+    start_angle_ = shaft_angle;
+    end_angle_ = shaft_angle + TWO_PI + 2 * SWEEP_MARGIN_RAD;
+    map_.clear();
+    beginPass();
+}
+
+void CoggingCalibration::cancel() {
+    if (running()) {
+        finish(Status::CANCELLED);
+    }
+}
+
+float CoggingCalibration::update(float shaft_angle, float shaft_velocity, float mechanical_angle, uint32_t now_micros) {
+    if (!running()) {
+        return 0;
+    }
+
+    float dt = std::min((now_micros - last_micros_) * 1e-6f, MAX_STEP_SECONDS);
+    last_micros_ = now_micros;
+
+    float error = setpoint_ - shaft_angle;
+    if (fabsf(error) > MAX_TRACKING_ERROR_RAD) {
+        finish(Status::SLIPPED);
+        return 0;
+    }
+
+    float setpoint_velocity = 0;
+    switch (phase_) {
+        case Phase::SWEEP_FORWARD:
+            setpoint_velocity = SWEEP_RAD_PER_SEC;
+            break;
+        case Phase::SWEEP_REVERSE:
+            setpoint_velocity = -SWEEP_RAD_PER_SEC;
+            break;
+        default:
+            break;
+    }
+    float torque = POSITION_P * error + POSITION_D * (setpoint_velocity - shaft_velocity) + map_.torque(mechanical_angle);
+    torque = std::clamp(torque, -max_torque_, max_torque_);
+
+    switch (phase_) {
+        case Phase::SETTLE:
+            if (now_micros - phase_start_micros_ >= SETTLE_MICROS) {
+                phase_ = Phase::SWEEP_FORWARD;
+                phase_start_micros_ = now_micros;
+            }
+            break;
+        case Phase::SWEEP_FORWARD:
+            if (setpoint_ - start_angle_ >= SWEEP_MARGIN_RAD) {
+                accumulate(0, mechanical_angle, torque);
+            }
+            setpoint_ += SWEEP_RAD_PER_SEC * dt;
+            if (setpoint_ >= end_angle_) {
+                phase_ = Phase::SWEEP_REVERSE;
+                phase_start_micros_ = now_micros;
+            }
+            break;
+        case Phase::SWEEP_REVERSE:
+            if (end_angle_ - setpoint_ >= SWEEP_MARGIN_RAD) {
+                accumulate(1, mechanical_angle, torque);
+            }
+            setpoint_ -= SWEEP_RAD_PER_SEC * dt;
+            if (setpoint_ <= start_angle_) {
+                Status status = updateMap();
+                if (status != Status::SUCCEEDED || ++pass_ == PASSES) {
+                    finish(status);
+                    return 0;
+                }
+                beginPass();
+                phase_ = Phase::SWEEP_FORWARD;
+                phase_start_micros_ = now_micros;
+            }
+            break;
+        case Phase::IDLE:
+            break;
+    }
+    return torque;
+}
+
+float CoggingCalibration::progress() const {
+    if (status_ == Status::SUCCEEDED) {
+        return 1;
+    }
+    float sweep = std::clamp((setpoint_ - start_angle_) / (end_angle_ - start_angle_), 0.0f, 1.0f);
+    float sweep_progress = (1 - SETTLE_PROGRESS) / (2 * PASSES);
+    float pass_progress = SETTLE_PROGRESS + 2 * pass_ * sweep_progress;
+    switch (phase_) {
+        case Phase::SETTLE:
+            return SETTLE_PROGRESS * std::min((last_micros_ - phase_start_micros_) / (float)SETTLE_MICROS, 1.0f);
+        case Phase::SWEEP_FORWARD:
+            return pass_progress + sweep_progress * sweep;
+        case Phase::SWEEP_REVERSE:
+            return pass_progress + sweep_progress * (2 - sweep);
+        case Phase::IDLE:
+            break;
+    }
+    return 0;
+}
+
+void CoggingCalibration::beginPass() {
+    std::fill(&sum_[0][0], &sum_[0][0] + 2 * CoggingMap::SIZE, 0.0f);
+    std::fill(&count_[0][0], &count_[0][0] + 2 * CoggingMap::SIZE, 0);
+}
+
+void CoggingCalibration::accumulate(uint8_t direction, float mechanical_angle, float torque) {
+    uint16_t i = sampleIndex(mechanical_angle);
+    sum_[direction][i] += torque;
+    if (count_[direction][i] < UINT16_MAX) {
+        count_[direction][i]++;
+    }
+}
+
+CoggingCalibration::Status CoggingCalibration::updateMap() {
+    // The accumulated torques include the feedforward, so they are the full holding torque.
+    // Average both directions in place, marking samples that are missing a direction with a zero count
+    float* map = sum_[0];
+    uint16_t missing = 0;
+    for (uint16_t i = 0; i < CoggingMap::SIZE; i++) {
+        if (count_[0][i] == 0 || count_[1][i] == 0) {
+            count_[0][i] = 0;
+            missing++;
+            continue;
+        }
+        map[i] = (sum_[0][i] / count_[0][i] + sum_[1][i] / count_[1][i]) / 2;
+    }
+    if (missing > MAX_MISSING_SAMPLES) {
+        return Status::SLIPPED;
+    }
+
+    // Fill samples the rotor skipped over (e.g. where it snapped past a steep cogging slope) from their neighbours
+    for (uint16_t i = 0; i < CoggingMap::SIZE && missing > 0; i++) {
+        if (count_[0][i] != 0) {
+            continue;
+        }
+        uint16_t before = 1;
+        while (count_[0][(i + CoggingMap::SIZE - before) % CoggingMap::SIZE] == 0) {
+            before++;
+        }
+        uint16_t after = 1;
+        while (count_[0][(i + after) % CoggingMap::SIZE] == 0) {
+            after++;
+        }
+        float previous = map[(i + CoggingMap::SIZE - before) % CoggingMap::SIZE];
+        float next = map[(i + after) % CoggingMap::SIZE];
+        map[i] = previous + (next - previous) * before / (before + after);
+    }
+
+    // Cogging averages to zero over a revolution; any constant torque left (e.g. a cable pulling on the
+    // knob) shouldn't be applied as feedforward
+    float mean = 0;
+    for (uint16_t i = 0; i < CoggingMap::SIZE; i++) {
+        mean += map[i];
+    }
+    mean /= CoggingMap::SIZE;
+    for (uint16_t i = 0; i < CoggingMap::SIZE; i++) {
+        map[i] -= mean;
+    }
+
+    // With the previous map applied as feedforward, the rotor should have followed the setpoint smoothly
+    // and the map barely changed. If it didn't, the rotor was jerked around by cogging too strong to
+    // hold, and the map can't be trusted.
+    if (map_.enabled()) {
+        float change_squares = 0;
+        float map_squares = 0;
+        for (uint16_t i = 0; i < CoggingMap::SIZE; i++) {
+            float change = map[i] - map_.torque(i / (CoggingMap::SIZE / TWO_PI));
+            change_squares += change * change;
+            map_squares += map[i] * map[i];
+        }
+        if (change_squares > MAX_MAP_CHANGE * MAX_MAP_CHANGE * map_squares) {
+            return Status::SLIPPED;
+        }
+    }
+    map_.set(map);
+    return Status::SUCCEEDED;
+}
+
+void CoggingCalibration::finish(Status status) {
+    status_ = status;
+    phase_ = Phase::IDLE;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+
+#include "motor_calibration.h"
+
+/**
+ * @brief Cogging torque of the motor over one mechanical revolution, added to the motor torque as feedforward.
+ *
+ * Samples are evenly spaced over the raw sensor angle, in units of motor torque (the torque that
+ * holds the rotor against cogging at that angle), and linearly interpolated, so a lookup is cheap
+ * enough for every haptic loop iteration.
+ */
+class CoggingMap {
+    public:
+        // Must match the max_size of CoggingCalibration.torque in smartknob.proto. Fine enough for
+        // several samples per cogging period of a typical 12 slot/14 pole gimbal motor (84 periods per revolution).
+        static const uint16_t SIZE = 512;
+
+        // Set from SIZE samples
+        void set(const float* torque);
+        // Set from stored samples (see CoggingCalibration in smartknob.proto). Clears the map unless count == SIZE.
+        void set(const int8_t* samples, uint16_t count, float scale);
+        void clear() { enabled_ = false; }
+        bool enabled() const { return enabled_; }
+
+        // Feedforward torque at a raw sensor angle in [0, 2PI). Zero if no map is set.
+        float torque(float mechanical_angle) const {
+            if (!enabled_) {
+                return 0;
+            }
+            float x = mechanical_angle * TABLE_SCALE;
+            int32_t i = (int32_t)x;
+            if (i >= SIZE) {
+                i = SIZE - 1;
+            } else if (i < 0) {
+                i = 0;
+            }
+            float fraction = x - i;
+            return table_[i] + (table_[i + 1] - table_[i]) * fraction;
+        }
+
+        // Largest absolute torque in the map
+        float maxTorque() const;
+
+        // Quantize the SIZE samples to int8 for storage, returning the scale to restore them with
+        float quantize(int8_t* samples) const;
+
+    private:
+        static constexpr float TWO_PI = 6.28318530717958647692f;
+        static constexpr float TABLE_SCALE = SIZE / TWO_PI;
+
+        // Plus a copy of the first sample, so interpolation never has to wrap
+        float table_[SIZE + 1];
+        bool enabled_ = false;
+};
+
+/**
+ * @brief Cogging torque measurement as a state machine, stepped once per motor loop iteration.
+ *
+ * Holds the rotor with a stiff position controller whose setpoint sweeps slowly through one
+ * mechanical revolution forward and then back. The rotor is (nearly) at rest at every point of
+ * the sweep, so the applied torque is the holding torque against cogging plus friction. Friction
+ * opposes the motion and flips sign between the two sweeps, so it cancels out when the torque
+ * samples of both sweeps are averaged per CoggingMap sample.
+ *
+ * Where the cogging torque is steeper than the position controller is stiff, the rotor jerks
+ * through instead of being held, which blurs the measurement. So the sweeps are repeated with the
+ * map measured so far applied as feedforward: the controller then only has to hold the rotor
+ * against what is left of the cogging, and the rotor follows the setpoint smoothly.
+ *
+ * Needs a valid motor calibration, since it drives the motor in closed loop (torque mode). The
+ * feedforward from any existing CoggingMap must not be applied while it runs.
+ *
+ * Hardware-free, like MotorCalibration, and reports the same statuses. software/tools/cogging_ripple_sim
+ * runs it on a simulated motor and measures the ripple left with the map it finds.
+ */
+class CoggingCalibration {
+    public:
+        enum class Phase : uint8_t {
+            IDLE = 0,
+            SETTLE,
+            SWEEP_FORWARD,
+            SWEEP_REVERSE,
+        };
+
+        using Status = MotorCalibration::Status;
+
+        // Begin a measurement at the current shaft angle, limiting the controller torque to max_torque
+        void start(float max_torque, float shaft_angle, uint32_t now_micros);
+        void cancel();
+
+        /**
+         * @brief Advance the measurement by one loop iteration.
+         *
+         * @param shaft_angle Unwrapped shaft angle, increasing with positive motor torque
+         * @param shaft_velocity Shaft velocity, in the same direction
+         * @param mechanical_angle Raw sensor angle, [0, 2PI), the CoggingMap is indexed by
+         * @return Motor torque to apply until the next call. Zero once the measurement has ended.
+         */
+        float update(float shaft_angle, float shaft_velocity, float mechanical_angle, uint32_t now_micros);
+
+        bool running() const { return status_ == Status::RUNNING; }
+        Phase phase() const { return phase_; }
+        Status status() const { return status_; }
+        // Fraction of the measurement completed, [0, 1]
+        float progress() const;
+        // Measured map. Only valid once status() is SUCCEEDED.
+        const CoggingMap& map() const { return map_; }
+
+    private:
+        Phase phase_ = Phase::IDLE;
+        Status status_ = Status::NONE;
+
+        float max_torque_ = 0;
+        uint8_t pass_ = 0;
+        uint32_t last_micros_ = 0;
+        uint32_t phase_start_micros_ = 0;
+
+        // Position controller setpoint, and the angles the sweeps start from and turn around at
+        float setpoint_ = 0;
+        float start_angle_ = 0;
+        float end_angle_ = 0;
+
+        // Torque sums and sample counts per map sample, for each sweep direction of the current pass
+        float sum_[2][CoggingMap::SIZE];
+        uint16_t count_[2][CoggingMap::SIZE];
+        // Map from the previous passes, applied as feedforward
+        CoggingMap map_;
+
+        void beginPass();
+        void accumulate(uint8_t direction, float mechanical_angle, float torque);
+        Status updateMap();
+        void finish(Status status);
+};
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+
+#include "motor_calibration.h"
+
+static const float TWO_PI = 2 * M_PI;
+
+// Time to hold electrical angle 0 at the start, for the rotor to settle into alignment
+static const uint32_t ALIGN_MICROS = 300 * 1000;
+// Speed of all sweeps, in electrical revolutions per second
+static const float SWEEP_REVOLUTIONS_PER_SEC = 3;
+// Length of the pole pair sweep. Must cover a good part of a mechanical revolution even at MAX_POLE_PAIRS.
+static const float POLE_PAIR_SWEEP_REVOLUTIONS = 8;
+// Samples from the start of each sweep, while the rotor gets up to speed, are ignored
+static const float SETTLE_REVOLUTIONS = 0.5;
+// A longer gap between updates (e.g. a stalled loop) doesn't advance the commanded angle any further than this
+static const float MAX_STEP_SECONDS = 0.01;
+// Measured pole pairs must be this close to an integer
+static const float MAX_POLE_PAIR_ERROR = 0.25;
+// The rotor is considered to have slipped if it deviates from a smooth sweep by this much (rms, electrical radians)
+static const float MAX_SWEEP_RESIDUAL_ELECTRICAL_RAD = M_PI / 2;
+
+// Share of the total calibration time spent in each phase, for progress reporting
+static const float ALIGN_PROGRESS = 0.05;
+static const float POLE_PAIRS_PROGRESS = 0.35;
+static const float OFFSET_REVERSE_PROGRESS = 0.3;
+
+static float normalizeAngle(float angle) {
+    angle = fmodf(angle, TWO_PI);
+    return angle < 0 ? angle + TWO_PI : angle;
+}
+
+void LineFit::clear() {
+    *this = LineFit();
+}
+
+void LineFit::add(float x, float y) {
+    if (count_ == 0) {
+        x0_ = x;
+        y0_ = y;
+    }
+    double dx = x - x0_;
+    double dy = y - y0_;
+    count_++;
+    sum_x_ += dx;
+    sum_y_ += dy;
+    sum_xx_ += dx * dx;
+    sum_xy_ += dx * dy;
+    sum_yy_ += dy * dy;
+}
+
+float LineFit::slope() const {
+    double var_x = sum_xx_ - sum_x_ * sum_x_ / count_;
+    if (count_ < 2 || var_x <= 0) {
+        return 0;
+    }
+    return (sum_xy_ - sum_x_ * sum_y_ / count_) / var_x;
+}
+
+float LineFit::rmsResidual() const {
+    if (count_ < 2) {
+        return 0;
+    }
+    double var_x = sum_xx_ - sum_x_ * sum_x_ / count_;
+    double var_y = sum_yy_ - sum_y_ * sum_y_ / count_;
+    double cov = sum_xy_ - sum_x_ * sum_y_ / count_;
+    double residual_squares = var_x > 0 ? var_y - cov * cov / var_x : var_y;
+    return sqrt(std::max(residual_squares, 0.0) / count_);
+}
+
+MotorCalibration::Status MotorCalibration::estimatePolePairs(const LineFit& fit, bool& direction_cw, uint8_t& pole_pairs) {
+    // The slope is mechanical radians per commanded electrical radian, i.e. +-1/pole_pairs
+    float slope = fit.slope();
+    if (fabsf(slope) < 0.5f / MAX_POLE_PAIRS) {
+        return Status::NO_MOVEMENT;
+    }
+    float measured_pole_pairs = 1 / fabsf(slope);
+    if (fit.rmsResidual() * measured_pole_pairs > MAX_SWEEP_RESIDUAL_ELECTRICAL_RAD) {
+        return Status::SLIPPED;
+    }
+    float rounded = roundf(measured_pole_pairs);
+    if (rounded < MIN_POLE_PAIRS || rounded > MAX_POLE_PAIRS || fabsf(measured_pole_pairs - rounded) > MAX_POLE_PAIR_ERROR) {
+        return Status::BAD_POLE_PAIRS;
+    }
+    direction_cw = slope > 0;
+    pole_pairs = (uint8_t)rounded;
+    return Status::SUCCEEDED;
+}
+
+float MotorCalibration::zeroElectricalOffset(float offset_x, float offset_y) {
+    // The open loop drive puts the rotor a quarter electrical revolution ahead of the commanded
+    // angle, so the rotor's electrical zero is 3PI/2 past the average offset between measured and
+    // commanded electrical angle
+    return normalizeAngle(atan2f(offset_y, offset_x) + 3 * M_PI / 2);
+}
+
+void MotorCalibration::start(float voltage, float mechanical_angle, uint32_t now_micros) {
+    *this = MotorCalibration();
+    voltage_ = voltage;
+    status_ = Status::RUNNING;
+    phase_ = Phase::ALIGN;
+    last_micros_ = now_micros;
+    phase_start_micros_ = now_micros;
+    last_mechanical_angle_ = mechanical_angle;
+}
+
+void MotorCalibration::cancel() {
+    if (running()) {
+        finish(Status::CANCELLED);
+    }
+}
+
+CalibrationDrive MotorCalibration::update(float mechanical_angle, uint32_t now_micros) {
+    if (!running()) {
+        return {0, 0};
+    }
+
+    float dt = std::min((now_micros - last_micros_) * 1e-6f, MAX_STEP_SECONDS);
+    last_micros_ = now_micros;
+
+    float delta = mechanical_angle - last_mechanical_angle_;
+    if (delta > M_PI) {
+        delta -= TWO_PI;
+    } else if (delta < -M_PI) {
+        delta += TWO_PI;
+    }
+    unwrapped_mechanical_angle_ += delta;
+    last_mechanical_angle_ = mechanical_angle;
+
+    // The sensor reading reflects the drive applied since the previous update, so samples are paired with
+    // the commanded angle before it is advanced
+    bool settled = fabsf(electrical_angle_ - sweep_start_) >= SETTLE_REVOLUTIONS * TWO_PI;
+    float step = SWEEP_REVOLUTIONS_PER_SEC * TWO_PI * dt;
+
+    switch (phase_) {
+        case Phase::ALIGN:
+            if (now_micros - phase_start_micros_ >= ALIGN_MICROS) {
+                beginSweep(Phase::MEASURE_POLE_PAIRS, POLE_PAIR_SWEEP_REVOLUTIONS);
+            }
+            break;
+        case Phase::MEASURE_POLE_PAIRS:
+            if (settled) {
+                pole_pair_fit_.add(electrical_angle_, unwrapped_mechanical_angle_);
+            }
+            electrical_angle_ += step;
+            if (electrical_angle_ >= sweep_end_) {
+                Status status = estimatePolePairs(pole_pair_fit_, result_.direction_cw, result_.pole_pairs);
+                if (status != Status::SUCCEEDED) {
+                    finish(status);
+                    break;
+                }
+                beginSweep(Phase::MEASURE_OFFSET_REVERSE, -result_.pole_pairs);
+            }
+            break;
+        case Phase::MEASURE_OFFSET_REVERSE:
+            if (settled) {
+                accumulateOffset(mechanical_angle);
+            }
+            electrical_angle_ -= step;
+            if (electrical_angle_ <= sweep_end_) {
+                beginSweep(Phase::MEASURE_OFFSET_FORWARD, result_.pole_pairs);
+            }
+            break;
+        case Phase::MEASURE_OFFSET_FORWARD:
+            if (settled) {
+                accumulateOffset(mechanical_angle);
+            }
+            electrical_angle_ += step;
+            if (electrical_angle_ >= sweep_end_) {
+                result_.zero_electrical_offset = zeroElectricalOffset(offset_x_, offset_y_);
+                sensor_fit_.solve(result_.sensor_error_cos, result_.sensor_error_sin);
+                finish(Status::SUCCEEDED);
+            }
+            break;
+        case Phase::IDLE:
+            break;
+    }
+
+    if (!running()) {
+        return {0, 0};
+    }
+    return {voltage_, normalizeAngle(electrical_angle_)};
+}
+
+float MotorCalibration::progress() const {
+    if (status_ == Status::SUCCEEDED) {
+        return 1;
+    }
+    float sweep = sweep_end_ == sweep_start_ ? 0 : (electrical_angle_ - sweep_start_) / (sweep_end_ - sweep_start_);
+    sweep = std::clamp(sweep, 0.0f, 1.0f);
+    switch (phase_) {
+        case Phase::ALIGN:
+            return ALIGN_PROGRESS * std::min((last_micros_ - phase_start_micros_) / (float)ALIGN_MICROS, 1.0f);
+        case Phase::MEASURE_POLE_PAIRS:
+            return ALIGN_PROGRESS + POLE_PAIRS_PROGRESS * sweep;
+        case Phase::MEASURE_OFFSET_REVERSE:
+            return ALIGN_PROGRESS + POLE_PAIRS_PROGRESS + OFFSET_REVERSE_PROGRESS * sweep;
+        case Phase::MEASURE_OFFSET_FORWARD:
+            return ALIGN_PROGRESS + POLE_PAIRS_PROGRESS + OFFSET_REVERSE_PROGRESS
+                + (1 - ALIGN_PROGRESS - POLE_PAIRS_PROGRESS - OFFSET_REVERSE_PROGRESS) * sweep;
+        case Phase::IDLE:
+            break;
+    }
+    return 0;
+}
+
+void MotorCalibration::beginSweep(Phase phase, float electrical_revolutions) {
+    float direction = electrical_revolutions < 0 ? -1 : 1;
+    phase_ = phase;
+    phase_start_micros_ = last_micros_;
+    sweep_start_ = electrical_angle_;
+    sweep_end_ = electrical_angle_ + direction * (SETTLE_REVOLUTIONS + fabsf(electrical_revolutions)) * TWO_PI;
+}
+
+void MotorCalibration::accumulateOffset(float mechanical_angle) {
+    float direction = result_.direction_cw ? 1 : -1;
+    float measured_electrical_angle = direction * result_.pole_pairs * mechanical_angle;
+    float offset = measured_electrical_angle - electrical_angle_;
+    offset_x_ += cosf(offset);
+    offset_y_ += sinf(offset);
+
+    // Apart from a constant lag, the rotor follows the commanded angle exactly, so any variation of the
+    // offset is sensor error (converted to mechanical radians, in the sensor's direction)
+    if (sensor_fit_.count() == 0) {
+        offset_reference_ = offset;
+    }
+    float deviation = remainderf(offset - offset_reference_, TWO_PI);
+    sensor_fit_.add(mechanical_angle, direction * deviation / result_.pole_pairs);
+}
+
+void MotorCalibration::finish(Status status) {
+    status_ = status;
+    phase_ = Phase::IDLE;
+}
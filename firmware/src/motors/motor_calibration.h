@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sensor_correction.h"
+
+/**
+ * @brief Drive to apply to the motor for one loop iteration of a calibration.
+ *
+ * The voltage vector is applied in open loop, i.e. as setPhaseVoltage(voltage, 0, electrical_angle)
+ * with the FOC loop itself disabled.
+ */
+struct CalibrationDrive {
+    float voltage;
+    float electrical_angle; // radians, [0, 2PI)
+};
+
+/**
+ * @brief Outcome of a successful calibration, in SimpleFOC terms.
+ */
+struct MotorCalibrationResult {
+    bool direction_cw;            // Sensor angle increases for positive electrical rotation
+    uint8_t pole_pairs;
+    float zero_electrical_offset; // radians, [0, 2PI)
+    // Sensor angle error harmonics (see SensorCorrection)
+    float sensor_error_cos[SensorCorrection::MAX_HARMONICS];
+    float sensor_error_sin[SensorCorrection::MAX_HARMONICS];
+};
+
+/**
+ * @brief Simple least squares line fit, accumulated one sample at a time.
+ *
+ * Samples are accumulated relative to the first one, in double precision, so long sweeps don't
+ * lose precision to large absolute angles.
+ */
+class LineFit {
+    public:
+        void clear();
+        void add(float x, float y);
+
+        uint32_t count() const { return count_; }
+        float slope() const;
+        // Root mean square distance of the samples from the fitted line, in units of y
+        float rmsResidual() const;
+
+    private:
+        uint32_t count_ = 0;
+        float x0_ = 0;
+        float y0_ = 0;
+        double sum_x_ = 0;
+        double sum_y_ = 0;
+        double sum_xx_ = 0;
+        double sum_xy_ = 0;
+        double sum_yy_ = 0;
+};
+
+/**
+ * @brief Motor/sensor calibration as a state machine, stepped once per motor loop iteration.
+ *
+ * Determines the sensor direction, pole pairs and electrical zero offset by driving the motor
+ * in open loop and observing the sensor:
+ *  1. Align: hold electrical angle 0 until the rotor has settled.
+ *  2. Pole pairs: sweep forward a fixed number of electrical revolutions at constant speed and
+ *     fit a line through (commanded electrical angle, measured mechanical angle). The slope
+ *     gives direction and pole pairs; the rotor's constant lag behind the commanded angle only
+ *     shifts the line, so it doesn't need to settle.
+ *  3./4. Offset: sweep one mechanical revolution backward, then forward again, accumulating the
+ *     difference between measured and commanded electrical angle at every sample. The rotor
+ *     lags by the same amount in both directions, so the lag cancels out in the average, and
+ *     covering a full revolution each way averages out sensor nonlinearity. The deviation of
+ *     each sample from that average is the sensor's angle error at that position, which is fit
+ *     with a SensorCorrection.
+ *
+ * The sensor must report raw angles (no SensorCorrection applied) during a calibration.
+ *
+ * The sweeps sample while moving instead of stopping and settling at each point, so a
+ * calibration takes seconds rather than minutes. Hardware-free (the caller reads the sensor and
+ * applies the drive), so the estimation can be checked against a simulated motor
+ * (software/tools/motor_calibration_check.cpp).
+ */
+class MotorCalibration {
+    public:
+        enum class Phase : uint8_t {
+            IDLE = 0,
+            ALIGN,
+            MEASURE_POLE_PAIRS,
+            MEASURE_OFFSET_REVERSE,
+            MEASURE_OFFSET_FORWARD,
+        };
+
+        enum class Status : uint8_t {
+            NONE = 0,       // Never started
+            RUNNING,
+            SUCCEEDED,
+            CANCELLED,
+            NO_MOVEMENT,    // The sensor didn't follow the motor (blocked rotor, or no magnet/sensor)
+            BAD_POLE_PAIRS, // Measured pole pairs outside [MIN_POLE_PAIRS, MAX_POLE_PAIRS]
+            SLIPPED,        // The rotor didn't follow the commanded angle smoothly (e.g. it was touched)
+        };
+
+        static const uint8_t MIN_POLE_PAIRS = 3;
+        static const uint8_t MAX_POLE_PAIRS = 12;
+
+        // Begin a calibration, driving with the given voltage
+        void start(float voltage, float mechanical_angle, uint32_t now_micros);
+        void cancel();
+
+        /**
+         * @brief Advance the calibration by one loop iteration.
+         *
+         * @param mechanical_angle Raw sensor angle, [0, 2PI), without any direction or offset applied
+         * @return Drive to apply until the next call. Zero voltage once the calibration has ended.
+         */
+        CalibrationDrive update(float mechanical_angle, uint32_t now_micros);
+
+        bool running() const { return status_ == Status::RUNNING; }
+        Phase phase() const { return phase_; }
+        Status status() const { return status_; }
+        // Fraction of the calibration completed, [0, 1]
+        float progress() const;
+        // Only valid once status() is SUCCEEDED
+        const MotorCalibrationResult& result() const { return result_; }
+
+        // Estimation math, exposed for testing
+        static Status estimatePolePairs(const LineFit& fit, bool& direction_cw, uint8_t& pole_pairs);
+        static float zeroElectricalOffset(float offset_x, float offset_y);
+
+    private:
+        Phase phase_ = Phase::IDLE;
+        Status status_ = Status::NONE;
+        MotorCalibrationResult result_ = {};
+
+        float voltage_ = 0;
+        uint32_t last_micros_ = 0;
+        uint32_t phase_start_micros_ = 0;
+
+        // Commanded electrical angle (unwrapped), and where the current sweep started/ends
+        float electrical_angle_ = 0;
+        float sweep_start_ = 0;
+        float sweep_end_ = 0;
+
+        // Sensor angle unwrapped since the start of the calibration
+        float last_mechanical_angle_ = 0;
+        float unwrapped_mechanical_angle_ = 0;
+
+        LineFit pole_pair_fit_;
+        float offset_x_ = 0;
+        float offset_y_ = 0;
+        float offset_reference_ = 0;
+        SensorCorrectionFit sensor_fit_;
+
+        void beginSweep(Phase phase, float electrical_revolutions);
+        void accumulateOffset(float mechanical_angle);
+        void finish(Status status);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mt6701_frame.h"
+
+/**
+ * @brief Smoothing of the MT6701 readings: an exponentially weighted moving average of the angle, in
+ * integer arithmetic on the counts.
+ *
+ * The angle is kept as a binary angle (a full turn is 2^32), so the difference between a reading and
+ * the average, taken as a signed 32-bit number, is the shortest step between them, across the wrap
+ * from 2PI to 0 included. Each reading moves the average ALPHA of the way along that step; the group
+ * delay is (1 - ALPHA) / ALPHA = 1.5 readings. The output is converted to radians once per reading and
+ * cached, so reading the angle costs nothing. It is converted from the average's top 22 bits (a count and
+ * 8 bits of it), which a float holds exactly: the whole binary angle would round to 2^32, so 2PI, within
+ * a few units of the wrap.
+ *
+ * This responds as the former average of the angle as a unit vector: the two differ by less than 2
+ * counts up to 20 turns/s at 2 kHz (see software/tools/mt6701_filter_check).
+ *
+ * Hardware-free, so the driver and host tools share the same filter.
+ */
+class MT6701Filter {
+    public:
+        static constexpr float ALPHA = 0.4;
+
+        void reset() { *this = MT6701Filter(); }
+
+        void add(uint16_t count) {
+            uint32_t reading = (uint32_t)count << COUNT_SHIFT;
+            if (!primed_) {
+                average_ = reading;
+                primed_ = true;
+            } else {
+                int32_t step = (int32_t)(reading - average_);
+                // ALPHA * step, by the high word of a 32x32 multiply
+                average_ += (int32_t)(((int64_t)step * ALPHA_Q32) >> 32);
+            }
+            // The driver's angle runs opposite to the counts
+            angle_ = (((uint32_t)-average_ >> FINE_SHIFT) & FINE_MASK) * RADIANS_PER_FINE;
+        }
+
+        // Filtered angle in [0, 2PI), in the sensor driver's direction (opposite to the counts)
+        float angle() const { return angle_; }
+
+    private:
+        // 14-bit counts to the top of the binary angle
+        static const uint8_t COUNT_SHIFT = 32 - 14;
+        static constexpr int64_t ALPHA_Q32 = (int64_t)(ALPHA * 4294967296.0);
+        // Fractions of a count kept in the output: 14 + 8 bits
+        static const uint8_t FINE_SHIFT = COUNT_SHIFT - 8;
+        static const uint32_t FINE_MASK = (1u << (32 - FINE_SHIFT)) - 1;
+        static constexpr float RADIANS_PER_FINE = 6.28318530717958647692f / (float)(1u << (32 - FINE_SHIFT));
+
+        bool primed_ = false;
+        uint32_t average_ = 0;
+        float angle_ = 0;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sensor_health.h"
+
+// Rate at which the MT6701 driver samples the sensor in the background (queued SPI transactions started by a
+// timer), independently of the motor loop. 0 reads the sensor synchronously from the motor loop instead, at
+// most every 100 us. Each sample goes through the driver's filter, so its response is set in samples at this rate.
+#ifndef SK_MT6701_SAMPLE_HZ
+    #define SK_MT6701_SAMPLE_HZ 2000
+#endif // SK_MT6701_SAMPLE_HZ
+
+/**
+ * @brief Raw 24-bit SSI frame of the MT6701, as read from the sensor, and its decoding.
+ *
+ * Frame layout, MSB first: 14-bit angle, loss of track, push button, 2-bit field status, CRC6 (polynomial
+ * x^6 + x + 1) over the 18 bits above it. A frame of all zeros or all ones is the data line stuck low or
+ * high (sensor unpowered or disconnected), not a reading. All ones fails the CRC, but all zeros passes it
+ * (the CRC of zero data is zero), and is also what the sensor sends at count 0 with nothing flagged: it is
+ * only taken as a reading right next to the previous valid one (see decode()).
+ *
+ * Hardware-free, so the driver and host tools share the same decoding.
+ */
+struct MT6701Frame {
+    // Frame in the low 24 bits
+    uint32_t bits;
+    // micros() when the transfer completed
+    uint32_t micros;
+};
+
+enum class MT6701FieldStatus : uint8_t {
+    NORMAL = 0,
+    TOO_STRONG = 1,
+    TOO_WEAK = 2,
+};
+
+struct MT6701Reading {
+    // Angle in 1/16384 turns
+    uint16_t count;
+    MT6701FieldStatus field_status;
+    bool push;
+    bool loss_of_track;
+    uint8_t received_crc;
+    uint8_t calculated_crc;
+    // The data line stuck low or high rather than a reading (see MT6701::decode())
+    bool stuck;
+
+    bool valid() const { return !stuck && received_crc == calculated_crc; }
+};
+
+namespace MT6701 {
+    static const uint16_t COUNTS_PER_TURN = 16384;
+    static const uint32_t FRAME_MASK = 0xFFFFFF;
+    // Distance from count 0, in counts, within which the previous valid reading makes an all-zero frame a reading
+    // of count 0: 1.4 degrees, more than the knob turns between two samples up to 5 turns/s at 2 kHz
+    static const uint16_t ZERO_FRAME_COUNTS = 64;
+    // No previous valid reading
+    static const int32_t NO_COUNT = -1;
+
+    static const uint8_t CRC6_TABLE[64] = {
+        0x00, 0x03, 0x06, 0x05, 0x0C, 0x0F, 0x0A, 0x09,
+        0x18, 0x1B, 0x1E, 0x1D, 0x14, 0x17, 0x12, 0x11,
+        0x30, 0x33, 0x36, 0x35, 0x3C, 0x3F, 0x3A, 0x39,
+        0x28, 0x2B, 0x2E, 0x2D, 0x24, 0x27, 0x22, 0x21,
+        0x23, 0x20, 0x25, 0x26, 0x2F, 0x2C, 0x29, 0x2A,
+        0x3B, 0x38, 0x3D, 0x3E, 0x37, 0x34, 0x31, 0x32,
+        0x13, 0x10, 0x15, 0x16, 0x1F, 0x1C, 0x19, 0x1A,
+        0x0B, 0x08, 0x0D, 0x0E, 0x07, 0x04, 0x01, 0x02
+    };
+
+    // CRC6 of the 18 data bits of a frame (right aligned), six bits at a time
+    inline uint8_t crc6(uint32_t data) {
+        uint8_t index = CRC6_TABLE[(data >> 12) & 0x3F];
+        index = ((data >> 6) & 0x3F) ^ index;
+        index = CRC6_TABLE[index];
+        index = (data & 0x3F) ^ index;
+        return CRC6_TABLE[index];
+    }
+
+    /**
+     * @brief Decode a frame.
+     *
+     * @param last_count Count of the previous valid reading, or NO_COUNT if there was none. An all-ones frame is
+     *   stuck; so is an all-zero frame, unless last_count is within ZERO_FRAME_COUNTS of 0. A line stuck low
+     *   while the knob rests at 0 reads as the knob staying there, which it can't be told from.
+     */
+    inline MT6701Reading decode(uint32_t bits, int32_t last_count = NO_COUNT) {
+        uint32_t frame = bits & FRAME_MASK;
+        bool near_zero = last_count != NO_COUNT && (last_count <= ZERO_FRAME_COUNTS || last_count >= COUNTS_PER_TURN - ZERO_FRAME_COUNTS);
+        return MT6701Reading {
+            .count = (uint16_t)((bits >> 10) & 0x3FFF),
+            .field_status = (MT6701FieldStatus)((bits >> 6) & 0x3),
+            .push = ((bits >> 8) & 0x1) != 0,
+            .loss_of_track = ((bits >> 9) & 0x1) != 0,
+            .received_crc = (uint8_t)(bits & 0x3F),
+            .calculated_crc = crc6((bits >> 6) & 0x3FFFF),
+            .stuck = frame == FRAME_MASK || (frame == 0 && !near_zero),
+        };
+    }
+
+    // What a reading flags, for the sensor's health accounting
+    inline uint8_t healthFlags(const MT6701Reading& reading) {
+        if (reading.stuck) {
+            return SensorHealth::STUCK_FRAME;
+        }
+        if (!reading.valid()) {
+            return SensorHealth::CRC_ERROR;
+        }
+        return (reading.field_status == MT6701FieldStatus::TOO_STRONG ? SensorHealth::FIELD_TOO_STRONG : 0)
+            | (reading.field_status == MT6701FieldStatus::TOO_WEAK ? SensorHealth::FIELD_TOO_WEAK : 0)
+            | (reading.loss_of_track ? SensorHealth::LOSS_OF_TRACK : 0);
+    }
+
+    // Frame the sensor would send for a reading (ignoring its CRC fields), for synthetic streams
+    inline uint32_t encode(uint16_t count, MT6701FieldStatus field_status = MT6701FieldStatus::NORMAL, bool push = false, bool loss_of_track = false) {
+        uint32_t data = ((uint32_t)(count & 0x3FFF) << 4) | ((uint32_t)loss_of_track << 3) | ((uint32_t)push << 2) | ((uint8_t)field_status & 0x3);
+        return (data << 6) | crc6(data);
+    }
+}
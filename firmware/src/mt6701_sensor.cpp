@@ -1,39 +1,6 @@
 #include "mt6701_sensor.h"
 #include "driver/spi_master.h"
 
-static const float ALPHA = 0.4;
-
-
-static uint8_t tableCRC6[64] = {
- 0x00, 0x03, 0x06, 0x05, 0x0C, 0x0F, 0x0A, 0x09,
- 0x18, 0x1B, 0x1E, 0x1D, 0x14, 0x17, 0x12, 0x11,
- 0x30, 0x33, 0x36, 0x35, 0x3C, 0x3F, 0x3A, 0x39,
- 0x28, 0x2B, 0x2E, 0x2D, 0x24, 0x27, 0x22, 0x21,
- 0x23, 0x20, 0x25, 0x26, 0x2F, 0x2C, 0x29, 0x2A,
- 0x3B, 0x38, 0x3D, 0x3E, 0x37, 0x34, 0x31, 0x32,
- 0x13, 0x10, 0x15, 0x16, 0x1F, 0x1C, 0x19, 0x1A,
- 0x0B, 0x08, 0x0D, 0x0E, 0x07, 0x04, 0x01, 0x02
-};
-
-/*32-bit input data, right alignment, Calculation over 18 bits (mult. of 6) */
-static uint8_t CRC6_43_18bit (uint32_t w_InputData)
-{
- uint8_t b_Index = 0;
- uint8_t b_CRC = 0;
-
- b_Index = (uint8_t )(((uint32_t)w_InputData >> 12u) & 0x0000003Fu);
-
- b_CRC = (uint8_t )(((uint32_t)w_InputData >> 6u) & 0x0000003Fu);
- b_Index = b_CRC ^ tableCRC6[b_Index];
-
- b_CRC = (uint8_t )((uint32_t)w_InputData & 0x0000003Fu);
- b_Index = b_CRC ^ tableCRC6[b_Index];
-
- b_CRC = tableCRC6[b_Index];
-
- return b_CRC;
-} 
-
 #if SENSOR_MT6701
 
 MT6701Sensor::MT6701Sensor() {}
@@ -74,7 +41,11 @@ void MT6701Sensor::init() {
       .flags = 0,
       .queue_size=1,
       .pre_cb=NULL,
+  #if SK_MT6701_SAMPLE_HZ
+      .post_cb=&MT6701Sensor::transactionDoneCallback,
+  #else
       .post_cb=NULL,
+  #endif // SK_MT6701_SAMPLE_HZ
   };
   #ifdef CONFIG_IDF_TARGET_ESP32S3
     ret=spi_bus_add_device(SPI3_HOST, &tx_device_config, &spi_device_);
@@ -90,52 +61,113 @@ void MT6701Sensor::init() {
   spi_transaction_.rxlength = 24;
   spi_transaction_.tx_buffer = NULL;
   spi_transaction_.rx_buffer = NULL;
+  spi_transaction_.user = this;
+
+  #if SK_MT6701_SAMPLE_HZ
+  const esp_timer_create_args_t sample_timer_args = {
+      .callback = &MT6701Sensor::sampleTimerCallback,
+      .arg = this,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "mt6701_sample",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&sample_timer_args, &sample_timer_));
+  ESP_ERROR_CHECK(esp_timer_start_periodic(sample_timer_, 1000000 / SK_MT6701_SAMPLE_HZ));
+  // Let a few samples arrive, so the first reading is a filtered angle
+  delay(5);
+  #endif // SK_MT6701_SAMPLE_HZ
 }
 
-float MT6701Sensor::getSensorAngle() {
+float MT6701Sensor::read() {
+#if SK_MT6701_SAMPLE_HZ
+    MT6701Frame frame;
+    while (frames_.pop(frame)) {
+        processFrame(frame);
+    }
+#else
     uint32_t now = micros();
     if (now - last_update_ > 100) {
-      
       esp_err_t ret=spi_device_polling_transmit(spi_device_, &spi_transaction_);
       assert(ret==ESP_OK);
 
-      uint32_t spi_32 = (spi_transaction_.rx_data[0] << 16) | (spi_transaction_.rx_data[1] << 8) | spi_transaction_.rx_data[2];
-      uint32_t angle_spi = spi_32 >> 10;
-
-      uint8_t field_status = (spi_32 >> 6) & 0x3;
-      uint8_t push_status = (spi_32 >> 8) & 0x1;
-      uint8_t loss_status = (spi_32 >> 9) & 0x1;
-
-      uint8_t received_crc = spi_32 & 0x3F;
-      uint8_t calculated_crc = CRC6_43_18bit(spi_32 >> 6);
-      
-      if (received_crc == calculated_crc) {
-        float new_angle = (float)angle_spi * 2 * PI / 16384;
-        float new_x = cosf(new_angle);
-        float new_y = sinf(new_angle);
-        x_ = new_x * ALPHA + x_ * (1-ALPHA);
-        y_ = new_y * ALPHA + y_ * (1-ALPHA);
-      } else {
+      processFrame({
+          .bits = (uint32_t)(spi_transaction_.rx_data[0] << 16) | (spi_transaction_.rx_data[1] << 8) | spi_transaction_.rx_data[2],
+          .micros = now,
+      });
+    }
+#endif // SK_MT6701_SAMPLE_HZ
+    return filter_.angle();
+}
+
+void MT6701Sensor::setCapture(SensorCapture* capture) {
+    capture_ = capture;
+    capture_->setFormat(SensorCaptureFormat::MT6701_SSI);
+}
+
+void MT6701Sensor::processFrame(const MT6701Frame& frame) {
+    if (capture_ != nullptr) {
+        capture_->record(frame.bits, frame.micros);
+    }
+    MT6701Reading reading = MT6701::decode(frame.bits, last_count_);
+    if (health_ != nullptr) {
+        health_->recordSample(MT6701::healthFlags(reading));
+    }
+    if (reading.valid()) {
+        filter_.add(reading.count);
+        last_count_ = reading.count;
+        // Only a valid reading refreshes the angle, so a run of CRC errors or stuck frames shows as a stale reading
+        last_update_ = frame.micros;
+    } else {
         error_ = {
           .error = true,
-          .received_crc = received_crc,
-          .calculated_crc = calculated_crc,
+          .stuck = reading.stuck,
+          .received_crc = reading.received_crc,
+          .calculated_crc = reading.calculated_crc,
         };
-      }
+    }
+}
 
-      last_update_ = now;
+// Runs in the esp_timer task: collects the previous transaction and queues the next, without waiting on the bus
+void MT6701Sensor::sampleTimerCallback(void* arg) {
+    MT6701Sensor* sensor = static_cast<MT6701Sensor*>(arg);
+    if (sensor->transaction_pending_) {
+        spi_transaction_t* done;
+        // A transfer takes about 10 us, so it is normally long complete; if not, skip this sample rather than wait
+        if (spi_device_get_trans_result(sensor->spi_device_, &done, 0) != ESP_OK) {
+            sensor->skipped_samples_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        sensor->transaction_pending_ = false;
     }
-    float rad = -atan2f(y_, x_);
-    if (rad < 0) {
-        rad += 2*PI;
+    if (spi_device_queue_trans(sensor->spi_device_, &sensor->spi_transaction_, 0) == ESP_OK) {
+        sensor->transaction_pending_ = true;
+    } else {
+        sensor->skipped_samples_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Runs in the SPI interrupt when a queued transaction completes
+void MT6701Sensor::transactionDoneCallback(spi_transaction_t* transaction) {
+    MT6701Sensor* sensor = static_cast<MT6701Sensor*>(transaction->user);
+    MT6701Frame frame = {
+        .bits = (uint32_t)(transaction->rx_data[0] << 16) | (transaction->rx_data[1] << 8) | transaction->rx_data[2],
+        .micros = micros(),
+    };
+    if (!sensor->frames_.push(frame)) {
+        sensor->dropped_frames_.fetch_add(1, std::memory_order_relaxed);
     }
-    return rad;
 }
 
-MT6701Error MT6701Sensor::getAndClearError() {
-  MT6701Error out = error_;
+bool MT6701Sensor::takeError(char* message, size_t size) {
+  if (!error_.error) {
+    return false;
+  }
+  if (error_.stuck) {
+    snprintf(message, size, "Stuck frame: data line all %s", error_.received_crc == 0 ? "zeros" : "ones");
+  } else {
+    snprintf(message, size, "CRC error. Received %d; calculated %d", error_.received_crc, error_.calculated_crc);
+  }
   error_ = {};
-  return out;
+  return true;
 }
 
 #endif // SENSOR_MT6701
@@ -1,37 +1,80 @@
 #pragma once
 
-#include <SimpleFOC.h>
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
 #include "driver/spi_master.h"
 
+#include "mt6701_filter.h"
+#include "mt6701_frame.h"
+#include "sensor_capture.h"
+#include "sensor_health.h"
+#include "spsc_queue.h"
+
 struct MT6701Error {
     bool error;
+    // All zeros or all ones, rather than a CRC mismatch
+    bool stuck;
     uint8_t received_crc;
     uint8_t calculated_crc;
 };
 
-class MT6701Sensor : public Sensor {
+/**
+ * @brief AngleSource backend (angle_source.h) for the MT6701 over SSI.
+ *
+ * With SK_MT6701_SAMPLE_HZ set, the sensor is sampled in the background: a periodic timer queues an SPI
+ * transaction, and its post-transaction callback (in the SPI interrupt) pushes the timestamped raw frame
+ * into a lock-free queue. read() then never waits on the bus; it decodes and filters the frames
+ * received since the last call and returns the latest filtered angle.
+ */
+class MT6701Sensor {
     public:
         MT6701Sensor();
 
         // initialize the sensor hardware
         void init();
 
-        // Get current shaft angle from the sensor hardware, and 
-        // return it as a float in radians, in the range 0 to 2PI.
-        //  - This method is pure virtual and must be implemented in subclasses.
-        //    Calling this method directly does not update the base-class internal fields.
-        //    Use update() when calling from outside code.
-        float getSensorAngle();
+        // Filtered angle in radians, in the range 0 to 2PI
+        float read();
+        // micros() of the latest valid reading
+        uint32_t sampleMicros() const { return last_update_; }
+
+        bool takeError(char* message, size_t size);
+
+        // Record every raw frame received into capture (SensorCapture::record() is called from read())
+        void setCapture(SensorCapture* capture);
+        // Report every frame received, and what it flagged, to health
+        void setHealth(SensorHealth* health) { health_ = health; }
 
-        MT6701Error getAndClearError();
+        // Frames lost because read() fell more than FRAME_QUEUE_SIZE samples behind
+        uint32_t droppedFrames() const { return dropped_frames_.load(std::memory_order_relaxed); }
+        // Samples skipped because the previous transaction had not completed yet
+        uint32_t skippedSamples() const { return skipped_samples_.load(std::memory_order_relaxed); }
     private:
+        // Enough for the motor loop at its low-power rate (SK_IDLE_LOOP_HZ) to keep up
+        static const uint16_t FRAME_QUEUE_SIZE = 32;
+
+        static void sampleTimerCallback(void* arg);
+        static void transactionDoneCallback(spi_transaction_t* transaction);
+        void processFrame(const MT6701Frame& frame);
 
         spi_device_handle_t spi_device_;
         spi_transaction_t spi_transaction_ = {};
 
-        float x_;
-        float y_;
-        uint32_t last_update_;
+        MT6701Filter filter_;
+        uint32_t last_update_ = 0;
+        // Count of the last valid reading, which tells a reading of 0 from a stuck line (MT6701::decode())
+        int32_t last_count_ = MT6701::NO_COUNT;
+
+        // Background sampling: written by the timer task and the SPI interrupt, drained by read()
+        esp_timer_handle_t sample_timer_ = nullptr;
+        bool transaction_pending_ = false;
+        std::atomic<uint32_t> skipped_samples_ = 0;
+        SpscQueue<MT6701Frame, FRAME_QUEUE_SIZE> frames_;
+        std::atomic<uint32_t> dropped_frames_ = 0;
 
         MT6701Error error_ = {};
+
+        SensorCapture* capture_ = nullptr;
+        SensorHealth* health_ = nullptr;
 };
@@ -19,8 +19,10 @@ void DemoPage::handleUserInput(input_t input, int input_data, PB_SmartKnobState
         if (current_config_ < sizeof(configs_) / sizeof(configs_[0])) {
             configChange(configs_[current_config_]);
         } else {
+            // Wrapped around to the first demo
             current_config_ = 0;
             configChange(configs_[current_config_]);
+            playHaptic(HapticEffect::DOUBLE_CLICK);
         }
         break;
     }
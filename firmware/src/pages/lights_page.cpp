@@ -4,12 +4,12 @@ PB_SmartKnobConfig * LightsPage::getPageConfig() {
     return &config_;
 }
 
-uint8_t positionToBrightness(int32_t position, PB_SmartKnobConfig config) {
+uint8_t positionToBrightness(int32_t position, const PB_SmartKnobConfig& config) {
     float mapped = mapf(position, config.min_position, config.max_position, BRIGHTNESS_MIN, BRIGHTNESS_MAX); // in-min, in-max, out-min, out-max
     uint8_t brightness = round(mapped);
     return brightness;
 }
-int32_t brightnessToPosition(uint8_t brightness, PB_SmartKnobConfig config) {
+int32_t brightnessToPosition(uint8_t brightness, const PB_SmartKnobConfig& config) {
     // Alert if brightness is out of range
     if (brightness < BRIGHTNESS_MIN || brightness > BRIGHTNESS_MAX) {
         assert(false); // TODO: Handle this case, include logging
@@ -42,6 +42,7 @@ void LightsPage::checkForBrightnessUpdates(PB_SmartKnobState &state, PB_SmartKno
     LOG_INFO("LIGHTS: Updating position to match received brightness");
     
     state.current_position = new_position;
+    position_ = new_position;
     last_published_position_ = new_position;
 }
 
@@ -49,20 +50,34 @@ void LightsPage::handleState(PB_SmartKnobState state) {
     // Incoming
     checkForBrightnessUpdates(state, config_);
 
-    // Outgoing
-    if (last_published_position_ != state.current_position) {
-        if (millis() - last_publish_time_ > BRIGHTNESS_PUBLISH_FREQUENCY_MS) {
-            LOG_INFO(
-                "LIGHTS: Publishing position to MQTT: %d (brightness: %d)",
-                state.current_position,
-                positionToBrightness(state.current_position, config_)
-            );
-            BrightnessData msg = { .brightness = positionToBrightness(state.current_position, config_), };
-            connectivity_task_.sendMqttMessage(msg);
-            last_publish_time_ = millis();
-            last_published_position_ = state.current_position;
-        }
+    // Outgoing; the last change of a spin goes out here, once the publish interval has passed
+    publishPosition();
+}
+
+void LightsPage::handlePositionChange(const PositionEvent& event) {
+    // Each config counts from the position its first change moved away from. The page's configs are bounded, so the steps add up to the position.
+    if (!has_position_ || event.config_generation != position_generation_) {
+        position_ = event.old_position;
+        position_generation_ = event.config_generation;
+        has_position_ = true;
+    }
+    position_ += event.steps;
+    publishPosition();
+}
+
+void LightsPage::publishPosition() {
+    if (!has_position_ || position_ == last_published_position_ || millis() - last_publish_time_ <= BRIGHTNESS_PUBLISH_FREQUENCY_MS) {
+        return;
     }
+    LOG_INFO(
+        "LIGHTS: Publishing position to MQTT: %d (brightness: %d)",
+        position_,
+        positionToBrightness(position_, config_)
+    );
+    BrightnessData msg = { .brightness = positionToBrightness(position_, config_), };
+    connectivity_task_.sendMqttMessage(msg);
+    last_publish_time_ = millis();
+    last_published_position_ = position_;
 }
 
 void LightsPage::handleUserInput(input_t input, int input_data, PB_SmartKnobState state) {    
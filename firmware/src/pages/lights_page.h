@@ -35,6 +35,7 @@ class LightsPage : public Page {
         PB_SmartKnobConfig *getPageConfig() override;
         void                handleState(PB_SmartKnobState state) override;
         void                handleUserInput(input_t input, int input_data, PB_SmartKnobState state) override;
+        void                handlePositionChange(const PositionEvent& event) override;
 
         QueueHandle_t getIncomingBrightnessQueue() { return incoming_brightness_queue_; }
 
@@ -43,8 +44,13 @@ class LightsPage : public Page {
 
         QueueHandle_t incoming_brightness_queue_;
 
-        uint32_t last_publish_time_;
-        uint32_t last_published_position_;
+        uint32_t last_publish_time_ = 0;
+        int32_t last_published_position_ = 0;
+
+        // Position counted from the steps of the position events, which handleState's sampled states skip during fast spins
+        int32_t position_ = 0;
+        uint32_t position_generation_ = 0;
+        bool has_position_ = false;
 
         PB_SmartKnobConfig config_ =
         {
@@ -71,4 +77,5 @@ class LightsPage : public Page {
         };
 
         void checkForBrightnessUpdates(PB_SmartKnobState&, PB_SmartKnobConfig&);
+        void publishPosition();
 };
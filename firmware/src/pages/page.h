@@ -7,6 +7,8 @@
 #include "proto_gen/smartknob.pb.h"
 #include "input_type.h"
 #include "event_bus.h"
+#include "haptics/haptic_effect.h"
+#include "position_events.h"
 
 #include "logger.h"
 
@@ -28,16 +30,22 @@ namespace PageEvent {
         PB_SmartKnobConfig config;
     };
     struct MotorCalibration {};
+    struct PlayHaptic {
+        HapticEffect effect;
+        float strength;
+    };
 
     using Message = std::variant<
         PageChange,
         ConfigChange,
-        MotorCalibration
+        MotorCalibration,
+        PlayHaptic
     >;
     
     static_assert(std::is_pod_v<PageChange> == true);
     static_assert(std::is_pod_v<ConfigChange> == true);
     static_assert(std::is_pod_v<MotorCalibration> == true);
+    static_assert(std::is_pod_v<PlayHaptic> == true);
 }
 
 struct PageContext {
@@ -57,6 +65,8 @@ class Page {
 
         virtual void handleState(PB_SmartKnobState state) = 0;
         virtual void handleUserInput(input_t input, int input_data, PB_SmartKnobState state) = 0;
+        // Every position change of the page's config, in order; unlike handleState, no steps are skipped during fast spins
+        virtual void handlePositionChange(const PositionEvent& event) {}
 
         void log(const std::string& msg) {
             logger_->log(msg);
@@ -74,6 +84,10 @@ class Page {
         void motorCalibration() {
             event_bus_.publish(PageEvent::MotorCalibration{});
         }
+        // A strength of 0 uses the effect's default strength
+        void playHaptic(HapticEffect effect, float strength = 0) {
+            event_bus_.publish(PageEvent::PlayHaptic{effect, strength});
+        }
 
         Logger *logger_;
 };
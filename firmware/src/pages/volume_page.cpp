@@ -4,11 +4,11 @@ PB_SmartKnobConfig * VolumePage::getPageConfig() {
     return &config_;
 }
 
-float positionToVolume(int32_t position, PB_SmartKnobConfig config) {
+float positionToVolume(int32_t position, const PB_SmartKnobConfig& config) {
     float mapped = mapf(position, config.min_position, config.max_position, VOLUME_MIN, VOLUME_MAX); // in-min, in-max, out-min, out-max
     return mapped;
 }
-int32_t volumeToPosition(uint8_t volume, PB_SmartKnobConfig config) {
+int32_t volumeToPosition(uint8_t volume, const PB_SmartKnobConfig& config) {
     // Alert if volume is out of range
     if (volume < VOLUME_MIN || volume > VOLUME_MAX) {
         assert(false); // TODO: Handle this case, include logging
@@ -49,21 +49,35 @@ void VolumePage::handleState(PB_SmartKnobState state) {
     // Incoming
     // checkForBrightnessUpdates(state, config_);
 
-    // Outgoing
-    if (last_published_position_ != state.current_position) {
-        if (millis() - last_publish_time_ > VOLUME_PUBLISH_FREQUENCY_MS) {
-            LOG_INFO(
-                "VOLUME: Publishing position to MQTT: %d (volume: %f)",
-                state.current_position,
-                positionToVolume(state.current_position, config_)
-            );
+    // Outgoing; the last change of a spin goes out here, once the publish interval has passed
+    publishPosition();
+}
 
-            VolumeData msg = { .volume = positionToVolume(state.current_position, config_), };
-            connectivity_task_.sendMqttMessage(msg);
-            last_publish_time_ = millis();
-            last_published_position_ = state.current_position;
-        }
+void VolumePage::handlePositionChange(const PositionEvent& event) {
+    // Each config counts from the position its first change moved away from. The page's configs are bounded, so the steps add up to the position.
+    if (!has_position_ || event.config_generation != position_generation_) {
+        position_ = event.old_position;
+        position_generation_ = event.config_generation;
+        has_position_ = true;
     }
+    position_ += event.steps;
+    publishPosition();
+}
+
+void VolumePage::publishPosition() {
+    if (!has_position_ || position_ == last_published_position_ || millis() - last_publish_time_ <= VOLUME_PUBLISH_FREQUENCY_MS) {
+        return;
+    }
+    LOG_INFO(
+        "VOLUME: Publishing position to MQTT: %d (volume: %f)",
+        position_,
+        positionToVolume(position_, config_)
+    );
+
+    VolumeData msg = { .volume = positionToVolume(position_, config_), };
+    connectivity_task_.sendMqttMessage(msg);
+    last_publish_time_ = millis();
+    last_published_position_ = position_;
 }
 
 void VolumePage::handleUserInput(input_t input, int input_data, PB_SmartKnobState state) {    
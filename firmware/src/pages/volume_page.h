@@ -34,6 +34,7 @@ class VolumePage : public Page {
         PB_SmartKnobConfig *getPageConfig() override;
         void                handleState(PB_SmartKnobState state) override;
         void                handleUserInput(input_t input, int input_data, PB_SmartKnobState state) override;
+        void                handlePositionChange(const PositionEvent& event) override;
 
         // QueueHandle_t getIncomingBrightnessQueue() { return incoming_volume_queue_; }
 
@@ -42,8 +43,13 @@ class VolumePage : public Page {
 
         QueueHandle_t incoming_volume_queue_;
 
-        uint32_t last_publish_time_;
-        uint32_t last_published_position_;
+        uint32_t last_publish_time_ = 0;
+        int32_t last_published_position_ = 0;
+
+        // Position counted from the steps of the position events, which handleState's sampled states skip during fast spins
+        int32_t position_ = 0;
+        uint32_t position_generation_ = 0;
+        bool has_position_ = false;
 
         PB_SmartKnobConfig config_ =
         {
@@ -74,4 +80,5 @@ class VolumePage : public Page {
         };
 
         // void checkForBrightnessUpdates(PB_SmartKnobState&, PB_SmartKnobConfig&);
+        void publishPosition();
 };
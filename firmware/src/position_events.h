@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include "spsc_queue.h"
+
+/**
+ * @brief A change of the knob's position, as detected by the haptic loop.
+ */
+struct PositionEvent {
+    uint32_t timestamp_micros;
+    int32_t old_position;
+    int32_t new_position;
+    // Positions moved, signed by direction. Differs from new_position - old_position when an
+    // infinite scroll config wraps around, or when several changes were merged into one event.
+    int32_t steps;
+    // Shaft velocity when the (latest) change happened, radians/second
+    float velocity;
+    // Generation of the config the positions belong to (see KnobStateFeed)
+    uint32_t config_generation;
+};
+
+/**
+ * @brief Every position change of the motor task, delivered in order to one consumer task.
+ *
+ * The knob state snapshot in KnobStateFeed only carries the latest position, so a consumer that
+ * polls it misses the intermediate positions of a fast spin. These events carry each change
+ * instead, so the consumer can count exact steps.
+ *
+ * The producer never blocks: if the consumer falls behind and the queue is full, further changes
+ * are merged into one pending event (its steps still add up), which is queued as soon as there is
+ * room again. Only a pending event from an older config is dropped when a change of a newer
+ * config arrives, since its positions no longer mean anything to the consumer.
+ *
+ * software/tools/position_event_sim.cpp spins a simulated knob at 20 rev/s through the haptic
+ * controller and this queue, and checks that no step is lost.
+ */
+class PositionEventQueue {
+    public:
+        static const uint16_t CAPACITY = 64;
+
+        // Producer side; must only be called from the motor task
+
+        void publish(const PositionEvent& event) {
+            if (has_pending_) {
+                if (pending_.config_generation == event.config_generation) {
+                    pending_.timestamp_micros = event.timestamp_micros;
+                    pending_.new_position = event.new_position;
+                    pending_.steps += event.steps;
+                    pending_.velocity = event.velocity;
+                } else {
+                    pending_ = event;
+                }
+                flush();
+                return;
+            }
+            if (!queue_.push(event)) {
+                pending_ = event;
+                has_pending_ = true;
+            }
+        }
+
+        // Retry queueing a pending event; cheap enough to call on every loop iteration
+        void flush() {
+            if (has_pending_ && queue_.push(pending_)) {
+                has_pending_ = false;
+            }
+        }
+
+        // Consumer side; must only be called from one task
+
+        bool read(PositionEvent& event) {
+            return queue_.pop(event);
+        }
+
+    private:
+        SpscQueue<PositionEvent, CAPACITY> queue_;
+
+        // Producer only
+        PositionEvent pending_ = {};
+        bool has_pending_ = false;
+};
@@ -30,10 +30,43 @@ PB_BIND(PB_MenuEntry, PB_MenuEntry, AUTO)
 PB_BIND(PB_SmartKnobConfig, PB_SmartKnobConfig, 2)
 
 
+PB_BIND(PB_PositionMap, PB_PositionMap, AUTO)
+
+
 PB_BIND(PB_RequestState, PB_RequestState, AUTO)
 
 
-PB_BIND(PB_PersistentConfiguration, PB_PersistentConfiguration, AUTO)
+PB_BIND(PB_PlayHapticEffect, PB_PlayHapticEffect, AUTO)
+
+
+PB_BIND(PB_MotorCalibrationRequest, PB_MotorCalibrationRequest, AUTO)
+
+
+PB_BIND(PB_MotorCalibrationStatus, PB_MotorCalibrationStatus, AUTO)
+
+
+PB_BIND(PB_TelemetryRequest, PB_TelemetryRequest, AUTO)
+
+
+PB_BIND(PB_TelemetryChunk, PB_TelemetryChunk, AUTO)
+
+
+PB_BIND(PB_SensorCaptureRequest, PB_SensorCaptureRequest, AUTO)
+
+
+PB_BIND(PB_SensorCaptureChunk, PB_SensorCaptureChunk, AUTO)
+
+
+PB_BIND(PB_RequestSensorHealth, PB_RequestSensorHealth, AUTO)
+
+
+PB_BIND(PB_SensorHealthCounts, PB_SensorHealthCounts, AUTO)
+
+
+PB_BIND(PB_SensorHealth, PB_SensorHealth, AUTO)
+
+
+PB_BIND(PB_PersistentConfiguration, PB_PersistentConfiguration, 2)
 
 
 PB_BIND(PB_MotorCalibration, PB_MotorCalibration, AUTO)
@@ -42,4 +75,10 @@ PB_BIND(PB_MotorCalibration, PB_MotorCalibration, AUTO)
 PB_BIND(PB_StrainCalibration, PB_StrainCalibration, AUTO)
 
 
+PB_BIND(PB_SensorCalibration, PB_SensorCalibration, AUTO)
+
+
+PB_BIND(PB_CoggingCalibration, PB_CoggingCalibration, 2)
+
+
 
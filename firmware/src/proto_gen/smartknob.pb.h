@@ -31,6 +31,32 @@ typedef struct _PB_ViewConfig {
     PB_MenuEntry menu_entries[8];
 } PB_ViewConfig;
 
+/* *
+ Widths of the positions of a SmartKnobConfig, along a curve over the position range.
+
+ The positions together keep the angle of the uniform layout, (max_position - min_position + 1)
+ * position_width_radians. The curve F(u) gives the fraction of that angle before the point u
+ (from 0 at min_position to 1 after max_position) of the range, so each position is as wide as
+ its share of F. sub_position_unit is reported relative to the current position's own width. */
+typedef struct _PB_PositionMap {
+    /* *
+ Curve:
+   0: uniform (no map)
+   1: power, F(u) = u^shape. Shapes above 1 make low positions narrow and high positions wide.
+   2: logarithmic, F(u) = log(1 + shape * u) / log(1 + shape). Low positions are wide.
+   3: piecewise, see segment_widths */
+    uint8_t curve;
+    /* * Exponent (power) or steepness (logarithmic) of the curve. Must be positive. */
+    float shape;
+    /* *
+ Piecewise curve: the range is split into as many equal parts as there are values, and the
+ positions in each part are as wide as its (positive) value relative to the others. With one
+ value per position, this sets each position's width directly. */
+    pb_size_t segment_widths_count;
+    float segment_widths[16];
+} PB_PositionMap;
+
+typedef PB_BYTES_ARRAY_T(256) PB_SmartKnobConfig_detent_runs_t;
 typedef struct _PB_SmartKnobConfig {
     bool has_view_config;
     PB_ViewConfig view_config;
@@ -110,7 +136,10 @@ typedef struct _PB_SmartKnobConfig {
  This approach enables effectively unbounded detent positions while keeping Config
  bounded in size, and is resilient against tightly-packed detents with fast rotation
  since multiple detent positions can be sent in advance; a full round-trip Config-State
- isn't needed between each detent in order to keep up. */
+ isn't needed between each detent in order to keep up.
+
+ For more than 5 detent positions, detent_runs is usually the better choice. Both can be
+ used together; the knob then has detents at the positions of either. */
     pb_size_t detent_positions_count;
     int32_t detent_positions[5];
     /* *
@@ -124,6 +153,43 @@ typedef struct _PB_SmartKnobConfig {
  Hue (0-255) for all 8 ring LEDs, if supported. Note: this will likely be replaced
  with more configurability in a future protocol version. */
     int16_t led_hue;
+    /* *
+ Optional sampled torque profile of a single detent. When set (non-empty), it replaces
+ the default detent torque derived from detent_strength_unit, allowing notchy, sawtooth
+ or asymmetric detents.
+
+ Samples are evenly spaced over one position width, starting at sub_position_unit -0.5:
+ sample i of n applies at sub_position_unit (-0.5 + i/n). The torque is linearly
+ interpolated between samples and the profile repeats for every position.
+
+ Values are in units of motor torque, multiplied by detent_strength_unit. Positive values
+ push the knob towards higher positions, so a typical detent has positive values for
+ negative sub positions and vice versa. Typical range: [-1, 1].
+
+ Endstop torque at the bounds and magnetic detent_positions are applied as usual. */
+    pb_size_t detent_torque_profile_count;
+    float detent_torque_profile[32];
+    /* *
+ Magnetic detent positions (see detent_positions), run-length encoded so that hundreds of
+ detents fit into a single Config. Empty if unused.
+
+ The positions are encoded as a sequence of runs of consecutive detent positions, in
+ ascending order. Each run is a varint v, followed by a second varint (length - 2) only if
+ (v & 1) is set; runs without it have length 1. (v >> 1) locates the run's first position:
+   - first run: the zigzag encoding (as for sint32) of its first position
+   - other runs: (first position - last position of the previous run - 2), so runs must be
+     separated by at least one position without a detent
+
+ E.g. detents at 0, 10, 20 encode as 00 10 10; 0..99 as 01 62. Isolated detents fewer than
+ 66 positions apart take one byte each. Decoding stops at the first malformed run. */
+    PB_SmartKnobConfig_detent_runs_t detent_runs;
+    /* *
+ Optional non-uniform layout of the positions, e.g. for finer steps at low volumes. When set,
+ position_width_radians is the average width of the positions instead of the width of each.
+ Only applies to bounded ranges (min_position < max_position) of up to 256 positions;
+ other configs use uniform positions. */
+    bool has_position_map;
+    PB_PositionMap position_map;
 } PB_SmartKnobConfig;
 
 typedef struct _PB_SmartKnobState {
@@ -159,8 +225,129 @@ typedef struct _PB_SmartKnobState {
  that a press has taken place at some point even if the State was lost during the press
  itself. Is this overkill? Probably, let's revisit in future protocol versions. */
     uint8_t press_nonce;
+    /* *
+ Running count of position changes since boot, signed by direction (wraps around).
+
+ current_position is sampled, so a fast spin through fine detents skips positions between
+ two States, and an infinite scroll wrap hides the steps taken altogether. This counts every
+ step the knob snapped, so the difference between two States is the exact number of steps
+ turned in between, even if States in between were dropped. */
+    int32_t position_steps;
 } PB_SmartKnobState;
 
+typedef struct _PB_MotorCalibration {
+    bool calibrated;
+    float zero_electrical_offset;
+    bool direction_cw;
+    uint32_t pole_pairs;
+} PB_MotorCalibration;
+
+/* * Progress of a motor calibration. Sent while it runs, and once more when it ends. */
+typedef struct _PB_MotorCalibrationStatus {
+    /* *
+ Current phase:
+   0: not running
+   1: aligning the rotor
+   2: measuring direction and pole pairs
+   3: measuring zero offset (reverse sweep)
+   4: measuring zero offset (forward sweep) */
+    uint8_t phase;
+    /* *
+ Outcome:
+   1: running
+   2: succeeded, the result has been saved
+   3: cancelled
+   4: failed, the sensor didn't detect any movement
+   5: failed, measured pole pairs out of range
+   6: failed, the rotor didn't follow the motor smoothly (e.g. the knob was touched) */
+    uint8_t status;
+    /* * Fraction of the calibration completed. Range: [0, 1]. */
+    float progress;
+    /* * Measured calibration. Only set once status is succeeded. */
+    bool has_calibration;
+    PB_MotorCalibration calibration;
+} PB_MotorCalibrationStatus;
+
+typedef PB_BYTES_ARRAY_T(224) PB_TelemetryChunk_frames_t;
+/* *
+ Consecutive frames of a telemetry capture. The frames are sent as they are recorded; if the
+ host doesn't keep up, the firmware drops frames instead of stalling the motor loop. */
+typedef struct _PB_TelemetryChunk {
+    /* * Index of the first frame of this chunk within the capture (frames before the trigger included). */
+    uint32_t first_frame;
+    /* *
+ Raw frames, frame_size bytes each, in the firmware's little-endian TelemetryFrame layout
+ (see firmware/src/telemetry_buffer.h and software/tools/telemetry_decode.cpp). */
+    PB_TelemetryChunk_frames_t frames;
+    uint8_t frame_size;
+    /* * Set on the last chunk of a capture (which may have no frames). */
+    bool end;
+    /* * Frames dropped during the capture because the host didn't keep up. Only set on the last chunk. */
+    uint32_t dropped;
+} PB_TelemetryChunk;
+
+typedef PB_BYTES_ARRAY_T(224) PB_SensorCaptureChunk_frames_t;
+/* *
+ Consecutive readings of a sensor capture. As with TelemetryChunk, the readings are sent as they are
+ recorded, and dropped by the firmware if the host doesn't keep up. */
+typedef struct _PB_SensorCaptureChunk {
+    /* * Index of the first frame of this chunk within the capture. */
+    uint32_t first_frame;
+    /* *
+ Raw frames, frame_size bytes each, in the firmware's little-endian SensorCaptureFrame layout
+ (see firmware/src/sensor_capture.h). */
+    PB_SensorCaptureChunk_frames_t frames;
+    uint8_t frame_size;
+    /* *
+ Layout of the raw readings:
+   0: none; the sensor driver doesn't record its readings (the capture ends without frames)
+   1: 24-bit MT6701 SSI frame */
+    uint8_t format;
+    /* * Set on the last chunk of a capture (which may have no frames). */
+    bool end;
+    /* * Frames dropped during the capture because the host didn't keep up. Only set on the last chunk. */
+    uint32_t dropped;
+} PB_SensorCaptureChunk;
+
+/* * Counts of the angle sensor's readings over some period. */
+typedef struct _PB_SensorHealthCounts {
+    /* * Readings received from the sensor. */
+    uint32_t samples;
+    /* * Readings discarded because their CRC didn't match. */
+    uint32_t crc_errors;
+    /* * Valid readings flagging the magnetic field as too strong, or too weak (magnet too close, or too far). */
+    uint32_t field_too_strong;
+    uint32_t field_too_weak;
+    /* * Valid readings flagging that the sensor lost track of the magnet. */
+    uint32_t loss_of_track;
+    /* * Oldest the latest valid reading was when a motor loop iteration used it, in microseconds. */
+    uint32_t max_age_micros;
+    /* * Motor loop iterations that didn't drive the motor, because the latest valid reading was too old. */
+    uint32_t stale_iterations;
+    /* * Readings discarded because every bit was the same (all zeros or all ones): the data line was stuck, with no sensor driving it. */
+    uint32_t stuck_frames;
+} PB_SensorHealthCounts;
+
+/* *
+ Health of the angle sensor, over the last complete window of counting (about a second) and since boot.
+ Sent in reply to RequestSensorHealth. Only the MT6701 reports its readings, with CRC errors and status
+ flags (see readings_reported); the age of the readings is counted for every sensor. */
+typedef struct _PB_SensorHealth {
+    /* * Length of the window. 0 until the first window is complete. */
+    uint32_t window_millis;
+    bool has_window;
+    PB_SensorHealthCounts window;
+    /* * Counts since boot, up to the end of the window. */
+    bool has_total;
+    PB_SensorHealthCounts total;
+    /* * Whether the motor was stopped at the end of the window, because the reading was too old. */
+    bool stale;
+    /* * Whether the sensor reports its readings, so that samples, crc_errors, the field and loss of track
+ flags and stuck_frames are counted. If not, they stay 0 whatever the sensor's health; only
+ max_age_micros and stale_iterations are. */
+    bool readings_reported;
+} PB_SensorHealth;
+
 /* Message FROM the SmartKnob to the host */
 typedef struct _PB_FromSmartKnob {
     uint8_t protocol_version;
@@ -169,6 +356,10 @@ typedef struct _PB_FromSmartKnob {
         PB_Ack ack;
         PB_Log log;
         PB_SmartKnobState smartknob_state;
+        PB_MotorCalibrationStatus motor_calibration_status;
+        PB_TelemetryChunk telemetry_chunk;
+        PB_SensorCaptureChunk sensor_capture_chunk;
+        PB_SensorHealth sensor_health;
     } payload;
 } PB_FromSmartKnob;
 
@@ -176,6 +367,66 @@ typedef struct _PB_RequestState {
     char dummy_field;
 } PB_RequestState;
 
+/* * Play a short haptic effect. The effect's torque is added to the detent torque while it plays. */
+typedef struct _PB_PlayHapticEffect {
+    /* *
+ Effect to play:
+   0: click
+   1: double click
+   2: buzz
+   3: ramp
+   4: bump */
+    uint8_t effect;
+    /* * Peak torque of the effect. A value of 0 uses the effect's default strength. */
+    float strength;
+} PB_PlayHapticEffect;
+
+/* *
+ Start a motor calibration, or cancel the one in progress. The knob must not be touched while
+ the calibration runs; progress is reported with MotorCalibrationStatus messages. */
+typedef struct _PB_MotorCalibrationRequest {
+    /* * Cancel the calibration in progress instead of starting a new one. */
+    bool cancel;
+    /* *
+ Start a cogging calibration instead: measure the motor's cogging torque, which is then
+ compensated by the haptics (see CoggingCalibration). Needs a completed motor calibration. */
+    bool cogging;
+} PB_MotorCalibrationRequest;
+
+/* *
+ Record the motor loop on every iteration, starting on a trigger, and stream the recording back
+ as TelemetryChunk messages. Replaces any capture in progress. */
+typedef struct _PB_TelemetryRequest {
+    /* *
+ What starts the capture:
+   0: immediately
+   1: the next config change applied by the motor
+   2: the knob's speed reaching velocity_threshold */
+    uint8_t trigger;
+    /* * Loop iterations to record from the trigger on. 0 cancels the capture in progress. */
+    uint32_t frames;
+    /* * Loop iterations from before the trigger to include (limited by the firmware's buffer size). */
+    uint16_t pre_trigger;
+    /* * Record only every Nth loop iteration, for longer captures. 0 and 1 record every iteration. */
+    uint16_t decimation;
+    /* * Speed in radians per second, for trigger 2. */
+    float velocity_threshold;
+} PB_TelemetryRequest;
+
+/* *
+ Record the angle sensor's raw readings, exactly as the driver receives them, and stream them back
+ as SensorCaptureChunk messages, for offline replay through the driver's decoding and filter (see
+ software/tools/sensor_replay.cpp). Replaces any capture in progress. */
+typedef struct _PB_SensorCaptureRequest {
+    /* * Readings to record. 0 stops the capture in progress; the readings recorded so far are still sent. */
+    uint32_t frames;
+} PB_SensorCaptureRequest;
+
+/* * Request a SensorHealth report. */
+typedef struct _PB_RequestSensorHealth {
+    char dummy_field;
+} PB_RequestSensorHealth;
+
 /* Message TO the Smartknob from the host */
 typedef struct _PB_ToSmartknob {
     uint8_t protocol_version;
@@ -184,27 +435,54 @@ typedef struct _PB_ToSmartknob {
     union {
         PB_RequestState request_state;
         PB_SmartKnobConfig smartknob_config;
+        PB_PlayHapticEffect play_haptic_effect;
+        PB_MotorCalibrationRequest motor_calibration;
+        PB_TelemetryRequest telemetry;
+        PB_SensorCaptureRequest sensor_capture;
+        PB_RequestSensorHealth request_sensor_health;
     } payload;
 } PB_ToSmartknob;
 
-typedef struct _PB_MotorCalibration {
-    bool calibrated;
-    float zero_electrical_offset;
-    bool direction_cw;
-    uint32_t pole_pairs;
-} PB_MotorCalibration;
-
 typedef struct _PB_StrainCalibration {
     int32_t idle_value;
     int32_t press_delta;
 } PB_StrainCalibration;
 
+/* *
+ Position-dependent error of the magnetic sensor (magnet eccentricity, sensor nonlinearity),
+ learned during motor calibration and subtracted from every reading.
+
+ The error in radians at raw sensor angle a is sum over k = 1..n of
+ error_cos[k-1] * cos(k * a) + error_sin[k-1] * sin(k * a). Empty means no correction. */
+typedef struct _PB_SensorCalibration {
+    pb_size_t error_cos_count;
+    float error_cos[4];
+    pb_size_t error_sin_count;
+    float error_sin[4];
+} PB_SensorCalibration;
+
+typedef PB_BYTES_ARRAY_T(512) PB_CoggingCalibration_torque_t;
+/* *
+ Cogging torque of the motor over one mechanical revolution, measured by a cogging calibration
+ and added to the motor torque as feedforward.
+
+ Sample i of n is the torque that holds the rotor against cogging at raw sensor angle
+ 2PI * i / n, in units of motor torque: (int8) torque[i] * scale. Empty means no feedforward. */
+typedef struct _PB_CoggingCalibration {
+    PB_CoggingCalibration_torque_t torque;
+    float scale;
+} PB_CoggingCalibration;
+
 typedef struct _PB_PersistentConfiguration {
     uint32_t version;
     bool has_motor;
     PB_MotorCalibration motor;
     bool has_strain;
     PB_StrainCalibration strain;
+    bool has_sensor;
+    PB_SensorCalibration sensor;
+    bool has_cogging;
+    PB_CoggingCalibration cogging;
 } PB_PersistentConfiguration;
 
 
@@ -217,26 +495,52 @@ extern "C" {
 #define PB_ToSmartknob_init_default              {0, 0, 0, {PB_RequestState_init_default}}
 #define PB_Ack_init_default                      {0}
 #define PB_Log_init_default                      {""}
-#define PB_SmartKnobState_init_default           {0, 0, false, PB_SmartKnobConfig_init_default, 0}
+#define PB_SmartKnobState_init_default           {0, 0, false, PB_SmartKnobConfig_init_default, 0, 0}
 #define PB_ViewConfig_init_default               {0, "", 0, {PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default, PB_MenuEntry_init_default}}
 #define PB_MenuEntry_init_default                {"", ""}
-#define PB_SmartKnobConfig_init_default          {false, PB_ViewConfig_init_default, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {0, 0, 0, 0, 0}, 0, 0}
+#define PB_SmartKnobConfig_init_default          {false, PB_ViewConfig_init_default, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {0, 0, 0, 0, 0}, 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, {0, {0}}, false, PB_PositionMap_init_default}
+#define PB_PositionMap_init_default              {0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}
 #define PB_RequestState_init_default             {0}
-#define PB_PersistentConfiguration_init_default  {0, false, PB_MotorCalibration_init_default, false, PB_StrainCalibration_init_default}
+#define PB_PlayHapticEffect_init_default         {0, 0}
+#define PB_MotorCalibrationRequest_init_default  {0, 0}
+#define PB_MotorCalibrationStatus_init_default   {0, 0, 0, false, PB_MotorCalibration_init_default}
+#define PB_TelemetryRequest_init_default         {0, 0, 0, 0, 0}
+#define PB_TelemetryChunk_init_default           {0, {0, {0}}, 0, 0, 0}
+#define PB_SensorCaptureRequest_init_default     {0}
+#define PB_SensorCaptureChunk_init_default       {0, {0, {0}}, 0, 0, 0, 0}
+#define PB_RequestSensorHealth_init_default      {0}
+#define PB_SensorHealthCounts_init_default       {0, 0, 0, 0, 0, 0, 0, 0}
+#define PB_SensorHealth_init_default             {0, false, PB_SensorHealthCounts_init_default, false, PB_SensorHealthCounts_init_default, 0, 0}
+#define PB_PersistentConfiguration_init_default  {0, false, PB_MotorCalibration_init_default, false, PB_StrainCalibration_init_default, false, PB_SensorCalibration_init_default, false, PB_CoggingCalibration_init_default}
 #define PB_MotorCalibration_init_default         {0, 0, 0, 0}
 #define PB_StrainCalibration_init_default        {0, 0}
+#define PB_SensorCalibration_init_default        {0, {0, 0, 0, 0}, 0, {0, 0, 0, 0}}
+#define PB_CoggingCalibration_init_default       {{0, {0}}, 0}
 #define PB_FromSmartKnob_init_zero               {0, 0, {PB_Ack_init_zero}}
 #define PB_ToSmartknob_init_zero                 {0, 0, 0, {PB_RequestState_init_zero}}
 #define PB_Ack_init_zero                         {0}
 #define PB_Log_init_zero                         {""}
-#define PB_SmartKnobState_init_zero              {0, 0, false, PB_SmartKnobConfig_init_zero, 0}
+#define PB_SmartKnobState_init_zero              {0, 0, false, PB_SmartKnobConfig_init_zero, 0, 0}
 #define PB_ViewConfig_init_zero                  {0, "", 0, {PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero, PB_MenuEntry_init_zero}}
 #define PB_MenuEntry_init_zero                   {"", ""}
-#define PB_SmartKnobConfig_init_zero             {false, PB_ViewConfig_init_zero, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {0, 0, 0, 0, 0}, 0, 0}
+#define PB_SmartKnobConfig_init_zero             {false, PB_ViewConfig_init_zero, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {0, 0, 0, 0, 0}, 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, {0, {0}}, false, PB_PositionMap_init_zero}
+#define PB_PositionMap_init_zero                 {0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}
 #define PB_RequestState_init_zero                {0}
-#define PB_PersistentConfiguration_init_zero     {0, false, PB_MotorCalibration_init_zero, false, PB_StrainCalibration_init_zero}
+#define PB_PlayHapticEffect_init_zero            {0, 0}
+#define PB_MotorCalibrationRequest_init_zero     {0, 0}
+#define PB_MotorCalibrationStatus_init_zero      {0, 0, 0, false, PB_MotorCalibration_init_zero}
+#define PB_TelemetryRequest_init_zero            {0, 0, 0, 0, 0}
+#define PB_TelemetryChunk_init_zero              {0, {0, {0}}, 0, 0, 0}
+#define PB_SensorCaptureRequest_init_zero        {0}
+#define PB_SensorCaptureChunk_init_zero          {0, {0, {0}}, 0, 0, 0, 0}
+#define PB_RequestSensorHealth_init_zero         {0}
+#define PB_SensorHealthCounts_init_zero          {0, 0, 0, 0, 0, 0, 0, 0}
+#define PB_SensorHealth_init_zero                {0, false, PB_SensorHealthCounts_init_zero, false, PB_SensorHealthCounts_init_zero, 0, 0}
+#define PB_PersistentConfiguration_init_zero     {0, false, PB_MotorCalibration_init_zero, false, PB_StrainCalibration_init_zero, false, PB_SensorCalibration_init_zero, false, PB_CoggingCalibration_init_zero}
 #define PB_MotorCalibration_init_zero            {0, 0, 0, 0}
 #define PB_StrainCalibration_init_zero           {0, 0}
+#define PB_SensorCalibration_init_zero           {0, {0, 0, 0, 0}, 0, {0, 0, 0, 0}}
+#define PB_CoggingCalibration_init_zero          {{0, {0}}, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define PB_Ack_nonce_tag                         1
@@ -246,6 +550,9 @@ extern "C" {
 #define PB_ViewConfig_view_type_tag              1
 #define PB_ViewConfig_description_tag            2
 #define PB_ViewConfig_menu_entries_tag           3
+#define PB_PositionMap_curve_tag                 1
+#define PB_PositionMap_shape_tag                 2
+#define PB_PositionMap_segment_widths_tag        3
 #define PB_SmartKnobConfig_view_config_tag       1
 #define PB_SmartKnobConfig_position_tag          2
 #define PB_SmartKnobConfig_sub_position_unit_tag 3
@@ -260,49 +567,124 @@ extern "C" {
 #define PB_SmartKnobConfig_detent_positions_tag  12
 #define PB_SmartKnobConfig_snap_point_bias_tag   13
 #define PB_SmartKnobConfig_led_hue_tag           14
+#define PB_SmartKnobConfig_detent_torque_profile_tag 15
+#define PB_SmartKnobConfig_detent_runs_tag       16
+#define PB_SmartKnobConfig_position_map_tag      17
 #define PB_SmartKnobState_current_position_tag   1
 #define PB_SmartKnobState_sub_position_unit_tag  2
 #define PB_SmartKnobState_config_tag             3
 #define PB_SmartKnobState_press_nonce_tag        4
+#define PB_SmartKnobState_position_steps_tag     5
+#define PB_TelemetryChunk_first_frame_tag        1
+#define PB_TelemetryChunk_frames_tag             2
+#define PB_TelemetryChunk_frame_size_tag         3
+#define PB_TelemetryChunk_end_tag                4
+#define PB_TelemetryChunk_dropped_tag            5
+#define PB_SensorCaptureChunk_first_frame_tag    1
+#define PB_SensorCaptureChunk_frames_tag         2
+#define PB_SensorCaptureChunk_frame_size_tag     3
+#define PB_SensorCaptureChunk_format_tag         4
+#define PB_SensorCaptureChunk_end_tag            5
+#define PB_SensorCaptureChunk_dropped_tag        6
+#define PB_SensorHealthCounts_samples_tag        1
+#define PB_SensorHealthCounts_crc_errors_tag     2
+#define PB_SensorHealthCounts_field_too_strong_tag 3
+#define PB_SensorHealthCounts_field_too_weak_tag 4
+#define PB_SensorHealthCounts_loss_of_track_tag  5
+#define PB_SensorHealthCounts_max_age_micros_tag 6
+#define PB_SensorHealthCounts_stale_iterations_tag 7
+#define PB_SensorHealthCounts_stuck_frames_tag   8
+#define PB_SensorHealth_window_millis_tag        1
+#define PB_SensorHealth_window_tag               2
+#define PB_SensorHealth_total_tag                3
+#define PB_SensorHealth_stale_tag                4
+#define PB_SensorHealth_readings_reported_tag    5
 #define PB_FromSmartKnob_protocol_version_tag    1
 #define PB_FromSmartKnob_ack_tag                 2
 #define PB_FromSmartKnob_log_tag                 3
 #define PB_FromSmartKnob_smartknob_state_tag     4
+#define PB_FromSmartKnob_motor_calibration_status_tag 5
+#define PB_FromSmartKnob_telemetry_chunk_tag     6
+#define PB_FromSmartKnob_sensor_capture_chunk_tag 7
+#define PB_FromSmartKnob_sensor_health_tag       8
+#define PB_TelemetryRequest_trigger_tag          1
+#define PB_TelemetryRequest_frames_tag           2
+#define PB_TelemetryRequest_pre_trigger_tag      3
+#define PB_TelemetryRequest_decimation_tag       4
+#define PB_TelemetryRequest_velocity_threshold_tag 5
+#define PB_SensorCaptureRequest_frames_tag       1
 #define PB_ToSmartknob_protocol_version_tag      1
 #define PB_ToSmartknob_nonce_tag                 2
 #define PB_ToSmartknob_request_state_tag         3
 #define PB_ToSmartknob_smartknob_config_tag      4
+#define PB_ToSmartknob_play_haptic_effect_tag    5
+#define PB_ToSmartknob_motor_calibration_tag     6
+#define PB_ToSmartknob_telemetry_tag             7
+#define PB_ToSmartknob_sensor_capture_tag        8
+#define PB_ToSmartknob_request_sensor_health_tag 9
+#define PB_PlayHapticEffect_effect_tag           1
+#define PB_PlayHapticEffect_strength_tag         2
+#define PB_MotorCalibrationRequest_cancel_tag    1
+#define PB_MotorCalibrationRequest_cogging_tag   2
 #define PB_MotorCalibration_calibrated_tag       1
 #define PB_MotorCalibration_zero_electrical_offset_tag 2
 #define PB_MotorCalibration_direction_cw_tag     3
 #define PB_MotorCalibration_pole_pairs_tag       4
+#define PB_MotorCalibrationStatus_phase_tag      1
+#define PB_MotorCalibrationStatus_status_tag     2
+#define PB_MotorCalibrationStatus_progress_tag   3
+#define PB_MotorCalibrationStatus_calibration_tag 4
 #define PB_StrainCalibration_idle_value_tag      1
 #define PB_StrainCalibration_press_delta_tag     2
+#define PB_SensorCalibration_error_cos_tag       1
+#define PB_SensorCalibration_error_sin_tag       2
+#define PB_CoggingCalibration_torque_tag         1
+#define PB_CoggingCalibration_scale_tag          2
 #define PB_PersistentConfiguration_version_tag   1
 #define PB_PersistentConfiguration_motor_tag     2
 #define PB_PersistentConfiguration_strain_tag    3
+#define PB_PersistentConfiguration_sensor_tag    4
+#define PB_PersistentConfiguration_cogging_tag   5
 
 /* Struct field encoding specification for nanopb */
 #define PB_FromSmartKnob_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   protocol_version,   1) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,ack,payload.ack),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,log,payload.log),   3) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (payload,smartknob_state,payload.smartknob_state),   4)
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,smartknob_state,payload.smartknob_state),   4) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,motor_calibration_status,payload.motor_calibration_status),   5) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,telemetry_chunk,payload.telemetry_chunk),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,sensor_capture_chunk,payload.sensor_capture_chunk),   7) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,sensor_health,payload.sensor_health),   8)
 #define PB_FromSmartKnob_CALLBACK NULL
 #define PB_FromSmartKnob_DEFAULT NULL
 #define PB_FromSmartKnob_payload_ack_MSGTYPE PB_Ack
 #define PB_FromSmartKnob_payload_log_MSGTYPE PB_Log
 #define PB_FromSmartKnob_payload_smartknob_state_MSGTYPE PB_SmartKnobState
+#define PB_FromSmartKnob_payload_motor_calibration_status_MSGTYPE PB_MotorCalibrationStatus
+#define PB_FromSmartKnob_payload_telemetry_chunk_MSGTYPE PB_TelemetryChunk
+#define PB_FromSmartKnob_payload_sensor_capture_chunk_MSGTYPE PB_SensorCaptureChunk
+#define PB_FromSmartKnob_payload_sensor_health_MSGTYPE PB_SensorHealth
 
 #define PB_ToSmartknob_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   protocol_version,   1) \
 X(a, STATIC,   SINGULAR, UINT32,   nonce,             2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,request_state,payload.request_state),   3) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (payload,smartknob_config,payload.smartknob_config),   4)
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,smartknob_config,payload.smartknob_config),   4) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,play_haptic_effect,payload.play_haptic_effect),   5) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,motor_calibration,payload.motor_calibration),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,telemetry,payload.telemetry),   7) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,sensor_capture,payload.sensor_capture),   8) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,request_sensor_health,payload.request_sensor_health),   9)
 #define PB_ToSmartknob_CALLBACK NULL
 #define PB_ToSmartknob_DEFAULT NULL
 #define PB_ToSmartknob_payload_request_state_MSGTYPE PB_RequestState
 #define PB_ToSmartknob_payload_smartknob_config_MSGTYPE PB_SmartKnobConfig
+#define PB_ToSmartknob_payload_play_haptic_effect_MSGTYPE PB_PlayHapticEffect
+#define PB_ToSmartknob_payload_motor_calibration_MSGTYPE PB_MotorCalibrationRequest
+#define PB_ToSmartknob_payload_telemetry_MSGTYPE PB_TelemetryRequest
+#define PB_ToSmartknob_payload_sensor_capture_MSGTYPE PB_SensorCaptureRequest
+#define PB_ToSmartknob_payload_request_sensor_health_MSGTYPE PB_RequestSensorHealth
 
 #define PB_Ack_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   nonce,             1)
@@ -318,7 +700,8 @@ X(a, STATIC,   SINGULAR, STRING,   msg,               1)
 X(a, STATIC,   SINGULAR, INT32,    current_position,   1) \
 X(a, STATIC,   SINGULAR, FLOAT,    sub_position_unit,   2) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  config,            3) \
-X(a, STATIC,   SINGULAR, UINT32,   press_nonce,       4)
+X(a, STATIC,   SINGULAR, UINT32,   press_nonce,       4) \
+X(a, STATIC,   SINGULAR, INT32,    position_steps,    5)
 #define PB_SmartKnobState_CALLBACK NULL
 #define PB_SmartKnobState_DEFAULT NULL
 #define PB_SmartKnobState_config_MSGTYPE PB_SmartKnobConfig
@@ -351,24 +734,121 @@ X(a, STATIC,   SINGULAR, FLOAT,    endstop_strength_unit,  10) \
 X(a, STATIC,   SINGULAR, FLOAT,    snap_point,       11) \
 X(a, STATIC,   REPEATED, INT32,    detent_positions,  12) \
 X(a, STATIC,   SINGULAR, FLOAT,    snap_point_bias,  13) \
-X(a, STATIC,   SINGULAR, INT32,    led_hue,          14)
+X(a, STATIC,   SINGULAR, INT32,    led_hue,          14) \
+X(a, STATIC,   REPEATED, FLOAT,    detent_torque_profile,  15) \
+X(a, STATIC,   SINGULAR, BYTES,    detent_runs,      16) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  position_map,     17)
 #define PB_SmartKnobConfig_CALLBACK NULL
 #define PB_SmartKnobConfig_DEFAULT NULL
 #define PB_SmartKnobConfig_view_config_MSGTYPE PB_ViewConfig
+#define PB_SmartKnobConfig_position_map_MSGTYPE PB_PositionMap
+
+#define PB_PositionMap_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   curve,             1) \
+X(a, STATIC,   SINGULAR, FLOAT,    shape,             2) \
+X(a, STATIC,   REPEATED, FLOAT,    segment_widths,    3)
+#define PB_PositionMap_CALLBACK NULL
+#define PB_PositionMap_DEFAULT NULL
 
 #define PB_RequestState_FIELDLIST(X, a) \
 
 #define PB_RequestState_CALLBACK NULL
 #define PB_RequestState_DEFAULT NULL
 
+#define PB_PlayHapticEffect_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   effect,            1) \
+X(a, STATIC,   SINGULAR, FLOAT,    strength,          2)
+#define PB_PlayHapticEffect_CALLBACK NULL
+#define PB_PlayHapticEffect_DEFAULT NULL
+
+#define PB_MotorCalibrationRequest_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, BOOL,     cancel,            1) \
+X(a, STATIC,   SINGULAR, BOOL,     cogging,           2)
+#define PB_MotorCalibrationRequest_CALLBACK NULL
+#define PB_MotorCalibrationRequest_DEFAULT NULL
+
+#define PB_MotorCalibrationStatus_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   phase,             1) \
+X(a, STATIC,   SINGULAR, UINT32,   status,            2) \
+X(a, STATIC,   SINGULAR, FLOAT,    progress,          3) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  calibration,       4)
+#define PB_MotorCalibrationStatus_CALLBACK NULL
+#define PB_MotorCalibrationStatus_DEFAULT NULL
+#define PB_MotorCalibrationStatus_calibration_MSGTYPE PB_MotorCalibration
+
+#define PB_TelemetryRequest_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   trigger,            1) \
+X(a, STATIC,   SINGULAR, UINT32,   frames,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   pre_trigger,        3) \
+X(a, STATIC,   SINGULAR, UINT32,   decimation,         4) \
+X(a, STATIC,   SINGULAR, FLOAT,    velocity_threshold,   5)
+#define PB_TelemetryRequest_CALLBACK NULL
+#define PB_TelemetryRequest_DEFAULT NULL
+
+#define PB_TelemetryChunk_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   first_frame,        1) \
+X(a, STATIC,   SINGULAR, BYTES,    frames,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   frame_size,         3) \
+X(a, STATIC,   SINGULAR, BOOL,     end,                4) \
+X(a, STATIC,   SINGULAR, UINT32,   dropped,            5)
+#define PB_TelemetryChunk_CALLBACK NULL
+#define PB_TelemetryChunk_DEFAULT NULL
+
+#define PB_SensorCaptureRequest_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   frames,             1)
+#define PB_SensorCaptureRequest_CALLBACK NULL
+#define PB_SensorCaptureRequest_DEFAULT NULL
+
+#define PB_SensorCaptureChunk_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   first_frame,        1) \
+X(a, STATIC,   SINGULAR, BYTES,    frames,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   frame_size,         3) \
+X(a, STATIC,   SINGULAR, UINT32,   format,             4) \
+X(a, STATIC,   SINGULAR, BOOL,     end,                5) \
+X(a, STATIC,   SINGULAR, UINT32,   dropped,            6)
+#define PB_SensorCaptureChunk_CALLBACK NULL
+#define PB_SensorCaptureChunk_DEFAULT NULL
+
+#define PB_RequestSensorHealth_FIELDLIST(X, a) \
+
+#define PB_RequestSensorHealth_CALLBACK NULL
+#define PB_RequestSensorHealth_DEFAULT NULL
+
+#define PB_SensorHealthCounts_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   samples,           1) \
+X(a, STATIC,   SINGULAR, UINT32,   crc_errors,        2) \
+X(a, STATIC,   SINGULAR, UINT32,   field_too_strong,   3) \
+X(a, STATIC,   SINGULAR, UINT32,   field_too_weak,    4) \
+X(a, STATIC,   SINGULAR, UINT32,   loss_of_track,     5) \
+X(a, STATIC,   SINGULAR, UINT32,   max_age_micros,    6) \
+X(a, STATIC,   SINGULAR, UINT32,   stale_iterations,   7) \
+X(a, STATIC,   SINGULAR, UINT32,   stuck_frames,      8)
+#define PB_SensorHealthCounts_CALLBACK NULL
+#define PB_SensorHealthCounts_DEFAULT NULL
+
+#define PB_SensorHealth_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   window_millis,     1) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  window,            2) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  total,             3) \
+X(a, STATIC,   SINGULAR, BOOL,     stale,             4) \
+X(a, STATIC,   SINGULAR, BOOL,     readings_reported,   5)
+#define PB_SensorHealth_CALLBACK NULL
+#define PB_SensorHealth_DEFAULT NULL
+#define PB_SensorHealth_window_MSGTYPE PB_SensorHealthCounts
+#define PB_SensorHealth_total_MSGTYPE PB_SensorHealthCounts
+
 #define PB_PersistentConfiguration_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, UINT32,   version,           1) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  motor,             2) \
-X(a, STATIC,   OPTIONAL, MESSAGE,  strain,            3)
+X(a, STATIC,   OPTIONAL, MESSAGE,  strain,            3) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  sensor,            4) \
+X(a, STATIC,   OPTIONAL, MESSAGE,  cogging,           5)
 #define PB_PersistentConfiguration_CALLBACK NULL
 #define PB_PersistentConfiguration_DEFAULT NULL
 #define PB_PersistentConfiguration_motor_MSGTYPE PB_MotorCalibration
 #define PB_PersistentConfiguration_strain_MSGTYPE PB_StrainCalibration
+#define PB_PersistentConfiguration_sensor_MSGTYPE PB_SensorCalibration
+#define PB_PersistentConfiguration_cogging_MSGTYPE PB_CoggingCalibration
 
 #define PB_MotorCalibration_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, BOOL,     calibrated,        1) \
@@ -384,6 +864,18 @@ X(a, STATIC,   SINGULAR, INT32,    press_delta,       2)
 #define PB_StrainCalibration_CALLBACK NULL
 #define PB_StrainCalibration_DEFAULT NULL
 
+#define PB_SensorCalibration_FIELDLIST(X, a) \
+X(a, STATIC,   REPEATED, FLOAT,    error_cos,         1) \
+X(a, STATIC,   REPEATED, FLOAT,    error_sin,         2)
+#define PB_SensorCalibration_CALLBACK NULL
+#define PB_SensorCalibration_DEFAULT NULL
+
+#define PB_CoggingCalibration_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, BYTES,    torque,            1) \
+X(a, STATIC,   SINGULAR, FLOAT,    scale,             2)
+#define PB_CoggingCalibration_CALLBACK NULL
+#define PB_CoggingCalibration_DEFAULT NULL
+
 extern const pb_msgdesc_t PB_FromSmartKnob_msg;
 extern const pb_msgdesc_t PB_ToSmartknob_msg;
 extern const pb_msgdesc_t PB_Ack_msg;
@@ -392,10 +884,23 @@ extern const pb_msgdesc_t PB_SmartKnobState_msg;
 extern const pb_msgdesc_t PB_ViewConfig_msg;
 extern const pb_msgdesc_t PB_MenuEntry_msg;
 extern const pb_msgdesc_t PB_SmartKnobConfig_msg;
+extern const pb_msgdesc_t PB_PositionMap_msg;
 extern const pb_msgdesc_t PB_RequestState_msg;
+extern const pb_msgdesc_t PB_PlayHapticEffect_msg;
+extern const pb_msgdesc_t PB_MotorCalibrationRequest_msg;
+extern const pb_msgdesc_t PB_MotorCalibrationStatus_msg;
+extern const pb_msgdesc_t PB_TelemetryRequest_msg;
+extern const pb_msgdesc_t PB_TelemetryChunk_msg;
+extern const pb_msgdesc_t PB_SensorCaptureRequest_msg;
+extern const pb_msgdesc_t PB_SensorCaptureChunk_msg;
+extern const pb_msgdesc_t PB_RequestSensorHealth_msg;
+extern const pb_msgdesc_t PB_SensorHealthCounts_msg;
+extern const pb_msgdesc_t PB_SensorHealth_msg;
 extern const pb_msgdesc_t PB_PersistentConfiguration_msg;
 extern const pb_msgdesc_t PB_MotorCalibration_msg;
 extern const pb_msgdesc_t PB_StrainCalibration_msg;
+extern const pb_msgdesc_t PB_SensorCalibration_msg;
+extern const pb_msgdesc_t PB_CoggingCalibration_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
 #define PB_FromSmartKnob_fields &PB_FromSmartKnob_msg
@@ -406,23 +911,49 @@ extern const pb_msgdesc_t PB_StrainCalibration_msg;
 #define PB_ViewConfig_fields &PB_ViewConfig_msg
 #define PB_MenuEntry_fields &PB_MenuEntry_msg
 #define PB_SmartKnobConfig_fields &PB_SmartKnobConfig_msg
+#define PB_PositionMap_fields &PB_PositionMap_msg
 #define PB_RequestState_fields &PB_RequestState_msg
+#define PB_PlayHapticEffect_fields &PB_PlayHapticEffect_msg
+#define PB_MotorCalibrationRequest_fields &PB_MotorCalibrationRequest_msg
+#define PB_MotorCalibrationStatus_fields &PB_MotorCalibrationStatus_msg
+#define PB_TelemetryRequest_fields &PB_TelemetryRequest_msg
+#define PB_TelemetryChunk_fields &PB_TelemetryChunk_msg
+#define PB_SensorCaptureRequest_fields &PB_SensorCaptureRequest_msg
+#define PB_SensorCaptureChunk_fields &PB_SensorCaptureChunk_msg
+#define PB_RequestSensorHealth_fields &PB_RequestSensorHealth_msg
+#define PB_SensorHealthCounts_fields &PB_SensorHealthCounts_msg
+#define PB_SensorHealth_fields &PB_SensorHealth_msg
 #define PB_PersistentConfiguration_fields &PB_PersistentConfiguration_msg
 #define PB_MotorCalibration_fields &PB_MotorCalibration_msg
 #define PB_StrainCalibration_fields &PB_StrainCalibration_msg
+#define PB_SensorCalibration_fields &PB_SensorCalibration_msg
+#define PB_CoggingCalibration_fields &PB_CoggingCalibration_msg
 
 /* Maximum encoded size of messages (where known) */
 #define PB_Ack_size                              6
-#define PB_FromSmartKnob_size                    442
+#define PB_CoggingCalibration_size               520
+#define PB_FromSmartKnob_size                    921
 #define PB_Log_size                              258
 #define PB_MenuEntry_size                        26
+#define PB_MotorCalibrationRequest_size          4
+#define PB_MotorCalibrationStatus_size           28
 #define PB_MotorCalibration_size                 15
-#define PB_PersistentConfiguration_size          47
+#define PB_PersistentConfiguration_size          608
+#define PB_PlayHapticEffect_size                 8
+#define PB_PositionMap_size                      74
+#define PB_RequestSensorHealth_size              0
 #define PB_RequestState_size                     0
-#define PB_SmartKnobConfig_size                  414
-#define PB_SmartKnobState_size                   436
+#define PB_SensorCalibration_size                36
+#define PB_SensorCaptureChunk_size               247
+#define PB_SensorCaptureRequest_size             6
+#define PB_SensorHealthCounts_size               48
+#define PB_SensorHealth_size                     110
+#define PB_SmartKnobConfig_size                  882
+#define PB_SmartKnobState_size                   915
 #define PB_StrainCalibration_size                22
-#define PB_ToSmartknob_size                      426
+#define PB_TelemetryChunk_size                   244
+#define PB_TelemetryRequest_size                 22
+#define PB_ToSmartknob_size                      894
 #define PB_ViewConfig_size                       277
 
 #ifdef __cplusplus
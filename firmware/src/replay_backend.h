@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct ReplaySample {
+    uint32_t micros;
+    // Angle in [0, 2PI), as a sensor driver would return it
+    float radians;
+};
+
+/**
+ * @brief AngleSource backend (angle_source.h) that plays back a recorded or synthetic stream of readings.
+ *
+ * The replay runs on a clock set by the caller, so a run is deterministic: read() returns the latest
+ * sample at or before the time given to setTime(), as a driver returns its latest reading. For host tools
+ * and benchmarks; the firmware never instantiates it.
+ */
+class ReplayBackend {
+    public:
+        explicit ReplayBackend(std::vector<ReplaySample> samples = {}) : samples_(std::move(samples)) {}
+
+        void init() {
+            next_ = 0;
+            now_micros_ = samples_.empty() ? 0 : samples_.front().micros;
+        }
+
+        // Moves the replay clock; only forwards
+        void setTime(uint32_t now_micros) {
+            now_micros_ = now_micros;
+        }
+
+        // Latest sample at or before the replay clock, or -1 before the first
+        float read() {
+            while (next_ < samples_.size() && (int32_t)(samples_[next_].micros - now_micros_) <= 0) {
+                next_++;
+            }
+            return next_ == 0 ? -1 : samples_[next_ - 1].radians;
+        }
+
+        uint32_t sampleMicros() const { return next_ == 0 ? 0 : samples_[next_ - 1].micros; }
+
+        bool takeError(char*, size_t) { return false; }
+
+        // True once the clock has passed the last sample
+        bool finished() const { return next_ >= samples_.size(); }
+        const std::vector<ReplaySample>& samples() const { return samples_; }
+
+    private:
+        std::vector<ReplaySample> samples_;
+        size_t next_ = 0;
+        uint32_t now_micros_ = 0;
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Frames the sensor capture ring holds (a power of two): 2048 frames are 1 s at the default 2 kHz sampling
+// rate, buffered while the serial protocol streams them out
+#ifndef SK_SENSOR_CAPTURE_FRAMES
+    #define SK_SENSOR_CAPTURE_FRAMES 2048
+#endif // SK_SENSOR_CAPTURE_FRAMES
+
+/**
+ * @brief One raw reading of the angle sensor, exactly as the driver received it, as recorded by a SensorCapture.
+ *
+ * Streamed to the host as raw bytes (see SensorCaptureChunk in smartknob.proto), in the ESP32's native
+ * little-endian layout; software/tools/sensor_replay.cpp includes this header to decode them.
+ */
+struct SensorCaptureFrame {
+    uint32_t micros; // micros() when the reading was received
+    uint32_t raw;    // Reading as sent by the sensor, in the layout given by the capture's SensorCaptureFormat
+};
+
+static_assert(sizeof(SensorCaptureFrame) == 8, "SensorCaptureFrame is streamed raw; the host tools expect this layout");
+
+enum class SensorCaptureFormat : uint8_t {
+    NONE = 0,       // The sensor driver doesn't record its readings
+    MT6701_SSI = 1, // 24-bit MT6701 SSI frame, CRC included, in the low bits (see mt6701_frame.h)
+};
+
+/**
+ * @brief Lock-free single-producer, single-consumer ring of raw sensor readings, for one capture at a time.
+ *
+ * The sensor driver (producer, in the motor task) calls record() with every frame it receives, before
+ * any decoding, so a capture holds CRC errors and noise exactly as the sensor produced them. The serial
+ * protocol (consumer) starts a capture and drains it concurrently, at its own pace:
+ *  - IDLE: nothing is recorded. Only the consumer may start().
+ *  - CAPTURING: the producer appends frames. When the ring is full, frames are dropped (and counted)
+ *    instead of waiting for the consumer.
+ *  - DONE: all frames were recorded (or the capture was stopped); once the consumer has read the rest,
+ *    finish() returns the ring to IDLE.
+ *
+ * As TelemetryBuffer, each index is only ever advanced by one side, and ownership of the state changes
+ * hands via release/acquire. While idle, record() is a single atomic load.
+ *
+ * Hardware-free, so the host tools share the frame layout.
+ */
+class SensorCapture {
+    public:
+        static const uint32_t CAPACITY = SK_SENSOR_CAPTURE_FRAMES;
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SK_SENSOR_CAPTURE_FRAMES must be a power of two");
+
+        // Set by the sensor driver that records into this capture, when it is linked to it
+        void setFormat(SensorCaptureFormat format) { format_.store(format, std::memory_order_relaxed); }
+        SensorCaptureFormat format() const { return format_.load(std::memory_order_relaxed); }
+
+        // Producer side; must only be called from the task that runs the sensor driver
+
+        void record(uint32_t raw, uint32_t micros) {
+            if (state_.load(std::memory_order_acquire) != State::CAPTURING) {
+                return;
+            }
+            if (stop_.load(std::memory_order_relaxed)) {
+                state_.store(State::DONE, std::memory_order_release);
+                return;
+            }
+
+            uint32_t write = write_.load(std::memory_order_relaxed);
+            if (write - read_.load(std::memory_order_acquire) >= CAPACITY) {
+                dropped_++;
+            } else {
+                frames_[write & MASK] = {micros, raw};
+                write_.store(write + 1, std::memory_order_release);
+            }
+
+            remaining_--;
+            if (remaining_ == 0) {
+                state_.store(State::DONE, std::memory_order_release);
+            }
+        }
+
+        // Consumer side; must only be called from one task (the serial protocol)
+
+        bool idle() const {
+            return state_.load(std::memory_order_acquire) == State::IDLE;
+        }
+
+        // Start recording the next frames. Returns false if a capture is still running or not yet read,
+        // or if the sensor driver doesn't record its readings.
+        bool start(uint32_t frames) {
+            if (!idle() || frames == 0 || format() == SensorCaptureFormat::NONE) {
+                return false;
+            }
+            remaining_ = frames;
+            dropped_ = 0;
+            capture_start_ = write_.load(std::memory_order_relaxed);
+            read_.store(capture_start_, std::memory_order_relaxed);
+            stop_.store(false, std::memory_order_relaxed);
+            state_.store(State::CAPTURING, std::memory_order_release);
+            return true;
+        }
+
+        // End the current capture early, with the next frame. Frames recorded so far can still be read.
+        void stop() {
+            if (!idle()) {
+                stop_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Copy up to max_frames recorded frames to out (unaligned bytes are fine).
+         *
+         * @param first_frame Set to the index of the first copied frame within the capture
+         * @return Number of frames copied
+         */
+        uint16_t read(uint8_t* out, uint16_t max_frames, uint32_t& first_frame) {
+            if (idle()) {
+                return 0;
+            }
+            uint32_t read = read_.load(std::memory_order_relaxed);
+            uint32_t available = write_.load(std::memory_order_acquire) - read;
+            uint16_t count = available < max_frames ? available : max_frames;
+            for (uint16_t i = 0; i < count; i++) {
+                memcpy(out + i * sizeof(SensorCaptureFrame), &frames_[(read + i) & MASK], sizeof(SensorCaptureFrame));
+            }
+            first_frame = read - capture_start_;
+            read_.store(read + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @brief Return to idle once a capture has ended and all its frames were read.
+         *
+         * @param dropped Set to the number of frames that were dropped because the ring was full
+         * @return true once per capture, when it was finished
+         */
+        bool finish(uint32_t& dropped) {
+            if (state_.load(std::memory_order_acquire) != State::DONE
+                    || read_.load(std::memory_order_relaxed) != write_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            dropped = dropped_;
+            state_.store(State::IDLE, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        enum class State : uint8_t {
+            IDLE,
+            CAPTURING,
+            DONE,
+        };
+
+        static const uint32_t MASK = CAPACITY - 1;
+
+        std::atomic<SensorCaptureFormat> format_ = SensorCaptureFormat::NONE;
+
+        std::atomic<State> state_ = State::IDLE;
+        std::atomic<bool> stop_ = false;
+
+        // Free-running frame counters; the slot of a frame is its counter modulo CAPACITY
+        std::atomic<uint32_t> write_ = 0;
+        std::atomic<uint32_t> read_ = 0;
+
+        // Written by the consumer while idle, by the producer while capturing
+        uint32_t remaining_ = 0;
+        uint32_t capture_start_ = 0;
+        uint32_t dropped_ = 0;
+
+        SensorCaptureFrame frames_[CAPACITY];
+};
@@ -0,0 +1,69 @@
+#include <cmath>
+
+#include "sensor_correction.h"
+
+void SensorCorrection::set(const float* cos_coefficients, const float* sin_coefficients, uint8_t count) {
+    if (count > MAX_HARMONICS) {
+        count = MAX_HARMONICS;
+    }
+    for (uint16_t i = 0; i < TABLE_SIZE; i++) {
+        table_[i] = error(cos_coefficients, sin_coefficients, count, i / TABLE_SCALE);
+    }
+    table_[TABLE_SIZE] = table_[0];
+    enabled_ = count > 0;
+}
+
+float SensorCorrection::maxError() const {
+    if (!enabled_) {
+        return 0;
+    }
+    float max_error = 0;
+    for (uint16_t i = 0; i < TABLE_SIZE; i++) {
+        max_error = fmaxf(max_error, fabsf(table_[i]));
+    }
+    return max_error;
+}
+
+float SensorCorrection::error(const float* cos_coefficients, const float* sin_coefficients, uint8_t count, float angle) {
+    float error = 0;
+    for (uint8_t k = 1; k <= count; k++) {
+        error += cos_coefficients[k - 1] * cosf(k * angle) + sin_coefficients[k - 1] * sinf(k * angle);
+    }
+    return error;
+}
+
+void SensorCorrectionFit::clear() {
+    *this = SensorCorrectionFit();
+}
+
+void SensorCorrectionFit::add(float raw_angle, float error) {
+    // cos/sin of the higher harmonics by angle addition, so each sample costs one cosf/sinf pair
+    float c1 = cosf(raw_angle);
+    float s1 = sinf(raw_angle);
+    float c = c1;
+    float s = s1;
+    for (uint8_t k = 0; k < SensorCorrection::MAX_HARMONICS; k++) {
+        sum_cos_[k] += c;
+        sum_sin_[k] += s;
+        sum_error_cos_[k] += error * c;
+        sum_error_sin_[k] += error * s;
+        float next_c = c * c1 - s * s1;
+        s = s * c1 + c * s1;
+        c = next_c;
+    }
+    sum_error_ += error;
+    count_++;
+}
+
+bool SensorCorrectionFit::solve(float* cos_coefficients, float* sin_coefficients) const {
+    if (count_ == 0) {
+        return false;
+    }
+    // Projection onto each harmonic, with the mean error removed
+    float mean_error = sum_error_ / count_;
+    for (uint8_t k = 0; k < SensorCorrection::MAX_HARMONICS; k++) {
+        cos_coefficients[k] = 2 * (sum_error_cos_[k] - mean_error * sum_cos_[k]) / count_;
+        sin_coefficients[k] = 2 * (sum_error_sin_[k] - mean_error * sum_sin_[k]) / count_;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Correction for the position-dependent angle error of a magnetic sensor.
+ *
+ * Magnet eccentricity and sensor nonlinearity make the measured angle deviate from the true
+ * shaft angle by an amount that repeats every revolution. The error is described by the first
+ * few harmonics of a Fourier series over the raw sensor angle (see SensorCalibration in
+ * smartknob.proto), and set() bakes it into a lookup table, so correcting a reading costs a table
+ * lookup and a linear interpolation.
+ *
+ * Hardware-free, so the sensor drivers, the calibration and host tools share the same code
+ * (software/tools/sensor_correction_check.cpp checks the fit and the table).
+ */
+class SensorCorrection {
+    public:
+        // Must match the max_count of the SensorCalibration coefficients in smartknob.proto
+        static const uint8_t MAX_HARMONICS = 4;
+        static const uint16_t TABLE_SIZE = 256;
+
+        // Set the error of a raw angle a from count harmonics (k = 1..count): error(a) = sum(cos[k-1] * cos(k*a) + sin[k-1] * sin(k*a))
+        void set(const float* cos_coefficients, const float* sin_coefficients, uint8_t count);
+        void clear() { enabled_ = false; }
+        bool enabled() const { return enabled_; }
+
+        // Corrected angle for a raw sensor angle, both in [0, 2PI). Returns the raw angle if no correction is set.
+        float apply(float raw_angle) const {
+            if (!enabled_) {
+                return raw_angle;
+            }
+            float x = raw_angle * TABLE_SCALE;
+            int32_t i = (int32_t)x;
+            if (i >= TABLE_SIZE) {
+                // raw_angle rounded up to exactly 2PI
+                i = TABLE_SIZE - 1;
+            }
+            float fraction = x - i;
+            float corrected = raw_angle - (table_[i] + (table_[i + 1] - table_[i]) * fraction);
+            return wrap(corrected);
+        }
+
+        // Largest absolute error in the table, in radians
+        float maxError() const;
+
+        // Error at the given raw angle, evaluated directly from the Fourier series
+        static float error(const float* cos_coefficients, const float* sin_coefficients, uint8_t count, float angle);
+
+    private:
+        static constexpr float TWO_PI = 6.28318530717958647692f;
+        static constexpr float TABLE_SCALE = TABLE_SIZE / TWO_PI;
+
+        // Error to subtract at each raw angle i * 2PI / TABLE_SIZE, plus a copy of the first entry
+        // so interpolation never has to wrap
+        float table_[TABLE_SIZE + 1];
+        bool enabled_ = false;
+
+        static float wrap(float angle) {
+            if (angle < 0) {
+                return angle + TWO_PI;
+            }
+            if (angle >= TWO_PI) {
+                return angle - TWO_PI;
+            }
+            return angle;
+        }
+};
+
+/**
+ * @brief Fits the harmonics of a SensorCorrection to measured sensor errors.
+ *
+ * Samples must be spread evenly over whole revolutions (e.g. taken at constant speed while the
+ * motor turns exactly one revolution), which reduces the least squares fit to accumulating
+ * Fourier projections. A constant offset in the errors doesn't matter.
+ */
+class SensorCorrectionFit {
+    public:
+        void clear();
+        // Add the error measured at the given raw sensor angle
+        void add(float raw_angle, float error);
+
+        uint32_t count() const { return count_; }
+        // Write the fitted coefficients (MAX_HARMONICS each). Returns false if there are no samples.
+        bool solve(float* cos_coefficients, float* sin_coefficients) const;
+
+    private:
+        uint32_t count_ = 0;
+        float sum_error_ = 0;
+        float sum_cos_[SensorCorrection::MAX_HARMONICS] = {};
+        float sum_sin_[SensorCorrection::MAX_HARMONICS] = {};
+        float sum_error_cos_[SensorCorrection::MAX_HARMONICS] = {};
+        float sum_error_sin_[SensorCorrection::MAX_HARMONICS] = {};
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+
+#include "seqlock.h"
+
+// Length of the windows the sensor's health is counted over; each complete window is published (see SensorHealth)
+#ifndef SK_SENSOR_HEALTH_WINDOW_MILLIS
+    #define SK_SENSOR_HEALTH_WINDOW_MILLIS 1000
+#endif // SK_SENSOR_HEALTH_WINDOW_MILLIS
+
+// Age of the latest valid sensor reading above which the motor loop stops driving the motor: the haptics would
+// push against where the knob was, not where it is. Ten samples at the default 2 kHz sampling rate; readings that
+// fail their CRC don't count as fresh.
+#ifndef SK_SENSOR_STALE_MICROS
+    #define SK_SENSOR_STALE_MICROS 5000
+#endif // SK_SENSOR_STALE_MICROS
+
+/**
+ * @brief Counts of the angle sensor's readings over some period.
+ */
+struct SensorHealthCounts {
+    uint32_t samples;          // Readings received from the sensor
+    uint32_t crc_errors;       // Readings discarded because their CRC didn't match
+    uint32_t field_too_strong; // Valid readings flagging the magnetic field as too strong
+    uint32_t field_too_weak;   // Valid readings flagging the magnetic field as too weak
+    uint32_t loss_of_track;    // Valid readings flagging that the sensor lost track of the magnet
+    uint32_t max_age_micros;   // Oldest the latest valid reading was when a motor loop iteration used it
+    uint32_t stale_iterations; // Motor loop iterations that didn't drive the motor, because the reading was stale
+    uint32_t stuck_frames;     // Readings discarded because every bit was the same: no sensor drove the data line
+
+    void add(const SensorHealthCounts& other) {
+        samples += other.samples;
+        crc_errors += other.crc_errors;
+        field_too_strong += other.field_too_strong;
+        field_too_weak += other.field_too_weak;
+        loss_of_track += other.loss_of_track;
+        max_age_micros = other.max_age_micros > max_age_micros ? other.max_age_micros : max_age_micros;
+        stale_iterations += other.stale_iterations;
+        stuck_frames += other.stuck_frames;
+    }
+
+    // Whether any reading was flagged or any iteration was stale
+    bool problems() const {
+        return crc_errors + field_too_strong + field_too_weak + loss_of_track + stale_iterations + stuck_frames > 0;
+    }
+};
+
+/**
+ * @brief Health of the angle sensor, as published at the end of each window.
+ */
+struct SensorHealthReport {
+    uint32_t window_micros;    // Length of the window below (0 until the first window is complete)
+    SensorHealthCounts window; // Counts over the last complete window
+    SensorHealthCounts total;  // Counts since begin(), up to the end of that window
+    bool stale;                // Whether the reading was stale at the end of the window
+    // Whether the sensor driver reports its readings with recordSample(). If not, samples and the flag counts
+    // stay 0 whatever the sensor's health, and only the age of the readings is counted.
+    bool readings_reported;
+};
+
+/**
+ * @brief Per-window accounting of the angle sensor's health, and the staleness check that gates the torque.
+ *
+ * The sensor driver reports every reading it receives with recordSample(), along with what the reading
+ * flagged; the motor loop checks the age of the reading it uses with checkAge() and closes the windows
+ * with update(). All three run in the motor task and only increment plain counters, so they cost a few
+ * cycles per reading. At the end of each window, the counts are published with a SeqLock, and other
+ * tasks read them with report() without blocking the motor loop. The age is checked for every sensor, but
+ * only some drivers report their readings (see setReadingsReported()).
+ *
+ * Hardware-free, so the accounting is checked on the host (software/tools/sensor_health_check.cpp).
+ */
+class SensorHealth {
+    public:
+        enum Flag : uint8_t {
+            CRC_ERROR = 1 << 0,
+            FIELD_TOO_STRONG = 1 << 1,
+            FIELD_TOO_WEAK = 1 << 2,
+            LOSS_OF_TRACK = 1 << 3,
+            STUCK_FRAME = 1 << 4,
+        };
+
+        void begin(uint32_t now_micros, uint32_t window_micros = SK_SENSOR_HEALTH_WINDOW_MILLIS * 1000, uint32_t stale_micros = SK_SENSOR_STALE_MICROS) {
+            window_micros_ = window_micros;
+            stale_micros_ = stale_micros;
+            window_start_micros_ = now_micros;
+            current_ = {};
+            total_ = {};
+            stale_ = false;
+            SensorHealthReport report = {};
+            report.readings_reported = readings_reported_;
+            report_.write(report);
+        }
+
+        // Whether a sensor driver reports its readings with recordSample(), so that the reports say whether
+        // their samples and flag counts mean anything; kept across begin()
+        void setReadingsReported(bool reported) {
+            readings_reported_ = reported;
+        }
+
+        // Sensor driver: a reading was received, with the Flag bits it raised (0 for a good reading)
+        void recordSample(uint8_t flags) {
+            current_.samples++;
+            if (flags != 0) {
+                recordFlags(flags);
+            }
+        }
+
+        /**
+         * @brief Motor loop: check the age of the reading an iteration is about to use.
+         *
+         * @param sample_micros When the latest valid reading was sampled
+         * @param now_micros When the iteration started
+         * @return false if the reading is too old to drive the motor with
+         */
+        bool checkAge(uint32_t sample_micros, uint32_t now_micros) {
+            // A reading that arrived after the iteration started is as fresh as it gets
+            int32_t age = (int32_t)(now_micros - sample_micros);
+            uint32_t age_micros = age > 0 ? age : 0;
+            if (age_micros > current_.max_age_micros) {
+                current_.max_age_micros = age_micros;
+            }
+            stale_ = age_micros > stale_micros_;
+            if (stale_) {
+                current_.stale_iterations++;
+            }
+            return !stale_;
+        }
+
+        // Whether the last checkAge() found the reading stale
+        bool stale() const { return stale_; }
+
+        // Motor loop: closes the window once it is over and publishes it. Returns true when it did.
+        bool update(uint32_t now_micros) {
+            uint32_t elapsed = now_micros - window_start_micros_;
+            if (elapsed < window_micros_) {
+                return false;
+            }
+            total_.add(current_);
+            report_.write({
+                .window_micros = elapsed,
+                .window = current_,
+                .total = total_,
+                .stale = stale_,
+                .readings_reported = readings_reported_,
+            });
+            current_ = {};
+            window_start_micros_ = now_micros;
+            return true;
+        }
+
+        // Any task: the last complete window
+        SensorHealthReport report() const {
+            SensorHealthReport report;
+            report_.read(report);
+            return report;
+        }
+
+    private:
+        uint32_t window_micros_ = SK_SENSOR_HEALTH_WINDOW_MILLIS * 1000;
+        uint32_t stale_micros_ = SK_SENSOR_STALE_MICROS;
+        uint32_t window_start_micros_ = 0;
+        bool readings_reported_ = false;
+
+        // Motor task only
+        SensorHealthCounts current_ = {};
+        SensorHealthCounts total_ = {};
+        bool stale_ = false;
+
+        SeqLock<SensorHealthReport> report_;
+
+        void recordFlags(uint8_t flags) {
+            if (flags & STUCK_FRAME) {
+                // Not a reading at all
+                current_.stuck_frames++;
+                return;
+            }
+            if (flags & CRC_ERROR) {
+                // The rest of a reading with a bad CRC can't be trusted
+                current_.crc_errors++;
+                return;
+            }
+            current_.field_too_strong += (flags & FIELD_TOO_STRONG) != 0;
+            current_.field_too_weak += (flags & FIELD_TOO_WEAK) != 0;
+            current_.loss_of_track += (flags & LOSS_OF_TRACK) != 0;
+        }
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Single-writer, multi-reader sequence lock for sharing a small struct without blocking.
+ *
+ * The writer never waits. Readers copy the value and retry if the writer was active while they
+ * were copying (odd sequence number, or sequence changed during the copy), so they can never
+ * observe a torn value.
+ *
+ * read() spins while a write is in progress, so a reader calling it must never preempt the writer
+ * on the same core (on the SmartKnob the writer is usually the motor task, which has core 1 to itself).
+ * tryRead() makes a single attempt and gives up instead, for readers that must not wait on the writer.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied with memcpy");
+
+    public:
+        void write(const T& value) {
+            uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            memcpy(&value_, &value, sizeof(T));
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        // Copies the latest value into out and returns its (even) sequence number, which changes on every write
+        uint32_t read(T& out) const {
+            uint32_t before;
+            uint32_t after;
+            do {
+                before = sequence_.load(std::memory_order_acquire);
+                memcpy(&out, &value_, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence_.load(std::memory_order_relaxed);
+            } while (before != after || (before & 1));
+            return before;
+        }
+
+        // Copies the value into out once. Returns false, leaving out unspecified, if a write was in progress
+        // or happened during the copy; otherwise true, with the value's (even) sequence number.
+        bool tryRead(T& out, uint32_t& sequence) const {
+            uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                return false;
+            }
+            memcpy(&out, &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) != before) {
+                return false;
+            }
+            sequence = before;
+            return true;
+        }
+
+        uint32_t sequence() const {
+            return sequence_.load(std::memory_order_acquire) & ~1u;
+        }
+
+    private:
+        std::atomic<uint32_t> sequence_ = 0;
+        T value_ = {};
+};
@@ -4,6 +4,13 @@
 
 #define PROTOBUF_PROTOCOL_VERSION (1)
 
+bool position_map_eq(PB_PositionMap& first, PB_PositionMap& second) {
+    return first.curve == second.curve
+        && first.shape == second.shape
+        && first.segment_widths_count == second.segment_widths_count
+        && memcmp(first.segment_widths, second.segment_widths, first.segment_widths_count * sizeof(first.segment_widths[0])) == 0;
+}
+
 bool config_eq(PB_SmartKnobConfig& first, PB_SmartKnobConfig& second) {
     return first.detent_strength_unit == second.detent_strength_unit
         && first.endstop_strength_unit == second.endstop_strength_unit
@@ -15,13 +22,18 @@ bool config_eq(PB_SmartKnobConfig& first, PB_SmartKnobConfig& second) {
         && first.snap_point == second.snap_point
         && first.sub_position_unit == second.sub_position_unit
         && first.detent_positions_count == second.detent_positions_count
-        && memcmp(first.detent_positions, second.detent_positions, first.detent_positions_count * sizeof(first.detent_positions[0]))
-        && first.snap_point_bias == second.snap_point_bias;
+        && memcmp(first.detent_positions, second.detent_positions, first.detent_positions_count * sizeof(first.detent_positions[0])) == 0
+        && first.detent_runs.size == second.detent_runs.size
+        && memcmp(first.detent_runs.bytes, second.detent_runs.bytes, first.detent_runs.size) == 0
+        && first.snap_point_bias == second.snap_point_bias
+        && first.has_position_map == second.has_position_map
+        && (!first.has_position_map || position_map_eq(first.position_map, second.position_map));
 }
 
 bool state_eq(PB_SmartKnobState& first, PB_SmartKnobState& second) {
     return first.has_config == second.has_config
         && (!first.has_config || config_eq(first.config, second.config))
         && first.current_position == second.current_position
-        && first.sub_position_unit == second.sub_position_unit;
+        && first.sub_position_unit == second.sub_position_unit
+        && first.position_steps == second.position_steps;
 }
@@ -19,6 +19,9 @@ class SerialProtocol : public Logger {
 
         virtual void handleState(const PB_SmartKnobState& state) = 0;
 
+        // Progress of a motor calibration. Results and errors are also logged, so this is optional.
+        virtual void handleCalibrationStatus(const PB_MotorCalibrationStatus& status) {}
+
         virtual void setProtocolChangeCallback(ProtocolChangeCallback cb) {
             protocol_change_callback_ = cb;
         }
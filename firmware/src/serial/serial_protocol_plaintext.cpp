@@ -41,10 +41,22 @@ void SerialProtocolPlaintext::loop() {
             }
         } else if (b == 'C') {
             motor_calibration_callback_();
+        } else if (b == 'X') {
+            if (motor_calibration_cancel_callback_) {
+                motor_calibration_cancel_callback_();
+            }
+        } else if (b == 'G') {
+            if (cogging_calibration_callback_) {
+                cogging_calibration_callback_();
+            }
         } else if (b == 'S') {
             if (strain_calibration_callback_) {
                 strain_calibration_callback_();
             }
+        } else if (b == 'T') {
+            if (loop_timing_report_callback_) {
+                loop_timing_report_callback_();
+            }
         }
     }
 }
@@ -53,10 +65,16 @@ void SerialProtocolPlaintext::init(
     DemoConfigChangeCallback demo_config_change_callback
     , StrainCalibrationCallback strain_calibration_callback
     , MotorCalibrationCallback motor_calibration_callback
+    , MotorCalibrationCancelCallback motor_calibration_cancel_callback
+    , CoggingCalibrationCallback cogging_calibration_callback
+    , LoopTimingReportCallback loop_timing_report_callback
 ) {
     demo_config_change_callback_ = demo_config_change_callback;
     strain_calibration_callback_ = strain_calibration_callback;
     motor_calibration_callback_ = motor_calibration_callback;
+    motor_calibration_cancel_callback_ = motor_calibration_cancel_callback;
+    cogging_calibration_callback_ = cogging_calibration_callback;
+    loop_timing_report_callback_ = loop_timing_report_callback;
 
-    stream_.println("SmartKnob starting!\n\nSerial mode: plaintext\nPress 'C' at any time to calibrate motor/sensor.\nPress 'S' at any time to calibrate strain sensors.\nPress <Space> to change haptic modes.\n");
+    stream_.println("SmartKnob starting!\n\nSerial mode: plaintext\nPress 'C' at any time to calibrate motor/sensor, 'X' to cancel the calibration.\nPress 'G' to measure the motor's cogging torque (after calibrating the motor).\nPress 'S' at any time to calibrate strain sensors.\nPress 'T' to report motor loop timing.\nPress <Space> to change haptic modes.\n");
 }
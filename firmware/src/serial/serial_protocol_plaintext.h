@@ -9,6 +9,9 @@
 typedef std::function<void(void)> DemoConfigChangeCallback;
 typedef std::function<void(void)> StrainCalibrationCallback;
 typedef std::function<void(void)> MotorCalibrationCallback;
+typedef std::function<void(void)> MotorCalibrationCancelCallback;
+typedef std::function<void(void)> CoggingCalibrationCallback;
+typedef std::function<void(void)> LoopTimingReportCallback;
 
 class SerialProtocolPlaintext : public SerialProtocol {
     public:
@@ -22,12 +25,18 @@ class SerialProtocolPlaintext : public SerialProtocol {
             DemoConfigChangeCallback demo_config_change_callback
             , StrainCalibrationCallback strain_calibration_callback
             , MotorCalibrationCallback motor_calibration_callback
+            , MotorCalibrationCancelCallback motor_calibration_cancel_callback
+            , CoggingCalibrationCallback cogging_calibration_callback
+            , LoopTimingReportCallback loop_timing_report_callback
         );
     
     private:
         Stream& stream_;
         PB_SmartKnobState latest_state_ = {};
         MotorCalibrationCallback motor_calibration_callback_;
+        MotorCalibrationCancelCallback motor_calibration_cancel_callback_;
+        CoggingCalibrationCallback cogging_calibration_callback_;
         DemoConfigChangeCallback demo_config_change_callback_;
         StrainCalibrationCallback strain_calibration_callback_;
+        LoopTimingReportCallback loop_timing_report_callback_;
 };
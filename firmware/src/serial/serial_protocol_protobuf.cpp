@@ -13,11 +13,18 @@ static SerialProtocolProtobuf* singleton_for_packet_serial = 0;
 
 static const uint16_t MIN_STATE_INTERVAL_MILLIS = 5;
 static const uint16_t PERIODIC_STATE_INTERVAL_MILLIS = 5000;
+static const uint16_t TELEMETRY_FRAMES_PER_CHUNK = sizeof(PB_TelemetryChunk_frames_t::bytes) / sizeof(TelemetryFrame);
+static const uint16_t SENSOR_CAPTURE_FRAMES_PER_CHUNK = sizeof(PB_SensorCaptureChunk_frames_t::bytes) / sizeof(SensorCaptureFrame);
 
-SerialProtocolProtobuf::SerialProtocolProtobuf(Stream& stream, ConfigCallback config_callback) :
+SerialProtocolProtobuf::SerialProtocolProtobuf(Stream& stream, ConfigCallback config_callback, HapticEffectCallback haptic_effect_callback, MotorCalibrationRequestCallback motor_calibration_callback, TelemetryBuffer& telemetry, SensorCapture* sensor_capture, const SensorHealth& sensor_health) :
         SerialProtocol(),
         stream_(stream),
         config_callback_(config_callback),
+        haptic_effect_callback_(haptic_effect_callback),
+        motor_calibration_callback_(motor_calibration_callback),
+        telemetry_(telemetry),
+        sensor_capture_(sensor_capture),
+        sensor_health_(sensor_health),
         packet_serial_() {
     packet_serial_.setStream(&stream);
 
@@ -35,6 +42,13 @@ void SerialProtocolProtobuf::handleState(const PB_SmartKnobState& state) {
     latest_state_ = state;
 }
 
+void SerialProtocolProtobuf::handleCalibrationStatus(const PB_MotorCalibrationStatus& status) {
+    pb_tx_buffer_ = {};
+    pb_tx_buffer_.which_payload = PB_FromSmartKnob_motor_calibration_status_tag;
+    pb_tx_buffer_.payload.motor_calibration_status = status;
+    sendPbTxBuffer();
+}
+
 void SerialProtocolProtobuf::ack(uint32_t nonce) {
     pb_tx_buffer_ = {};
     pb_tx_buffer_.which_payload = PB_FromSmartKnob_ack_tag;
@@ -72,6 +86,99 @@ void SerialProtocolProtobuf::loop() {
         last_sent_state_ = latest_state_;
         last_sent_state_millis_ = millis();
     }
+
+    updateTelemetry();
+    updateSensorCapture();
+}
+
+void SerialProtocolProtobuf::updateTelemetry() {
+    // A new request waits until the previous capture has been cancelled and drained
+    if (telemetry_request_pending_ && telemetry_.idle()) {
+        telemetry_request_pending_ = false;
+        if (telemetry_request_.frames > 0) {
+            telemetry_.arm({
+                .trigger = (TelemetryTrigger)telemetry_request_.trigger,
+                .frames = telemetry_request_.frames,
+                .pre_trigger = telemetry_request_.pre_trigger,
+                .decimation = telemetry_request_.decimation,
+                .velocity_threshold = telemetry_request_.velocity_threshold,
+            });
+        }
+    }
+    if (telemetry_.idle()) {
+        return;
+    }
+
+    // At most one chunk per loop, so acks and state updates still get through during a capture
+    pb_tx_buffer_ = {};
+    pb_tx_buffer_.which_payload = PB_FromSmartKnob_telemetry_chunk_tag;
+    PB_TelemetryChunk& chunk = pb_tx_buffer_.payload.telemetry_chunk;
+    uint16_t count = telemetry_.read(chunk.frames.bytes, TELEMETRY_FRAMES_PER_CHUNK, chunk.first_frame);
+    chunk.end = count < TELEMETRY_FRAMES_PER_CHUNK && telemetry_.finish(chunk.dropped);
+    if (count == 0 && !chunk.end) {
+        return;
+    }
+    chunk.frames.size = count * sizeof(TelemetryFrame);
+    chunk.frame_size = sizeof(TelemetryFrame);
+    sendPbTxBuffer();
+}
+
+void SerialProtocolProtobuf::updateSensorCapture() {
+    bool unsupported = false;
+    // A new request waits until the previous capture has been stopped and drained
+    if (sensor_capture_request_pending_ && (sensor_capture_ == nullptr || sensor_capture_->idle())) {
+        sensor_capture_request_pending_ = false;
+        if (sensor_capture_request_frames_ > 0) {
+            // Only fails if the sensor driver doesn't record its readings; end the capture right away, so the host doesn't wait for it
+            unsupported = sensor_capture_ == nullptr || !sensor_capture_->start(sensor_capture_request_frames_);
+        }
+    }
+    if (!unsupported && (sensor_capture_ == nullptr || sensor_capture_->idle())) {
+        return;
+    }
+
+    // At most one chunk per loop, as telemetry
+    pb_tx_buffer_ = {};
+    pb_tx_buffer_.which_payload = PB_FromSmartKnob_sensor_capture_chunk_tag;
+    PB_SensorCaptureChunk& chunk = pb_tx_buffer_.payload.sensor_capture_chunk;
+    uint16_t count = unsupported ? 0 : sensor_capture_->read(chunk.frames.bytes, SENSOR_CAPTURE_FRAMES_PER_CHUNK, chunk.first_frame);
+    chunk.end = unsupported || (count < SENSOR_CAPTURE_FRAMES_PER_CHUNK && sensor_capture_->finish(chunk.dropped));
+    if (count == 0 && !chunk.end) {
+        return;
+    }
+    chunk.frames.size = count * sizeof(SensorCaptureFrame);
+    chunk.frame_size = sizeof(SensorCaptureFrame);
+    chunk.format = (uint8_t)(unsupported ? SensorCaptureFormat::NONE : sensor_capture_->format());
+    sendPbTxBuffer();
+}
+
+static PB_SensorHealthCounts toPb(const SensorHealthCounts& counts) {
+    return {
+        .samples = counts.samples,
+        .crc_errors = counts.crc_errors,
+        .field_too_strong = counts.field_too_strong,
+        .field_too_weak = counts.field_too_weak,
+        .loss_of_track = counts.loss_of_track,
+        .max_age_micros = counts.max_age_micros,
+        .stale_iterations = counts.stale_iterations,
+        .stuck_frames = counts.stuck_frames,
+    };
+}
+
+void SerialProtocolProtobuf::sendSensorHealth() {
+    SensorHealthReport report = sensor_health_.report();
+    pb_tx_buffer_ = {};
+    pb_tx_buffer_.which_payload = PB_FromSmartKnob_sensor_health_tag;
+    pb_tx_buffer_.payload.sensor_health = {
+        .window_millis = report.window_micros / 1000,
+        .has_window = true,
+        .window = toPb(report.window),
+        .has_total = true,
+        .total = toPb(report.total),
+        .stale = report.stale,
+        .readings_reported = report.readings_reported,
+    };
+    sendPbTxBuffer();
 }
 
 void SerialProtocolProtobuf::handlePacket(const uint8_t* buffer, size_t size) {
@@ -131,6 +238,27 @@ void SerialProtocolProtobuf::handlePacket(const uint8_t* buffer, size_t size) {
         case PB_ToSmartknob_request_state_tag:
             state_requested_ = true;
             break;
+        case PB_ToSmartknob_play_haptic_effect_tag:
+            haptic_effect_callback_(pb_rx_buffer_.payload.play_haptic_effect);
+            break;
+        case PB_ToSmartknob_motor_calibration_tag:
+            motor_calibration_callback_(pb_rx_buffer_.payload.motor_calibration);
+            break;
+        case PB_ToSmartknob_telemetry_tag:
+            telemetry_request_ = pb_rx_buffer_.payload.telemetry;
+            telemetry_request_pending_ = true;
+            telemetry_.cancel();
+            break;
+        case PB_ToSmartknob_sensor_capture_tag:
+            sensor_capture_request_frames_ = pb_rx_buffer_.payload.sensor_capture.frames;
+            sensor_capture_request_pending_ = true;
+            if (sensor_capture_ != nullptr) {
+                sensor_capture_->stop();
+            }
+            break;
+        case PB_ToSmartknob_request_sensor_health_tag:
+            sendSensorHealth();
+            break;
         default: {
             char buf[200];
             snprintf(buf, sizeof(buf), "Unknown payload type: %d", pb_rx_buffer_.which_payload);
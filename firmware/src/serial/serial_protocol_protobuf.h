@@ -5,6 +5,9 @@
 #include "../proto_gen/smartknob.pb.h"
 
 #include "tasks/motor_task.h"
+#include "sensor_capture.h"
+#include "sensor_health.h"
+#include "telemetry_buffer.h"
 #include "serial_protocol.h"
 #include "uart_stream.h"
 
@@ -15,17 +18,47 @@
  */
 typedef std::function<void(PB_SmartKnobConfig&)> ConfigCallback;
 
+/**
+ * @brief Callback to request a haptic effect
+ *
+ * @param effect The requested effect
+ */
+typedef std::function<void(const PB_PlayHapticEffect&)> HapticEffectCallback;
+
+/**
+ * @brief Callback to start or cancel a motor calibration
+ *
+ * @param request The request
+ */
+typedef std::function<void(const PB_MotorCalibrationRequest&)> MotorCalibrationRequestCallback;
+
 class SerialProtocolProtobuf : public SerialProtocol {
     public:
-        SerialProtocolProtobuf(Stream& stream, ConfigCallback config_callback);
+        SerialProtocolProtobuf(Stream& stream, ConfigCallback config_callback, HapticEffectCallback haptic_effect_callback, MotorCalibrationRequestCallback motor_calibration_callback, TelemetryBuffer& telemetry, SensorCapture* sensor_capture, const SensorHealth& sensor_health);
         ~SerialProtocolProtobuf(){};
         void log(const std::string& msg) override;
         void loop() override;
         void handleState(const PB_SmartKnobState& state) override;
+        void handleCalibrationStatus(const PB_MotorCalibrationStatus& status) override;
     
     private:
         Stream& stream_;
         ConfigCallback config_callback_;
+        HapticEffectCallback haptic_effect_callback_;
+        MotorCalibrationRequestCallback motor_calibration_callback_;
+
+        // Telemetry captures are armed and drained here, directly (the buffer is lock-free)
+        TelemetryBuffer& telemetry_;
+        PB_TelemetryRequest telemetry_request_ = {};
+        bool telemetry_request_pending_ = false;
+
+        // Sensor captures likewise; the sensor driver records into the ring from the motor task
+        // Null if the sensor driver doesn't record its readings
+        SensorCapture* sensor_capture_;
+        uint32_t sensor_capture_request_frames_ = 0;
+        bool sensor_capture_request_pending_ = false;
+
+        const SensorHealth& sensor_health_;
         
         PB_FromSmartKnob pb_tx_buffer_;
         PB_ToSmartknob pb_rx_buffer_;
@@ -43,6 +76,9 @@ class SerialProtocolProtobuf : public SerialProtocol {
         bool state_requested_;
 
         void sendPbTxBuffer();
+        void updateTelemetry();
+        void updateSensorCapture();
+        void sendSensorHealth();
         void handlePacket(const uint8_t* buffer, size_t size);
         void ack(uint32_t nonce);
 };
@@ -0,0 +1,25 @@
+#include <SimpleFOC.h>
+
+#include "fast_trig.h"
+
+/**
+ * SimpleFOC declares its trigonometry weak (common/foc_utils.cpp), so these definitions replace it
+ * for the whole library: the FOC loop's Park transforms and setPhaseVoltage take sin/cos of the
+ * electrical angle every iteration. These are faster than its own coarser quarter-wave table, and more
+ * accurate (see fast_trig.h).
+ */
+float _sin(float a) {
+    return fastSin(a);
+}
+
+float _cos(float a) {
+    return fastCos(a);
+}
+
+void _sincos(float a, float* s, float* c) {
+    fastSinCos(a, *s, *c);
+}
+
+float _atan2(float y, float x) {
+    return fastAtan2(y, x);
+}
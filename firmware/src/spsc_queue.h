@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer task and one consumer task.
+ *
+ * Neither side ever blocks: push() fails when the queue is full, pop() when it is empty. Each
+ * index is only written by one side and published with release/acquire, so no critical section
+ * is needed even across cores.
+ */
+template <typename T, uint16_t CAPACITY>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscQueue values are copied between tasks");
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    public:
+        // Producer side
+        bool push(const T& value) {
+            uint32_t write = write_.load(std::memory_order_relaxed);
+            if (write - read_.load(std::memory_order_acquire) >= CAPACITY) {
+                return false;
+            }
+            values_[write & MASK] = value;
+            write_.store(write + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side
+        bool pop(T& value) {
+            uint32_t read = read_.load(std::memory_order_relaxed);
+            if (read == write_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = values_[read & MASK];
+            read_.store(read + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        static const uint32_t MASK = CAPACITY - 1;
+
+        // Free-running counters; the slot of an element is its counter modulo CAPACITY
+        std::atomic<uint32_t> write_ = 0;
+        std::atomic<uint32_t> read_ = 0;
+        T values_[CAPACITY];
+};
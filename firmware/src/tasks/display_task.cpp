@@ -49,15 +49,12 @@ void my_touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data)
 
 DisplayTask::DisplayTask(const uint8_t task_core, const uint32_t stack_depth) : Task{"Display", stack_depth, 1, task_core} {
   display_task_ = this;
-  knob_state_queue_ = xQueueCreate(1, sizeof(PB_SmartKnobState));
-  assert(knob_state_queue_ != NULL);
 
   mutex_ = xSemaphoreCreateMutex();
   assert(mutex_ != NULL);
 }
 
 DisplayTask::~DisplayTask() {
-  vQueueDelete(knob_state_queue_);
   vSemaphoreDelete(mutex_);
 }
 
@@ -181,12 +178,12 @@ void DisplayTask::run() {
     SliderView sliderView = SliderView(screen, display_task_);
 
     while(1) {
-        PB_SmartKnobState state;
-        if (xQueueReceive(knob_state_queue_, &state, portMAX_DELAY) == pdFALSE) {
+        // Sleep until the motor task publishes a new state (see MotorTask::setKnobStateListener)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!knob_state_reader_.poll(state_)) {
           continue;
         }
-
-        state_ = state;
+        const PB_SmartKnobState& state = state_;
 
         bool config_change = (latest_state_.config.detent_strength_unit != state.config.detent_strength_unit)
         || (latest_state_.config.endstop_strength_unit != state.config.endstop_strength_unit)
@@ -239,8 +236,8 @@ void DisplayTask::run() {
     }
 }
 
-QueueHandle_t DisplayTask::getKnobStateQueue() {
-  return knob_state_queue_;
+void DisplayTask::setKnobStateFeed(const KnobStateFeed& feed) {
+  knob_state_reader_.setFeed(feed);
 }
 
 void DisplayTask::setBrightness(uint16_t brightness) {
@@ -6,6 +6,7 @@
 #include <TFT_eSPI.h>
 #include <vector>
 
+#include "knob_state_feed.h"
 #include "logger.h"
 #include "proto_gen/smartknob.pb.h"
 #include "task.h"
@@ -21,7 +22,7 @@ class DisplayTask : public Task<DisplayTask> {
         DisplayTask(const uint8_t task_core, const uint32_t stack_depth);
         ~DisplayTask();
 
-        QueueHandle_t getKnobStateQueue();
+        void setKnobStateFeed(const KnobStateFeed& feed);
         SemaphoreHandle_t * i2c_mutex_;
 
         void setListener(QueueHandle_t queue);
@@ -37,7 +38,7 @@ class DisplayTask : public Task<DisplayTask> {
     private:
         lv_obj_t * screen;
 
-        QueueHandle_t knob_state_queue_;
+        KnobStateReader knob_state_reader_;
 
         QueueHandle_t listener_;
         PB_SmartKnobState state_ = {};
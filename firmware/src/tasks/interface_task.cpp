@@ -48,8 +48,30 @@ InterfaceTask::InterfaceTask(const uint8_t task_core, const uint32_t stack_depth
     , motor_task_(motor_task)
     , display_task_(display_task)
     , connectivity_task_(connectivity_task)
+    , knob_state_reader_(motor_task.knobStateFeed())
     , plaintext_protocol_(stream_)
-    , proto_protocol_(stream_, [this](PB_SmartKnobConfig &config) { applyConfig(config, true); })
+    , proto_protocol_(
+        stream_,
+        [this](PB_SmartKnobConfig &config) { applyConfig(config, true); },
+        [this](const PB_PlayHapticEffect &effect) { motor_task_.playHaptic((HapticEffect)effect.effect, effect.strength); },
+        [this](const PB_MotorCalibrationRequest &request) {
+            if (request.cancel) {
+                motor_task_.cancelCalibration();
+            } else if (!configuration_loaded_) {
+                return;
+            } else if (request.cogging) {
+                motor_task_.runCoggingCalibration();
+            } else {
+                motor_task_.runCalibration();
+            }
+        },
+        motor_task.telemetry(),
+#if SENSOR_MT6701
+        &motor_task.sensorCapture(),
+#else
+        nullptr,
+#endif // SENSOR_MT6701
+        motor_task.sensorHealth())
     , page_event_bus_()
     , page_event_sender_(page_event_bus_.queue())
     , page_event_receiver_(page_event_bus_.queue())
@@ -61,9 +83,6 @@ InterfaceTask::InterfaceTask(const uint8_t task_core, const uint32_t stack_depth
     log_queue_ = xQueueCreate(10, sizeof(std::string *));
     assert(log_queue_ != NULL);
 
-    knob_state_queue_ = xQueueCreate(1, sizeof(PB_SmartKnobState));
-    assert(knob_state_queue_ != NULL);
-
     user_input_queue_ = xQueueCreate(1, sizeof(userInput_t));
     assert(user_input_queue_ != NULL);
 
@@ -87,14 +106,12 @@ InterfaceTask::InterfaceTask(const uint8_t task_core, const uint32_t stack_depth
     page_map_[PageType::DEMO_PAGE]       = std::make_unique<DemoPage>(page_context_);
     page_map_[PageType::LIGHTS_PAGE]     = std::make_unique<LightsPage>(page_context_, connectivity_task_);
 
-    motor_task_.registerStateListener(knob_state_queue_);
     display_task_->setListener(user_input_queue_);
 }
 
 InterfaceTask::~InterfaceTask() {
     vSemaphoreDelete(mutex_);
     vQueueDelete(log_queue_);
-    vQueueDelete(knob_state_queue_);
     vQueueDelete(user_input_queue_);
     vSemaphoreDelete(i2c_mutex_);
 }
@@ -162,6 +179,18 @@ void InterfaceTask::run() {
                 return;
             }
             motor_task_.runCalibration();
+        },
+        [this]() {
+            motor_task_.cancelCalibration();
+        },
+        [this]() {
+            if (!configuration_loaded_) {
+                return;
+            }
+            motor_task_.runCoggingCalibration();
+        },
+        [this]() {
+            motor_task_.reportLoopTiming();
         }
     );
 
@@ -199,18 +228,24 @@ void InterfaceTask::run() {
 
     // Interface loop:
     while (1) {
-        PB_SmartKnobState new_state;
-        if (xQueueReceive(knob_state_queue_, &new_state, 0) == pdTRUE) {
-            // Discard all outdated state messages (incorrect nonce)
+        if (knob_state_reader_.poll(knob_state_)) {
+            // Discard all outdated states (incorrect nonce)
             // if (true) {
-            if (new_state.config.position_nonce == position_nonce_) {
-                latest_state_ = new_state;
+            if (knob_state_.config.position_nonce == position_nonce_) {
+                latest_state_ = knob_state_;
                 publishState();
                 current_page_->handleState(latest_state_);
             } else {
-                LOG_WARN("Discarding outdated state message (expected nonce %d, got %d)", position_nonce_, new_state.config.position_nonce);
+                LOG_WARN("Discarding outdated state message (expected nonce %d, got %d)", position_nonce_, knob_state_.config.position_nonce);
             }
         }
+        dispatchPositionEvents();
+
+        uint32_t calibration_status_version = motor_task_.knobStateFeed().readCalibrationStatus(calibration_status_);
+        if (calibration_status_version != calibration_status_version_) {
+            calibration_status_version_ = calibration_status_version;
+            current_protocol_->handleCalibrationStatus(calibration_status_);
+        }
 
         static uint32_t last_stack_log = 0;
         if (millis() - last_stack_log > 1000) {
@@ -219,8 +254,7 @@ void InterfaceTask::run() {
             // logStackAndHeapUsage(monitored_tasks, monitored_tasks_count);
         }
 
-        PageEvent::Message event;
-        if (page_event_receiver_.receive(event)) {
+        if (page_event_receiver_.receive(page_event_)) {
             auto visitor = overload {
                 [&](const PageEvent::PageChange& e) {
                     changePage(e.new_page);
@@ -230,9 +264,12 @@ void InterfaceTask::run() {
                 },
                 [&](const PageEvent::MotorCalibration&) {
                     motor_task_.runCalibration();
+                },
+                [&](const PageEvent::PlayHaptic& e) {
+                    motor_task_.playHaptic(e.effect, e.strength);
                 }
             };
-            std::visit(visitor, event);
+            std::visit(visitor, page_event_);
         }
 
         current_protocol_->loop();
@@ -259,7 +296,7 @@ void InterfaceTask::run() {
         if (!configuration_loaded_) {
             SemaphoreGuard lock(mutex_);
             if (configuration_ != nullptr) {
-                configuration_value_  = configuration_->get();
+                configuration_->get(configuration_value_);
                 configuration_loaded_ = true;
             }
         }
@@ -382,9 +419,35 @@ void InterfaceTask::setConfiguration(Configuration *configuration) {
     configuration_ = configuration;
 }
 
+void InterfaceTask::dispatchPositionEvents() {
+    PositionEventQueue& events = motor_task_.positionEvents();
+    int32_t position_steps = position_steps_;
+    while (has_position_event_ || events.read(position_event_)) {
+        // Generations are SeqLock sequence numbers, compared in int32_t so they stay ordered across a wrap
+        int32_t age = (int32_t)(knob_state_reader_.configGeneration() - position_event_.config_generation);
+        if (age < 0) {
+            // The event belongs to a config that hasn't been polled yet; keep it until it has
+            has_position_event_ = true;
+            break;
+        }
+        has_position_event_ = false;
+        // Steps of every config count towards the host's total; wraps like the protocol's int32
+        position_steps_ = (int32_t)((uint32_t)position_steps_ + (uint32_t)position_event_.steps);
+        // Changes of older configs, or of configs applied on behalf of an outdated nonce, don't concern the page
+        if (age == 0 && knob_state_.config.position_nonce == position_nonce_) {
+            current_page_->handlePositionChange(position_event_);
+        }
+    }
+    // The state was published when it was polled, before these steps were counted
+    if (position_steps_ != position_steps) {
+        publishState();
+    }
+}
+
 void InterfaceTask::publishState() {
     // Apply local state before publishing to serial
     latest_state_.press_nonce = press_count_;
+    latest_state_.position_steps = position_steps_;
     current_protocol_->handleState(latest_state_);
 }
 
@@ -78,11 +78,19 @@ class InterfaceTask : public Task<InterfaceTask>, public Logger {
 
         uint8_t position_nonce_ = 0; // This will overwrite all position_nonce values defined in the config, but should work fine, since it achieves the same thing
 
+        KnobStateReader knob_state_reader_;
+        PB_SmartKnobState knob_state_ = {};    // Polled from the motor task, may be outdated (see position_nonce_)
         PB_SmartKnobState latest_state_ = {};
         PB_SmartKnobConfig latest_config_ = {};
 
+        PositionEvent position_event_ = {};
+        bool has_position_event_ = false;   // position_event_ was read, but its config hasn't been polled yet
+        int32_t position_steps_ = 0;        // Steps of all dispatched position events, for PB_SmartKnobState.position_steps
+
+        PB_MotorCalibrationStatus calibration_status_ = {};
+        uint32_t calibration_status_version_ = 0;
+
         QueueHandle_t log_queue_;
-        QueueHandle_t knob_state_queue_;
         QueueHandle_t user_input_queue_;
         SerialProtocolPlaintext plaintext_protocol_;
         SerialProtocolProtobuf proto_protocol_;
@@ -92,11 +100,13 @@ class InterfaceTask : public Task<InterfaceTask>, public Logger {
         EventBusCore<PageEvent::Message> page_event_bus_;
         EventSender<PageEvent::Message> page_event_sender_;
         EventReceiver<PageEvent::Message> page_event_receiver_;
+        PageEvent::Message page_event_;     // Received into a member, as it holds a whole config (see the stack sizes in main.cpp)
 
         userInput_t user_input_;
 
         void setUserInput(userInput_t user_input, bool playHapticts);
         void updateHardware();
         void publishState();
+        void dispatchPositionEvents();
         void applyConfig(PB_SmartKnobConfig& config, bool from_remote);
 };
@@ -1,5 +1,8 @@
+#include <algorithm>
+
 #include <SimpleFOC.h>
 
+#include "foc_angle_source.h"
 #include "motor_task.h"
 #if SENSOR_MT6701
 #include "mt6701_sensor.h"
@@ -12,57 +15,92 @@
 #include "motors/motor_config.h"
 #include "util.h"
 
-// Empirically determined values for the knob with red wires
-/*
-    (absolute) maximum shaft velocity while idle (not exactly at detent center): 0.33
-    (absolute) maximum shaft velocity while at detent center: 0.29
-    Angle difference where motor is unable to move: 0.12 (set to 0.15 for safety)
-        0.12 rad = 6.87 degrees => Let's accept 8 degrees (maybe even 10?)
-*/
-
-static const float DEAD_ZONE_DETENT_PERCENT = 0.2;
-static const float DEAD_ZONE_RAD = 1 * _PI / 180;
+#if SK_INVERT_ROTATION
+static const float ROTATION_SIGN = -1;
+#else
+static const float ROTATION_SIGN = 1;
+#endif // SK_INVERT_ROTATION
 
-static const float IDLE_VELOCITY_EWMA_ALPHA = 0.001;
-static const float IDLE_VELOCITY_RAD_PER_SEC = 0.05;
-static const uint32_t IDLE_CORRECTION_DELAY_MILLIS = 500;
-static const float IDLE_CORRECTION_MAX_ANGLE_RAD = 8 * PI / 180;
-static const float IDLE_CORRECTION_RATE_ALPHA = 0.0005;
+// Interval between calibration progress updates while a calibration runs
+static const uint32_t CALIBRATION_STATUS_INTERVAL_MICROS = 100 * 1000;
+// Calibration phase reported while a cogging calibration runs (see MotorCalibrationStatus in smartknob.proto)
+static const uint8_t COGGING_CALIBRATION_PHASE = 5;
+// Movement of the knob that wakes the loop from low power: above the sensor noise, well below a detent
+static const float IDLE_WAKE_RAD = 0.3 * M_PI / 180;
+static const float IDLE_DRIVE_LIMIT = FOC_VOLTAGE_LIMIT * SK_IDLE_DRIVE_SCALE;
 
 
 MotorTask::MotorTask(const uint8_t task_core, const uint32_t stack_depth, Configuration& configuration)
     : Task("Motor", stack_depth, 1, task_core)
     , configuration_(configuration)
-    , command_bus_()
-    , command_sender_(command_bus_.queue())
-    , command_receiver_(command_bus_.queue())
     {}
 
 MotorTask::~MotorTask() {}
 
 
 #if SENSOR_TLV
-    TlvSensor encoder = TlvSensor();
+    #define SENSOR_BACKEND TlvSensor
+    #define SENSOR_BACKEND_ARGS &Wire, false
 #elif SENSOR_MT6701
-    MT6701Sensor encoder = MT6701Sensor();
+    #define SENSOR_BACKEND MT6701Sensor
+    #define SENSOR_BACKEND_ARGS
 #elif SENSOR_MAQ430
-    MagneticSensorSPI encoder = MagneticSensorSPI(MAQ430_SPI, PIN_MAQ_SS);
+    #define SENSOR_BACKEND MAQ430Sensor
+    #define SENSOR_BACKEND_ARGS PIN_MAQ_SS
 #endif // SENSOR_TLV, SENSOR_MT6701, SENSOR_MAQ430
 
+FocAngleSource<SENSOR_BACKEND> encoder = FocAngleSource<SENSOR_BACKEND>(SENSOR_BACKEND_ARGS);
+
+#if SK_CYCLE_PROBES
+// Printable names of MotorLoopStage, in order
+static const char* const MOTOR_LOOP_STAGE_NAMES[MotorLoopStage::COUNT] = {
+    "iteration", "foc", "sensor", "commands", "haptics", "move", "publish",
+};
+#endif // SK_CYCLE_PROBES
+
+static_assert(sizeof(PB_SensorCalibration::error_cos) / sizeof(float) == SensorCorrection::MAX_HARMONICS);
+static_assert(sizeof(PB_CoggingCalibration_torque_t::bytes) == CoggingMap::SIZE);
+
+// Correct sensor readings with a learned error (an empty calibration disables the correction)
+static void setSensorCorrection(const PB_SensorCalibration& calibration) {
+    pb_size_t count = std::min(calibration.error_cos_count, calibration.error_sin_count);
+    encoder.source().correction().set(calibration.error_cos, calibration.error_sin, (uint8_t)count);
+}
+
+// One line of sensor health counts, for the log
+static void formatSensorHealth(char* out, size_t size, const SensorHealthCounts& counts, bool readings_reported) {
+    if (!readings_reported) {
+        snprintf(out, size, "readings not reported by this sensor; max age %u us, %u iterations stale",
+            counts.max_age_micros,
+            counts.stale_iterations);
+        return;
+    }
+    snprintf(out, size, "%u readings, %u CRC errors, %u stuck, field too strong %u, too weak %u, loss of track %u; max age %u us, %u iterations stale",
+        counts.samples,
+        counts.crc_errors,
+        counts.stuck_frames,
+        counts.field_too_strong,
+        counts.field_too_weak,
+        counts.loss_of_track,
+        counts.max_age_micros,
+        counts.stale_iterations);
+}
+
+void MotorTask::setCoggingMap(const PB_CoggingCalibration& calibration) {
+    cogging_map_.set((const int8_t*)calibration.torque.bytes, calibration.torque.size, calibration.scale);
+}
+
 void MotorTask::run() {
 
     motor_driver_.voltage_power_supply = 5;
     motor_driver_.init();
 
-    #if SENSOR_TLV
-    encoder.init(&Wire, false);
-    #elif SENSOR_MT6701
+    #if SENSOR_MT6701
+    encoder.source().backend().setCapture(&sensor_capture_);
+    encoder.source().backend().setHealth(&sensor_health_);
+    sensor_health_.setReadingsReported(true);
+    #endif // SENSOR_MT6701
     encoder.init();
-    #elif SENSOR_MAQ430
-    SPIClass* spi = new SPIClass(HSPI);
-    spi->begin(PIN_MAQ_SCK, PIN_MAQ_MISO, PIN_MAQ_MOSI, PIN_MAQ_SS);
-    encoder.init(spi);
-    #endif // SENSOR_TLV, SENSOR_MT6701, SENSOR_MAQ430
 
     motor_.linkDriver(&motor_driver_);
 
@@ -71,16 +109,16 @@ void MotorTask::run() {
     motor_.velocity_limit = 10000;
     motor_.linkSensor(&encoder);
 
-    // Not actually using the velocity loop built into SimpleFOC; but I'm using those PID variables
-    // to run PID for torque (and SimpleFOC studio supports updating them easily over serial for tuning)
-    motor_.PID_velocity.P = FOC_PID_P;
-    motor_.PID_velocity.I = FOC_PID_I;
-    motor_.PID_velocity.D = FOC_PID_D;
-    motor_.PID_velocity.output_ramp = FOC_PID_OUTPUT_RAMP;
-    motor_.PID_velocity.limit = FOC_PID_LIMIT;
+    // Torque PID for the haptic controller (P and D are adjusted per-config)
+    TorquePid& pid = haptic_controller_.pid();
+    pid.P = FOC_PID_P;
+    pid.I = FOC_PID_I;
+    pid.D = FOC_PID_D;
+    pid.output_ramp = FOC_PID_OUTPUT_RAMP;
+    pid.limit = FOC_PID_LIMIT;
 
     #ifdef FOC_LPF
-    motor.LPF_angle.Tf = FOC_LPF;
+    motor_.LPF_angle.Tf = FOC_LPF;
     #endif // FOC_LPF
 
     motor_.init();
@@ -88,480 +126,543 @@ void MotorTask::run() {
     encoder.update();
     delay(10);
 
-    PB_PersistentConfiguration c = configuration_.get();
-    motor_.pole_pairs = c.motor.calibrated ? c.motor.pole_pairs : 7;
-    motor_.initFOC(c.motor.zero_electrical_offset, c.motor.direction_cw ? Direction::CW : Direction::CCW);
+    configuration_.get(persistent_configuration_);
+    setSensorCorrection(persistent_configuration_.sensor);
+    if (persistent_configuration_.has_cogging) {
+        setCoggingMap(persistent_configuration_.cogging);
+    }
+    const PB_MotorCalibration& motor_calibration = persistent_configuration_.motor;
+    motor_calibrated_ = motor_calibration.calibrated;
+    motor_.pole_pairs = motor_calibration.calibrated ? motor_calibration.pole_pairs : 7;
+    motor_.initFOC(motor_calibration.zero_electrical_offset, motor_calibration.direction_cw ? Direction::CW : Direction::CCW);
 
     motor_.monitor_downsample = 0; // disable monitor at first - optional
 
     // disableCore0WDT();
 
-    float current_detent_center = motor_.shaft_angle;
-    PB_SmartKnobConfig config = {
-        .initial_position = 0,
-        .sub_position_unit = 0,
-        .position_nonce = 0,
-        .min_position = 0,
-        .max_position = 1,
-        .position_width_radians = 60 * _PI / 180,
-        .detent_strength_unit = 0,
-    };
-    int32_t current_position = 0;
-    float latest_sub_position_unit = 0;
+    angle_observer_.setBandwidth(SK_OBSERVER_BANDWIDTH);
+    angle_observer_.reset(sensorAngle(), micros());
+    haptic_controller_.begin(angle_observer_.angle());
+    knob_state_feed_.publishConfig(haptic_controller_.config());
 
-    float idle_check_velocity_ewma = 0;
-    uint32_t last_idle_start = 0;
     uint32_t last_publish = 0;
 
+    // Run the loop at a fixed rate, paced by a periodic timer that notifies this task on every tick
+    loop_scheduler_.begin(SK_MOTOR_LOOP_HZ, SK_HAPTIC_LOOP_DIVISOR);
+    const esp_timer_create_args_t loop_timer_args = {
+        .callback = &MotorTask::loopTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "motor_loop",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&loop_timer_args, &loop_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(loop_timer_, loop_scheduler_.periodMicros()));
+    idle_governor_.begin(SK_IDLE_DELAY_MILLIS * 1000, IDLE_WAKE_RAD, micros());
+    sensor_health_.begin(micros());
+
+    #if SK_CYCLE_PROBES
+    encoder.stats = &loop_stages_[MotorLoopStage::SENSOR];
+    #endif // SK_CYCLE_PROBES
+
+    HapticOutput output = {};
+    // Latest commanded torque, in the knob's logical direction, for telemetry
+    float torque = 0;
     while (1) {
-        motor_.loopFOC();
-
-        // Receive and handle commands from other tasks
-        MotorCommand::Message command;
-        if (command_receiver_.receive(command)) {
-            auto visitor = overload {
-                [&](const MotorCommand::Calibrate&) {
-                    calibrate();
-                },
-                [&](const MotorCommand::SetConfig& c) {
-                    const PB_SmartKnobConfig& new_config = c.config;
-
-                    // Check new config for validity
-                    assert(new_config.detent_strength_unit >= 0);
-                    assert(new_config.endstop_strength_unit >= 0);
-                    assert(new_config.snap_point >= 0.5);
-                    assert(new_config.detent_positions_count <= COUNT_OF(new_config.detent_positions));
-                    assert(new_config.snap_point_bias >= 0);
-                    assert(new_config.position_width_radians >= 0);
-                    if (new_config.min_position < new_config.max_position) {
-                        // If the minimum position is greater than the maximum position, the bounds are disabled
-                        assert(new_config.initial_position >= new_config.min_position && new_config.initial_position <= new_config.max_position);
-                    }
-
-                    // Change haptic input mode
-                    bool position_updated = false;
-                    if (new_config.initial_position != config.initial_position
-                            || new_config.sub_position_unit != config.sub_position_unit
-                            || new_config.position_nonce != config.position_nonce) {
-                        LOG_INFO("applying position change");
-                        current_position = new_config.initial_position;
-                        position_updated = true;
-                    }
-
-                    if (new_config.min_position <= new_config.max_position) {
-                        // Only check bounds if min/max indicate bounds are active (min >= max)
-                        if (current_position < new_config.min_position) {
-                            current_position = new_config.min_position;
-                            LOG_INFO("adjusting position to min");
-                        } else if (current_position > new_config.max_position) {
-                            current_position = new_config.max_position;
-                            LOG_INFO("adjusting position to max");
-                        }
-                    }
-
-                    if (position_updated || new_config.position_width_radians != config.position_width_radians) {
-                        LOG_INFO("adjusting detent center");
-                        float new_sub_position = position_updated ? new_config.sub_position_unit : latest_sub_position_unit;
-                        #if SK_INVERT_ROTATION
-                            float shaft_angle = -motor.shaft_angle;
-                        #else
-                            float shaft_angle = motor_.shaft_angle;
-                        #endif // SK_INVERT_ROTATION
-                        current_detent_center = shaft_angle + new_sub_position * new_config.position_width_radians;
-                    }
-                    config = new_config;
-                    LOG_INFO("Got new config");
-
-                    // Update derivative factor of torque controller based on detent width.
-                    // If the D factor is large on coarse detents, the motor ends up making noise because the P&D factors amplify the noise from the sensor.
-                    // This is a piecewise linear function so that fine detents (small width) get a higher D factor and coarse detents get a small D factor.
-                    // Fine detents need a nonzero D factor to artificially create "clicks" each time a new value is reached (the P factor is small
-                    // for fine detents due to the smaller angular errors, and the existing P factor doesn't work well for very small angle changes (easy to
-                    // get runaway due to sensor noise & lag)).
-                    // TODO: consider eliminating this D factor entirely and just "play" a hardcoded haptic "click" (e.g. a quick burst of torque in each
-                    // direction) whenever the position changes when the detent width is too small for the P factor to work well.
-                    const float derivative_lower_strength = config.detent_strength_unit * 0.08;
-                    const float derivative_upper_strength = config.detent_strength_unit * 0.02;
-                    const float derivative_position_width_lower = radians(3);
-                    const float derivative_position_width_upper = radians(8);
-                    const float raw = derivative_lower_strength + (derivative_upper_strength - derivative_lower_strength)/(derivative_position_width_upper - derivative_position_width_lower)*(config.position_width_radians - derivative_position_width_lower);
-                    // When there are intermittent detents (set via detent_positions), disable derivative factor as this adds extra "clicks" when nearing
-                    // a detent.
-                    motor_.PID_velocity.D = config.detent_positions_count > 0 ? 0 : CLAMP(
-                        raw,
-                        min(derivative_lower_strength, derivative_upper_strength),
-                        max(derivative_lower_strength, derivative_upper_strength)
-                    );
-                },
-                [&](const MotorCommand::PlayHaptic& h) {
-                    // Play a hardcoded haptic "click"
-                    float strength = h.press ? 5 : 1.5;
-                    motor_.move(strength);
-                    for (uint8_t i = 0; i < 3; i++) {
-                        motor_.loopFOC();
-                        delay(1);
-                    }
-                    motor_.move(-strength);
-                    for (uint8_t i = 0; i < 3; i++) {
-                        motor_.loopFOC();
-                        delay(1);
-                    }
-                    motor_.move(0);
-                    motor_.loopFOC();
-                },
-                [&](const MotorCommand::RegisterStateListener& r) {
-                    // Register a listener for state updates
-                    listeners_.push_back(r.queue);
-                },
-            };
-            std::visit(visitor, command);
+        uint32_t pending_ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        CYCLE_PROBE(loop_stages_[MotorLoopStage::ITERATION]);
+        bool haptic_due = loop_scheduler_.tick(micros(), pending_ticks);
+
+        // loopFOC() reads the sensor first; SimpleFOC's own shaft_angle/shaft_velocity are only refreshed
+        // in move() (one iteration late, and low-pass filtered), so the haptics use the observer instead.
+        // While the knob rests, the FOC step only runs along with the haptic update, but the sensor is still
+        // read on every tick, so that the first sample that sees the knob move wakes the loop.
+        uint32_t sample_micros = micros();
+        {
+            CYCLE_PROBE(loop_stages_[MotorLoopStage::FOC]);
+            if (haptic_due || !loop_scheduler_.idle()) {
+                motor_.loopFOC();
+            } else {
+                encoder.update();
+            }
         }
-
-        // If we are not moving and we're close to the center (but not exactly there), slowly adjust the centerpoint to match the current position
-        idle_check_velocity_ewma = motor_.shaft_velocity * IDLE_VELOCITY_EWMA_ALPHA + idle_check_velocity_ewma * (1 - IDLE_VELOCITY_EWMA_ALPHA);
-        if (fabsf(idle_check_velocity_ewma) > IDLE_VELOCITY_RAD_PER_SEC) {
-            last_idle_start = 0;
-        } else {
-            if (last_idle_start == 0) {
-                last_idle_start = millis();
+        const TurnAngle sample_angle = sensorAngle();
+        angle_observer_.update(sample_angle, sample_micros - SK_SENSOR_LATENCY_MICROS);
+
+        // Without a fresh reading (the sensor stopped answering, or only with CRC errors), the observer only
+        // extrapolates; the motor isn't driven in closed loop from that
+        bool was_stale = sensor_health_.stale();
+        bool sensor_fresh = sensor_health_.checkAge(encoder.source().sampleMicros(), sample_micros);
+        if (sensor_fresh == was_stale) {
+            if (sensor_fresh) {
+                LOG_INFO("Sensor: readings resumed, torque on");
+            } else {
+                LOG_WARN("Sensor: no valid reading for %u us, torque off", SK_SENSOR_STALE_MICROS);
             }
         }
-        if (last_idle_start > 0 && millis() - last_idle_start > IDLE_CORRECTION_DELAY_MILLIS && fabsf(motor_.shaft_angle - current_detent_center) < IDLE_CORRECTION_MAX_ANGLE_RAD) {
-            current_detent_center = motor_.shaft_angle * IDLE_CORRECTION_RATE_ALPHA + current_detent_center * (1 - IDLE_CORRECTION_RATE_ALPHA);
+        if (sensor_health_.update(sample_micros)) {
+            SensorHealthReport health = sensor_health_.report();
+            if (health.window.problems()) {
+                char counts[160];
+                formatSensorHealth(counts, sizeof(counts), health.window, health.readings_reported);
+                LOG_WARN("Sensor health, last %u ms: %s", health.window_micros / 1000, counts);
+            }
+            checkSensorError();
         }
 
-        // // Log current motor state
-        // char motor_buf[256];
-        // static float global_maximum_absolute_velocity = 0;
-        // static float local_maximum_absolute_velocity = 0;
-        // static uint32_t shaft_velocity_count = 0;
-        // shaft_velocity_count++;
-        // if (fabsf(motor.shaft_velocity) > global_maximum_absolute_velocity) {
-        //     global_maximum_absolute_velocity = fabs(motor.shaft_velocity);
-        // }
-        // if (fabs(motor.shaft_velocity) > local_maximum_absolute_velocity) {
-        //     local_maximum_absolute_velocity = fabs(motor.shaft_velocity);
-        // }
-        // static uint32_t last_motor_shaft_angle_log = 0;
-        // if (millis() - last_motor_shaft_angle_log > 250) {
-        //     snprintf(
-        //         motor_buf,
-        //         sizeof(motor_buf),
-        //         "angle:% 5.2f"
-        //         ", max_local_velocity:% 5.2f"
-        //         ", ewma_velocity:% 5.2f"
-        //         ", current_detent_center:% 5.2f"
-        //         ,motor.shaft_angle
-        //         ,local_maximum_absolute_velocity
-        //         ,idle_check_velocity_ewma
-        //         ,current_detent_center
-        //     );
-        //     log(motor_buf);
-        //     local_maximum_absolute_velocity = fabs(motor.shaft_velocity);
-        //     shaft_velocity_count = 0;
-        //     last_motor_shaft_angle_log = millis();
-        // }
-
-        // Check where we are relative to the current nearest detent; update our position if we've moved far enough to snap to another detent
-        float angle_to_detent_center = motor_.shaft_angle - current_detent_center;  // Positive means the physical sensor is to the "right" of the detent center
-        #if SK_INVERT_ROTATION
-            angle_to_detent_center = -motor.shaft_angle - current_detent_center;
-        #endif // SK_INVERT_ROTATION
-
-        float snap_point_radians = config.position_width_radians * config.snap_point;
-        float bias_radians = config.position_width_radians * config.snap_point_bias;
-        float snap_point_radians_decrease = -snap_point_radians + (current_position <= 0 ? -bias_radians : bias_radians);
-        float snap_point_radians_increase = snap_point_radians + (current_position >= 0 ? bias_radians : -bias_radians); 
-
-        int32_t num_positions = config.max_position - config.min_position + 1;
-        if (angle_to_detent_center > snap_point_radians_increase && (num_positions <= 0 || current_position < config.max_position || config.infinite_scroll)) {
-            current_detent_center += config.position_width_radians;
-            angle_to_detent_center -= config.position_width_radians;
-            current_position++;
-        } else if (angle_to_detent_center < snap_point_radians_decrease && (num_positions <= 0 || current_position > config.min_position || config.infinite_scroll)) {
-            current_detent_center -= config.position_width_radians;
-            angle_to_detent_center += config.position_width_radians;
-            current_position--;
+        // Handle all commands from other tasks that arrived since the last iteration
+        {
+            CYCLE_PROBE(loop_stages_[MotorLoopStage::COMMANDS]);
+            handleCommands();
         }
 
-        if (config.infinite_scroll) {
-            if (current_position > config.max_position) {
-                current_position = config.min_position;
-            } else if (current_position < config.min_position) {
-                current_position = config.max_position;
+        // Slow down while the knob rests, and speed up again on the first sample that sees it move (or when
+        // anything else needs the full rate); the haptics below already run, at full drive, on that sample
+        #if SK_IDLE_LOOP_HZ
+        bool busy = calibration_.running() || cogging_calibration_.running() || haptic_effect_player_.playing() || telemetry_.active();
+        bool was_low_power = idle_governor_.lowPower();
+        if (idle_governor_.update(sample_micros, sample_angle, haptic_controller_.idle(), busy) != was_low_power) {
+            setLowPower(!was_low_power);
+            haptic_due = haptic_due || was_low_power;
+        }
+        #endif // SK_IDLE_LOOP_HZ
+
+        if (calibration_.running()) {
+            // The calibration drives the motor in open loop instead of the haptics, at the full loop rate
+            MotorCalibration::Phase phase = calibration_.phase();
+            CalibrationDrive drive = calibration_.update(encoder.getMechanicalAngle(), sample_micros);
+            motor_.setPhaseVoltage(drive.voltage, 0, drive.electrical_angle);
+            torque = 0;
+            if (!calibration_.running()) {
+                finishCalibration();
+            } else if (calibration_.phase() != phase || micros() - last_calibration_status_micros_ > CALIBRATION_STATUS_INTERVAL_MICROS) {
+                publishCalibrationStatus();
+            }
+        } else if (cogging_calibration_.running()) {
+            // The cogging calibration holds the rotor in closed loop instead of the haptics, at the full loop rate.
+            // It works in the motor's direction, and without the cogging feedforward, which it is measuring.
+            float motor_torque = cogging_calibration_.update(
+                ROTATION_SIGN * angle_observer_.predictAngle(sample_micros + loop_scheduler_.periodMicros()).radiansSince(cogging_origin_),
+                ROTATION_SIGN * angle_observer_.velocity(),
+                encoder.getMechanicalAngle(),
+                sample_micros
+            );
+            if (!sensor_fresh) {
+                motor_torque = 0;
+            }
+            motor_.move(motor_torque);
+            torque = ROTATION_SIGN * motor_torque;
+            if (!cogging_calibration_.running()) {
+                finishCoggingCalibration();
+            } else if (micros() - last_calibration_status_micros_ > CALIBRATION_STATUS_INTERVAL_MICROS) {
+                publishCoggingCalibrationStatus();
+            }
+        } else if (haptic_due) {
+            // The torque set by move() is applied by the next loopFOC(), one period from now
+            int32_t previous_position = haptic_controller_.currentPosition();
+            {
+                CYCLE_PROBE(loop_stages_[MotorLoopStage::HAPTICS]);
+                output = haptic_controller_.update({
+                    .shaft_angle = angle_observer_.predictAngle(sample_micros + loop_scheduler_.drivePeriodMicros()),
+                    .shaft_velocity = angle_observer_.velocity(),
+                    .now_micros = micros(),
+                });
+            }
+            if (output.position_steps != 0) {
+                position_events_.publish({
+                    .timestamp_micros = sample_micros,
+                    .old_position = previous_position,
+                    .new_position = output.current_position,
+                    .steps = output.position_steps,
+                    .velocity = angle_observer_.velocity(),
+                    .config_generation = knob_state_feed_.configGeneration(),
+                });
+            }
+            CYCLE_PROBE(loop_stages_[MotorLoopStage::MOVE]);
+            // Mix the playing haptic effects (if any) into the detent torque
+            torque = output.torque + haptic_effect_player_.torque(micros());
+            // Cancel the motor's cogging, so only the detents are felt. The map is indexed by raw sensor angle
+            // and in the motor's direction.
+            float motor_torque = ROTATION_SIGN * torque + cogging_map_.torque(encoder.getMechanicalAngle());
+            if (idle_governor_.lowPower()) {
+                motor_torque = std::clamp(motor_torque, -IDLE_DRIVE_LIMIT, IDLE_DRIVE_LIMIT);
             }
+            if (!sensor_fresh) {
+                motor_torque = 0;
+                torque = 0;
+            }
+            motor_.move(motor_torque);
+        } else if (!sensor_fresh) {
+            // Between haptic updates, drop the torque of the last one as soon as the reading goes stale
+            motor_.move(0);
+            torque = 0;
         }
 
-        latest_sub_position_unit = angle_to_detent_center / config.position_width_radians;
-
-        float dead_zone_adjustment = CLAMP(
-            angle_to_detent_center,
-            fmaxf(-config.position_width_radians*DEAD_ZONE_DETENT_PERCENT, -DEAD_ZONE_RAD),
-            fminf(config.position_width_radians*DEAD_ZONE_DETENT_PERCENT, DEAD_ZONE_RAD));
-
-        bool out_of_bounds = num_positions > 0 && !config.infinite_scroll && ((angle_to_detent_center > 0 && current_position == config.max_position) || (angle_to_detent_center < 0 && current_position == config.min_position));
-        motor_.PID_velocity.limit = 10; //out_of_bounds ? 10 : 3;
-        motor_.PID_velocity.P = out_of_bounds ? config.endstop_strength_unit * 4 : config.detent_strength_unit * 4;
-
-
-        // Apply motor torque based on our angle to the nearest detent (detent strength, etc is handled by the PID_velocity parameters)
-        if (fabsf(motor_.shaft_velocity) > 60) {
-            // Don't apply torque if velocity is too high (helps avoid positive feedback loop/runaway)
-            motor_.move(0);
-        } else {
-            float input = -angle_to_detent_center + dead_zone_adjustment;
-            if (!out_of_bounds && config.detent_positions_count > 0) {
-                bool in_detent = false;
-                for (uint8_t i = 0; i < config.detent_positions_count; i++) {
-                    if (config.detent_positions[i] == current_position) {
-                        in_detent = true;
-                        break;
-                    }
-                }
-                if (!in_detent) {
-                    input = 0;
-                }
+        CYCLE_PROBE(loop_stages_[MotorLoopStage::PUBLISH]);
+        if (telemetry_.active()) {
+            uint8_t flags = 0;
+            if (calibration_.running() || cogging_calibration_.running()) {
+                flags |= TelemetryFrame::CALIBRATING;
+            } else if (haptic_due) {
+                flags |= TelemetryFrame::HAPTIC;
             }
-            float torque = motor_.PID_velocity(input);
-            #if SK_INVERT_ROTATION
-                torque = -torque;
-            #endif // SK_INVERT_ROTATION
-            motor_.move(torque);
+            telemetry_.record({
+                .timestamp_micros = sample_micros,
+                .angle = haptic_controller_.frameAngle(angle_observer_.angle()),
+                .velocity = angle_observer_.velocity(),
+                .target = haptic_controller_.detentCenter(),
+                .torque = torque,
+                .position = output.current_position,
+                .loop_micros = (uint16_t)std::min<uint32_t>(micros() - sample_micros, UINT16_MAX),
+                .flags = flags,
+                .reserved = 0,
+            });
         }
 
-        // Publish current status to other registered tasks periodically
+        // Queue changes that didn't fit while the consumer was behind
+        position_events_.flush();
+
+        // Publish current status to other tasks periodically (the config is only published when it changes)
         if (millis() - last_publish > 5) {
-            publish({
-                .current_position = current_position,
-                .sub_position_unit = latest_sub_position_unit,
-                .has_config = true,
-                .config = config,
-            });
+            knob_state_feed_.publishState(output.current_position, output.sub_position_unit, micros());
+            if (knob_state_listener_ != nullptr) {
+                xTaskNotifyGive(knob_state_listener_);
+            }
             last_publish = millis();
         }
+    }
+}
 
-        delay(1);
+void MotorTask::handleCommands() {
+    // Control operations first: a cancelled calibration hands the motor back to the haptics before the config and effects below
+    control_lane_.drain([&](const MotorCommand::Control& command) {
+        auto visitor = overload {
+            [&](const MotorCommand::Calibrate&) {
+                startCalibration();
+            },
+            [&](const MotorCommand::CalibrateCogging&) {
+                startCoggingCalibration();
+            },
+            [&](const MotorCommand::CancelCalibration&) {
+                if (calibration_.running()) {
+                    calibration_.cancel();
+                    finishCalibration();
+                } else if (cogging_calibration_.running()) {
+                    cogging_calibration_.cancel();
+                    finishCoggingCalibration();
+                }
+            },
+            [&](const MotorCommand::ReportLoopTiming&) {
+                logLoopTiming();
+            },
+        };
+        std::visit(visitor, command);
+    });
+
+    // Configs published since the last iteration were superseded by the latest one, so only that is applied
+    if (config_lane_.take(received_config_)) {
+        if (haptic_controller_.setConfig(received_config_, angle_observer_.angle())) {
+            LOG_INFO("applying position change");
+        }
+        telemetry_.notifyConfigChange();
+        knob_state_feed_.publishConfig(haptic_controller_.config());
+        LOG_INFO("Got new config");
     }
+
+    haptic_lane_.drain([&](const MotorCommand::PlayHaptic& h) {
+        if (!haptic_effect_player_.play(h.effect, h.strength, micros())) {
+            LOG_WARN("Unknown haptic effect %u", (uint8_t)h.effect);
+        }
+    });
+}
+
+void MotorTask::setLowPower(bool low_power) {
+    #if SK_IDLE_LOOP_HZ
+    // The timer keeps ticking at the full rate for the sensor; only the FOC step and the haptics slow down
+    loop_scheduler_.setIdleDivisor(low_power ? SK_MOTOR_LOOP_HZ / SK_IDLE_LOOP_HZ : 0);
+    #endif // SK_IDLE_LOOP_HZ
+}
+
+void MotorTask::loopTimerCallback(void* arg) {
+    MotorTask* motor_task = static_cast<MotorTask*>(arg);
+    xTaskNotifyGive(motor_task->getHandle());
 }
 
 void MotorTask::setConfig(const PB_SmartKnobConfig& config) {
-    command_sender_.publish(MotorCommand::SetConfig{config});
+    config_lane_.publish(config);
 }
 void MotorTask::playHaptic(bool press) {
-    command_sender_.publish(MotorCommand::PlayHaptic{press});
+    // Stronger click on press than on release
+    playHaptic(HapticEffect::CLICK, press ? 5 : 1.5);
+}
+void MotorTask::playHaptic(HapticEffect effect, float strength) {
+    haptic_lane_.publish(MotorCommand::PlayHaptic{effect, strength});
 }
 void MotorTask::runCalibration() {
-    command_sender_.publish(MotorCommand::Calibrate{});
+    control_lane_.publish(MotorCommand::Calibrate{});
+}
+void MotorTask::runCoggingCalibration() {
+    control_lane_.publish(MotorCommand::CalibrateCogging{});
+}
+void MotorTask::cancelCalibration() {
+    control_lane_.publish(MotorCommand::CancelCalibration{});
 }
-void MotorTask::registerStateListener(QueueHandle_t queue) {
-    command_sender_.publish(MotorCommand::RegisterStateListener{queue});
+void MotorTask::reportLoopTiming() {
+    control_lane_.publish(MotorCommand::ReportLoopTiming{});
 }
 
-void MotorTask::publish(const PB_SmartKnobState& state) {
-    for (auto listener : listeners_) {
-        xQueueOverwrite(listener, &state);
+void MotorTask::startCalibration() {
+    if (calibration_.running() || cogging_calibration_.running()) {
+        LOG_WARN("Calibration already in progress");
+        return;
     }
-}
 
-void MotorTask::calibrate() {
     // SimpleFOC is supposed to be able to determine this automatically (if you omit params to initFOC), but
     // it seems to have a bug (or I've misconfigured it) that gets both the offset and direction very wrong!
-    // So this value is based on experimentation.
-    // TODO: dig into SimpleFOC calibration and find/fix the issue
-
+    // So the motor task measures them itself, see MotorCalibration.
     LOG_INFO("\n\n\nStarting calibration, please DO NOT TOUCH MOTOR until complete!");
-    delay(1000);
 
+    // The calibration sets the phase voltages directly; in open loop mode loopFOC() only updates the sensor
     motor_.controller = MotionControlType::angle_openloop;
-    motor_.pole_pairs = 1;
-    motor_.initFOC(0, Direction::CW);
-
-    float a = 0;
-
-    motor_.voltage_limit = FOC_VOLTAGE_LIMIT;
-    motor_.move(a);
+    haptic_effect_player_.stop();
+    // The calibration learns the sensor's angle error, so it has to see uncorrected readings
+    encoder.source().correction().clear();
+    calibration_.start(FOC_VOLTAGE_LIMIT, encoder.getMechanicalAngle(), micros());
+    publishCalibrationStatus();
+}
 
-    // #### Determine direction motor rotates relative to angle sensor
-    for (uint8_t i = 0; i < 200; i++) {
-        encoder.update();
-        motor_.move(a);
-        delay(1);
-    }
-    float start_sensor = encoder.getAngle();
+void MotorTask::finishCalibration() {
+    motor_.setPhaseVoltage(0, 0, 0);
+    motor_.controller = MotionControlType::torque;
 
-    for (; a < 3 * _2PI; a += 0.01) {
-        encoder.update();
-        motor_.move(a);
-        delay(1);
+    switch (calibration_.status()) {
+        case MotorCalibration::Status::SUCCEEDED: {
+            const MotorCalibrationResult& result = calibration_.result();
+            motor_.pole_pairs = result.pole_pairs;
+            motor_.zero_electric_angle = result.zero_electrical_offset;
+            motor_.sensor_direction = result.direction_cw ? Direction::CW : Direction::CCW;
+
+            LOG_INFO("");
+            LOG_INFO("RESULTS:");
+            LOG_INFO("  ZERO_ELECTRICAL_OFFSET: %.2f", motor_.zero_electric_angle);
+            if (motor_.sensor_direction == Direction::CW) {
+                LOG_INFO("  FOC_DIRECTION: Direction::CW");
+            } else {
+                LOG_INFO("  FOC_DIRECTION: Direction::CCW");
+            }
+            LOG_INFO("  MOTOR_POLE_PAIRS: %d", motor_.pole_pairs);
+
+            PB_SensorCalibration sensor_calibration = {};
+            sensor_calibration.error_cos_count = SensorCorrection::MAX_HARMONICS;
+            sensor_calibration.error_sin_count = SensorCorrection::MAX_HARMONICS;
+            for (uint8_t i = 0; i < SensorCorrection::MAX_HARMONICS; i++) {
+                sensor_calibration.error_cos[i] = result.sensor_error_cos[i];
+                sensor_calibration.error_sin[i] = result.sensor_error_sin[i];
+            }
+            setSensorCorrection(sensor_calibration);
+            LOG_INFO("  SENSOR_MAX_ERROR: %.2f deg", encoder.source().correction().maxError() * 180 / PI);
+
+            LOG_INFO("");
+            LOG_INFO("Saving to persistent configuration...");
+            PB_MotorCalibration calibration = {
+                .calibrated = true,
+                .zero_electrical_offset = motor_.zero_electric_angle,
+                .direction_cw = motor_.sensor_direction == Direction::CW,
+                .pole_pairs = motor_.pole_pairs,
+            };
+            if (configuration_.setMotorCalibrationAndSave(calibration, sensor_calibration)) {
+                LOG_SUCCESS("Success!");
+            }
+            motor_calibrated_ = true;
+            break;
+        }
+        case MotorCalibration::Status::CANCELLED:
+            LOG_WARN("Calibration cancelled");
+            break;
+        case MotorCalibration::Status::NO_MOVEMENT:
+            LOG_ERROR("Calibration failed: the sensor did not detect any motor movement");
+            break;
+        case MotorCalibration::Status::BAD_POLE_PAIRS:
+            LOG_ERROR("Calibration failed: unexpected pole pairs");
+            break;
+        case MotorCalibration::Status::SLIPPED:
+            LOG_ERROR("Calibration failed: the motor did not follow the commanded angle. Was it touched?");
+            break;
+        default:
+            break;
     }
-
-    for (uint8_t i = 0; i < 200; i++) {
-        encoder.update();
-        delay(1);
+    if (calibration_.status() != MotorCalibration::Status::SUCCEEDED) {
+        // Keep the previously saved correction
+        configuration_.get(persistent_configuration_);
+        setSensorCorrection(persistent_configuration_.sensor);
     }
-    float end_sensor = encoder.getAngle();
 
+    // The sensor direction may have changed, and the rotor has moved; start the haptics over from where it is now
+    angle_observer_.reset(sensorAngle(), micros());
+    haptic_controller_.begin(angle_observer_.angle());
+    publishCalibrationStatus();
+}
 
-    motor_.voltage_limit = 0;
-    motor_.move(a);
-
-    LOG_INFO("");
+void MotorTask::publishCalibrationStatus() {
+    const MotorCalibrationResult& result = calibration_.result();
+    bool succeeded = calibration_.status() == MotorCalibration::Status::SUCCEEDED;
+    knob_state_feed_.publishCalibrationStatus({
+        .phase = (uint8_t)calibration_.phase(),
+        .status = (uint8_t)calibration_.status(),
+        .progress = calibration_.progress(),
+        .has_calibration = succeeded,
+        .calibration = {
+            .calibrated = succeeded,
+            .zero_electrical_offset = result.zero_electrical_offset,
+            .direction_cw = result.direction_cw,
+            .pole_pairs = result.pole_pairs,
+        },
+    });
+    last_calibration_status_micros_ = micros();
+}
 
-    float movement_angle = fabsf(end_sensor - start_sensor);
-    if (movement_angle < radians(30) || movement_angle > radians(180)) {
-        LOG_ERROR("Unexpected sensor change: start=%.2f end=%.2f", start_sensor, end_sensor);
+void MotorTask::startCoggingCalibration() {
+    if (calibration_.running() || cogging_calibration_.running()) {
+        LOG_WARN("Calibration already in progress");
         return;
     }
-
-    LOG_INFO("Sensor measures positive for positive motor rotation:");
-    if (end_sensor > start_sensor) {
-        LOG_INFO("YES, Direction=CW");
-        motor_.initFOC(0, Direction::CW);
-    } else {
-        LOG_WARN("NO, Direction=CCW");
-        motor_.initFOC(0, Direction::CCW);
-    }
-    LOG_INFO("  (start was %.1f, end was %.1f)", start_sensor, end_sensor);
-
-    // #### Determine pole-pairs
-    // Rotate 20 electrical revolutions and measure mechanical angle traveled, to calculate pole-pairs
-    uint8_t electrical_revolutions = 20;
-    LOG_INFO("Going to measure %d electrical revolutions...", electrical_revolutions);
-    motor_.voltage_limit = FOC_VOLTAGE_LIMIT;
-    motor_.move(a);
-    LOG_INFO("Going to electrical zero...");
-    float destination = a + _2PI;
-    for (; a < destination; a += 0.03) {
-        encoder.update();
-        motor_.move(a);
-        delay(1);
-    }
-    LOG_INFO("pause..."); // Let momentum settle...
-    for (uint16_t i = 0; i < 1000; i++) {
-        encoder.update();
-        delay(1);
-    }
-    LOG_INFO("Measuring...");
-
-    start_sensor = motor_.sensor_direction * encoder.getAngle();
-    destination = a + electrical_revolutions * _2PI;
-    for (; a < destination; a += 0.03) {
-        encoder.update();
-        motor_.move(a);
-        delay(1);
-    }
-    for (uint16_t i = 0; i < 1000; i++) {
-        encoder.update();
-        motor_.move(a);
-        delay(1);
-    }
-    end_sensor = motor_.sensor_direction * encoder.getAngle();
-    motor_.voltage_limit = 0;
-    motor_.move(a);
-
-    if (fabsf(motor_.shaft_angle - motor_.target) > 1 * PI / 180) {
-        LOG_ERROR("Motor did not reach target!");
-        while(1) {}
-    }
-
-    float electrical_per_mechanical = electrical_revolutions * _2PI / (end_sensor - start_sensor);
-    LOG_INFO("Electrical angle / mechanical angle (i.e. pole pairs) = %.2f", electrical_per_mechanical);
-
-    if (electrical_per_mechanical < 3 || electrical_per_mechanical > 12) {
-        LOG_ERROR("Unexpected calculated pole pairs: %.2f", electrical_per_mechanical);
+    if (!motor_calibrated_) {
+        LOG_ERROR("Cogging calibration needs a motor calibration first");
         return;
     }
 
-    int measured_pole_pairs = (int)round(electrical_per_mechanical);
-    LOG_INFO("Pole pairs set to %d", measured_pole_pairs);
-
-    delay(1000);
-
-
-    // #### Determine mechanical offset to electrical zero
-    // Measure mechanical angle at every electrical zero for several revolutions
-    motor_.voltage_limit = FOC_VOLTAGE_LIMIT;
-    motor_.move(a);
-    float offset_x = 0;
-    float offset_y = 0;
-    float destination1 = (floor(a / _2PI) + measured_pole_pairs / 2.) * _2PI;
-    float destination2 = (floor(a / _2PI)) * _2PI;
-    for (; a < destination1; a += 0.4) {
-        motor_.move(a);
-        delay(100);
-        for (uint8_t i = 0; i < 100; i++) {
-            encoder.update();
-            delay(1);
-        }
-        float real_electrical_angle = _normalizeAngle(a);
-        float measured_electrical_angle = _normalizeAngle( (float)(motor_.sensor_direction * measured_pole_pairs) * encoder.getMechanicalAngle()  - 0);
-
-        float offset_angle = measured_electrical_angle - real_electrical_angle;
-        offset_x += cosf(offset_angle);
-        offset_y += sinf(offset_angle);
+    LOG_INFO("\n\n\nStarting cogging calibration, please DO NOT TOUCH MOTOR until complete!");
+    haptic_effect_player_.stop();
+    // The measurement only spans a turn or so, which a float relative to its start holds precisely
+    cogging_origin_ = angle_observer_.predictAngle(micros() + loop_scheduler_.periodMicros());
+    cogging_calibration_.start(FOC_VOLTAGE_LIMIT, 0, micros());
+    publishCoggingCalibrationStatus();
+}
 
-        LOG_INFO("%.2f, %.2f, %.2f", degrees(real_electrical_angle), degrees(measured_electrical_angle), degrees(_normalizeAngle(offset_angle)));
-    }
-    for (; a > destination2; a -= 0.4) {
-        motor_.move(a);
-        delay(100);
-        for (uint8_t i = 0; i < 100; i++) {
-            encoder.update();
-            delay(1);
+void MotorTask::finishCoggingCalibration() {
+    motor_.move(0);
+
+    switch (cogging_calibration_.status()) {
+        case CoggingCalibration::Status::SUCCEEDED: {
+            cogging_map_ = cogging_calibration_.map();
+            LOG_INFO("");
+            LOG_INFO("RESULTS:");
+            LOG_INFO("  MAX_COGGING_TORQUE: %.3f", cogging_map_.maxTorque());
+
+            LOG_INFO("");
+            LOG_INFO("Saving to persistent configuration...");
+            PB_CoggingCalibration& calibration = persistent_configuration_.cogging;
+            calibration = {};
+            calibration.scale = cogging_map_.quantize((int8_t*)calibration.torque.bytes);
+            calibration.torque.size = CoggingMap::SIZE;
+            if (configuration_.setCoggingCalibrationAndSave(calibration)) {
+                LOG_SUCCESS("Success!");
+            }
+            break;
         }
-        float real_electrical_angle = _normalizeAngle(a);
-        float measured_electrical_angle = _normalizeAngle( (float)(motor_.sensor_direction * measured_pole_pairs) * encoder.getMechanicalAngle()  - 0);
-
-        float offset_angle = measured_electrical_angle - real_electrical_angle;
-        offset_x += cosf(offset_angle);
-        offset_y += sinf(offset_angle);
-
-        LOG_INFO("%.2f, %.2f, %.2f", degrees(real_electrical_angle), degrees(measured_electrical_angle), degrees(_normalizeAngle(offset_angle)));
+        case CoggingCalibration::Status::CANCELLED:
+            LOG_WARN("Cogging calibration cancelled");
+            break;
+        case CoggingCalibration::Status::SLIPPED:
+            LOG_ERROR("Cogging calibration failed: the motor did not follow the commanded angle. Was it touched?");
+            break;
+        default:
+            break;
     }
-    motor_.voltage_limit = 0;
-    motor_.move(a);
 
-    float avg_offset_angle = atan2f(offset_y, offset_x);
+    // The rotor has moved; start the haptics over from where it is now
+    haptic_controller_.begin(angle_observer_.angle());
+    publishCoggingCalibrationStatus();
+}
 
+void MotorTask::publishCoggingCalibrationStatus() {
+    knob_state_feed_.publishCalibrationStatus({
+        .phase = cogging_calibration_.running() ? COGGING_CALIBRATION_PHASE : (uint8_t)0,
+        .status = (uint8_t)cogging_calibration_.status(),
+        .progress = cogging_calibration_.progress(),
+        .has_calibration = false,
+        .calibration = {},
+    });
+    last_calibration_status_micros_ = micros();
+}
 
-    // #### Apply settings
-    motor_.pole_pairs = measured_pole_pairs;
-    motor_.zero_electric_angle = avg_offset_angle + _3PI_2;
-    motor_.voltage_limit = FOC_VOLTAGE_LIMIT;
-    motor_.controller = MotionControlType::torque;
+TurnAngle MotorTask::sensorAngle() const {
+    // Same as SimpleFOC's shaftAngle(), but without its low-pass filter, in the knob's logical direction. The
+    // whole turns are kept apart from the angle within the turn, which getAngle() would lose precision of.
+    float direction = ROTATION_SIGN * motor_.sensor_direction;
+    const TurnAngle& angle = encoder.source().angle();
+    return TurnAngle{
+        (int32_t)direction * angle.turns,
+        direction * angle.radians - ROTATION_SIGN * motor_.sensor_offset,
+    }.normalized();
+}
 
-    LOG_INFO("");
-    LOG_INFO("RESULTS:");
-    LOG_INFO("  ZERO_ELECTRICAL_OFFSET: %.2f", motor_.zero_electric_angle);
-    if (motor_.sensor_direction == Direction::CW) {
-        LOG_INFO("  FOC_DIRECTION: Direction::CW");
-    } else {
-        LOG_INFO("  FOC_DIRECTION: Direction::CCW");
-    }
-    LOG_INFO("  MOTOR_POLE_PAIRS: %d", motor_.pole_pairs);
-
-    LOG_INFO("");
-    LOG_INFO("Saving to persistent configuration...");
-    PB_MotorCalibration calibration = {
-        .calibrated = true,
-        .zero_electrical_offset = motor_.zero_electric_angle,
-        .direction_cw = motor_.sensor_direction == Direction::CW,
-        .pole_pairs = motor_.pole_pairs,
-    };
-    if (configuration_.setMotorCalibrationAndSave(calibration)) {
-        LOG_SUCCESS("Success!");
+void MotorTask::checkSensorError() {
+    char message[64];
+    if (encoder.source().takeError(message, sizeof(message))) {
+        LOG_ERROR("Sensor: %s", message);
     }
 }
 
-void MotorTask::checkSensorError() {
-#if SENSOR_TLV
-    if (encoder.getAndClearError()) {
-        LOG_ERROR("LOCKED!");
+void MotorTask::logLoopTiming() {
+    const LoopTimingHistogram& histogram = loop_scheduler_.histogram();
+    LOG_INFO("Motor loop: %u Hz (haptic divisor %u), %u samples, period min/avg/max %u/%.1f/%u us, %u overruns, %u missed ticks",
+        1000000 / loop_scheduler_.periodMicros(),
+        loop_scheduler_.hapticDivisor(),
+        histogram.samples(),
+        histogram.minPeriodMicros(),
+        histogram.meanPeriodMicros(),
+        histogram.maxPeriodMicros(),
+        histogram.overruns(),
+        histogram.missedTicks());
+
+    char line[256] = "Period histogram (us):";
+    for (uint8_t i = 0; i < LoopTimingHistogram::NUM_BUCKETS; i++) {
+        snprintf(line + strlen(line), sizeof(line) - strlen(line), " %u:%u", i * histogram.bucketWidthMicros(), histogram.bucket(i));
     }
-#elif SENSOR_MT6701
-    MT6701Error error = encoder.getAndClearError();
-    if (error.error) {
-        LOG_ERROR("CRC error. Received %d; calculated %d", error.received_crc, error.calculated_crc);
+    LOG_INFO("%s", line);
+
+    LOG_INFO("Idle: FOC and haptics at %u Hz after %u ms at rest, full rate %.1f%% of the time, %u wake-ups, wake latency avg/max %.0f/%u us",
+        SK_IDLE_LOOP_HZ,
+        SK_IDLE_DELAY_MILLIS,
+        idle_governor_.dutyCycle() * 100,
+        idle_governor_.wakeups(),
+        idle_governor_.meanWakeLatencyMicros(),
+        idle_governor_.maxWakeLatencyMicros());
+
+    LOG_INFO("Commands: %u configs (%u coalesced, %u takes retried), %u haptics (%u dropped), %u control (%u dropped)",
+        config_lane_.taken(),
+        config_lane_.coalesced(),
+        config_lane_.missed(),
+        haptic_lane_.received(),
+        haptic_lane_.dropped(),
+        control_lane_.received(),
+        control_lane_.dropped());
+
+    #if SENSOR_MT6701 && SK_MT6701_SAMPLE_HZ
+    LOG_INFO("Sensor: sampled at %u Hz in the background, %u samples skipped, %u frames dropped",
+        SK_MT6701_SAMPLE_HZ,
+        encoder.source().backend().skippedSamples(),
+        encoder.source().backend().droppedFrames());
+    #endif // SENSOR_MT6701 && SK_MT6701_SAMPLE_HZ
+    char health[160];
+    SensorHealthReport report = sensor_health_.report();
+    formatSensorHealth(health, sizeof(health), report.total, report.readings_reported);
+    LOG_INFO("Sensor health since boot: %s", health);
+
+    #if SK_CYCLE_PROBES
+    const float ticks_per_micro = CycleClock::ticksPerMicro();
+    LOG_INFO("Loop stages (us): samples min/avg/p50/p90/p99/max");
+    for (uint8_t i = 0; i < MotorLoopStage::COUNT; i++) {
+        const CycleStats& stage = loop_stages_[i];
+        LOG_INFO("  %-9s %7u %.1f/%.1f/%.1f/%.1f/%.1f/%.1f",
+            MOTOR_LOOP_STAGE_NAMES[i],
+            stage.count(),
+            stage.minTicks() / ticks_per_micro,
+            stage.meanTicks() / ticks_per_micro,
+            stage.percentileTicks(0.5) / ticks_per_micro,
+            stage.percentileTicks(0.9) / ticks_per_micro,
+            stage.percentileTicks(0.99) / ticks_per_micro,
+            stage.maxTicks() / ticks_per_micro);
     }
-#endif // SENSOR_TLV, SENSOR_MT6701
+    #endif // SK_CYCLE_PROBES
 }
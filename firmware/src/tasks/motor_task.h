@@ -2,39 +2,117 @@
 
 #include <Arduino.h>
 #include <SimpleFOC.h>
+#include <esp_timer.h>
 #include <vector>
 #include <variant>
 
+#include "command_channel.h"
 #include "configuration.h"
+#include "cycle_probe.h"
+#include "haptics/angle_observer.h"
+#include "haptics/haptic_controller.h"
+#include "haptics/haptic_effect.h"
+#include "haptics/idle_governor.h"
+#include "haptics/loop_scheduler.h"
+#include "knob_state_feed.h"
 #include "logger.h"
+#include "motors/cogging_calibration.h"
+#include "motors/motor_calibration.h"
+#include "mt6701_frame.h"
+#include "position_events.h"
 #include "proto_gen/smartknob.pb.h"
+#include "sensor_capture.h"
+#include "sensor_health.h"
 #include "task.h"
-#include "event_bus.h"
+#include "telemetry_buffer.h"
 
-// Motor event definitions
+// Rate of the fixed-rate FOC loop (loopFOC() + sensor read)
+#ifndef SK_MOTOR_LOOP_HZ
+    #define SK_MOTOR_LOOP_HZ 2000
+#endif // SK_MOTOR_LOOP_HZ
+
+// The haptic (detent) update runs every Nth FOC loop iteration
+#ifndef SK_HAPTIC_LOOP_DIVISOR
+    #define SK_HAPTIC_LOOP_DIVISOR 1
+#endif // SK_HAPTIC_LOOP_DIVISOR
+
+// Low-power mode while the knob rests: once it has been still for SK_IDLE_DELAY_MILLIS, the FOC step and
+// the haptics run at SK_IDLE_LOOP_HZ with the drive reduced to SK_IDLE_DRIVE_SCALE of its limit, until the
+// first sample that sees it move. The sensor is still read at SK_MOTOR_LOOP_HZ, so that is within one sensor
+// sample. 0 Hz disables the mode.
+#ifndef SK_IDLE_LOOP_HZ
+    #define SK_IDLE_LOOP_HZ 250
+#endif // SK_IDLE_LOOP_HZ
+#ifndef SK_IDLE_DELAY_MILLIS
+    #define SK_IDLE_DELAY_MILLIS 2000
+#endif // SK_IDLE_DELAY_MILLIS
+#ifndef SK_IDLE_DRIVE_SCALE
+    #define SK_IDLE_DRIVE_SCALE 0.5
+#endif // SK_IDLE_DRIVE_SCALE
+
+// Bandwidth of the angle/velocity observer feeding the haptic controller. Higher tracks fast
+// motion more closely, lower gives a quieter velocity estimate at rest.
+#ifndef SK_OBSERVER_BANDWIDTH
+    #define SK_OBSERVER_BANDWIDTH 300
+#endif // SK_OBSERVER_BANDWIDTH
+
+// Delay between the physical shaft angle and the angle reported by the sensor driver
+#ifndef SK_SENSOR_LATENCY_MICROS
+    #if SENSOR_MT6701 && SK_MT6701_SAMPLE_HZ
+        // Group delay of the MT6701 driver's EWMA (alpha 0.4, i.e. 1.5 samples), plus the half sample period
+        // the newest background sample has aged on average when the loop reads it
+        #define SK_SENSOR_LATENCY_MICROS (2000000 / SK_MT6701_SAMPLE_HZ)
+    #elif SENSOR_MT6701
+        // Group delay of the MT6701 driver's EWMA (alpha 0.4, i.e. 1.5 samples at the loop rate)
+        #define SK_SENSOR_LATENCY_MICROS (1500000 / SK_MOTOR_LOOP_HZ)
+    #else
+        #define SK_SENSOR_LATENCY_MICROS 0
+    #endif // SENSOR_MT6701
+#endif // SK_SENSOR_LATENCY_MICROS
+
+// Stages of the motor loop timed by the cycle probes (SK_CYCLE_PROBES). SENSOR is part of FOC, and
+// ITERATION covers everything after the wait for the loop timer.
+namespace MotorLoopStage {
+    enum Stage : uint8_t {
+        ITERATION,
+        FOC,
+        SENSOR,
+        COMMANDS,
+        HAPTICS,
+        MOVE,
+        PUBLISH,
+        COUNT,
+    };
+}
+
+// Commands to the motor task, in lanes (see MotorTask::commands_)
 namespace MotorCommand {
     struct Calibrate {};
-    struct SetConfig {
-        PB_SmartKnobConfig config;
-    };
+    struct CalibrateCogging {};
+    struct CancelCalibration {};
     struct PlayHaptic {
-        bool press;
-    };
-    struct RegisterStateListener {
-        QueueHandle_t queue;
+        HapticEffect effect;
+        float strength;
     };
+    struct ReportLoopTiming {};
 
-    using Message = std::variant<
+    // Rare operations, which all go through one lane
+    using Control = std::variant<
         Calibrate
-        , SetConfig
-        , PlayHaptic
-        , RegisterStateListener
+        , CalibrateCogging
+        , CancelCalibration
+        , ReportLoopTiming
     >;
-    
+
     static_assert(std::is_pod_v<Calibrate>);
-    static_assert(std::is_pod_v<SetConfig>);
+    static_assert(std::is_pod_v<CalibrateCogging>);
+    static_assert(std::is_pod_v<CancelCalibration>);
     static_assert(std::is_pod_v<PlayHaptic>);
-    static_assert(std::is_pod_v<RegisterStateListener>);
+    static_assert(std::is_pod_v<ReportLoopTiming>);
+
+    // Haptic effects queued at once; a click per detent while scrolling fast stays far below this
+    static const uint16_t HAPTIC_LANE_SIZE = 8;
+    static const uint16_t CONTROL_LANE_SIZE = 4;
 }
 
 class MotorTask : public Task<MotorTask> {
@@ -46,26 +124,92 @@ class MotorTask : public Task<MotorTask> {
 
         void setConfig(const PB_SmartKnobConfig& config);
         void playHaptic(bool press);
+        void playHaptic(HapticEffect effect, float strength = 0);
         void runCalibration();
+        // Measure the motor's cogging torque, to cancel it in the haptics. Needs a motor calibration first.
+        void runCoggingCalibration();
+        void cancelCalibration();
+        void reportLoopTiming();
 
-        void registerStateListener(QueueHandle_t queue);
+        // Latest knob state, config and calibration status, readable from any task without blocking the motor loop
+        const KnobStateFeed& knobStateFeed() const { return knob_state_feed_; }
+        // Task notified (xTaskNotifyGive) whenever a new knob state is published, so it can block until then; set before begin()
+        void setKnobStateListener(TaskHandle_t task) { knob_state_listener_ = task; }
+        // Per-iteration recording of the motor loop; armed and drained by the serial protocol without blocking the motor loop
+        TelemetryBuffer& telemetry() { return telemetry_; }
+        #if SENSOR_MT6701
+        // Raw readings of the angle sensor, recorded by its driver; started and drained by the serial protocol
+        SensorCapture& sensorCapture() { return sensor_capture_; }
+        #endif // SENSOR_MT6701
+        // Counts of the sensor's readings over the last complete window, readable from any task without blocking the motor loop
+        const SensorHealth& sensorHealth() const { return sensor_health_; }
+        // Every position change, in order, for one consumer task (the knob state feed only holds the latest position)
+        PositionEventQueue& positionEvents() { return position_events_; }
 
     protected:
         void run();
 
     private:
         Configuration& configuration_;
-        std::vector<QueueHandle_t> listeners_;
+        KnobStateFeed knob_state_feed_;
+        TaskHandle_t knob_state_listener_ = nullptr;
+        TelemetryBuffer telemetry_;
+        #if SENSOR_MT6701
+        // Only the MT6701 driver records its readings; 16 KB, so not reserved for other sensors
+        SensorCapture sensor_capture_;
+        #endif // SENSOR_MT6701
+        SensorHealth sensor_health_;
+        PositionEventQueue position_events_;
 
-        EventBusCore<MotorCommand::Message> command_bus_;
-        EventSender<MotorCommand::Message> command_sender_;
-        EventReceiver<MotorCommand::Message> command_receiver_;
+        // Commands from the interface task (the only producer), drained on every loop iteration. Only
+        // the latest config matters, so configs replace each other; haptics and control operations are
+        // queued in order, and dropped (and counted) if their lane is full.
+        LatestValueLane<PB_SmartKnobConfig> config_lane_;
+        FifoLane<MotorCommand::PlayHaptic, MotorCommand::HAPTIC_LANE_SIZE> haptic_lane_;
+        FifoLane<MotorCommand::Control, MotorCommand::CONTROL_LANE_SIZE> control_lane_;
+        // Latest config taken from its lane; a member, so the (large) config isn't on the task's stack
+        PB_SmartKnobConfig received_config_ = {};
+        // Persistent configuration read at startup and after a failed calibration, and the cogging calibration
+        // being saved; a member, so neither is copied onto the task's stack
+        PB_PersistentConfiguration persistent_configuration_ = {};
 
         // BLDC motor & driver instance
         BLDCMotor motor_ = BLDCMotor(1);
         BLDCDriver6PWM motor_driver_ = BLDCDriver6PWM(PIN_UH, PIN_UL, PIN_VH, PIN_VL, PIN_WH, PIN_WL);
 
-        void publish(const PB_SmartKnobState& state);
-        void calibrate();
+        AngleObserver angle_observer_;
+        HapticController<> haptic_controller_;
+        HapticEffectPlayer haptic_effect_player_;
+
+        MotorCalibration calibration_;
+        CoggingCalibration cogging_calibration_;
+        // Angle the cogging calibration started at; it measures relative to it
+        TurnAngle cogging_origin_ = {0, 0};
+        uint32_t last_calibration_status_micros_ = 0;
+        bool motor_calibrated_ = false;
+
+        // Cogging torque applied as feedforward while the haptics run
+        CoggingMap cogging_map_;
+
+        esp_timer_handle_t loop_timer_ = nullptr;
+        LoopScheduler loop_scheduler_;
+        IdleGovernor idle_governor_;
+        #if SK_CYCLE_PROBES
+        CycleStats loop_stages_[MotorLoopStage::COUNT];
+        #endif // SK_CYCLE_PROBES
+
+        void startCalibration();
+        void finishCalibration();
+        void publishCalibrationStatus();
+        void startCoggingCalibration();
+        void finishCoggingCalibration();
+        void publishCoggingCalibrationStatus();
+        void setCoggingMap(const PB_CoggingCalibration& calibration);
+        TurnAngle sensorAngle() const;
         void checkSensorError();
+        void handleCommands();
+        void setLowPower(bool low_power);
+        void logLoopTiming();
+
+        static void loopTimerCallback(void* arg);
 };
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief One motor loop iteration, as recorded by a TelemetryBuffer.
+ *
+ * Streamed to the host as raw bytes (see TelemetryChunk in smartknob.proto), in the ESP32's
+ * native little-endian layout; the host tools (software/tools/telemetry_decode.cpp) include this
+ * header to decode them. Changing the layout changes sizeof(TelemetryFrame), which the host
+ * checks against TelemetryChunk.frame_size.
+ */
+struct TelemetryFrame {
+    enum Flag : uint8_t {
+        HAPTIC = 1 << 0,      // The haptic update ran in this iteration (and set the torque)
+        TRIGGER = 1 << 1,     // The capture was triggered by this iteration
+        GAP = 1 << 2,         // Frames were dropped right before this one, because the buffer was full
+        CALIBRATING = 1 << 3, // A motor or cogging calibration is driving the motor
+    };
+
+    uint32_t timestamp_micros; // Time the sensor was sampled
+    float angle;               // Observer angle, radians, in the knob's logical direction (*)
+    float velocity;            // Observer velocity, radians/second
+    float target;              // Detent center the haptics pull towards, radians (*)
+    float torque;              // Latest commanded torque, in the knob's logical direction
+    int32_t position;          // Current position
+    uint16_t loop_micros;      // Time from the sensor sample to the end of the iteration
+    uint8_t flags;             // Flag bits
+    uint8_t reserved;
+
+    // (*) Both relative to the haptic controller's frame, which follows the knob by whole turns (see
+    // HapticController::frameAngle()), so they stay precise however far the knob has turned; they jump
+    // by a turn together when the frame moves.
+};
+
+static_assert(sizeof(TelemetryFrame) == 28, "TelemetryFrame is streamed raw; the host tools expect this layout");
+
+enum class TelemetryTrigger : uint8_t {
+    IMMEDIATE = 0,     // Start with the next loop iteration
+    CONFIG_CHANGE = 1, // Start when the motor task applies a new config
+    VELOCITY = 2,      // Start when the speed reaches velocity_threshold
+};
+
+/**
+ * @brief Parameters of a telemetry capture (see TelemetryRequest in smartknob.proto).
+ */
+struct TelemetryCapture {
+    TelemetryTrigger trigger;
+    uint32_t frames;           // Frames to record from the trigger on
+    uint16_t pre_trigger;      // Frames from before the trigger to include, if still in the buffer
+    uint16_t decimation;       // Record every Nth loop iteration (0 is treated as 1)
+    float velocity_threshold;  // Radians/second, for TelemetryTrigger::VELOCITY
+};
+
+/**
+ * @brief Lock-free single-producer, single-consumer ring of TelemetryFrames for one capture at a time.
+ *
+ * The motor task (producer) calls record() on every loop iteration; the serial protocol
+ * (consumer) arms a capture and drains the recorded frames at its own pace. A capture goes
+ * through these states:
+ *  - IDLE: nothing is recorded. Only the consumer may arm().
+ *  - ARMED: the producer records into the ring as a rolling history (nothing is read yet) and
+ *    waits for the trigger. On the trigger, the last pre_trigger frames become the start of
+ *    the capture.
+ *  - CAPTURING: the producer appends frames, which the consumer reads concurrently. When the
+ *    ring is full, frames are dropped (and counted) instead of waiting for the consumer.
+ *  - DONE: all frames were recorded (or the capture was cancelled); once the consumer has read
+ *    the rest, finish() returns the buffer to IDLE.
+ *
+ * Each index is only ever advanced by one side, and ownership of the state changes hands via
+ * release/acquire, so neither side ever waits for the other. While idle, record() is a single
+ * atomic load.
+ *
+ * software/tools/telemetry_buffer_stress.cpp drains captures from a concurrent producer on the host.
+ */
+class TelemetryBuffer {
+    public:
+        // Must be a power of two. 512 frames are 0.25s at the default 2kHz loop rate.
+        static const uint16_t CAPACITY = 512;
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+        // Producer side; must only be called from the motor task
+
+        // Whether record() would do anything, so the caller can skip assembling frames while idle
+        bool active() const {
+            State state = state_.load(std::memory_order_acquire);
+            return state == State::ARMED || state == State::CAPTURING;
+        }
+
+        // Only changes while a capture is armed count; one from before would trigger its first frame
+        void notifyConfigChange() {
+            if (active()) {
+                config_changed_ = true;
+            }
+        }
+
+        void record(const TelemetryFrame& frame) {
+            State state = state_.load(std::memory_order_acquire);
+            if (state != State::ARMED && state != State::CAPTURING) {
+                config_changed_ = false;
+                return;
+            }
+
+            uint32_t write = write_.load(std::memory_order_relaxed);
+            if (cancel_.load(std::memory_order_relaxed)) {
+                if (state == State::ARMED) {
+                    // Nothing was captured yet; discard the history
+                    read_.store(write, std::memory_order_relaxed);
+                    capture_start_ = write;
+                }
+                config_changed_ = false;
+                state_.store(State::DONE, std::memory_order_release);
+                return;
+            }
+
+            if (decimation_counter_ > 0) {
+                decimation_counter_--;
+                return;
+            }
+            decimation_counter_ = capture_.decimation > 1 ? capture_.decimation - 1 : 0;
+
+            bool config_changed = config_changed_;
+            config_changed_ = false;
+            uint8_t flags = frame.flags;
+            if (state == State::ARMED) {
+                bool triggered = false;
+                switch (capture_.trigger) {
+                    case TelemetryTrigger::IMMEDIATE:
+                        triggered = true;
+                        break;
+                    case TelemetryTrigger::CONFIG_CHANGE:
+                        triggered = config_changed;
+                        break;
+                    case TelemetryTrigger::VELOCITY:
+                        triggered = frame.velocity >= capture_.velocity_threshold || frame.velocity <= -capture_.velocity_threshold;
+                        break;
+                }
+                if (!triggered) {
+                    // Rolling history; the consumer doesn't read while armed, so the oldest frame is simply overwritten
+                    frames_[write & MASK] = frame;
+                    write_.store(write + 1, std::memory_order_relaxed);
+                    history_++;
+                    return;
+                }
+
+                uint32_t pre_trigger = capture_.pre_trigger;
+                if (pre_trigger > history_) {
+                    pre_trigger = history_;
+                }
+                if (pre_trigger > CAPACITY - 1) {
+                    pre_trigger = CAPACITY - 1;
+                }
+                read_.store(write - pre_trigger, std::memory_order_relaxed);
+                capture_start_ = write - pre_trigger;
+                flags |= TelemetryFrame::TRIGGER;
+                state = State::CAPTURING;
+            }
+
+            if (write - read_.load(std::memory_order_acquire) >= CAPACITY) {
+                dropped_++;
+                gap_ = true;
+            } else {
+                TelemetryFrame& slot = frames_[write & MASK];
+                slot = frame;
+                slot.flags = flags | (gap_ ? TelemetryFrame::GAP : 0);
+                gap_ = false;
+                write_.store(write + 1, std::memory_order_release);
+            }
+
+            remaining_--;
+            state_.store(remaining_ == 0 ? State::DONE : state, std::memory_order_release);
+        }
+
+        // Consumer side; must only be called from one task (the serial protocol)
+
+        bool idle() const {
+            return state_.load(std::memory_order_acquire) == State::IDLE;
+        }
+
+        // Start a capture. Returns false if a capture is still armed, running, or not yet read.
+        bool arm(const TelemetryCapture& capture) {
+            if (!idle() || capture.frames == 0) {
+                return false;
+            }
+            capture_ = capture;
+            remaining_ = capture.frames;
+            history_ = 0;
+            dropped_ = 0;
+            gap_ = false;
+            decimation_counter_ = 0;
+            cancel_.store(false, std::memory_order_relaxed);
+            state_.store(State::ARMED, std::memory_order_release);
+            return true;
+        }
+
+        // End the current capture early. Frames recorded so far can still be read.
+        void cancel() {
+            if (!idle()) {
+                cancel_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Copy up to max_frames recorded frames to out (unaligned bytes are fine).
+         *
+         * @param first_frame Set to the index of the first copied frame within the capture
+         * @return Number of frames copied
+         */
+        uint16_t read(uint8_t* out, uint16_t max_frames, uint32_t& first_frame) {
+            State state = state_.load(std::memory_order_acquire);
+            if (state != State::CAPTURING && state != State::DONE) {
+                return 0;
+            }
+            uint32_t read = read_.load(std::memory_order_relaxed);
+            uint32_t available = write_.load(std::memory_order_acquire) - read;
+            uint16_t count = available < max_frames ? available : max_frames;
+            for (uint16_t i = 0; i < count; i++) {
+                memcpy(out + i * sizeof(TelemetryFrame), &frames_[(read + i) & MASK], sizeof(TelemetryFrame));
+            }
+            first_frame = read - capture_start_;
+            read_.store(read + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @brief Return to idle once a capture has ended and all its frames were read.
+         *
+         * @param dropped Set to the number of frames that were dropped because the buffer was full
+         * @return true once per capture, when it was finished
+         */
+        bool finish(uint32_t& dropped) {
+            if (state_.load(std::memory_order_acquire) != State::DONE
+                    || read_.load(std::memory_order_relaxed) != write_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            dropped = dropped_;
+            state_.store(State::IDLE, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        enum class State : uint8_t {
+            IDLE,
+            ARMED,
+            CAPTURING,
+            DONE,
+        };
+
+        static const uint32_t MASK = CAPACITY - 1;
+
+        std::atomic<State> state_ = State::IDLE;
+        std::atomic<bool> cancel_ = false;
+
+        // Free-running frame counters; the slot of a frame is its counter modulo CAPACITY
+        std::atomic<uint32_t> write_ = 0;
+        std::atomic<uint32_t> read_ = 0;
+
+        // Written by the consumer while idle, by the producer while armed/capturing
+        TelemetryCapture capture_ = {};
+        uint32_t remaining_ = 0;
+        uint32_t capture_start_ = 0;
+        uint32_t history_ = 0;
+        uint32_t dropped_ = 0;
+        uint16_t decimation_counter_ = 0;
+        bool gap_ = false;
+
+        // Producer only
+        bool config_changed_ = false;
+
+        TelemetryFrame frames_[CAPACITY];
+};
@@ -1,19 +1,18 @@
 #include "tlv_sensor.h"
+#include "fast_trig.h"
 
 static const float ALPHA = 1;
 
-TlvSensor::TlvSensor() {}
+TlvSensor::TlvSensor(TwoWire* wire, bool invert) : wire_(wire), invert_(invert) {}
 
-void TlvSensor::init(TwoWire* wire, bool invert) {
-  wire_ = wire;
-  invert_ = invert;
-  tlv_.begin(*wire);
+void TlvSensor::init() {
+  tlv_.begin(*wire_);
   tlv_.setAccessMode(Tlv493d::AccessMode_e::MASTERCONTROLLEDMODE);
   tlv_.disableInterrupt();
   tlv_.disableTemp();
 }
 
-float TlvSensor::getSensorAngle() {
+float TlvSensor::read() {
     uint32_t now = micros();
     if (now - last_update_ > 50) {
       tlv_.updateData();
@@ -36,22 +35,25 @@ float TlvSensor::getSensorAngle() {
       }
       if (all_same) {
         error_ = true;
-        init(wire_, invert_);
+        init();
         // Force unique frame counts to avoid reset loop
         for (uint8_t i = 1; i < sizeof(frame_counts_); i++) {
           frame_counts_[i] = i;
         }
       }
     }
-    float rad = (invert_ ? -1 : 1) * atan2f(y_, x_);
+    float rad = (invert_ ? -1 : 1) * fastAtan2(y_, x_);
     if (rad < 0) {
         rad += 2*PI;
     }
     return rad;
 }
 
-bool TlvSensor::getAndClearError() {
-  bool error = error_;
+bool TlvSensor::takeError(char* message, size_t size) {
+  if (!error_) {
+    return false;
+  }
+  snprintf(message, size, "LOCKED!");
   error_ = false;
-  return error;
+  return true;
 }
@@ -1,28 +1,27 @@
 #pragma once
 
-#include <SimpleFOC.h>
+#include <Arduino.h>
 #include <Tlv493d.h>
 
-class TlvSensor : public Sensor {
+/** AngleSource backend (angle_source.h) for the TLV493D over I2C */
+class TlvSensor {
     public:
-        TlvSensor();
+        TlvSensor(TwoWire* wire, bool invert);
 
         // initialize the sensor hardware
-        void init(TwoWire* wire, bool invert);
+        void init();
 
-        // Get current shaft angle from the sensor hardware, and 
-        // return it as a float in radians, in the range 0 to 2PI.
-        //  - This method is pure virtual and must be implemented in subclasses.
-        //    Calling this method directly does not update the base-class internal fields.
-        //    Use update() when calling from outside code.
-        float getSensorAngle();
+        // Shaft angle in radians, in the range 0 to 2PI
+        float read();
+        // micros() of the latest reading
+        uint32_t sampleMicros() const { return last_update_; }
 
-        bool getAndClearError();
+        bool takeError(char* message, size_t size);
     private:
         Tlv493d tlv_ = Tlv493d();
         float x_;
         float y_;
-        uint32_t last_update_;
+        uint32_t last_update_ = 0;
         TwoWire* wire_;
         bool invert_;
 
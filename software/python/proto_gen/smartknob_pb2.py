@@ -15,7 +15,7 @@ _sym_db = _symbol_database.Default()
 import nanopb_pb2 as nanopb__pb2
 
 
-DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0fsmartknob.proto\x12\x02PB\x1a\x0cnanopb.proto\"\x9a\x01\n\rFromSmartKnob\x12\x1f\n\x10protocol_version\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\x16\n\x03\x61\x63k\x18\x02 \x01(\x0b\x32\x07.PB.AckH\x00\x12\x16\n\x03log\x18\x03 \x01(\x0b\x32\x07.PB.LogH\x00\x12-\n\x0fsmartknob_state\x18\x04 \x01(\x0b\x32\x12.PB.SmartKnobStateH\x00\x42\t\n\x07payload\"\xa4\x01\n\x0bToSmartknob\x12\x1f\n\x10protocol_version\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\r\n\x05nonce\x18\x02 \x01(\r\x12)\n\rrequest_state\x18\x03 \x01(\x0b\x32\x10.PB.RequestStateH\x00\x12/\n\x10smartknob_config\x18\x04 \x01(\x0b\x32\x13.PB.SmartKnobConfigH\x00\x42\t\n\x07payload\"\x14\n\x03\x41\x63k\x12\r\n\x05nonce\x18\x01 \x01(\r\"\x1a\n\x03Log\x12\x13\n\x03msg\x18\x01 \x01(\tB\x06\x92?\x03p\xff\x01\"\x86\x01\n\x0eSmartKnobState\x12\x18\n\x10\x63urrent_position\x18\x01 \x01(\x05\x12\x19\n\x11sub_position_unit\x18\x02 \x01(\x02\x12#\n\x06\x63onfig\x18\x03 \x01(\x0b\x32\x13.PB.SmartKnobConfig\x12\x1a\n\x0bpress_nonce\x18\x04 \x01(\rB\x05\x92?\x02\x38\x08\"g\n\nViewConfig\x12\x11\n\tview_type\x18\x01 \x01(\x05\x12\x1a\n\x0b\x64\x65scription\x18\x02 \x01(\tB\x05\x92?\x02p(\x12*\n\x0cmenu_entries\x18\x03 \x03(\x0b\x32\r.PB.MenuEntryB\x05\x92?\x02\x10\x08\"<\n\tMenuEntry\x12\x1a\n\x0b\x64\x65scription\x18\x01 \x01(\tB\x05\x92?\x02p\x13\x12\x13\n\x04icon\x18\x02 \x01(\tB\x05\x92?\x02p\x03\"\x8a\x03\n\x0fSmartKnobConfig\x12#\n\x0bview_config\x18\x01 \x01(\x0b\x32\x0e.PB.ViewConfig\x12\x10\n\x08position\x18\x02 \x01(\x05\x12\x19\n\x11sub_position_unit\x18\x03 \x01(\x02\x12\x1d\n\x0eposition_nonce\x18\x04 \x01(\rB\x05\x92?\x02\x38\x08\x12\x14\n\x0cmin_position\x18\x05 \x01(\x05\x12\x14\n\x0cmax_position\x18\x06 \x01(\x05\x12\x17\n\x0finfinite_scroll\x18\x07 \x01(\x08\x12\x1e\n\x16position_width_radians\x18\x08 \x01(\x02\x12\x1c\n\x14\x64\x65tent_strength_unit\x18\t \x01(\x02\x12\x1d\n\x15\x65ndstop_strength_unit\x18\n \x01(\x02\x12\x12\n\nsnap_point\x18\x0b \x01(\x02\x12\x1f\n\x10\x64\x65tent_positions\x18\x0c \x03(\x05\x42\x05\x92?\x02\x10\x05\x12\x17\n\x0fsnap_point_bias\x18\r \x01(\x02\x12\x16\n\x07led_hue\x18\x0e \x01(\x05\x42\x05\x92?\x02\x38\x10\"\x0e\n\x0cRequestState\"v\n\x17PersistentConfiguration\x12\x0f\n\x07version\x18\x01 \x01(\r\x12#\n\x05motor\x18\x02 \x01(\x0b\x32\x14.PB.MotorCalibration\x12%\n\x06strain\x18\x03 \x01(\x0b\x32\x15.PB.StrainCalibration\"p\n\x10MotorCalibration\x12\x12\n\ncalibrated\x18\x01 \x01(\x08\x12\x1e\n\x16zero_electrical_offset\x18\x02 \x01(\x02\x12\x14\n\x0c\x64irection_cw\x18\x03 \x01(\x08\x12\x12\n\npole_pairs\x18\x04 \x01(\r\"<\n\x11StrainCalibration\x12\x12\n\nidle_value\x18\x01 \x01(\x05\x12\x13\n\x0bpress_delta\x18\x02 \x01(\x05\x62\x06proto3')
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0fsmartknob.proto\x12\x02PB\x1a\x0cnanopb.proto\"\xec\x02\n\rFromSmartKnob\x12\x1f\n\x10protocol_version\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\x16\n\x03\x61\x63k\x18\x02 \x01(\x0b\x32\x07.PB.AckH\x00\x12\x16\n\x03log\x18\x03 \x01(\x0b\x32\x07.PB.LogH\x00\x12-\n\x0fsmartknob_state\x18\x04 \x01(\x0b\x32\x12.PB.SmartKnobStateH\x00\x12>\n\x18motor_calibration_status\x18\x05 \x01(\x0b\x32\x1a.PB.MotorCalibrationStatusH\x00\x12-\n\x0ftelemetry_chunk\x18\x06 \x01(\x0b\x32\x12.PB.TelemetryChunkH\x00\x12\x36\n\x14sensor_capture_chunk\x18\x07 \x01(\x0b\x32\x16.PB.SensorCaptureChunkH\x00\x12)\n\rsensor_health\x18\x08 \x01(\x0b\x32\x10.PB.SensorHealthH\x00\x42\t\n\x07payload\"\xab\x03\n\x0bToSmartknob\x12\x1f\n\x10protocol_version\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\r\n\x05nonce\x18\x02 \x01(\r\x12)\n\rrequest_state\x18\x03 \x01(\x0b\x32\x10.PB.RequestStateH\x00\x12/\n\x10smartknob_config\x18\x04 \x01(\x0b\x32\x13.PB.SmartKnobConfigH\x00\x12\x32\n\x12play_haptic_effect\x18\x05 \x01(\x0b\x32\x14.PB.PlayHapticEffectH\x00\x12\x38\n\x11motor_calibration\x18\x06 \x01(\x0b\x32\x1b.PB.MotorCalibrationRequestH\x00\x12)\n\ttelemetry\x18\x07 \x01(\x0b\x32\x14.PB.TelemetryRequestH\x00\x12\x32\n\x0esensor_capture\x18\x08 \x01(\x0b\x32\x18.PB.SensorCaptureRequestH\x00\x12\x38\n\x15request_sensor_health\x18\t \x01(\x0b\x32\x17.PB.RequestSensorHealthH\x00\x42\t\n\x07payload\"\x14\n\x03\x41\x63k\x12\r\n\x05nonce\x18\x01 \x01(\r\"\x1a\n\x03Log\x12\x13\n\x03msg\x18\x01 \x01(\tB\x06\x92?\x03p\xff\x01\"\x9e\x01\n\x0eSmartKnobState\x12\x18\n\x10\x63urrent_position\x18\x01 \x01(\x05\x12\x19\n\x11sub_position_unit\x18\x02 \x01(\x02\x12#\n\x06\x63onfig\x18\x03 \x01(\x0b\x32\x13.PB.SmartKnobConfig\x12\x1a\n\x0bpress_nonce\x18\x04 \x01(\rB\x05\x92?\x02\x38\x08\x12\x16\n\x0eposition_steps\x18\x05 \x01(\x05\"g\n\nViewConfig\x12\x11\n\tview_type\x18\x01 \x01(\x05\x12\x1a\n\x0b\x64\x65scription\x18\x02 \x01(\tB\x05\x92?\x02p(\x12*\n\x0cmenu_entries\x18\x03 \x03(\x0b\x32\r.PB.MenuEntryB\x05\x92?\x02\x10\x08\"<\n\tMenuEntry\x12\x1a\n\x0b\x64\x65scription\x18\x01 \x01(\tB\x05\x92?\x02p\x13\x12\x13\n\x04icon\x18\x02 \x01(\tB\x05\x92?\x02p\x03\"\xf4\x03\n\x0fSmartKnobConfig\x12#\n\x0bview_config\x18\x01 \x01(\x0b\x32\x0e.PB.ViewConfig\x12\x10\n\x08position\x18\x02 \x01(\x05\x12\x19\n\x11sub_position_unit\x18\x03 \x01(\x02\x12\x1d\n\x0eposition_nonce\x18\x04 \x01(\rB\x05\x92?\x02\x38\x08\x12\x14\n\x0cmin_position\x18\x05 \x01(\x05\x12\x14\n\x0cmax_position\x18\x06 \x01(\x05\x12\x17\n\x0finfinite_scroll\x18\x07 \x01(\x08\x12\x1e\n\x16position_width_radians\x18\x08 \x01(\x02\x12\x1c\n\x14\x64\x65tent_strength_unit\x18\t \x01(\x02\x12\x1d\n\x15\x65ndstop_strength_unit\x18\n \x01(\x02\x12\x12\n\nsnap_point\x18\x0b \x01(\x02\x12\x1f\n\x10\x64\x65tent_positions\x18\x0c \x03(\x05\x42\x05\x92?\x02\x10\x05\x12\x17\n\x0fsnap_point_bias\x18\r \x01(\x02\x12\x16\n\x07led_hue\x18\x0e \x01(\x05\x42\x05\x92?\x02\x38\x10\x12$\n\x15\x64\x65tent_torque_profile\x18\x0f \x03(\x02\x42\x05\x92?\x02\x10 \x12\x1b\n\x0b\x64\x65tent_runs\x18\x10 \x01(\x0c\x42\x06\x92?\x03\x08\x80\x02\x12%\n\x0cposition_map\x18\x11 \x01(\x0b\x32\x0f.PB.PositionMap\"Q\n\x0bPositionMap\x12\x14\n\x05\x63urve\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\r\n\x05shape\x18\x02 \x01(\x02\x12\x1d\n\x0esegment_widths\x18\x03 \x03(\x02\x42\x05\x92?\x02\x10\x10\"\x0e\n\x0cRequestState\";\n\x10PlayHapticEffect\x12\x15\n\x06\x65\x66\x66\x65\x63t\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\x10\n\x08strength\x18\x02 \x01(\x02\":\n\x17MotorCalibrationRequest\x12\x0e\n\x06\x63\x61ncel\x18\x01 \x01(\x08\x12\x0f\n\x07\x63ogging\x18\x02 \x01(\x08\"\x82\x01\n\x16MotorCalibrationStatus\x12\x14\n\x05phase\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\x15\n\x06status\x18\x02 \x01(\rB\x05\x92?\x02\x38\x08\x12\x10\n\x08progress\x18\x03 \x01(\x02\x12)\n\x0b\x63\x61libration\x18\x04 \x01(\x0b\x32\x14.PB.MotorCalibration\"\x8d\x01\n\x10TelemetryRequest\x12\x16\n\x07trigger\x18\x01 \x01(\rB\x05\x92?\x02\x38\x08\x12\x0e\n\x06\x66rames\x18\x02 \x01(\r\x12\x1a\n\x0bpre_trigger\x18\x03 \x01(\rB\x05\x92?\x02\x38\x10\x12\x19\n\ndecimation\x18\x04 \x01(\rB\x05\x92?\x02\x38\x10\x12\x1a\n\x12velocity_threshold\x18\x05 \x01(\x02\"v\n\x0eTelemetryChunk\x12\x13\n\x0b\x66irst_frame\x18\x01 \x01(\r\x12\x16\n\x06\x66rames\x18\x02 \x01(\x0c\x42\x06\x92?\x03\x08\xe0\x01\x12\x19\n\nframe_size\x18\x03 \x01(\rB\x05\x92?\x02\x38\x08\x12\x0b\n\x03\x65nd\x18\x04 \x01(\x08\x12\x0f\n\x07\x64ropped\x18\x05 \x01(\r\"&\n\x14SensorCaptureRequest\x12\x0e\n\x06\x66rames\x18\x01 \x01(\r\"\x91\x01\n\x12SensorCaptureChunk\x12\x13\n\x0b\x66irst_frame\x18\x01 \x01(\r\x12\x16\n\x06\x66rames\x18\x02 \x01(\x0c\x42\x06\x92?\x03\x08\xe0\x01\x12\x19\n\nframe_size\x18\x03 \x01(\rB\x05\x92?\x02\x38\x08\x12\x15\n\x06\x66ormat\x18\x04 \x01(\rB\x05\x92?\x02\x38\x08\x12\x0b\n\x03\x65nd\x18\x05 \x01(\x08\x12\x0f\n\x07\x64ropped\x18\x06 \x01(\r\"\x15\n\x13RequestSensorHealth\"\xca\x01\n\x12SensorHealthCounts\x12\x0f\n\x07samples\x18\x01 \x01(\r\x12\x12\n\ncrc_errors\x18\x02 \x01(\r\x12\x18\n\x10\x66ield_too_strong\x18\x03 \x01(\r\x12\x16\n\x0e\x66ield_too_weak\x18\x04 \x01(\r\x12\x15\n\rloss_of_track\x18\x05 \x01(\r\x12\x16\n\x0emax_age_micros\x18\x06 \x01(\r\x12\x18\n\x10stale_iterations\x18\x07 \x01(\r\x12\x14\n\x0cstuck_frames\x18\x08 \x01(\r\"\x9e\x01\n\x0cSensorHealth\x12\x15\n\rwindow_millis\x18\x01 \x01(\r\x12&\n\x06window\x18\x02 \x01(\x0b\x32\x16.PB.SensorHealthCounts\x12%\n\x05total\x18\x03 \x01(\x0b\x32\x16.PB.SensorHealthCounts\x12\r\n\x05stale\x18\x04 \x01(\x08\x12\x19\n\x11readings_reported\x18\x05 \x01(\x08\"\xc6\x01\n\x17PersistentConfiguration\x12\x0f\n\x07version\x18\x01 \x01(\r\x12#\n\x05motor\x18\x02 \x01(\x0b\x32\x14.PB.MotorCalibration\x12%\n\x06strain\x18\x03 \x01(\x0b\x32\x15.PB.StrainCalibration\x12%\n\x06sensor\x18\x04 \x01(\x0b\x32\x15.PB.SensorCalibration\x12\'\n\x07\x63ogging\x18\x05 \x01(\x0b\x32\x16.PB.CoggingCalibration\"p\n\x10MotorCalibration\x12\x12\n\ncalibrated\x18\x01 \x01(\x08\x12\x1e\n\x16zero_electrical_offset\x18\x02 \x01(\x02\x12\x14\n\x0c\x64irection_cw\x18\x03 \x01(\x08\x12\x12\n\npole_pairs\x18\x04 \x01(\r\"<\n\x11StrainCalibration\x12\x12\n\nidle_value\x18\x01 \x01(\x05\x12\x13\n\x0bpress_delta\x18\x02 \x01(\x05\"G\n\x11SensorCalibration\x12\x18\n\terror_cos\x18\x01 \x03(\x02\x42\x05\x92?\x02\x10\x04\x12\x18\n\terror_sin\x18\x02 \x03(\x02\x42\x05\x92?\x02\x10\x04\";\n\x12\x43oggingCalibration\x12\x16\n\x06torque\x18\x01 \x01(\x0c\x42\x06\x92?\x03\x08\x80\x04\x12\r\n\x05scale\x18\x02 \x01(\x02\x62\x06proto3')
 
 _globals = globals()
 _builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, _globals)
@@ -44,28 +44,90 @@ if not _descriptor._USE_C_DESCRIPTORS:
   _globals['_SMARTKNOBCONFIG'].fields_by_name['detent_positions']._serialized_options = b'\222?\002\020\005'
   _globals['_SMARTKNOBCONFIG'].fields_by_name['led_hue']._loaded_options = None
   _globals['_SMARTKNOBCONFIG'].fields_by_name['led_hue']._serialized_options = b'\222?\0028\020'
+  _globals['_SMARTKNOBCONFIG'].fields_by_name['detent_torque_profile']._loaded_options = None
+  _globals['_SMARTKNOBCONFIG'].fields_by_name['detent_torque_profile']._serialized_options = b'\222?\002\020 '
+  _globals['_SMARTKNOBCONFIG'].fields_by_name['detent_runs']._loaded_options = None
+  _globals['_SMARTKNOBCONFIG'].fields_by_name['detent_runs']._serialized_options = b'\222?\003\010\200\002'
+  _globals['_POSITIONMAP'].fields_by_name['curve']._loaded_options = None
+  _globals['_POSITIONMAP'].fields_by_name['curve']._serialized_options = b'\222?\0028\010'
+  _globals['_POSITIONMAP'].fields_by_name['segment_widths']._loaded_options = None
+  _globals['_POSITIONMAP'].fields_by_name['segment_widths']._serialized_options = b'\222?\002\020\020'
+  _globals['_PLAYHAPTICEFFECT'].fields_by_name['effect']._loaded_options = None
+  _globals['_PLAYHAPTICEFFECT'].fields_by_name['effect']._serialized_options = b'\222?\0028\010'
+  _globals['_MOTORCALIBRATIONSTATUS'].fields_by_name['phase']._loaded_options = None
+  _globals['_MOTORCALIBRATIONSTATUS'].fields_by_name['phase']._serialized_options = b'\222?\0028\010'
+  _globals['_MOTORCALIBRATIONSTATUS'].fields_by_name['status']._loaded_options = None
+  _globals['_MOTORCALIBRATIONSTATUS'].fields_by_name['status']._serialized_options = b'\222?\0028\010'
+  _globals['_TELEMETRYREQUEST'].fields_by_name['trigger']._loaded_options = None
+  _globals['_TELEMETRYREQUEST'].fields_by_name['trigger']._serialized_options = b'\222?\0028\010'
+  _globals['_TELEMETRYREQUEST'].fields_by_name['pre_trigger']._loaded_options = None
+  _globals['_TELEMETRYREQUEST'].fields_by_name['pre_trigger']._serialized_options = b'\222?\0028\020'
+  _globals['_TELEMETRYREQUEST'].fields_by_name['decimation']._loaded_options = None
+  _globals['_TELEMETRYREQUEST'].fields_by_name['decimation']._serialized_options = b'\222?\0028\020'
+  _globals['_TELEMETRYCHUNK'].fields_by_name['frames']._loaded_options = None
+  _globals['_TELEMETRYCHUNK'].fields_by_name['frames']._serialized_options = b'\222?\003\010\340\001'
+  _globals['_TELEMETRYCHUNK'].fields_by_name['frame_size']._loaded_options = None
+  _globals['_TELEMETRYCHUNK'].fields_by_name['frame_size']._serialized_options = b'\222?\0028\010'
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['frames']._loaded_options = None
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['frames']._serialized_options = b'\222?\003\010\340\001'
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['frame_size']._loaded_options = None
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['frame_size']._serialized_options = b'\222?\0028\010'
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['format']._loaded_options = None
+  _globals['_SENSORCAPTURECHUNK'].fields_by_name['format']._serialized_options = b'\222?\0028\010'
+  _globals['_SENSORCALIBRATION'].fields_by_name['error_cos']._loaded_options = None
+  _globals['_SENSORCALIBRATION'].fields_by_name['error_cos']._serialized_options = b'\222?\002\020\004'
+  _globals['_SENSORCALIBRATION'].fields_by_name['error_sin']._loaded_options = None
+  _globals['_SENSORCALIBRATION'].fields_by_name['error_sin']._serialized_options = b'\222?\002\020\004'
+  _globals['_COGGINGCALIBRATION'].fields_by_name['torque']._loaded_options = None
+  _globals['_COGGINGCALIBRATION'].fields_by_name['torque']._serialized_options = b'\222?\003\010\200\004'
   _globals['_FROMSMARTKNOB']._serialized_start=38
-  _globals['_FROMSMARTKNOB']._serialized_end=192
-  _globals['_TOSMARTKNOB']._serialized_start=195
-  _globals['_TOSMARTKNOB']._serialized_end=359
-  _globals['_ACK']._serialized_start=361
-  _globals['_ACK']._serialized_end=381
-  _globals['_LOG']._serialized_start=383
-  _globals['_LOG']._serialized_end=409
-  _globals['_SMARTKNOBSTATE']._serialized_start=412
-  _globals['_SMARTKNOBSTATE']._serialized_end=546
-  _globals['_VIEWCONFIG']._serialized_start=548
-  _globals['_VIEWCONFIG']._serialized_end=651
-  _globals['_MENUENTRY']._serialized_start=653
-  _globals['_MENUENTRY']._serialized_end=713
-  _globals['_SMARTKNOBCONFIG']._serialized_start=716
-  _globals['_SMARTKNOBCONFIG']._serialized_end=1110
-  _globals['_REQUESTSTATE']._serialized_start=1112
-  _globals['_REQUESTSTATE']._serialized_end=1126
-  _globals['_PERSISTENTCONFIGURATION']._serialized_start=1128
-  _globals['_PERSISTENTCONFIGURATION']._serialized_end=1246
-  _globals['_MOTORCALIBRATION']._serialized_start=1248
-  _globals['_MOTORCALIBRATION']._serialized_end=1360
-  _globals['_STRAINCALIBRATION']._serialized_start=1362
-  _globals['_STRAINCALIBRATION']._serialized_end=1422
+  _globals['_FROMSMARTKNOB']._serialized_end=402
+  _globals['_TOSMARTKNOB']._serialized_start=405
+  _globals['_TOSMARTKNOB']._serialized_end=832
+  _globals['_ACK']._serialized_start=834
+  _globals['_ACK']._serialized_end=854
+  _globals['_LOG']._serialized_start=856
+  _globals['_LOG']._serialized_end=882
+  _globals['_SMARTKNOBSTATE']._serialized_start=885
+  _globals['_SMARTKNOBSTATE']._serialized_end=1043
+  _globals['_VIEWCONFIG']._serialized_start=1045
+  _globals['_VIEWCONFIG']._serialized_end=1148
+  _globals['_MENUENTRY']._serialized_start=1150
+  _globals['_MENUENTRY']._serialized_end=1210
+  _globals['_SMARTKNOBCONFIG']._serialized_start=1213
+  _globals['_SMARTKNOBCONFIG']._serialized_end=1713
+  _globals['_POSITIONMAP']._serialized_start=1715
+  _globals['_POSITIONMAP']._serialized_end=1796
+  _globals['_REQUESTSTATE']._serialized_start=1798
+  _globals['_REQUESTSTATE']._serialized_end=1812
+  _globals['_PLAYHAPTICEFFECT']._serialized_start=1814
+  _globals['_PLAYHAPTICEFFECT']._serialized_end=1873
+  _globals['_MOTORCALIBRATIONREQUEST']._serialized_start=1875
+  _globals['_MOTORCALIBRATIONREQUEST']._serialized_end=1933
+  _globals['_MOTORCALIBRATIONSTATUS']._serialized_start=1936
+  _globals['_MOTORCALIBRATIONSTATUS']._serialized_end=2066
+  _globals['_TELEMETRYREQUEST']._serialized_start=2069
+  _globals['_TELEMETRYREQUEST']._serialized_end=2210
+  _globals['_TELEMETRYCHUNK']._serialized_start=2212
+  _globals['_TELEMETRYCHUNK']._serialized_end=2330
+  _globals['_SENSORCAPTUREREQUEST']._serialized_start=2332
+  _globals['_SENSORCAPTUREREQUEST']._serialized_end=2370
+  _globals['_SENSORCAPTURECHUNK']._serialized_start=2373
+  _globals['_SENSORCAPTURECHUNK']._serialized_end=2518
+  _globals['_REQUESTSENSORHEALTH']._serialized_start=2520
+  _globals['_REQUESTSENSORHEALTH']._serialized_end=2541
+  _globals['_SENSORHEALTHCOUNTS']._serialized_start=2544
+  _globals['_SENSORHEALTHCOUNTS']._serialized_end=2746
+  _globals['_SENSORHEALTH']._serialized_start=2749
+  _globals['_SENSORHEALTH']._serialized_end=2907
+  _globals['_PERSISTENTCONFIGURATION']._serialized_start=2910
+  _globals['_PERSISTENTCONFIGURATION']._serialized_end=3108
+  _globals['_MOTORCALIBRATION']._serialized_start=3110
+  _globals['_MOTORCALIBRATION']._serialized_end=3222
+  _globals['_STRAINCALIBRATION']._serialized_start=3224
+  _globals['_STRAINCALIBRATION']._serialized_end=3284
+  _globals['_SENSORCALIBRATION']._serialized_start=3286
+  _globals['_SENSORCALIBRATION']._serialized_end=3357
+  _globals['_COGGINGCALIBRATION']._serialized_start=3359
+  _globals['_COGGINGCALIBRATION']._serialized_end=3418
 # @@protoc_insertion_point(module_scope)
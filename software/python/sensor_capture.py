@@ -0,0 +1,59 @@
+import os
+import sys
+if __name__ == '__main__':
+    if 'PIPENV_ACTIVE' not in os.environ:
+        sys.exit(f'This script should be run in a Pipenv.\n\nRun it as:\npipenv run python {os.path.basename(__file__)}')
+
+# Place imports below this line
+import argparse
+import logging
+from queue import Queue
+
+from smartknob_io import (
+    ask_for_serial_port,
+    smartknob_context
+)
+
+FORMATS = {
+    1: 'MT6701 SSI',
+}
+
+def _run_capture():
+    parser = argparse.ArgumentParser(description='Record the raw readings of the angle sensor to a capture file. Replay it with software/tools/sensor_replay.cpp.')
+    parser.add_argument('output', help='Capture file to write')
+    parser.add_argument('--frames', type=int, default=10000, help='Sensor readings to record (at 2 kHz by default)')
+    parser.add_argument('--port', help='Serial port (asks if omitted)')
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+
+    p = args.port or ask_for_serial_port()
+    with smartknob_context(p) as s, open(args.output, 'wb') as f:
+        done = Queue(1)
+        next_frame = 0
+
+        def handle_chunk(chunk):
+            nonlocal next_frame
+            if chunk.first_frame != next_frame and len(chunk.frames) > 0:
+                logging.warning(f'Missing frames {next_frame}..{chunk.first_frame - 1} (lost packets)')
+            f.write(chunk.frames)
+            if chunk.frame_size > 0:
+                next_frame = chunk.first_frame + len(chunk.frames) // chunk.frame_size
+            if chunk.end:
+                done.put(chunk)
+
+        s.add_handler('sensor_capture_chunk', handle_chunk)
+        s.request_sensor_capture(args.frames)
+        logging.info('Recording...')
+        try:
+            last = done.get()
+        except KeyboardInterrupt:
+            # Stop early; the readings recorded so far are still sent
+            s.request_sensor_capture(0)
+            last = done.get()
+        if last.format not in FORMATS:
+            sys.exit('The knob\'s sensor driver does not record its readings')
+        logging.info(f'Wrote {next_frame} {FORMATS[last.format]} frames to {args.output} ({last.dropped} dropped by the knob)')
+
+if __name__ == '__main__':
+    _run_capture()
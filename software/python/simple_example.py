@@ -31,8 +31,10 @@ def _run_example():
             position_changed = last_state.current_position != new_state.current_position
             sub_position_large_change = abs(last_state.sub_position_unit * last_state.config.position_width_radians - new_state.sub_position_unit * new_state.config.position_width_radians) > math.radians(5)
             press_nonce_changed = last_state.press_nonce != new_state.press_nonce
-            if config_changed or position_changed or sub_position_large_change or press_nonce_changed:
-                logging.info('State: ' + str(new_state))
+            # Exact steps turned since the last logged state, including positions skipped between states
+            steps = (new_state.position_steps - last_state.position_steps + 2**31) % 2**32 - 2**31
+            if config_changed or position_changed or sub_position_large_change or press_nonce_changed or steps != 0:
+                logging.info(f'State ({steps:+d} steps): ' + str(new_state))
                 last_state = new_state
 
         # Register our state handler function
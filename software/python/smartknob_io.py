@@ -173,6 +173,62 @@ class Smartknob(object):
         message.smartknob_config.CopyFrom(config)
         self._enqueue_message(message)
 
+    def play_haptic_effect(self, effect, strength=0):
+        message = smartknob_pb2.ToSmartknob()
+        message.play_haptic_effect.effect = effect
+        message.play_haptic_effect.strength = strength
+        self._enqueue_message(message)
+
+    def start_motor_calibration(self):
+        """Progress is reported as 'motor_calibration_status' messages (see add_handler)."""
+        message = smartknob_pb2.ToSmartknob()
+        message.motor_calibration.SetInParent()
+        self._enqueue_message(message)
+
+    def start_cogging_calibration(self):
+        """Requires a motor calibration. Progress is reported as 'motor_calibration_status' messages, with phase 5."""
+        message = smartknob_pb2.ToSmartknob()
+        message.motor_calibration.cogging = True
+        self._enqueue_message(message)
+
+    def cancel_motor_calibration(self):
+        message = smartknob_pb2.ToSmartknob()
+        message.motor_calibration.cancel = True
+        self._enqueue_message(message)
+
+    def request_telemetry(self, frames, trigger=0, pre_trigger=0, decimation=1, velocity_threshold=0):
+        """
+        Record the motor loop, starting on a trigger (0: immediately, 1: next config change, 2: speed
+        reaching velocity_threshold). Frames are streamed back as 'telemetry_chunk' messages (see
+        add_handler, and telemetry_capture.py). frames=0 cancels the capture in progress.
+        """
+        message = smartknob_pb2.ToSmartknob()
+        message.telemetry.trigger = trigger
+        message.telemetry.frames = frames
+        message.telemetry.pre_trigger = pre_trigger
+        message.telemetry.decimation = decimation
+        message.telemetry.velocity_threshold = velocity_threshold
+        self._enqueue_message(message)
+
+    def request_sensor_capture(self, frames):
+        """
+        Record the angle sensor's raw readings. Frames are streamed back as 'sensor_capture_chunk'
+        messages (see add_handler, and sensor_capture.py). frames=0 stops the capture in progress.
+        """
+        message = smartknob_pb2.ToSmartknob()
+        message.sensor_capture.frames = frames
+        self._enqueue_message(message)
+
+    def request_sensor_health(self):
+        """
+        Ask for the angle sensor's health counts (CRC errors, field strength and loss of track flags,
+        age of the readings), over the last window and since boot. The reply is a 'sensor_health'
+        message (see add_handler); only the age counts are meaningful unless its readings_reported is set.
+        """
+        message = smartknob_pb2.ToSmartknob()
+        message.request_sensor_health.SetInParent()
+        self._enqueue_message(message)
+
     def start(self):
         self.read_thread = Thread(target=self._read_loop)
         self.write_thread = Thread(target=self._write_loop)
@@ -241,6 +297,43 @@ def smartknob_context(serial_port, default_logging=True, wait_for_comms=True):
             s.shutdown()
 
 
+def encode_detent_runs(positions):
+    """
+    Encode magnetic detent positions for SmartKnobConfig.detent_runs (see smartknob.proto).
+    Needs at most 256 bytes to fit; the firmware's encoder is DetentIndex::encodeRuns.
+    """
+    def varint(value):
+        out = bytearray()
+        while True:
+            b = value & 0x7f
+            value >>= 7
+            if value:
+                out.append(b | 0x80)
+            else:
+                out.append(b)
+                return out
+
+    out = bytearray()
+    previous_end = None
+    positions = sorted(set(positions))
+    i = 0
+    while i < len(positions):
+        start = end = positions[i]
+        i += 1
+        while i < len(positions) and positions[i] == end + 1:
+            end = positions[i]
+            i += 1
+        if previous_end is None:
+            delta = ((start << 1) ^ (start >> 31)) & 0xffffffff
+        else:
+            delta = start - previous_end - 2
+        out += varint((delta << 1) | (end != start))
+        if end != start:
+            out += varint(end - start - 1)
+        previous_end = end
+    return bytes(out)
+
+
 def ask_for_serial_port():
     """
     Helper function to ask which port to use via stdin
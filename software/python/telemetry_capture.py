@@ -0,0 +1,64 @@
+import os
+import sys
+if __name__ == '__main__':
+    if 'PIPENV_ACTIVE' not in os.environ:
+        sys.exit(f'This script should be run in a Pipenv.\n\nRun it as:\npipenv run python {os.path.basename(__file__)}')
+
+# Place imports below this line
+import argparse
+import logging
+from queue import Queue
+
+from smartknob_io import (
+    ask_for_serial_port,
+    smartknob_context
+)
+
+TRIGGERS = {
+    'now': 0,
+    'config': 1,
+    'velocity': 2,
+}
+
+def _run_capture():
+    parser = argparse.ArgumentParser(description='Record motor loop telemetry to a raw capture file. Decode it with software/tools/telemetry_decode.cpp.')
+    parser.add_argument('output', help='Capture file to write')
+    parser.add_argument('--frames', type=int, default=512, help='Loop iterations to record from the trigger on')
+    parser.add_argument('--trigger', choices=TRIGGERS.keys(), default='now')
+    parser.add_argument('--pre-trigger', type=int, default=0, help='Loop iterations from before the trigger to include')
+    parser.add_argument('--decimation', type=int, default=1, help='Record every Nth loop iteration')
+    parser.add_argument('--velocity-threshold', type=float, default=10, help='Speed (rad/s) for --trigger velocity')
+    parser.add_argument('--port', help='Serial port (asks if omitted)')
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+
+    p = args.port or ask_for_serial_port()
+    with smartknob_context(p) as s, open(args.output, 'wb') as f:
+        done = Queue(1)
+        next_frame = 0
+
+        def handle_chunk(chunk):
+            nonlocal next_frame
+            if chunk.first_frame != next_frame and len(chunk.frames) > 0:
+                logging.warning(f'Missing frames {next_frame}..{chunk.first_frame - 1} (lost packets)')
+            f.write(chunk.frames)
+            if chunk.frame_size > 0:
+                next_frame = chunk.first_frame + len(chunk.frames) // chunk.frame_size
+            if chunk.end:
+                done.put(chunk)
+
+        s.add_handler('telemetry_chunk', handle_chunk)
+        s.request_telemetry(
+            args.frames,
+            trigger=TRIGGERS[args.trigger],
+            pre_trigger=args.pre_trigger,
+            decimation=args.decimation,
+            velocity_threshold=args.velocity_threshold,
+        )
+        logging.info('Waiting for trigger...')
+        last = done.get()
+        logging.info(f'Wrote {next_frame} frames to {args.output} ({last.dropped} dropped by the knob)')
+
+if __name__ == '__main__':
+    _run_capture()
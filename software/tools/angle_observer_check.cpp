@@ -0,0 +1,245 @@
+/**
+ * Checks the motor task's angle/velocity observer (firmware/src/haptics/angle_observer.h) against a
+ * simulated MT6701 on a jittery loop clock.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/angle_observer_check.cpp -o angle_observer_check
+ *
+ * Usage:
+ *   angle_observer_check
+ *
+ * The sensor reads the shaft once per loop iteration, some microseconds off the nominal time, with noise and
+ * 14-bit quantization, and filters sin/cos with the driver's EWMA, which delays the reading. As in the motor
+ * task, the observer is updated with the sample time minus SK_SENSOR_LATENCY_MICROS, and the haptic controller
+ * gets the angle predicted for the next iteration, when its torque is applied. Checks that:
+ *  - at rest, the estimate is quieter than the readings, and the velocity stays near 0
+ *  - after a step, the angle settles within a few times 1/bandwidth, overshooting by less than the
+ *    critically damped loop's 14% plus what the sensor's delay adds
+ *  - on a ramp, the velocity converges on the true one, and with latency compensation the applied angle
+ *    has no lag left, where it lags by the sensor delay plus a period without
+ *  - after a thousand turns, the estimate is as precise as after the first
+ *  - after a gap in the samples, the observer restarts from the reading
+ * Exits with 1 if any of these fails.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+#include "haptics/angle_observer.h"
+
+#include "tool_check.h"
+
+// As the motor task's defaults with the MT6701 read in the loop
+static const uint32_t LOOP_HZ = 2000;
+static const float BANDWIDTH = 300;
+static const float SENSOR_ALPHA = 0.4;
+static const uint32_t LATENCY_MICROS = 1500000 / LOOP_HZ;
+static const uint32_t PERIOD_MICROS = 1000000 / LOOP_HZ;
+static const double NOISE_RAD = 0.0005;
+static const double JITTER_MICROS = 20;
+static const double COUNT_RAD = 2 * M_PI / 16384;
+// Near the wrap of micros()
+static const uint32_t START_MICROS = 0xFFFFFFFFu - 1000000;
+
+/**
+ * The MT6701 and its driver: a quantized, noisy reading, filtered on sin/cos, unwrapped into turns.
+ */
+class Sensor {
+    public:
+        explicit Sensor(double angle) : rng_(1), noise_(0, NOISE_RAD), x_(cos(angle)), y_(sin(angle)) {
+            previous_ = wrap(angle);
+            turns_ = (int32_t)floor(angle / (2 * M_PI));
+        }
+
+        TurnAngle read(double angle) {
+            double counts = floor(wrap(angle + noise_(rng_)) / COUNT_RAD);
+            double reading = counts * COUNT_RAD;
+            x_ = SENSOR_ALPHA * cos(reading) + (1 - SENSOR_ALPHA) * x_;
+            y_ = SENSOR_ALPHA * sin(reading) + (1 - SENSOR_ALPHA) * y_;
+            double filtered = wrap(atan2(y_, x_));
+            if (filtered - previous_ < -M_PI) {
+                turns_++;
+            } else if (filtered - previous_ > M_PI) {
+                turns_--;
+            }
+            previous_ = filtered;
+            return {turns_, (float)filtered};
+        }
+
+    private:
+        static double wrap(double angle) {
+            double wrapped = fmod(angle, 2 * M_PI);
+            return wrapped < 0 ? wrapped + 2 * M_PI : wrapped;
+        }
+
+        std::mt19937 rng_;
+        std::normal_distribution<double> noise_;
+        double x_;
+        double y_;
+        double previous_;
+        int32_t turns_;
+};
+
+// Angle of the shaft at a time, in seconds since the start
+using Trajectory = std::function<double(double)>;
+
+struct Sample {
+    double t;
+    double angle;
+    double velocity;
+    // Estimate for the time the torque is applied, and the true angle then
+    double estimate;
+    double applied_angle;
+    double velocity_estimate;
+};
+
+/**
+ * @brief Run the sensor and observer along a trajectory, as the motor loop does.
+ *
+ * @param compensate Whether to compensate the latency, as the motor task; otherwise the observer is
+ *                   updated with the sample time and its current angle is used
+ */
+static void run(const Trajectory& trajectory, double seconds, bool compensate, const std::function<void(const Sample&)>& sample) {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> jitter(-JITTER_MICROS, JITTER_MICROS);
+    Sensor sensor(trajectory(0));
+    AngleObserver observer;
+    observer.setBandwidth(BANDWIDTH);
+    const double period = 1.0 / LOOP_HZ;
+    for (uint32_t k = 0; k < seconds * LOOP_HZ; k++) {
+        double t = k * period + jitter(rng) * 1e-6;
+        uint32_t sample_micros = START_MICROS + (uint32_t)llround(t * 1e6);
+        TurnAngle measured = sensor.read(trajectory(t));
+        double applied;
+        TurnAngle estimate;
+        if (compensate) {
+            observer.update(measured, sample_micros - LATENCY_MICROS);
+            applied = t + PERIOD_MICROS * 1e-6;
+            estimate = observer.predictAngle(sample_micros + PERIOD_MICROS);
+        } else {
+            observer.update(measured, sample_micros);
+            applied = t;
+            estimate = observer.angle();
+        }
+        const double h = 1e-6;
+        sample({
+            .t = t,
+            .angle = trajectory(t),
+            .velocity = (trajectory(applied + h) - trajectory(applied - h)) / (2 * h),
+            .estimate = estimate.turns * 2 * M_PI + estimate.radians,
+            .applied_angle = trajectory(applied),
+            .velocity_estimate = observer.velocity(),
+        });
+    }
+}
+
+struct Stats {
+    double sum = 0;
+    double squares = 0;
+    uint32_t n = 0;
+
+    void add(double value) {
+        sum += value;
+        squares += value * value;
+        n++;
+    }
+    double mean() const { return n == 0 ? 0 : sum / n; }
+    double rms() const { return n == 0 ? 0 : sqrt(squares / n); }
+};
+
+int main() {
+    char what[128];
+    bool ok = true;
+
+    // At rest: compare with the readings' own error
+    Stats rest_angle, rest_velocity, reading_error;
+    {
+        Sensor sensor(0.3);
+        for (int i = 0; i < 10000; i++) {
+            TurnAngle reading = sensor.read(0.3);
+            reading_error.add(reading.radians - 0.3);
+        }
+    }
+    run([](double) { return 0.3; }, 2, true, [&](const Sample& s) {
+        if (s.t > 0.1) {
+            rest_angle.add(s.estimate - s.applied_angle);
+            rest_velocity.add(s.velocity_estimate);
+        }
+    });
+    snprintf(what, sizeof(what), "rest: angle %.2g rad rms (readings %.2g), velocity %.3f rad/s rms",
+        rest_angle.rms(), reading_error.rms(), rest_velocity.rms());
+    ok &= check(rest_angle.rms() < reading_error.rms() && rest_velocity.rms() < 0.5, what);
+
+    // A step of the reading, 0.5 rad at 0.5 s; relative to the step, after the sensor's own delay
+    const double step_at = 0.5, step = 0.5;
+    double overshoot = 0, settled_at = 0;
+    run([&](double t) { return t < step_at ? 0.3 : 0.3 + step; }, 1, true, [&](const Sample& s) {
+        if (s.t < step_at) {
+            return;
+        }
+        double error = (s.estimate - (0.3 + step)) / step;
+        overshoot = fmax(overshoot, error);
+        if (fabs(error) > 0.01) {
+            settled_at = s.t - step_at;
+        }
+    });
+    snprintf(what, sizeof(what), "step %.1f rad: settled within 1%% after %.1f ms (%.1f/bandwidth), overshoot %.1f%%",
+        step, settled_at * 1e3, settled_at * BANDWIDTH, overshoot * 100);
+    ok &= check(settled_at < 8 / BANDWIDTH && overshoot < 0.3, what);
+
+    // A ramp at 10 rad/s from 0.2 s, once the loop has settled on it
+    const double speed = 10;
+    const Trajectory ramp = [&](double t) { return t < 0.2 ? 0.3 : 0.3 + speed * (t - 0.2); };
+    Stats compensated, uncompensated, ramp_velocity;
+    run(ramp, 1, true, [&](const Sample& s) {
+        if (s.t > 0.2 + 10 / BANDWIDTH) {
+            compensated.add(s.estimate - s.applied_angle);
+            ramp_velocity.add(s.velocity_estimate - s.velocity);
+        }
+    });
+    run(ramp, 1, false, [&](const Sample& s) {
+        if (s.t > 0.2 + 10 / BANDWIDTH) {
+            // Against the angle when the torque is applied, a period after the sample
+            uncompensated.add(s.estimate - ramp(s.t + PERIOD_MICROS * 1e-6));
+        }
+    });
+    const double lag = speed * (LATENCY_MICROS + PERIOD_MICROS) * 1e-6;
+    snprintf(what, sizeof(what), "ramp %.0f rad/s: velocity error %.3f rad/s mean, %.3f rms", speed, ramp_velocity.mean(), ramp_velocity.rms());
+    ok &= check(fabs(ramp_velocity.mean()) < 0.01 * speed && ramp_velocity.rms() < 0.1 * speed, what);
+    snprintf(what, sizeof(what), "ramp %.0f rad/s: applied angle lags %.5f rad compensated, %.5f without (delay %.5f)",
+        speed, -compensated.mean(), -uncompensated.mean(), lag);
+    ok &= check(fabs(compensated.mean()) < 0.05 * lag && fabs(uncompensated.mean() + lag) < 0.1 * lag, what);
+
+    // A thousand turns at 100 rad/s: the last second is as precise as the first after settling
+    const double fast = 100;
+    Stats first_second, last_second;
+    const double turns_seconds = 1000 * 2 * M_PI / fast;
+    run([&](double t) { return fast * t; }, turns_seconds, true, [&](const Sample& s) {
+        if (s.t > 0.1 && s.t < 1.1) {
+            first_second.add(s.estimate - s.applied_angle);
+        } else if (s.t > turns_seconds - 1) {
+            last_second.add(s.estimate - s.applied_angle);
+        }
+    });
+    snprintf(what, sizeof(what), "%.0f turns at %.0f rad/s: angle error %.2g rad rms in the first second, %.2g in the last",
+        turns_seconds * fast / (2 * M_PI), fast, first_second.rms(), last_second.rms());
+    ok &= check(last_second.rms() < 1.5 * first_second.rms() && last_second.rms() < 10 * COUNT_RAD, what);
+
+    // A gap longer than MAX_SAMPLE_GAP_SECONDS while moving: the observer restarts at the new reading
+    AngleObserver observer;
+    observer.setBandwidth(BANDWIDTH);
+    for (uint32_t i = 0; i < 1000; i++) {
+        observer.update(TurnAngle{0, 0.001f * i}, START_MICROS + i * PERIOD_MICROS);
+    }
+    const uint32_t after_gap = START_MICROS + 1000 * PERIOD_MICROS + (uint32_t)(AngleObserver::MAX_SAMPLE_GAP_SECONDS * 2e6);
+    observer.update(TurnAngle{3, 1}, after_gap);
+    snprintf(what, sizeof(what), "gap: restarted at %d turns + %.3f rad, velocity %.3f rad/s",
+        observer.angle().turns, observer.angle().radians, observer.velocity());
+    ok &= check(observer.angle().turns == 3 && observer.angle().radians == 1 && observer.velocity() == 0
+        && observer.sampleMicros() == after_gap, what);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+/**
+ * Simulates the cogging calibration (firmware/src/motors/cogging_calibration.h) on a motor with cogging, and
+ * the torque ripple felt through the knob with and without the measured map as feedforward.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/cogging_ripple_sim.cpp \
+ *     firmware/src/motors/cogging_calibration.cpp firmware/src/motors/motor_calibration.cpp \
+ *     firmware/src/sensor_correction.cpp -o cogging_ripple_sim
+ *
+ * Usage:
+ *   cogging_ripple_sim
+ *
+ * The motor has cogging at the slot count per revolution and some lower harmonics (from magnet and stator
+ * tolerances), Coulomb and viscous friction; the sensor reads its angle from an arbitrary zero with noise
+ * and 14-bit quantization. The calibration runs in the motor loop as in MotorTask::run(), on the observer's
+ * angle. The map it measures is then stored as int8 samples and restored, as it is in the config. Ripple
+ * is measured, in volts of motor torque:
+ *  - static: the cogging torque left over a revolution, with the restored map added
+ *  - felt: the torque a hand turning the knob slowly through a compliant grip has to apply, without
+ *    detents and with fine 2.4 degree detents, against the same motor without cogging
+ * Checks that the calibration succeeds, that the map cancels most of the static and felt ripple (next to
+ * the floor of a map of the true cogging at the same resolution), that fine detents feel as they do
+ * without cogging, and that a knob grabbed during the sweep ends the calibration in SLIPPED. Exits with 1
+ * if any of these fails.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "haptics/angle_observer.h"
+#include "motors/cogging_calibration.h"
+
+#include "tool_check.h"
+
+// As the motor task's defaults
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t PERIOD_MICROS = 1000000 / LOOP_HZ;
+static const float BANDWIDTH = 300;
+static const float MAX_TORQUE = 5;
+static const double MAX_SECONDS = 60;
+static const double COUNT_RAD = 2 * M_PI / 16384;
+// Largest static and felt ripple (rms) accepted with the map, as a fraction of the ripple without it
+static const double MAX_STATIC_RIPPLE = 0.25;
+static const double MAX_FELT_RIPPLE = 0.35;
+// Largest difference of the felt ripple with fine detents from the motor without cogging
+static const double MAX_DETENT_DIFFERENCE = 0.1;
+
+/**
+ * Rotor with cogging and friction, a hand that may hold it through a spring, and the sensor.
+ */
+struct Plant {
+    double inertia = 3e-6;
+    double viscous = 2e-5;
+    double coulomb = 0.0008;
+    double torque_per_volt = 0.01;
+    // Cogging at the slot count, and two lower harmonics
+    int cogging_periods = 84;
+    double cogging = 0.0015;
+    double cogging_14 = 0.0005;
+    double cogging_12 = 0.0003;
+    double sensor_zero = 1;
+    double noise = 0.0005;
+
+    double angle = 0.4;
+    double velocity = 0;
+    // Hand: a spring and damper pulling towards a target angle (no hand at 0 stiffness)
+    double hand_stiffness = 0;
+    double hand_damping = 0;
+    double hand_target = 0;
+    double hand_torque = 0;
+
+    double coggingTorque(double a) const {
+        return -cogging * sin(cogging_periods * a) - cogging_14 * sin(14 * a + 0.7) - cogging_12 * sin(12 * a + 2.1);
+    }
+
+    void step(double volts, double dt) {
+        const int substeps = 20;
+        const double h = dt / substeps;
+        for (int i = 0; i < substeps; i++) {
+            hand_torque = hand_stiffness * (hand_target - angle) - hand_damping * velocity;
+            double torque = torque_per_volt * volts + coggingTorque(angle) - viscous * velocity + hand_torque;
+            if (fabs(velocity) < 1e-4 && fabs(torque) < coulomb) {
+                velocity = 0;
+                continue;
+            }
+            torque -= coulomb * (velocity > 0 ? 1 : velocity < 0 ? -1 : (torque > 0 ? 1 : -1));
+            velocity += torque / inertia * h;
+            angle += velocity * h;
+        }
+    }
+
+    // Raw sensor angle, [0, 2PI)
+    float sensor(std::mt19937& rng) const {
+        std::normal_distribution<double> noise_rad(0, noise);
+        double reading = fmod(angle + sensor_zero + noise_rad(rng), 2 * M_PI);
+        reading = reading < 0 ? reading + 2 * M_PI : reading;
+        return floor(reading / COUNT_RAD) * COUNT_RAD;
+    }
+};
+
+/**
+ * The motor loop's sensing: the raw angle, unwrapped into the observer.
+ */
+class Loop {
+    public:
+        explicit Loop(Plant& plant) : plant_(plant), rng_(3) {
+            observer_.setBandwidth(BANDWIDTH);
+            mechanical_angle_ = plant.sensor(rng_);
+            unwrapped_ = mechanical_angle_;
+            observer_.reset(TurnAngle{0, 0} + mechanical_angle_, now_micros_);
+        }
+
+        void sense() {
+            float previous = mechanical_angle_;
+            mechanical_angle_ = plant_.sensor(rng_);
+            unwrapped_ += remainder(mechanical_angle_ - previous, 2 * M_PI);
+            observer_.update(TurnAngle{0, 0} + (float)unwrapped_, now_micros_);
+        }
+
+        void drive(float volts) {
+            plant_.step(volts, PERIOD_MICROS * 1e-6);
+            now_micros_ += PERIOD_MICROS;
+        }
+
+        // As the motor task: the angle predicted for when the torque is applied
+        TurnAngle predictedAngle() const { return observer_.predictAngle(now_micros_ + PERIOD_MICROS); }
+        float velocity() const { return observer_.velocity(); }
+        float mechanicalAngle() const { return mechanical_angle_; }
+        uint32_t now() const { return now_micros_; }
+
+    private:
+        Plant& plant_;
+        std::mt19937 rng_;
+        AngleObserver observer_;
+        // Near the wrap of micros()
+        uint32_t now_micros_ = 0xFFFFFFFFu - 5000000;
+        float mechanical_angle_ = 0;
+        double unwrapped_ = 0;
+};
+
+/**
+ * @brief Run a cogging calibration on the plant, as MotorTask::run() does.
+ *
+ * @param grab_at Seconds after which a hand grabs the knob for a second (negative for never)
+ */
+static CoggingCalibration::Status calibrate(Plant plant, CoggingMap& map, double& seconds, double grab_at = -1) {
+    Loop loop(plant);
+    CoggingCalibration calibration;
+    const TurnAngle origin = loop.predictedAngle();
+    calibration.start(MAX_TORQUE, 0, loop.now());
+    double t = 0;
+    while (calibration.running() && t < MAX_SECONDS) {
+        loop.sense();
+        // The hand holds the knob where it grabbed it
+        bool grabbed = grab_at >= 0 && t > grab_at && t < grab_at + 1;
+        if (grabbed && plant.hand_stiffness == 0) {
+            plant.hand_target = plant.angle;
+        }
+        plant.hand_stiffness = grabbed ? 0.5 : 0;
+        float volts = calibration.update(loop.predictedAngle().radiansSince(origin), loop.velocity(), loop.mechanicalAngle(), loop.now());
+        loop.drive(volts);
+        t += PERIOD_MICROS * 1e-6;
+    }
+    seconds = t;
+    map = calibration.map();
+    return calibration.status();
+}
+
+struct Ripple {
+    double rms;
+    double peak_to_peak;
+};
+
+static Ripple ripple(const std::vector<double>& volts) {
+    double mean = 0;
+    for (double v : volts) {
+        mean += v / volts.size();
+    }
+    double squares = 0;
+    for (double v : volts) {
+        squares += (v - mean) * (v - mean);
+    }
+    auto [min, max] = std::minmax_element(volts.begin(), volts.end());
+    return {sqrt(squares / volts.size()), *max - *min};
+}
+
+// Cogging torque left over a revolution, with the map as feedforward
+static Ripple staticRipple(const Plant& plant, const CoggingMap& map) {
+    std::vector<double> volts;
+    for (int i = 0; i < 20000; i++) {
+        double angle = 2 * M_PI * i / 20000;
+        double mechanical = fmod(angle + plant.sensor_zero, 2 * M_PI);
+        volts.push_back(plant.coggingTorque(angle) / plant.torque_per_volt + map.torque((float)mechanical));
+    }
+    return ripple(volts);
+}
+
+// Detent torque in volts at a shaft angle, as the haptic controller's output
+using Detents = std::function<float(const TurnAngle&)>;
+
+// Torque the hand applies, in volts, while turning the knob half a radian per second through a compliant grip
+static Ripple feltRipple(Plant plant, const CoggingMap& map, const Detents& detents) {
+    plant.hand_stiffness = 0.05;
+    plant.hand_damping = 2e-4;
+    plant.hand_target = plant.angle;
+    plant.velocity = 0;
+    Loop loop(plant);
+    const double start = plant.angle;
+    std::vector<double> hand;
+    for (uint32_t k = 0; k < 8 * LOOP_HZ; k++) {
+        plant.hand_target = start + 0.5 * std::max(0.0, (double)k / LOOP_HZ - 1);
+        loop.sense();
+        loop.drive(detents(loop.predictedAngle()) + map.torque(loop.mechanicalAngle()));
+        if (k > 2 * LOOP_HZ) {
+            hand.push_back(plant.hand_torque / plant.torque_per_volt);
+        }
+    }
+    return ripple(hand);
+}
+
+int main() {
+    char what[160];
+    bool ok = true;
+
+    struct Case {
+        const char* name;
+        Plant plant;
+    };
+    Case cases[3];
+    cases[0].name = "84/rev 0.15 V, 14 and 12/rev";
+    cases[1].name = "84/rev 0.15 V, stiff bearing";
+    cases[1].plant.coulomb = 0.002;
+    cases[2].name = "42/rev 0.2 V, 14 and 12/rev";
+    cases[2].plant.cogging_periods = 42;
+    cases[2].plant.cogging = 0.002;
+
+    const CoggingMap none = {};
+    const Detents no_detents = [](const TurnAngle&) { return 0.0f; };
+    // A detent every 2.4 degrees, 0.5 V at its edges
+    const float width = 2.4 * M_PI / 180;
+    const Detents fine_detents = [width](const TurnAngle& angle) {
+        float x = remainderf(angle.radians, width);
+        return -x / width * 2;
+    };
+
+    for (const Case& c : cases) {
+        CoggingMap measured;
+        double seconds;
+        CoggingCalibration::Status status = calibrate(c.plant, measured, seconds);
+        snprintf(what, sizeof(what), "%s: calibration status %u after %.1f s", c.name, (uint8_t)status, seconds);
+        ok &= check(status == CoggingCalibration::Status::SUCCEEDED, what);
+        if (status != CoggingCalibration::Status::SUCCEEDED) {
+            continue;
+        }
+
+        // Stored as in the config, and restored
+        int8_t samples[CoggingMap::SIZE];
+        float scale = measured.quantize(samples);
+        CoggingMap map;
+        map.set(samples, CoggingMap::SIZE, scale);
+
+        // The floor: a map of the true cogging at the same resolution
+        float truth[CoggingMap::SIZE];
+        for (uint16_t i = 0; i < CoggingMap::SIZE; i++) {
+            double mechanical = 2 * M_PI * i / CoggingMap::SIZE;
+            truth[i] = -c.plant.coggingTorque(mechanical - c.plant.sensor_zero) / c.plant.torque_per_volt;
+        }
+        CoggingMap ideal;
+        ideal.set(truth);
+
+        Ripple off = staticRipple(c.plant, none);
+        Ripple on = staticRipple(c.plant, map);
+        Ripple floor = staticRipple(c.plant, ideal);
+        snprintf(what, sizeof(what), "%s: static ripple %.4f V rms, %.4f with the map (floor %.4f), %.3f/%.3f/%.3f V p-p",
+            c.name, off.rms, on.rms, floor.rms, off.peak_to_peak, on.peak_to_peak, floor.peak_to_peak);
+        ok &= check(on.rms < MAX_STATIC_RIPPLE * off.rms, what);
+
+        off = feltRipple(c.plant, none, no_detents);
+        on = feltRipple(c.plant, map, no_detents);
+        snprintf(what, sizeof(what), "%s: felt ripple without detents %.4f V rms, %.4f with the map",
+            c.name, off.rms, on.rms);
+        ok &= check(on.rms < MAX_FELT_RIPPLE * off.rms, what);
+
+        Plant clean = c.plant;
+        clean.cogging = clean.cogging_14 = clean.cogging_12 = 0;
+        Ripple reference = feltRipple(clean, none, fine_detents);
+        off = feltRipple(c.plant, none, fine_detents);
+        on = feltRipple(c.plant, map, fine_detents);
+        snprintf(what, sizeof(what), "%s: 2.4 deg detents %.4f V rms, %.4f with the map, %.4f without cogging",
+            c.name, off.rms, on.rms, reference.rms);
+        ok &= check(fabs(on.rms - reference.rms) < MAX_DETENT_DIFFERENCE * reference.rms, what);
+    }
+
+    CoggingMap unused;
+    double seconds;
+    CoggingCalibration::Status status = calibrate(cases[0].plant, unused, seconds, 1.5);
+    snprintf(what, sizeof(what), "grabbed during the sweep: status %u after %.1f s", (uint8_t)status, seconds);
+    ok &= check(status == CoggingCalibration::Status::SLIPPED, what);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/**
+ * Soak test of the motor task's command lanes (firmware/src/command_channel.h) on the host: a
+ * producer thread publishes bursts of configs and haptic effects while a consumer thread drains the
+ * lanes at a fixed tick, as the interface and motor tasks do.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -pthread -Ifirmware/src software/tools/command_channel_soak.cpp -o command_channel_soak
+ *
+ * Usage:
+ *   command_channel_soak [seconds]
+ *
+ * Checks that:
+ *  - configs are never torn, are taken in publishing order, and the last one published is taken
+ *  - a take never waits for the producer: one caught by it gives up and is retried on the next tick
+ *  - every config is either taken or counted as coalesced
+ *  - effects arrive in order, and every effect is either received or counted as dropped
+ * Exits with 1 if any of these fails.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "command_channel.h"
+
+// Consumer tick, as the motor loop at 2 kHz
+static const auto TICK = std::chrono::microseconds(500);
+static const uint16_t HAPTIC_LANE_SIZE = 8;
+
+// Stand-in for the config, large enough that a torn copy is likely to show
+struct Config {
+    uint32_t sequence;
+    uint32_t words[256];
+};
+
+static Config makeConfig(uint32_t sequence) {
+    Config config;
+    config.sequence = sequence;
+    for (uint32_t i = 0; i < 256; i++) {
+        config.words[i] = sequence * 2654435761u + i;
+    }
+    return config;
+}
+
+static bool intact(const Config& config) {
+    for (uint32_t i = 0; i < 256; i++) {
+        if (config.words[i] != config.sequence * 2654435761u + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5;
+
+    static LatestValueLane<Config> configs;
+    static FifoLane<uint32_t, HAPTIC_LANE_SIZE> effects;
+    std::atomic<bool> producing = true;
+    uint32_t configs_published = 0;
+    uint32_t effects_published = 0;
+
+    std::thread producer([&] {
+        std::mt19937 rng(1);
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            // A burst, as when scrolling quickly through pages: a config and a click each, back to back
+            uint32_t burst = 1 + rng() % 24;
+            for (uint32_t i = 0; i < burst; i++) {
+                configs.publish(makeConfig(++configs_published));
+                effects.publish(++effects_published);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(rng() % 5000));
+        }
+        producing = false;
+    });
+
+    bool ok = true;
+    uint32_t last_config = 0;
+    uint32_t last_effect = 0;
+    uint64_t effect_gaps = 0;
+    uint32_t max_drained = 0;
+    static Config config;
+    auto drain = [&] {
+        if (configs.take(config)) {
+            if (!intact(config)) {
+                fprintf(stderr, "Torn config %u\n", config.sequence);
+                ok = false;
+            }
+            if (config.sequence <= last_config) {
+                fprintf(stderr, "Config %u taken after %u\n", config.sequence, last_config);
+                ok = false;
+            }
+            last_config = config.sequence;
+        }
+        uint16_t drained = effects.drain([&](uint32_t effect) {
+            if (effect <= last_effect) {
+                fprintf(stderr, "Effect %u received after %u\n", effect, last_effect);
+                ok = false;
+            }
+            effect_gaps += effect - last_effect - 1;
+            last_effect = effect;
+        });
+        max_drained = drained > max_drained ? drained : max_drained;
+    };
+
+    auto next_tick = std::chrono::steady_clock::now();
+    while (producing) {
+        drain();
+        next_tick += TICK;
+        std::this_thread::sleep_until(next_tick);
+    }
+    producer.join();
+    drain();
+
+    // Effects dropped at the end of the run don't leave a gap before a received one
+    effect_gaps += effects_published - last_effect;
+    ok &= last_config == configs_published;
+    ok &= configs.taken() + configs.coalesced() == configs_published;
+    ok &= effects.received() + effects.dropped() == effects_published;
+    ok &= effect_gaps == effects.dropped();
+
+    printf("configs: %u published, %u taken, %u coalesced, %u takes retried, last %u\n",
+        configs_published, configs.taken(), configs.coalesced(), configs.missed(), last_config);
+    printf("effects: %u published, %u received, %u dropped, up to %u per tick\n",
+        effects_published, effects.received(), effects.dropped(), max_drained);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/**
+ * Checks the cycle probes of the motor loop (firmware/src/cycle_probe.h) on the host: the percentiles
+ * of CycleStats against exact ones over a few duration distributions, and the cost of a probe.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src -DSK_CYCLE_PROBES=1 software/tools/cycle_probe_bench.cpp -o cycle_probe_bench
+ *
+ * Usage:
+ *   cycle_probe_bench
+ *
+ * On the host the probes count nanoseconds of the steady clock instead of CPU cycles, so the probe
+ * cost printed here is only indicative of the ESP32, where reading CCOUNT is a single instruction.
+ * Exits with 1 if a percentile is further from the exact one than the histogram's resolution.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "cycle_probe.h"
+
+static const size_t SAMPLES = 1000000;
+static const size_t PROBES = 10000000;
+static const float PERCENTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+struct Distribution {
+    const char* name;
+    // Returns a duration in ticks
+    uint32_t (*sample)(std::mt19937& rng);
+};
+
+static const Distribution DISTRIBUTIONS[] = {
+    // A loop stage: steady, with occasional long stalls (interrupts, cache misses)
+    {"stage with stalls", [](std::mt19937& rng) {
+        std::normal_distribution<float> steady(2400, 60);
+        std::uniform_int_distribution<uint32_t> stall(20000, 200000);
+        return rng() % 1000 == 0 ? stall(rng) : (uint32_t)std::max(steady(rng), 0.0f);
+    }},
+    {"uniform 0-16", [](std::mt19937& rng) {
+        return (uint32_t)(rng() % 17);
+    }},
+    {"log-uniform 1-2^24", [](std::mt19937& rng) {
+        std::uniform_real_distribution<float> exponent(0, 24);
+        return (uint32_t)exp2f(exponent(rng));
+    }},
+    {"beyond the histogram", [](std::mt19937& rng) {
+        return (uint32_t)((1u << CycleStats::MAX_BITS) + rng() % 1000000);
+    }},
+};
+
+static bool check(const Distribution& distribution, std::mt19937& rng) {
+    CycleStats stats;
+    std::vector<uint32_t> samples(SAMPLES);
+    for (uint32_t& ticks : samples) {
+        ticks = distribution.sample(rng);
+        stats.record(ticks);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    bool ok = stats.count() == SAMPLES && stats.minTicks() == samples.front() && stats.maxTicks() == samples.back();
+    double mean = 0;
+    for (uint32_t ticks : samples) {
+        mean += ticks;
+    }
+    mean /= SAMPLES;
+    ok &= fabs(stats.meanTicks() - mean) <= mean * 1e-6;
+
+    printf("%-22s %8u %10.1f %8u", distribution.name, stats.minTicks(), stats.meanTicks(), stats.maxTicks());
+    for (float p : PERCENTILES) {
+        uint32_t exact = samples[std::min<size_t>(SAMPLES - 1, (size_t)(p * SAMPLES + 0.5f) - 1)];
+        uint32_t estimate = stats.percentileTicks(p);
+        // Half a bucket either way, which is 1/16 of the duration (or exact below 2^SUB_BITS), plus a
+        // tick of rounding. The last bucket is only bounded by the maximum seen.
+        double tolerance = exact >= (1u << CycleStats::MAX_BITS) ? samples.back() - exact : exact / 16.0 + 1;
+        bool pass = fabs((double)estimate - exact) <= tolerance;
+        printf(" %9u/%-9u", estimate, exact);
+        ok &= pass;
+    }
+    printf("  %s\n", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    printf("%-22s %8s %10s %8s", "distribution", "min", "mean", "max");
+    for (float p : PERCENTILES) {
+        printf("  p%-6g est/exact", p * 100);
+    }
+    printf("\n");
+
+    bool ok = true;
+    for (const Distribution& distribution : DISTRIBUTIONS) {
+        ok &= check(distribution, rng);
+    }
+
+    // Cost of a probe around nothing, which is what it adds to every stage it times
+    CycleStats empty;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < PROBES; i++) {
+        CYCLE_PROBE(empty);
+    }
+    double probe_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / PROBES;
+    printf("\nprobe: %.1f ns each, empty scope measured as p50 %.1f ns, p99 %.1f ns\n",
+        probe_ns, empty.percentileTicks(0.5) / CycleClock::ticksPerMicro() * 1000,
+        empty.percentileTicks(0.99) / CycleClock::ticksPerMicro() * 1000);
+    ok &= empty.count() == PROBES;
+
+    return ok ? 0 : 1;
+}
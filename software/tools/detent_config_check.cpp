@@ -0,0 +1,294 @@
+/**
+ * Checks the haptic controller's precompiled detent config (firmware/src/haptics/detent_config.h) against
+ * the detent math it replaced, as it was inline in MotorTask::run(), on all of DemoPage's configs, and
+ * compares the cost per iteration of both.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/detent_config_check.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o detent_config_check
+ *
+ * Usage:
+ *   detent_config_check
+ *
+ * For each config, the knob sweeps back and forth across all positions and past both ends, with sensor
+ * noise and now and then a velocity above the torque cutoff. Before every iteration, the reference takes
+ * over the controller's detent center and position, so both start from the same state; the torque,
+ * position, position steps and sub-position must then be bit for bit the same. The sweep moves less than
+ * a position per iteration (the reference snaps at most once per iteration) and fast enough that the
+ * idle correction, which doesn't depend on the config, never engages.
+ *
+ * Timings are of the host, not the ESP32, so only compare them with each other. Exits with 1 if any
+ * iteration differs.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "haptics/haptic_controller.h"
+
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t SWEEPS = 4;
+static const uint32_t BENCH_ITERATIONS = 1 << 21;
+
+// As the former MotorTask::run()
+static const float DEAD_ZONE_DETENT_PERCENT = 0.2;
+static const float DEAD_ZONE_RAD = 1 * M_PI / 180;
+static const float MAX_TORQUE_VELOCITY_RAD_PER_SEC = 60;
+
+/**
+ * The configs of DemoPage (firmware/src/pages/demo_page.h, which needs Arduino), field for field.
+ */
+struct DemoConfig {
+    const char* name;
+    int32_t initial_position;
+    int32_t position_nonce;
+    int32_t min_position;
+    int32_t max_position;
+    double position_width_degrees;
+    float detent_strength_unit;
+    float endstop_strength_unit;
+    float snap_point;
+    pb_size_t detent_positions_count;
+    int32_t detent_positions[5];
+    float snap_point_bias;
+};
+
+static const DemoConfig DEMO_CONFIGS[] = {
+    {"Unbounded", 0, 0, 0, -1, 10, 0, 1, 1.1, 0, {}, 0},
+    {"Bounded 0-10", 0, 1, 0, 10, 10, 0, 1, 1.1, 0, {}, 0},
+    {"Multi-rev, no detents", 0, 2, 0, 72, 10, 0, 1, 1.1, 0, {}, 0},
+    {"On/off, strong detent", 0, 3, 0, 1, 60, 1, 1, 0.55, 0, {}, 0},
+    {"Return-to-center", 0, 4, 0, 0, 60, 0.01, 0.6, 1.1, 0, {}, 0},
+    {"Fine values, no detents", 127, 5, 0, 255, 1, 0, 1, 1.1, 0, {}, 0},
+    {"Fine values, with detents", 127, 5, 0, 255, 1, 1, 1, 1.1, 0, {}, 0},
+    {"Coarse values, strong detents", 0, 6, 0, 31, 8.225806452, 2, 1, 1.1, 0, {}, 0},
+    {"Coarse values, weak detents", 0, 6, 0, 31, 8.225806452, 0.2, 1, 1.1, 0, {}, 0},
+    {"Magnetic detents", 0, 7, 0, 31, 7, 2.5, 1, 0.7, 4, {2, 10, 21, 22}, 0},
+    {"Return-to-center with detents", 0, 8, -6, 6, 60, 1, 1, 0.55, 0, {}, 0.4},
+};
+
+static PB_SmartKnobConfig toConfig(const DemoConfig& demo) {
+    PB_SmartKnobConfig config = {};
+    config.initial_position = demo.initial_position;
+    config.position_nonce = demo.position_nonce;
+    config.min_position = demo.min_position;
+    config.max_position = demo.max_position;
+    config.position_width_radians = demo.position_width_degrees * M_PI / 180;
+    config.detent_strength_unit = demo.detent_strength_unit;
+    config.endstop_strength_unit = demo.endstop_strength_unit;
+    config.snap_point = demo.snap_point;
+    config.detent_positions_count = demo.detent_positions_count;
+    memcpy(config.detent_positions, demo.detent_positions, sizeof(demo.detent_positions));
+    config.snap_point_bias = demo.snap_point_bias;
+    return config;
+}
+
+/**
+ * The detent math of the former MotorTask::run(), recomputing everything from the config on every
+ * iteration; the idle correction is left out.
+ */
+class InlineDetents {
+    public:
+        void setConfig(const PB_SmartKnobConfig& config, float shaft_angle) {
+            config_ = config;
+            current_position_ = config.initial_position;
+            current_detent_center_ = shaft_angle;
+
+            const float derivative_lower_strength = config_.detent_strength_unit * 0.08;
+            const float derivative_upper_strength = config_.detent_strength_unit * 0.02;
+            const float derivative_position_width_lower = 3 * M_PI / 180;
+            const float derivative_position_width_upper = 8 * M_PI / 180;
+            const float raw = derivative_lower_strength + (derivative_upper_strength - derivative_lower_strength)/(derivative_position_width_upper - derivative_position_width_lower)*(config_.position_width_radians - derivative_position_width_lower);
+            pid_.D = config_.detent_positions_count > 0 ? 0 : std::clamp(
+                raw,
+                std::min(derivative_lower_strength, derivative_upper_strength),
+                std::max(derivative_lower_strength, derivative_upper_strength)
+            );
+            pid_.output_ramp = 10000;
+        }
+
+        // Take over the detent center and position that the controller tracked
+        void sync(float detent_center, int32_t position) {
+            current_detent_center_ = detent_center;
+            current_position_ = position;
+        }
+
+        HapticOutput update(float shaft_angle, float shaft_velocity, uint32_t now_micros) {
+            float angle_to_detent_center = shaft_angle - current_detent_center_;
+
+            float snap_point_radians = config_.position_width_radians * config_.snap_point;
+            float bias_radians = config_.position_width_radians * config_.snap_point_bias;
+            float snap_point_radians_decrease = -snap_point_radians + (current_position_ <= 0 ? -bias_radians : bias_radians);
+            float snap_point_radians_increase = snap_point_radians + (current_position_ >= 0 ? bias_radians : -bias_radians);
+
+            int32_t steps = 0;
+            int32_t num_positions = config_.max_position - config_.min_position + 1;
+            if (angle_to_detent_center > snap_point_radians_increase && (num_positions <= 0 || current_position_ < config_.max_position || config_.infinite_scroll)) {
+                current_detent_center_ += config_.position_width_radians;
+                angle_to_detent_center -= config_.position_width_radians;
+                current_position_++;
+                steps = 1;
+            } else if (angle_to_detent_center < snap_point_radians_decrease && (num_positions <= 0 || current_position_ > config_.min_position || config_.infinite_scroll)) {
+                current_detent_center_ -= config_.position_width_radians;
+                angle_to_detent_center += config_.position_width_radians;
+                current_position_--;
+                steps = -1;
+            }
+
+            if (config_.infinite_scroll) {
+                if (current_position_ > config_.max_position) {
+                    current_position_ = config_.min_position;
+                } else if (current_position_ < config_.min_position) {
+                    current_position_ = config_.max_position;
+                }
+            }
+
+            float sub_position_unit = angle_to_detent_center / config_.position_width_radians;
+
+            float dead_zone_adjustment = std::clamp(
+                angle_to_detent_center,
+                fmaxf(-config_.position_width_radians*DEAD_ZONE_DETENT_PERCENT, -DEAD_ZONE_RAD),
+                fminf(config_.position_width_radians*DEAD_ZONE_DETENT_PERCENT, DEAD_ZONE_RAD));
+
+            bool out_of_bounds = num_positions > 0 && !config_.infinite_scroll && ((angle_to_detent_center > 0 && current_position_ == config_.max_position) || (angle_to_detent_center < 0 && current_position_ == config_.min_position));
+            pid_.limit = 10;
+            pid_.P = out_of_bounds ? config_.endstop_strength_unit * 4 : config_.detent_strength_unit * 4;
+
+            float torque = 0;
+            if (fabsf(shaft_velocity) <= MAX_TORQUE_VELOCITY_RAD_PER_SEC) {
+                float input = -angle_to_detent_center + dead_zone_adjustment;
+                if (!out_of_bounds && config_.detent_positions_count > 0) {
+                    bool in_detent = false;
+                    for (uint8_t i = 0; i < config_.detent_positions_count; i++) {
+                        if (config_.detent_positions[i] == current_position_) {
+                            in_detent = true;
+                            break;
+                        }
+                    }
+                    if (!in_detent) {
+                        input = 0;
+                    }
+                }
+                torque = pid_(input, now_micros);
+            }
+            return {
+                .torque = torque,
+                .current_position = current_position_,
+                .position_steps = steps,
+                .sub_position_unit = sub_position_unit,
+            };
+        }
+
+    private:
+        PB_SmartKnobConfig config_ = {};
+        TorquePid pid_;
+        float current_detent_center_ = 0;
+        int32_t current_position_ = 0;
+};
+
+struct Input {
+    float angle;
+    float velocity;
+};
+
+// Sweeps from the initial position past both ends of the config's range and back, less than half a
+// position per iteration
+static std::vector<Input> sweep(const PB_SmartKnobConfig& config, std::mt19937& rng) {
+    const float width = config.position_width_radians;
+    int32_t positions = config.max_position >= config.min_position ? config.max_position - config.min_position + 1 : 100;
+    const float low = (config.min_position - config.initial_position - 3) * width;
+    const float high = (config.min_position - config.initial_position + positions + 3) * width;
+    // Slow enough that the velocity stays below the torque cutoff
+    const float step = std::min(width * 0.37f, 0.5f * MAX_TORQUE_VELOCITY_RAD_PER_SEC / LOOP_HZ);
+    std::normal_distribution<float> noise(0, width * 0.05f);
+    std::uniform_int_distribution<int> spike(0, 499);
+
+    std::vector<Input> inputs;
+    float angle = 0;
+    for (uint32_t s = 0; s < SWEEPS; s++) {
+        for (; angle < high; angle += step) {
+            inputs.push_back({angle + noise(rng), spike(rng) == 0 ? 80.0f : step * LOOP_HZ});
+        }
+        for (; angle > low; angle -= step) {
+            inputs.push_back({angle + noise(rng), spike(rng) == 0 ? -80.0f : -step * LOOP_HZ});
+        }
+    }
+    return inputs;
+}
+
+static bool sameOutput(const HapticOutput& a, const HapticOutput& b) {
+    return memcmp(&a.torque, &b.torque, sizeof(float)) == 0 && a.current_position == b.current_position
+        && a.position_steps == b.position_steps && memcmp(&a.sub_position_unit, &b.sub_position_unit, sizeof(float)) == 0;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    bool ok = true;
+    printf("%-32s %10s %10s %12s %10s\n", "config", "iterations", "mismatches", "compiled ns", "inline ns");
+
+    for (const DemoConfig& demo : DEMO_CONFIGS) {
+        const PB_SmartKnobConfig config = toConfig(demo);
+        const std::vector<Input> inputs = sweep(config, rng);
+        const uint32_t period = 1000000 / LOOP_HZ;
+
+        static HapticController<FloatPolicy> controller;
+        controller = HapticController<FloatPolicy>();
+        controller.pid().output_ramp = 10000;
+        controller.begin({0, 0});
+        controller.setConfig(config, {0, 0});
+        InlineDetents reference;
+        reference.setConfig(config, 0);
+
+        uint32_t mismatches = 0;
+        uint32_t now = 0;
+        for (const Input& input : inputs) {
+            now += period;
+            TurnAngle angle = TurnAngle{0, input.angle}.normalized();
+            reference.sync(controller.detentCenter(), controller.currentPosition());
+            float reference_angle = controller.frameAngle(angle);
+            HapticOutput expected = reference.update(reference_angle, input.velocity, now);
+            HapticOutput output = controller.update({angle, input.velocity, now});
+            if (!sameOutput(output, expected)) {
+                if (mismatches++ < 3) {
+                    fprintf(stderr, "%s at %.4f rad: torque %g/%g, position %d/%d, steps %d/%d, sub-position %g/%g\n",
+                        demo.name, input.angle, output.torque, expected.torque, output.current_position, expected.current_position,
+                        output.position_steps, expected.position_steps, output.sub_position_unit, expected.sub_position_unit);
+                }
+            }
+        }
+        ok &= mismatches == 0;
+
+        // Both on their own, over the same sweep
+        controller.begin({0, 0});
+        reference.setConfig(config, 0);
+        float torque = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            const Input& input = inputs[i % inputs.size()];
+            torque += controller.update({{0, input.angle}, input.velocity, i * period}).torque;
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            const Input& input = inputs[i % inputs.size()];
+            torque += reference.update(input.angle, input.velocity, i * period).torque;
+        }
+        auto end = std::chrono::steady_clock::now();
+        // Keeps the updates from being optimized away
+        if (torque == INFINITY) {
+            printf("\n");
+        }
+
+        printf("%-32s %10zu %10u %12.2f %10.2f\n", demo.name, inputs.size(), mismatches,
+            std::chrono::duration<double, std::nano>(middle - start).count() / BENCH_ITERATIONS,
+            std::chrono::duration<double, std::nano>(end - middle).count() / BENCH_ITERATIONS);
+    }
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
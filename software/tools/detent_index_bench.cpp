@@ -0,0 +1,116 @@
+/**
+ * Measures the magnetic detent index of the firmware (firmware/src/haptics/detent_index.h): the
+ * encoded size of SmartKnobConfig.detent_runs and the cost of the haptic loop's lookup, for 10, 100
+ * and 1000 detents in a few typical layouts.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/detent_index_bench.cpp firmware/src/haptics/detent_index.cpp -o detent_index_bench
+ *
+ * Usage:
+ *   detent_index_bench
+ *
+ * Sizes are compared to the detent_positions list (5 positions per Config, 6 bytes each when
+ * encoded); lookups to a linear scan over all positions. Timings are of the host, not the ESP32,
+ * so only compare them with each other.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "haptics/detent_index.h"
+
+// Must match the max_size of detent_runs in smartknob.proto
+static const size_t DETENT_RUNS_MAX_SIZE = 256;
+static const size_t LOOKUPS = 20000000;
+
+struct Layout {
+    const char* name;
+    // Appends count detent positions in ascending order
+    void (*generate)(size_t count, std::mt19937& rng, std::vector<int32_t>& positions);
+};
+
+static const Layout LAYOUTS[] = {
+    {"every 2nd", [](size_t count, std::mt19937&, std::vector<int32_t>& out) {
+        for (size_t i = 0; i < count; i++) out.push_back(i * 2);
+    }},
+    {"every 30th", [](size_t count, std::mt19937&, std::vector<int32_t>& out) {
+        for (size_t i = 0; i < count; i++) out.push_back(i * 30);
+    }},
+    {"random gaps 2..200", [](size_t count, std::mt19937& rng, std::vector<int32_t>& out) {
+        std::uniform_int_distribution<int32_t> gap(2, 200);
+        int32_t position = -1000;
+        for (size_t i = 0; i < count; i++) out.push_back(position += gap(rng));
+    }},
+    {"blocks of 10", [](size_t count, std::mt19937&, std::vector<int32_t>& out) {
+        for (size_t i = 0; i < count; i++) out.push_back((i / 10) * 25 + i % 10);
+    }},
+};
+
+// Returns nanoseconds per call of lookup over the given probe positions
+template <typename Lookup>
+static double timeLookups(const std::vector<int32_t>& probes, Lookup lookup) {
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        hits += lookup(probes[i & (probes.size() - 1)]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    // Keeps the lookups from being optimized away
+    if (hits == SIZE_MAX) {
+        printf("\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / LOOKUPS;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    printf("%-20s %7s %8s %6s %10s %9s %10s %10s\n",
+        "layout", "detents", "runs", "bytes", "fits", "list cfgs", "index ns", "scan ns");
+
+    for (const Layout& layout : LAYOUTS) {
+        for (size_t count : {10, 100, 1000}) {
+            std::vector<int32_t> positions;
+            layout.generate(count, rng, positions);
+
+            uint8_t encoded[DETENT_RUNS_MAX_SIZE];
+            size_t size = DetentIndex::encodeRuns(positions.data(), positions.size(), encoded, sizeof(encoded));
+            bool fits = size <= sizeof(encoded);
+
+            // Decode everything, even what wouldn't fit into one Config, to time the full index
+            std::vector<uint8_t> all(size);
+            DetentIndex::encodeRuns(positions.data(), positions.size(), all.data(), all.size());
+            static DetentIndex index;
+            index.clear();
+            bool complete = index.decodeRuns(all.data(), all.size());
+
+            // Verify the round trip over the whole span (and a margin on both sides)
+            for (int32_t p = positions.front() - 5; p <= positions.back() + 5; p++) {
+                bool expected = std::binary_search(positions.begin(), positions.end(), p);
+                if (complete && index.contains(p) != expected) {
+                    fprintf(stderr, "Mismatch at position %d (%s, %zu detents)\n", p, layout.name, count);
+                    return 1;
+                }
+            }
+
+            // The knob is at a random position of the span on every lookup
+            std::vector<int32_t> probes(4096);
+            std::uniform_int_distribution<int32_t> probe(positions.front() - 5, positions.back() + 5);
+            for (int32_t& p : probes) {
+                p = probe(rng);
+            }
+            double index_ns = timeLookups(probes, [&](int32_t p) { return index.contains(p); });
+            double scan_ns = timeLookups(probes, [&](int32_t p) {
+                return std::find(positions.begin(), positions.end(), p) != positions.end();
+            });
+
+            printf("%-20s %7zu %8u %6zu %10s %9zu %10.2f %10.2f\n",
+                layout.name, count, index.runCount(), size,
+                fits ? "yes" : (complete ? "no" : "no, >runs"),
+                (count + 4) / 5, index_ns, scan_ns);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * Checks the fast trigonometry of the firmware (firmware/src/fast_trig.h) against libm, exhaustively
+ * over float inputs, and measures its speed against sinf/cosf/atan2f.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/fast_trig_check.cpp -o fast_trig_check
+ *
+ * Usage:
+ *   fast_trig_check [max |angle| for sin/cos]
+ *
+ * The sweeps compare against double-precision libm:
+ *  - sin and cos at every float angle up to the given magnitude (16 by default, beyond the 2PI of
+ *    the normalized electrical and sensor angles)
+ *  - atan2 at every float ratio in [0, 1], on both sides of the diagonal (which covers the polynomial
+ *    and the octant folding), and at random points of all magnitudes in all quadrants
+ *  - the MT6701 driver's path: the angle recovered by atan2 from the sin/cos of every 14-bit reading
+ * Prints a table of the largest error of each sweep, where it occurs and its bound, next to the cost
+ * per call of the fast function and of libm's: CPU cycles where the host has a cycle counter (x86 TSC),
+ * otherwise nanoseconds. Costs are of the host, not the ESP32, so only compare them with each other.
+ * Exits with 1 if an error exceeds the bound documented in fast_trig.h. The full sweep evaluates a few
+ * billion angles, which takes a few minutes.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fast_trig.h"
+
+#include "tool_check.h"
+
+// Error bounds of fast_trig.h; for sin/cos, plus SIN_COS_BOUND_PER_RADIAN times the largest |angle|
+static const double SIN_COS_BOUND = 2.5e-6;
+static const double SIN_COS_BOUND_PER_RADIAN = 8e-8;
+static const double ATAN2_BOUND = 2e-6;
+static const size_t BENCH_CALLS = 20000000;
+
+static float bitsToFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static uint32_t floatToBits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// Calls check(a) for every non-negative float up to max, and for its negative
+template <typename Check>
+static void forEachFloat(float max, Check check) {
+    for (uint32_t bits = 0, end = floatToBits(max); bits <= end; bits++) {
+        float a = bitsToFloat(bits);
+        check(a);
+        check(-a);
+    }
+}
+
+// Difference between two angles, wrapped into [-PI, PI]
+static double angleError(double a, double b) {
+    return remainder(a - b, 2 * M_PI);
+}
+
+// Cycles per call of f over the given arguments
+template <typename F>
+static double cyclesPerArgument(const std::vector<float>& args, F f) {
+    return cyclesPerCall(BENCH_CALLS, [&](uint32_t i) { return f(args[i & (args.size() - 1)]); });
+}
+
+// A row of the table: the largest error of a sweep, and the cost of the fast and libm calls it compares
+struct Row {
+    char name[40];
+    double error;
+    float at;
+    double bound;
+    double fast_cost;
+    double libm_cost;
+};
+
+static bool report(const Row& row) {
+    bool pass = row.error <= row.bound;
+    printf("%-34s %10.3g %14.9g %10.3g %10.1f %10.1f  %s\n", row.name, row.error, row.at, row.bound, row.fast_cost,
+        row.libm_cost, pass ? "ok" : "FAIL");
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    const float max_angle = argc > 1 ? atof(argv[1]) : 16;
+    const double sin_cos_bound = SIN_COS_BOUND + SIN_COS_BOUND_PER_RADIAN * max_angle;
+    bool ok = true;
+
+    double sin_error = 0, cos_error = 0, sincos_error = 0;
+    float sin_at = 0, cos_at = 0, sincos_at = 0;
+    forEachFloat(max_angle, [&](float a) {
+        double s = sin((double)a);
+        double c = cos((double)a);
+        double e = fabs(fastSin(a) - s);
+        if (e > sin_error) {
+            sin_error = e;
+            sin_at = a;
+        }
+        e = fabs(fastCos(a) - c);
+        if (e > cos_error) {
+            cos_error = e;
+            cos_at = a;
+        }
+        float fs, fc;
+        fastSinCos(a, fs, fc);
+        e = fmax(fabs(fs - s), fabs(fc - c));
+        if (e > sincos_error) {
+            sincos_error = e;
+            sincos_at = a;
+        }
+    });
+    std::vector<Row> rows;
+    rows.push_back({"", sin_error, sin_at, sin_cos_bound, 0, 0});
+    snprintf(rows.back().name, sizeof(rows.back().name), "sin, all floats |a| <= %g", max_angle);
+    rows.push_back({"", cos_error, cos_at, sin_cos_bound, 0, 0});
+    snprintf(rows.back().name, sizeof(rows.back().name), "cos, all floats |a| <= %g", max_angle);
+    rows.push_back({"", sincos_error, sincos_at, sin_cos_bound, 0, 0});
+    snprintf(rows.back().name, sizeof(rows.back().name), "sincos, all floats |a| <= %g", max_angle);
+
+    double atan_error = 0;
+    float atan_at = 0;
+    for (uint32_t bits = 0, end = floatToBits(1.0f); bits <= end; bits++) {
+        float z = bitsToFloat(bits);
+        double e = fmax(fabs(fastAtan2(z, 1) - atan2((double)z, 1.0)), fabs(fastAtan2(1, z) - atan2(1.0, (double)z)));
+        if (e > atan_error) {
+            atan_error = e;
+            atan_at = z;
+        }
+    }
+    rows.push_back({"atan2, all ratios in [0, 1]", atan_error, atan_at, ATAN2_BOUND, 0, 0});
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> exponent(-30, 30);
+    atan_error = 0;
+    for (int i = 0; i < 100000000; i++) {
+        float y = (rng() & 1 ? -1 : 1) * exp10f(exponent(rng));
+        float x = (rng() & 1 ? -1 : 1) * exp10f(exponent(rng));
+        double e = fabs(angleError(fastAtan2(y, x), atan2((double)y, (double)x)));
+        if (e > atan_error) {
+            atan_error = e;
+            atan_at = atan2f(y, x);
+        }
+    }
+    rows.push_back({"atan2, random in all quadrants", atan_error, atan_at, ATAN2_BOUND, 0, 0});
+
+    // As the MT6701 driver recovers the angle of a reading (without its filter, which is linear)
+    double reading_error = 0;
+    float reading_at = 0;
+    for (uint32_t reading = 0; reading < 16384; reading++) {
+        float angle = (float)reading * 2 * (float)M_PI / 16384;
+        float s, c;
+        fastSinCos(angle, s, c);
+        double e = fabs(angleError(fastAtan2(s, c), angle));
+        if (e > reading_error) {
+            reading_error = e;
+            reading_at = angle;
+        }
+    }
+    rows.push_back({"atan2(sincos), all 14-bit readings", reading_error, reading_at, SIN_COS_BOUND + ATAN2_BOUND, 0, 0});
+
+    std::vector<float> angles(4096);
+    std::uniform_real_distribution<float> any_angle(0, 2 * M_PI);
+    for (float& a : angles) {
+        a = any_angle(rng);
+    }
+    rows[0].fast_cost = cyclesPerArgument(angles, [](float a) { return fastSin(a); });
+    rows[0].libm_cost = cyclesPerArgument(angles, [](float a) { return sinf(a); });
+    rows[1].fast_cost = cyclesPerArgument(angles, [](float a) { return fastCos(a); });
+    rows[1].libm_cost = cyclesPerArgument(angles, [](float a) { return cosf(a); });
+    rows[2].fast_cost = cyclesPerArgument(angles, [](float a) { float s, c; fastSinCos(a, s, c); return s + c; });
+    rows[2].libm_cost = cyclesPerArgument(angles, [](float a) { return sinf(a) + cosf(a); });
+    rows[3].fast_cost = cyclesPerArgument(angles, [](float a) { return fastAtan2(a - 3, 1.5f - a); });
+    rows[3].libm_cost = cyclesPerArgument(angles, [](float a) { return atan2f(a - 3, 1.5f - a); });
+    rows[4].fast_cost = rows[3].fast_cost;
+    rows[4].libm_cost = rows[3].libm_cost;
+    rows[5].fast_cost = cyclesPerArgument(angles, [](float a) { float s, c; fastSinCos(a, s, c); return fastAtan2(s, c); });
+    rows[5].libm_cost = cyclesPerArgument(angles, [](float a) { return atan2f(sinf(a), cosf(a)); });
+
+    printf("%-34s %10s %14s %10s %10s %10s\n", "", "max error", "at", "bound", "fast", "libm");
+    printf("%-34s %10s %14s %10s %10s %10s  (%s per call)\n", "", "", "", "", "", "", CYCLE_UNIT);
+    for (const Row& row : rows) {
+        ok &= report(row);
+    }
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/**
+ * Checks the haptic effect waveforms and their mixing (firmware/src/haptics/haptic_effect.h) against
+ * a simulated clock.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/haptic_effect_check.cpp firmware/src/haptics/haptic_effect.cpp \
+ *     -o haptic_effect_check
+ *
+ * Usage:
+ *   haptic_effect_check
+ *
+ * Samples the player at the motor loop's haptic rate, with the clock starting right before the wrap of
+ * micros(). Checks that:
+ *  - every effect has the envelope of its shape: peak, net impulse, sign changes and the sample at which
+ *    it ends, after which the player stops
+ *  - the torque scales with the requested strength, and a strength of 0 plays the default strength
+ *  - an unknown effect is refused and leaves the playing effects alone
+ *  - overlapping effects add up, never beyond the strongest of them, and each ends on its own; with all
+ *    voices busy, a new effect replaces the oldest
+ * Exits with 1 if any of these fails.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "haptics/haptic_effect.h"
+
+#include "tool_check.h"
+
+static const uint32_t STEP_MICROS = 500;
+static const uint32_t START_MICROS = 0xFFFFFFFFu - 20000;
+static const float EPSILON = 1e-5;
+
+struct Envelope {
+    float peak;
+    float positive_peak;
+    float negative_peak;
+    double impulse;
+    uint32_t sign_changes;
+    // Time after the start of the last non-zero sample
+    uint32_t last_micros;
+    bool stopped;
+};
+
+// Plays one effect on its own and samples it until well after it ends
+static Envelope sample(HapticEffect effect, float strength) {
+    HapticEffectPlayer player;
+    player.play(effect, strength, START_MICROS);
+    Envelope envelope = {};
+    float previous = 0;
+    for (uint32_t t = 0; t < HapticEffectPlayer::durationMicros(effect) + 10000; t += STEP_MICROS) {
+        float torque = player.torque(START_MICROS + t);
+        envelope.peak = fmaxf(envelope.peak, fabsf(torque));
+        envelope.positive_peak = fmaxf(envelope.positive_peak, torque);
+        envelope.negative_peak = fminf(envelope.negative_peak, torque);
+        envelope.impulse += torque * STEP_MICROS * 1e-6;
+        if (torque != 0) {
+            envelope.sign_changes += previous * torque < 0;
+            previous = torque;
+            envelope.last_micros = t;
+        }
+    }
+    envelope.stopped = !player.playing();
+    return envelope;
+}
+
+int main() {
+    char what[128];
+    bool ok = true;
+
+    struct Expected {
+        HapticEffect effect;
+        const char* name;
+        bool alternating;
+        // Net impulse per unit of strength, in volt-seconds
+        double impulse;
+        uint32_t sign_changes;
+    };
+    // Clicks and buzz push both ways equally; the ramp and bump push one way
+    const Expected expected[] = {
+        {HapticEffect::CLICK, "click", true, 0, 1},
+        {HapticEffect::DOUBLE_CLICK, "double click", true, 0, 3},
+        {HapticEffect::BUZZ, "buzz", true, 0, 39},
+        {HapticEffect::RAMP, "ramp", false, 0.06, 0},
+        {HapticEffect::BUMP, "bump", false, 0.03 * 2 / M_PI, 0},
+    };
+    for (const Expected& e : expected) {
+        const float strength = HapticEffectPlayer::defaultStrength(e.effect);
+        const uint32_t duration = HapticEffectPlayer::durationMicros(e.effect);
+        Envelope envelope = sample(e.effect, 0);
+        // Square waves reach their strength both ways; the ramp and bump get within a step of it
+        bool shape = e.alternating
+            ? envelope.positive_peak == strength && envelope.negative_peak == -strength
+            : envelope.peak <= strength && envelope.peak > strength * 0.99f && envelope.negative_peak == 0;
+        snprintf(what, sizeof(what), "%s: peak %.3f of %.1f, impulse %.5f Vs, %u sign changes, last at %u of %u us",
+            e.name, envelope.peak, strength, envelope.impulse, envelope.sign_changes, envelope.last_micros, duration);
+        ok &= check(shape && fabs(envelope.impulse - e.impulse * strength) < 0.01 * strength
+            && envelope.sign_changes == e.sign_changes && envelope.last_micros + STEP_MICROS >= duration
+            && envelope.last_micros < duration && envelope.stopped, what);
+
+        Envelope scaled = sample(e.effect, 2.5f * strength);
+        snprintf(what, sizeof(what), "%s: 2.5x strength, peak %.3f, impulse %.5f Vs", e.name, scaled.peak, scaled.impulse);
+        ok &= check(fabsf(scaled.peak - 2.5f * envelope.peak) < EPSILON * strength
+            && fabs(scaled.impulse - 2.5 * envelope.impulse) < EPSILON * strength, what);
+    }
+
+    HapticEffectPlayer player;
+    player.play(HapticEffect::BUZZ, 1, START_MICROS);
+    ok &= check(!player.play((HapticEffect)HapticEffectPlayer::NUM_EFFECTS, 1, START_MICROS)
+        && player.torque(START_MICROS + 1000) == 1, "unknown effect refused, buzz keeps playing");
+
+    // A bump, and a click 10ms into it: the click adds to the bump, but the sum stays within the bump's strength
+    player.stop();
+    ok &= check(!player.playing() && player.torque(START_MICROS) == 0, "stopped: no torque");
+    const float bump_strength = 2;
+    const float click_strength = 1;
+    player.play(HapticEffect::BUMP, bump_strength, START_MICROS);
+    player.play(HapticEffect::CLICK, click_strength, START_MICROS + 10000);
+    float mixed_error = 0;
+    float mixed_peak = 0;
+    for (uint32_t t = 10000; t < 16000; t += STEP_MICROS) {
+        float bump = bump_strength * HapticEffectPlayer::waveform(HapticEffect::BUMP, t);
+        float click = click_strength * HapticEffectPlayer::waveform(HapticEffect::CLICK, t - 10000);
+        float expected_torque = fminf(fmaxf(bump + click, -bump_strength), bump_strength);
+        float torque = player.torque(START_MICROS + t);
+        mixed_error = fmaxf(mixed_error, fabsf(torque - expected_torque));
+        mixed_peak = fmaxf(mixed_peak, torque);
+    }
+    float after_click = player.torque(START_MICROS + 20000);
+    snprintf(what, sizeof(what), "bump + click: max error %.2g against the sum, peak %.3f of %.1f, then %.3f",
+        mixed_error, mixed_peak, bump_strength, after_click);
+    ok &= check(mixed_error < EPSILON && mixed_peak == bump_strength
+        && fabsf(after_click - bump_strength * HapticEffectPlayer::waveform(HapticEffect::BUMP, 20000)) < EPSILON
+        && player.playing(), what);
+    player.torque(START_MICROS + 30000);
+    ok &= check(!player.playing(), "bump + click: stops once both ended");
+
+    // A ramp, then clicks 1ms apart on all the other voices and one more: the ramp, the oldest, is replaced
+    player.stop();
+    player.play(HapticEffect::RAMP, 1, START_MICROS);
+    for (uint32_t i = 1; i <= HapticEffectPlayer::MAX_VOICES; i++) {
+        player.play(HapticEffect::CLICK, 0.1f, START_MICROS + i * 1000);
+    }
+    const uint32_t last_click = HapticEffectPlayer::MAX_VOICES * 1000;
+    float expected_torque = 0;
+    for (uint32_t i = 1; i <= HapticEffectPlayer::MAX_VOICES; i++) {
+        expected_torque += 0.1f * HapticEffectPlayer::waveform(HapticEffect::CLICK, last_click + 500 - i * 1000);
+    }
+    // Within the clicks' strength, where the ramp's would let the sum through
+    expected_torque = fminf(fmaxf(expected_torque, -0.1f), 0.1f);
+    float torque = player.torque(START_MICROS + last_click + 500);
+    float after_clicks = player.torque(START_MICROS + last_click + HapticEffectPlayer::durationMicros(HapticEffect::CLICK));
+    snprintf(what, sizeof(what), "ramp and %u clicks: %.3f, expected %.3f from the clicks alone, then %.3f",
+        HapticEffectPlayer::MAX_VOICES, torque, expected_torque, after_clicks);
+    ok &= check(fabsf(torque - expected_torque) < EPSILON && after_clicks == 0 && !player.playing(), what);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+/**
+ * Closed-loop simulation of the haptic controller (firmware/src/haptics/haptic_controller.h) against a
+ * simulated knob, with a benchmark of controller iterations per second.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/haptic_plant_sim.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o haptic_plant_sim
+ *
+ * Usage:
+ *   haptic_plant_sim
+ *
+ * The knob is a rotor with inertia, viscous and Coulomb friction, driven through a voltage limit; the
+ * sensor adds noise and 14-bit quantization. The loop runs the way the motor task does: observer, then
+ * haptic controller, at the motor loop rate. A finger drags the knob towards a moving target through a
+ * spring and damper, with limited force, then lets go. Scenarios, for each numeric policy:
+ *  - spin through 100 detents and back: the position follows every detent, and the knob settles in
+ *    the detent of the final position
+ *  - push past both endstops of a bounded range: the position stays at the end, the controller
+ *    pushes back, and the knob returns within the range when released
+ *  - spin an infinite scroll across its wrap in both directions: the position wraps, and the position
+ *    steps add up to the detents crossed
+ * Exits with 1 if any scenario fails.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "haptics/angle_observer.h"
+#include "haptics/haptic_controller.h"
+
+#include "tool_check.h"
+
+// As the motor task's defaults (tasks/motor_task.h and motors/wanzhida_once_top.h)
+static const uint32_t LOOP_HZ = 2000;
+static const float OBSERVER_BANDWIDTH = 300;
+static const double VOLTAGE_LIMIT = 5;
+
+// Knob: rotor inertia, torque per volt of drive, viscous and Coulomb friction
+static const double INERTIA = 3e-6;
+static const double TORQUE_PER_VOLT = 0.004;
+static const double VISCOUS_FRICTION = 2e-6;
+static const double COULOMB_FRICTION = 2e-4;
+static const double SIM_STEP_SECONDS = 5e-6;
+// Sensor: bounded noise and quantization
+static const double SENSOR_NOISE_RAD = 0.05 * M_PI / 180;
+static const double SENSOR_LSB_RAD = 2 * M_PI / 16384;
+// Finger: stiffness and damping towards its target angle, and the most torque it applies
+static const double FINGER_STIFFNESS = 0.2;
+static const double FINGER_DAMPING = 2e-4;
+static const double FINGER_MAX_TORQUE = 0.01;
+
+static const double WIDTH_RAD = 10 * M_PI / 180;
+static const double SNAP_POINT = 1.1;
+// Past the detent the finger aims for, in positions; beyond the snap point of the one before
+static const double SNAP_OVERSHOOT = 0.3;
+static const uint32_t BENCH_ITERATIONS = 1 << 22;
+
+struct Knob {
+    double angle = 0.5;
+    double velocity = 0;
+
+    void step(double drive_volts, double finger_torque, double dt) {
+        drive_volts = std::clamp(drive_volts, -VOLTAGE_LIMIT, VOLTAGE_LIMIT);
+        double torque = drive_volts * TORQUE_PER_VOLT + finger_torque - VISCOUS_FRICTION * velocity;
+        if (velocity == 0 && fabs(torque) <= COULOMB_FRICTION) {
+            return;
+        }
+        torque -= copysign(COULOMB_FRICTION, velocity != 0 ? velocity : torque);
+        double new_velocity = velocity + torque / INERTIA * dt;
+        // Friction stops the knob rather than reversing it
+        velocity = (velocity != 0 && new_velocity * velocity < 0) ? 0 : new_velocity;
+        angle += velocity * dt;
+    }
+};
+
+static TurnAngle toTurnAngle(double angle) {
+    double turns = floor(angle / (2 * M_PI));
+    return TurnAngle{(int32_t)turns, (float)(angle - turns * 2 * M_PI)}.normalized();
+}
+
+static PB_SmartKnobConfig makeConfig(int32_t min_position, int32_t max_position, bool infinite_scroll) {
+    PB_SmartKnobConfig config = {};
+    config.min_position = min_position;
+    config.max_position = max_position;
+    config.infinite_scroll = infinite_scroll;
+    config.position_width_radians = WIDTH_RAD;
+    config.detent_strength_unit = 1;
+    config.endstop_strength_unit = 1;
+    config.snap_point = SNAP_POINT;
+    return config;
+}
+
+/**
+ * The motor loop around a HapticController, with the knob and a finger on it.
+ */
+template <typename Policy>
+class Simulation {
+    public:
+        explicit Simulation(const PB_SmartKnobConfig& config) : rng_(1), noise_(-SENSOR_NOISE_RAD, SENSOR_NOISE_RAD) {
+            TorquePid& pid = controller_.pid();
+            pid.output_ramp = 10000;
+            pid.limit = 10;
+            observer_.setBandwidth(OBSERVER_BANDWIDTH);
+            observer_.reset(sample(), 0);
+            controller_.begin(observer_.angle());
+            controller_.setConfig(config, observer_.angle());
+            start_angle_ = knob_.angle;
+        }
+
+        // Drag the knob across the given number of positions at the given speed, then let go and let it
+        // settle. The finger goes a little further than the last detent, until it feels it snap.
+        void drag(double positions, double radians_per_second, double settle_seconds = 0.5) {
+            double radians = (positions + copysign(SNAP_OVERSHOOT, positions)) * WIDTH_RAD;
+            double from = finger_target_ = knob_.angle;
+            double seconds = fabs(radians) / radians_per_second;
+            run(seconds, true, [&](double t) { finger_target_ = from + radians * std::min(t / seconds, 1.0); });
+            // Hold at the end, as a finger does before letting go
+            run(0.2, true, [](double) {});
+            released_position_ = output_.current_position;
+            run(settle_seconds, false, [](double) {});
+        }
+
+        int32_t position() const { return output_.current_position; }
+        // Position when the finger let go, after the last drag
+        int32_t releasedPosition() const { return released_position_; }
+        int64_t steps() const { return steps_; }
+        // Angle of the knob from where it started, in positions
+        double positionsTurned() const { return (knob_.angle - start_angle_) / WIDTH_RAD; }
+        float minTorque() const { return min_torque_; }
+        float maxTorque() const { return max_torque_; }
+        void resetTorqueRange() { min_torque_ = max_torque_ = 0; }
+
+    private:
+        std::mt19937 rng_;
+        std::uniform_real_distribution<double> noise_;
+        Knob knob_;
+        HapticController<Policy> controller_;
+        AngleObserver observer_;
+        HapticOutput output_ = {};
+        int32_t released_position_ = 0;
+        double start_angle_;
+        double finger_target_ = 0;
+        int64_t steps_ = 0;
+        float min_torque_ = 0;
+        float max_torque_ = 0;
+        uint64_t now_ = 0;
+        uint64_t next_tick_ = 0;
+        double drive_ = 0;
+
+        TurnAngle sample() {
+            return toTurnAngle(round((knob_.angle + noise_(rng_)) / SENSOR_LSB_RAD) * SENSOR_LSB_RAD);
+        }
+
+        template <typename OnStep>
+        void run(double seconds, bool finger, OnStep on_step) {
+            const uint32_t period = 1000000 / LOOP_HZ;
+            uint64_t start = now_;
+            for (uint64_t end = now_ + (uint64_t)(seconds * 1e6); now_ < end; now_ += (uint64_t)(SIM_STEP_SECONDS * 1e6)) {
+                on_step((now_ - start) * 1e-6);
+                if (now_ >= next_tick_) {
+                    observer_.update(sample(), (uint32_t)now_);
+                    output_ = controller_.update({observer_.predictAngle((uint32_t)(now_ + period)), observer_.velocity(), (uint32_t)now_});
+                    drive_ = output_.torque;
+                    steps_ += output_.position_steps;
+                    min_torque_ = std::min(min_torque_, output_.torque);
+                    max_torque_ = std::max(max_torque_, output_.torque);
+                    next_tick_ += period;
+                }
+                double finger_torque = 0;
+                if (finger) {
+                    finger_torque = std::clamp(FINGER_STIFFNESS * (finger_target_ - knob_.angle) - FINGER_DAMPING * knob_.velocity,
+                        -FINGER_MAX_TORQUE, FINGER_MAX_TORQUE);
+                }
+                knob_.step(drive_, finger_torque, SIM_STEP_SECONDS);
+            }
+        }
+};
+
+template <typename Policy>
+static bool checkSpin() {
+    char what[128];
+    Simulation<Policy> simulation(makeConfig(0, -1, false));
+    simulation.drag(100, 2 * M_PI);
+    bool ok = simulation.position() == 100 && simulation.steps() == 100 && fabs(simulation.positionsTurned() - 100) < 0.25;
+    snprintf(what, sizeof(what), "%s: 100 detents forward at 1 rev/s: position %d, %lld steps, settled at %.2f",
+        Policy::NAME, simulation.position(), (long long)simulation.steps(), simulation.positionsTurned());
+    bool pass = check(ok, what);
+
+    simulation.drag(-100, 2 * M_PI);
+    ok = simulation.position() == 0 && simulation.steps() == 0 && fabs(simulation.positionsTurned()) < 0.25;
+    snprintf(what, sizeof(what), "%s: and back: position %d, %lld steps, settled at %.2f",
+        Policy::NAME, simulation.position(), (long long)simulation.steps(), simulation.positionsTurned());
+    return check(ok, what) && pass;
+}
+
+template <typename Policy>
+static bool checkEndstops() {
+    char what[128];
+    Simulation<Policy> simulation(makeConfig(0, 10, false));
+    // Released at the end, the knob springs back into the range, possibly across a few detents
+    simulation.drag(15, M_PI);
+    bool ok = simulation.releasedPosition() == 10 && simulation.minTorque() < -1
+        && simulation.position() >= 0 && simulation.position() <= 10 && simulation.positionsTurned() < 10.5;
+    snprintf(what, sizeof(what), "%s: pushed 5 past the upper end of 0..10: held at %d, torque down to %.2f, settled at %.2f",
+        Policy::NAME, simulation.releasedPosition(), simulation.minTorque(), simulation.positionsTurned());
+    bool pass = check(ok, what);
+
+    simulation.resetTorqueRange();
+    simulation.drag(-20, M_PI);
+    ok = simulation.releasedPosition() == 0 && simulation.maxTorque() > 1
+        && simulation.position() >= 0 && simulation.position() <= 10 && simulation.positionsTurned() > -0.5;
+    snprintf(what, sizeof(what), "%s: then past the lower end: held at %d, torque up to %.2f, settled at %.2f",
+        Policy::NAME, simulation.releasedPosition(), simulation.maxTorque(), simulation.positionsTurned());
+    return check(ok, what) && pass;
+}
+
+template <typename Policy>
+static bool checkInfiniteScroll() {
+    char what[128];
+    Simulation<Policy> simulation(makeConfig(0, 9, true));
+    simulation.drag(25, 2 * M_PI);
+    bool ok = simulation.position() == 5 && simulation.steps() == 25;
+    snprintf(what, sizeof(what), "%s: 25 detents forward on an infinite scroll of 0..9: position %d, %lld steps",
+        Policy::NAME, simulation.position(), (long long)simulation.steps());
+    bool pass = check(ok, what);
+
+    simulation.drag(-37, 2 * M_PI);
+    ok = simulation.position() == 8 && simulation.steps() == -12;
+    snprintf(what, sizeof(what), "%s: then 37 back: position %d, %lld steps",
+        Policy::NAME, simulation.position(), (long long)simulation.steps());
+    return check(ok, what) && pass;
+}
+
+template <typename Policy>
+static void bench() {
+    HapticController<Policy> controller;
+    controller.pid().output_ramp = 10000;
+    controller.pid().limit = 10;
+    controller.begin({0, 0});
+    controller.setConfig(makeConfig(0, -1, false), {0, 0});
+
+    // A knob turning back and forth across a few detents
+    float angles[1024];
+    for (int i = 0; i < 1024; i++) {
+        angles[i] = 3 * WIDTH_RAD * sinf(2 * M_PI * i / 1024) + 1;
+    }
+    float torque = 0;
+    uint32_t now = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        now += 1000000 / LOOP_HZ;
+        torque += controller.update({{0, angles[i & 1023]}, 1, now}).torque;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %.1f M iterations/s, %.1f ns per iteration (%g)\n",
+        Policy::NAME, BENCH_ITERATIONS / seconds * 1e-6, seconds * 1e9 / BENCH_ITERATIONS, torque);
+}
+
+template <typename Policy>
+static bool checkPolicy() {
+    bool ok = checkSpin<Policy>();
+    ok &= checkEndstops<Policy>();
+    ok &= checkInfiniteScroll<Policy>();
+    return ok;
+}
+
+int main() {
+    bool ok = checkPolicy<FloatPolicy>();
+    ok &= checkPolicy<FixedQ16Policy>();
+    bench<FloatPolicy>();
+    bench<FixedQ16Policy>();
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
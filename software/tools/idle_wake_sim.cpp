@@ -0,0 +1,224 @@
+/**
+ * Simulation of the motor loop's low-power idle mode (firmware/src/haptics/idle_governor.h) against a
+ * simulated knob: checks that a touch wakes the loop within a bound, and that sensor noise at rest
+ * doesn't.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/idle_wake_sim.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o idle_wake_sim
+ *
+ * Usage:
+ *   idle_wake_sim [idle FOC and haptics Hz] [wake latency bound in us] [touches]
+ *
+ * The loop runs the way the motor task does: the sensor, observer and governor on every tick at the full
+ * rate, and the haptic controller (with the drive it sets) at the rate the governor picks, limited while
+ * in low power, or on the sample that wakes the loop. The knob is a rotor with inertia and
+ * friction, and the sensor adds bounded noise and 14-bit quantization. The knob rests in a detent
+ * until the governor enters low power. Then a finger pushes it, from barely to a flick.
+ *
+ * The wake latency runs from the moment the knob is far enough from where the governor saw it settle
+ * that any sample must see it (the wake threshold plus the sensor noise) to the sample that wakes the
+ * loop. By default
+ * the bound is one sensor sample period, i.e. one tick at the full rate. Exits with 1 if a touch exceeds the bound, a touch
+ * doesn't wake the loop, or the loop wakes while the knob rests.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "haptics/angle_observer.h"
+#include "haptics/haptic_controller.h"
+#include "haptics/idle_governor.h"
+#include "haptics/loop_scheduler.h"
+
+// As the motor task's defaults (tasks/motor_task.h and motors/wanzhida_once_top.h)
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t IDLE_DELAY_MICROS = 2000 * 1000;
+static const float IDLE_WAKE_RAD = 0.3 * M_PI / 180;
+static const float IDLE_DRIVE_LIMIT = 5 * 0.5;
+static const float OBSERVER_BANDWIDTH = 300;
+
+// Knob: rotor inertia, torque per volt of drive, viscous and Coulomb friction
+static const double INERTIA = 3e-6;
+static const double TORQUE_PER_VOLT = 0.004;
+static const double VISCOUS_FRICTION = 2e-6;
+static const double COULOMB_FRICTION = 2e-4;
+static const double SIM_STEP_SECONDS = 5e-6;
+// Sensor: bounded noise and quantization
+static const double SENSOR_NOISE_RAD = 0.05 * M_PI / 180;
+static const double SENSOR_LSB_RAD = 2 * M_PI / 16384;
+
+struct Knob {
+    double angle = 0.5;
+    double velocity = 0;
+
+    void step(double drive_volts, double finger_torque, double dt) {
+        double torque = drive_volts * TORQUE_PER_VOLT + finger_torque - VISCOUS_FRICTION * velocity;
+        if (velocity == 0 && fabs(torque) <= COULOMB_FRICTION) {
+            return;
+        }
+        torque -= copysign(COULOMB_FRICTION, velocity != 0 ? velocity : torque);
+        double new_velocity = velocity + torque / INERTIA * dt;
+        // Friction stops the knob rather than reversing it
+        velocity = (velocity != 0 && new_velocity * velocity < 0) ? 0 : new_velocity;
+        angle += velocity * dt;
+    }
+};
+
+static TurnAngle toTurnAngle(double angle) {
+    double turns = floor(angle / (2 * M_PI));
+    return TurnAngle{(int32_t)turns, (float)(angle - turns * 2 * M_PI)}.normalized();
+}
+
+int main(int argc, char** argv) {
+    const uint32_t idle_hz = argc > 1 ? atoi(argv[1]) : 250;
+    const uint32_t bound_micros = argc > 2 ? atoi(argv[2]) : 1000000 / LOOP_HZ;
+    const int touches = argc > 3 ? atoi(argv[3]) : 200;
+    // Departure from the settled (sampled) angle that a sample sees for certain, whatever its noise
+    const double certain_departure = IDLE_WAKE_RAD + SENSOR_NOISE_RAD + SENSOR_LSB_RAD / 2;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> noise(-SENSOR_NOISE_RAD, SENSOR_NOISE_RAD);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    PB_SmartKnobConfig config = {};
+    config.min_position = 0;
+    config.max_position = -1;
+    config.position_width_radians = 10 * M_PI / 180;
+    config.detent_strength_unit = 1;
+    config.endstop_strength_unit = 1;
+    config.snap_point = 1.1;
+
+    Knob knob;
+    HapticController<FloatPolicy> controller;
+    TorquePid& pid = controller.pid();
+    pid.output_ramp = 10000;
+    pid.limit = 10;
+    AngleObserver observer;
+    observer.setBandwidth(OBSERVER_BANDWIDTH);
+    IdleGovernor governor;
+    LoopScheduler scheduler;
+    scheduler.begin(LOOP_HZ, 1);
+
+    auto sample = [&]() {
+        double measured = round((knob.angle + noise(rng)) / SENSOR_LSB_RAD) * SENSOR_LSB_RAD;
+        return toTurnAngle(measured);
+    };
+    uint64_t now = 0;
+    observer.reset(sample(), 0);
+    controller.begin(observer.angle());
+    controller.setConfig(config, observer.angle());
+    governor.begin(IDLE_DELAY_MICROS, IDLE_WAKE_RAD, 0);
+
+    double drive = 0;
+    uint64_t next_tick = 0;
+    uint64_t haptic_updates = 0;
+    // Runs the loop iteration that is due, if any; returns true if it woke the loop from low power
+    auto tick = [&]() {
+        if (now < next_tick) {
+            return false;
+        }
+        next_tick += scheduler.periodMicros();
+        bool haptic_due = scheduler.tick((uint32_t)now, 1);
+        TurnAngle angle = sample();
+        observer.update(angle, (uint32_t)now);
+        bool was_low_power = governor.lowPower();
+        bool low_power = governor.update((uint32_t)now, angle, controller.idle(), false);
+        if (low_power != was_low_power) {
+            scheduler.setIdleDivisor(low_power ? LOOP_HZ / idle_hz : 0);
+            haptic_due = haptic_due || was_low_power;
+        }
+        if (haptic_due) {
+            haptic_updates++;
+            HapticOutput output = controller.update({observer.predictAngle((uint32_t)(now + scheduler.drivePeriodMicros())), observer.velocity(), (uint32_t)now});
+            drive = low_power ? std::clamp(output.torque, -IDLE_DRIVE_LIMIT, IDLE_DRIVE_LIMIT) : output.torque;
+        }
+        return was_low_power && !low_power;
+    };
+    auto run = [&](double seconds, double finger_torque, auto on_step) {
+        for (uint64_t end = now + (uint64_t)(seconds * 1e6); now < end; ) {
+            // The iteration samples the knob as on_step sees it
+            bool woke = tick();
+            on_step(woke);
+            knob.step(drive, finger_torque, SIM_STEP_SECONDS);
+            now += (uint64_t)(SIM_STEP_SECONDS * 1e6);
+        }
+    };
+    auto ignore = [](bool) {};
+
+    bool ok = true;
+    int missed = 0, late = 0, false_wakes = 0;
+    uint64_t worst_latency = 0, total_latency = 0;
+    int measured = 0;
+    for (int touch = 0; touch < touches; touch++) {
+        // Rest until in low power, plus a random while; any wake-up now is a false one
+        uint32_t wakeups = governor.wakeups();
+        run(1.0, 0, ignore);
+        while (!governor.lowPower() && now < 60e6 * (touch + 1)) {
+            run(0.01, 0, ignore);
+        }
+        if (!governor.lowPower()) {
+            fprintf(stderr, "Touch %d: never entered low power\n", touch);
+            return 1;
+        }
+        run(unit(rng) * 2, 0, ignore);
+        false_wakes += governor.wakeups() - wakeups;
+        if (!governor.lowPower()) {
+            continue;
+        }
+
+        // Push, from barely moving the knob to a flick
+        const TurnAngle settled = governor.settledAngle();
+        const double rest = settled.turns * 2 * M_PI + settled.radians;
+        const double finger = (unit(rng) < 0.5 ? -1 : 1) * (2e-4 + 3e-3 * pow(unit(rng), 2));
+        const double push_seconds = 0.02 + unit(rng) * 0.2;
+        int64_t onset = -1, woke_at = -1;
+        auto watch = [&](bool woke) {
+            if (onset < 0 && fabs(knob.angle - rest) > certain_departure) {
+                onset = now;
+            }
+            if (woke && woke_at < 0) {
+                woke_at = now;
+            }
+        };
+        run(push_seconds, finger, watch);
+        run(0.5, 0, watch);
+
+        if (onset < 0) {
+            // Too gentle to move the knob past the threshold; waking is optional
+            continue;
+        }
+        measured++;
+        if (woke_at < 0) {
+            fprintf(stderr, "Touch %d: moved %.3f deg but never woke\n", touch, (knob.angle - rest) * 180 / M_PI);
+            missed++;
+            continue;
+        }
+        // Noise can make a sample see the knob move before it certainly has
+        uint64_t latency = woke_at > onset ? woke_at - onset : 0;
+        total_latency += latency;
+        if (latency > worst_latency) {
+            worst_latency = latency;
+        }
+        if (latency > bound_micros) {
+            fprintf(stderr, "Touch %d: woke %llu us after moving (bound %u us)\n", touch, (unsigned long long)latency, bound_micros);
+            late++;
+        }
+    }
+    ok = missed == 0 && late == 0 && false_wakes == 0 && measured > 0;
+
+    printf("idle %u Hz, bound %u us: %d touches, %d moved the knob, %d missed, %d late, %d false wake-ups\n",
+        idle_hz, bound_micros, touches, measured, missed, late, false_wakes);
+    printf("wake latency avg/max %.0f/%llu us (from the knob being certainly off rest)\n",
+        measured ? (double)total_latency / measured : 0.0, (unsigned long long)worst_latency);
+    printf("governor: %u wake-ups, latency avg/max %.0f/%u us (from the last sample at rest), full rate %.1f%% of the time\n",
+        governor.wakeups(), governor.meanWakeLatencyMicros(), governor.maxWakeLatencyMicros(), governor.dutyCycle() * 100);
+    printf("loop: %.0f haptic updates/s on average, against %u at the full rate\n", haptic_updates / (now * 1e-6), LOOP_HZ);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
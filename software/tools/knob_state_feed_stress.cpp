@@ -0,0 +1,155 @@
+/**
+ * Stress test of the knob state feed (firmware/src/knob_state_feed.h) on the host: a writer thread
+ * publishes a new config every other state, as fast as it can, while reader threads poll it.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=c++17 -O2 -pthread -Ifirmware/src -Ithirdparty/nanopb software/tools/knob_state_feed_stress.cpp \
+ *     -o knob_state_feed_stress
+ *
+ * Usage:
+ *   knob_state_feed_stress [states]
+ *
+ * Every byte of a config carries its tag, and every state carries the tag of the config it was published
+ * with, so a torn copy or a state mixed with another config shows. A timer signal forces context switches
+ * at arbitrary points, so readers are interrupted mid-copy even on a single core. Checks that:
+ *  - every state a reader gets is intact and goes with the config it gets along with it
+ *  - a poll that returns false leaves the state untouched, config included
+ *  - config generations only move forward, and every reader ends on the last state
+ * Exits with 1 if any of these fails.
+ */
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "knob_state_feed.h"
+
+static const int READERS = 3;
+
+static void fillConfig(PB_SmartKnobConfig& config, uint32_t tag) {
+    memset(&config, (uint8_t)tag, sizeof(config));
+    config.min_position = (int32_t)tag;
+    config.max_position = (int32_t)tag;
+}
+
+// The config carries its tag in the positions, and its low byte everywhere else
+static bool intact(const PB_SmartKnobConfig& config) {
+    if (config.min_position != config.max_position) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)&config;
+    const size_t positions = offsetof(PB_SmartKnobConfig, min_position);
+    for (size_t i = 0; i < sizeof(config); i++) {
+        if (i >= positions && i < positions + 2 * sizeof(int32_t)) {
+            continue;
+        }
+        if (bytes[i] != (uint8_t)config.min_position) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A state's position holds the tag of its config in the high half and its index in the low half
+static int32_t makePosition(uint32_t tag, uint32_t index) {
+    return (int32_t)(((tag & 0xFFFF) << 16) | (index & 0xFFFF));
+}
+
+static void onAlarm(int) {
+    sched_yield();
+}
+
+struct ReaderResult {
+    uint64_t polls = 0;
+    uint64_t config_changes = 0;
+    uint64_t torn = 0;
+    uint64_t touched = 0;
+    uint64_t backwards = 0;
+    uint32_t last_index = 0;
+};
+
+int main(int argc, char** argv) {
+    const uint32_t states = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000000;
+
+    signal(SIGALRM, onAlarm);
+    itimerval timer = {{0, 50}, {0, 50}};
+    setitimer(ITIMER_REAL, &timer, nullptr);
+
+    static KnobStateFeed feed;
+    static PB_SmartKnobConfig config;
+    uint32_t tag = 1;
+    fillConfig(config, tag);
+    feed.publishConfig(config);
+
+    std::atomic<bool> publishing = true;
+    std::vector<ReaderResult> results(READERS);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&, r] {
+            ReaderResult& result = results[r];
+            KnobStateReader reader(feed);
+            static thread_local PB_SmartKnobState state;
+            static thread_local PB_SmartKnobState before;
+            state = {};
+            uint32_t generation = reader.configGeneration();
+            auto poll = [&] {
+                memcpy(&before, &state, sizeof(state));
+                if (!reader.poll(state)) {
+                    result.touched += memcmp(&before, &state, sizeof(state)) != 0;
+                    return false;
+                }
+                result.polls++;
+                if (!intact(state.config)
+                    || ((uint32_t)state.current_position >> 16) != ((uint32_t)state.config.min_position & 0xFFFF)
+                    || state.sub_position_unit != (float)(state.current_position & 0xFFFF)) {
+                    result.torn++;
+                }
+                if (reader.configGeneration() != generation) {
+                    result.config_changes++;
+                    result.backwards += (int32_t)(reader.configGeneration() - generation) < 0;
+                    generation = reader.configGeneration();
+                }
+                return true;
+            };
+            while (publishing.load(std::memory_order_relaxed)) {
+                poll();
+            }
+            // Everything is published by now; the last state is there for the taking
+            poll();
+            result.last_index = (uint32_t)(state.current_position & 0xFFFF);
+        });
+    }
+
+    for (uint32_t i = 0; i < states; i++) {
+        if (i % 2 == 0) {
+            fillConfig(config, ++tag);
+            feed.publishConfig(config);
+        }
+        feed.publishState(makePosition(tag, i), (float)(i & 0xFFFF), i);
+    }
+    publishing = false;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    bool ok = true;
+    for (int r = 0; r < READERS; r++) {
+        const ReaderResult& result = results[r];
+        bool pass = result.torn == 0 && result.touched == 0 && result.backwards == 0
+            && result.last_index == ((states - 1) & 0xFFFF);
+        ok &= pass;
+        printf("reader %d: %llu states, %llu configs, %llu torn, %llu touched on false, %llu backwards  %s\n", r,
+            (unsigned long long)result.polls, (unsigned long long)result.config_changes, (unsigned long long)result.torn,
+            (unsigned long long)result.touched, (unsigned long long)result.backwards, pass ? "ok" : "FAIL");
+    }
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
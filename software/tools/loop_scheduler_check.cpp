@@ -0,0 +1,172 @@
+/**
+ * Checks the motor loop's fixed-rate scheduler and period histogram (firmware/src/haptics/loop_scheduler.h)
+ * on a simulated clock.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/loop_scheduler_check.cpp -o loop_scheduler_check
+ *
+ * Usage:
+ *   loop_scheduler_check
+ *
+ * A periodic timer ticks at the loop rate and notifies the loop, as in MotorTask::run(): the loop wakes
+ * some microseconds after a tick (jitter), takes the pending notifications, calls tick() and works for a
+ * while. Now and then an iteration works for more than a period, so ticks pile up or merge. The clock
+ * starts right before the wrap of micros(). Checks that:
+ *  - the histogram holds exactly the periods between iterations, bucket by bucket, with the minimum,
+ *    maximum and mean period, and counts every late iteration and merged tick as an overrun
+ *  - without overruns, the periods stay within the wake-up jitter of the nominal period
+ *  - the haptic update is due on exactly every divisor-th tick at the nominal period
+ *  - with an idle divisor, the loop keeps running (and recording) at the nominal period, the haptic
+ *    update is due on the first tick and every divisor-th one after, and without it every haptic
+ *    divisor-th tick again
+ * Exits with 1 if any of these fails.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "haptics/loop_scheduler.h"
+
+#include "tool_check.h"
+
+static const uint32_t LOOP_HZ = 5000;
+static const uint8_t HAPTIC_DIVISOR = 2;
+static const uint32_t IDLE_DIVISOR = LOOP_HZ / 250;
+static const uint32_t WAKE_JITTER_MICROS = 20;
+static const uint32_t START_MICROS = 0xFFFFFFFFu - 100000;
+
+/**
+ * The periodic timer and the loop around a LoopScheduler, with what its histogram should hold kept alongside.
+ */
+class Simulation {
+    public:
+        Simulation() : rng_(1), jitter_(0, WAKE_JITTER_MICROS), now_(START_MICROS), next_tick_(START_MICROS) {
+            scheduler_.begin(LOOP_HZ, HAPTIC_DIVISOR);
+            expected_.reset(scheduler_.periodMicros());
+        }
+
+        /**
+         * @brief Run iterations of the loop, each working for the given time.
+         *
+         * @param overrun_every Every this many iterations, work for overrun_micros instead (0 for never)
+         * @return Ticks on which the haptic update was due
+         */
+        uint32_t run(uint32_t iterations, uint32_t work_micros, uint32_t overrun_every = 0, uint32_t overrun_micros = 0) {
+            uint32_t haptic_ticks = 0;
+            for (uint32_t i = 0; i < iterations; i++) {
+                // Wait for the notification, if no tick is pending yet
+                if ((int32_t)(now_ - next_tick_) < 0) {
+                    now_ = next_tick_;
+                }
+                // Take every tick that fired by now, like ulTaskNotifyTake(pdTRUE, ...)
+                uint32_t period = scheduler_.periodMicros();
+                uint32_t pending = (now_ - next_tick_) / period + 1;
+                next_tick_ += pending * period;
+                now_ += jitter_(rng_);
+
+                if (has_last_) {
+                    expected_.record(now_ - last_micros_, pending - 1);
+                }
+                last_micros_ = now_;
+                has_last_ = true;
+                haptic_ticks += scheduler_.tick(now_, pending);
+
+                now_ += overrun_every != 0 && (iterations_ % overrun_every) == overrun_every - 1 ? overrun_micros : work_micros;
+                iterations_++;
+            }
+            return haptic_ticks;
+        }
+
+        // As MotorTask::setLowPower(); the timer keeps running at the nominal period
+        void setIdleDivisor(uint32_t divisor) {
+            scheduler_.setIdleDivisor(divisor);
+        }
+
+        const LoopTimingHistogram& histogram() const { return scheduler_.histogram(); }
+        const LoopTimingHistogram& expected() const { return expected_; }
+        uint32_t now() const { return now_; }
+
+    private:
+        LoopScheduler scheduler_;
+        // Fed independently from the simulation's own clock, as a reference for the scheduler's histogram
+        LoopTimingHistogram expected_;
+        std::mt19937 rng_;
+        std::uniform_int_distribution<uint32_t> jitter_;
+
+        uint32_t now_;
+        uint32_t next_tick_;
+        uint32_t last_micros_ = 0;
+        bool has_last_ = false;
+        uint32_t iterations_ = 0;
+};
+
+static bool sameHistogram(const LoopTimingHistogram& a, const LoopTimingHistogram& b) {
+    for (uint8_t i = 0; i < LoopTimingHistogram::NUM_BUCKETS; i++) {
+        if (a.bucket(i) != b.bucket(i)) {
+            return false;
+        }
+    }
+    return a.samples() == b.samples() && a.overruns() == b.overruns() && a.missedTicks() == b.missedTicks()
+        && a.minPeriodMicros() == b.minPeriodMicros() && a.maxPeriodMicros() == b.maxPeriodMicros()
+        && a.meanPeriodMicros() == b.meanPeriodMicros();
+}
+
+static void printHistogram(const LoopTimingHistogram& histogram) {
+    for (uint8_t i = 0; i < LoopTimingHistogram::NUM_BUCKETS; i++) {
+        printf("  %4u-%4u us %6u\n", i * histogram.bucketWidthMicros(), (i + 1) * histogram.bucketWidthMicros() - 1, histogram.bucket(i));
+    }
+}
+
+int main() {
+    const uint32_t period = 1000000 / LOOP_HZ;
+    char what[128];
+    bool ok = true;
+    Simulation simulation;
+
+    // Steady: the loop works for well under a period
+    uint32_t haptic_ticks = simulation.run(10000, period / 2);
+    const LoopTimingHistogram& histogram = simulation.histogram();
+    snprintf(what, sizeof(what), "steady %u Hz: %u periods, %u-%u us, mean %.2f us, %u overruns",
+        LOOP_HZ, histogram.samples(), histogram.minPeriodMicros(), histogram.maxPeriodMicros(), histogram.meanPeriodMicros(), histogram.overruns());
+    ok &= check(histogram.samples() == 9999 && histogram.overruns() == 0 && histogram.missedTicks() == 0
+        && histogram.minPeriodMicros() >= period - WAKE_JITTER_MICROS && histogram.maxPeriodMicros() <= period + WAKE_JITTER_MICROS
+        && histogram.meanPeriodMicros() > period - 0.5f && histogram.meanPeriodMicros() < period + 0.5f, what);
+    // The jitter only reaches the buckets either side of the nominal period
+    const uint32_t nominal_bucket = period / histogram.bucketWidthMicros();
+    ok &= check(sameHistogram(histogram, simulation.expected())
+        && histogram.bucket(nominal_bucket - 1) + histogram.bucket(nominal_bucket) == histogram.samples(),
+        "steady: every period in its bucket, all next to the nominal period");
+    printHistogram(histogram);
+    snprintf(what, sizeof(what), "haptic update due on %u of 10000 ticks with divisor %u", haptic_ticks, HAPTIC_DIVISOR);
+    ok &= check(haptic_ticks == 10000 / HAPTIC_DIVISOR, what);
+
+    // Every 97th iteration works for 2.5 periods: the next one is late, and ticks merge
+    simulation.run(10000, period / 2, 97, period * 5 / 2);
+    snprintf(what, sizeof(what), "overruns: %u periods, up to %u us, %u overruns, %u merged ticks",
+        histogram.samples(), histogram.maxPeriodMicros(), histogram.overruns(), histogram.missedTicks());
+    ok &= check(sameHistogram(histogram, simulation.expected()) && histogram.overruns() >= 10000 / 97
+        && histogram.missedTicks() >= 10000 / 97 && histogram.bucket(LoopTimingHistogram::NUM_BUCKETS - 1) >= 10000 / 97, what);
+
+    // Idle: still ticking at the nominal period, with the haptic update due on the first tick and every divisor-th one after
+    const uint32_t samples_before = histogram.samples();
+    simulation.setIdleDivisor(IDLE_DIVISOR);
+    uint32_t start = simulation.now();
+    haptic_ticks = simulation.run(250, period / 2);
+    uint32_t elapsed = simulation.now() - start;
+    snprintf(what, sizeof(what), "idle divisor %u: 250 ticks in %u us, haptic update due on %u, %u periods recorded",
+        IDLE_DIVISOR, elapsed, haptic_ticks, histogram.samples() - samples_before);
+    ok &= check(haptic_ticks == (250 + IDLE_DIVISOR - 1) / IDLE_DIVISOR && histogram.samples() - samples_before == 250
+        && sameHistogram(histogram, simulation.expected())
+        && elapsed >= 250 * period - WAKE_JITTER_MICROS && elapsed <= 250 * period + WAKE_JITTER_MICROS, what);
+
+    // Back at the haptic divisor
+    simulation.setIdleDivisor(0);
+    haptic_ticks = simulation.run(1000, period / 2);
+    snprintf(what, sizeof(what), "not idle: %u periods recorded for 1000 more ticks, haptic update due on %u",
+        histogram.samples() - samples_before - 250, haptic_ticks);
+    ok &= check(histogram.samples() - samples_before == 1250 && sameHistogram(histogram, simulation.expected())
+        && haptic_ticks == 1000 / HAPTIC_DIVISOR, what);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+ * Runs the motor calibration (firmware/src/motors/motor_calibration.h) against a simulated motor and
+ * sensor, and checks what it finds against the simulated truth.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/motor_calibration_check.cpp \
+ *     firmware/src/motors/motor_calibration.cpp firmware/src/sensor_correction.cpp -o motor_calibration_check
+ *
+ * Usage:
+ *   motor_calibration_check
+ *
+ * The motor is a rotor with inertia, viscous and Coulomb friction and cogging, pulled by the open-loop
+ * voltage vector towards its electrical angle; the sensor reads its angle in either direction, from an
+ * arbitrary zero, with noise and 14-bit quantization, at the motor loop's rate with jitter. Checks that:
+ *  - for every supported pole pair count (3 to 12) in both directions, and with an eccentric magnet,
+ *    a stiffer bearing with stronger cogging or a noisy sensor, the calibration succeeds with the right
+ *    pole pairs and direction, and an electrical zero within MAX_ZERO_ERROR
+ *  - a blocked rotor and a missing magnet end in NO_MOVEMENT, a rotor held during the sweep in SLIPPED,
+ *    pole pairs outside the supported range in BAD_POLE_PAIRS, and a cancel in CANCELLED
+ *  - estimatePolePairs() recovers direction and pole pairs from exact sweeps
+ * Exits with 1 if any of these fails.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "motors/motor_calibration.h"
+
+static const double LOOP_SECONDS = 500e-6;
+static const double JITTER_SECONDS = 30e-6;
+static const float DRIVE_VOLTAGE = 3;
+// Largest error of the electrical zero accepted, in electrical radians. At 0.1 rad the loss of torque is 0.5%.
+static const double MAX_ZERO_ERROR = 0.1;
+static const double MAX_SECONDS = 60;
+
+/**
+ * Rotor, drive and sensor.
+ */
+struct Plant {
+    int pole_pairs = 7;
+    // Sensor angle per rotor angle: 1 or -1
+    int sensor_direction = 1;
+    // Sensor angle at rotor angle 0
+    double sensor_zero = 1;
+    double inertia = 3e-6;
+    double viscous = 2e-5;
+    double coulomb = 0.002;
+    double cogging = 0.002;
+    int cogging_periods = 42;
+    double torque_per_volt = 0.01;
+    double eccentricity = 0;
+    double noise = 0.0005;
+    bool blocked = false;
+    bool magnet = true;
+
+    double angle = 0.4;
+    double velocity = 0;
+    // Torque from outside, e.g. a finger holding the knob
+    double external_torque = 0;
+
+    void step(const CalibrationDrive& drive, double dt) {
+        const int substeps = 10;
+        const double h = dt / substeps;
+        for (int i = 0; i < substeps; i++) {
+            double torque = torque_per_volt * drive.voltage * sin(drive.electrical_angle + M_PI / 2 - pole_pairs * angle)
+                - viscous * velocity - cogging * sin(cogging_periods * angle) + external_torque;
+            if (blocked || (fabs(velocity) < 1e-3 && fabs(torque) < coulomb)) {
+                velocity = 0;
+                continue;
+            }
+            torque -= coulomb * (velocity > 0 ? 1 : velocity < 0 ? -1 : (torque > 0 ? 1 : -1));
+            velocity += torque / inertia * h;
+            angle += velocity * h;
+        }
+    }
+
+    float sensor(std::mt19937& rng) const {
+        std::normal_distribution<double> noise_rad(0, noise);
+        double reading = magnet ? sensor_direction * angle + sensor_zero + eccentricity * sin(angle + 0.3) : sensor_zero;
+        reading = fmod(reading + noise_rad(rng), 2 * M_PI);
+        reading = reading < 0 ? reading + 2 * M_PI : reading;
+        return floor(reading / (2 * M_PI) * 16384) * 2 * M_PI / 16384;
+    }
+
+    // The electrical zero as SimpleFOC expects it: electrical angle, in sensor terms, of rotor angle 0
+    double zeroElectricalOffset() const {
+        double zero = fmod(sensor_direction * pole_pairs * sensor_zero, 2 * M_PI);
+        return zero < 0 ? zero + 2 * M_PI : zero;
+    }
+};
+
+struct Outcome {
+    MotorCalibration::Status status;
+    MotorCalibrationResult result;
+    double seconds;
+    double zero_error;
+};
+
+/**
+ * @brief Calibrate the plant as the motor task does, one update per loop iteration.
+ *
+ * @param cancel_at Seconds after which to cancel (negative for never)
+ * @param hold_at Seconds after which to hold the rotor against the drive for 0.3 s (negative for never)
+ */
+static Outcome calibrate(Plant plant, uint32_t seed, double cancel_at = -1, double hold_at = -1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-JITTER_SECONDS, JITTER_SECONDS);
+    MotorCalibration calibration;
+    // Near the wrap of micros()
+    uint32_t now_micros = 0xFFFFFFFFu - 1000000;
+    calibration.start(DRIVE_VOLTAGE, plant.sensor(rng), now_micros);
+    CalibrationDrive drive = {0, 0};
+    double t = 0;
+    while (calibration.running() && t < MAX_SECONDS) {
+        double dt = LOOP_SECONDS + jitter(rng);
+        plant.external_torque = hold_at >= 0 && t > hold_at && t < hold_at + 0.3 ? 0.03 : 0;
+        plant.step(drive, dt);
+        t += dt;
+        now_micros += (uint32_t)lround(dt * 1e6);
+        if (cancel_at >= 0 && t > cancel_at) {
+            calibration.cancel();
+        }
+        drive = calibration.update(plant.sensor(rng), now_micros);
+    }
+    double zero_error = remainder(calibration.result().zero_electrical_offset - plant.zeroElectricalOffset(), 2 * M_PI);
+    return {calibration.status(), calibration.result(), t, zero_error};
+}
+
+static const char* statusName(MotorCalibration::Status status) {
+    static const char* const NAMES[] = {"NONE", "RUNNING", "SUCCEEDED", "CANCELLED", "NO_MOVEMENT", "BAD_POLE_PAIRS", "SLIPPED"};
+    return NAMES[(uint8_t)status];
+}
+
+int main() {
+    bool ok = true;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> any_angle(0, 2 * M_PI);
+
+    const char* const VARIANTS[] = {"clean", "eccentric magnet", "stiff, strong cogging", "noisy sensor"};
+    printf("%-4s %-4s %-22s %-8s %-15s %-4s %-4s %9s %8s\n", "pp", "dir", "variant", "zero", "status", "pp'", "cw", "zero err", "time");
+    double max_error = 0, max_seconds = 0;
+    for (int pole_pairs = MotorCalibration::MIN_POLE_PAIRS; pole_pairs <= MotorCalibration::MAX_POLE_PAIRS; pole_pairs++) {
+        for (int direction : {1, -1}) {
+            for (int variant = 0; variant < 4; variant++) {
+                Plant plant;
+                plant.pole_pairs = pole_pairs;
+                plant.sensor_direction = direction;
+                plant.sensor_zero = any_angle(rng);
+                plant.angle = any_angle(rng);
+                if (variant == 1) {
+                    plant.eccentricity = 0.02;
+                } else if (variant == 2) {
+                    plant.coulomb = 0.004;
+                    plant.cogging = 0.003;
+                } else if (variant == 3) {
+                    plant.noise = 0.002;
+                }
+                Outcome outcome = calibrate(plant, variant * 100 + pole_pairs);
+                bool pass = outcome.status == MotorCalibration::Status::SUCCEEDED && outcome.result.pole_pairs == pole_pairs
+                    && outcome.result.direction_cw == (direction > 0) && fabs(outcome.zero_error) < MAX_ZERO_ERROR;
+                ok &= pass;
+                max_error = fmax(max_error, fabs(outcome.zero_error));
+                max_seconds = fmax(max_seconds, outcome.seconds);
+                printf("%-4d %-4d %-22s %-8.3f %-15s %-4u %-4d %+9.4f %7.2fs  %s\n", pole_pairs, direction, VARIANTS[variant],
+                    plant.sensor_zero, statusName(outcome.status), outcome.result.pole_pairs, outcome.result.direction_cw,
+                    outcome.zero_error, outcome.seconds, pass ? "ok" : "FAIL");
+            }
+        }
+    }
+    printf("largest zero error %.4f electrical rad (bound %.2f), longest calibration %.2f s\n\n", max_error, MAX_ZERO_ERROR, max_seconds);
+
+    struct Failure {
+        const char* name;
+        MotorCalibration::Status expected;
+    };
+    const Failure failures[] = {
+        {"blocked rotor", MotorCalibration::Status::NO_MOVEMENT},
+        {"no magnet", MotorCalibration::Status::NO_MOVEMENT},
+        {"held during the pole pair sweep", MotorCalibration::Status::SLIPPED},
+        {"2 pole pairs", MotorCalibration::Status::BAD_POLE_PAIRS},
+        {"14 pole pairs", MotorCalibration::Status::BAD_POLE_PAIRS},
+        {"cancelled after 2 s", MotorCalibration::Status::CANCELLED},
+    };
+    for (uint32_t i = 0; i < sizeof(failures) / sizeof(failures[0]); i++) {
+        Plant plant;
+        double cancel_at = -1, hold_at = -1;
+        switch (i) {
+            case 0: plant.blocked = true; break;
+            case 1: plant.magnet = false; break;
+            case 2: hold_at = 1.2; break;
+            case 3: plant.pole_pairs = 2; break;
+            case 4: plant.pole_pairs = 14; break;
+            case 5: cancel_at = 2; break;
+        }
+        Outcome outcome = calibrate(plant, 1000 + i, cancel_at, hold_at);
+        bool pass = outcome.status == failures[i].expected;
+        ok &= pass;
+        printf("%-40s %-15s after %5.2f s  %s\n", failures[i].name, statusName(outcome.status), outcome.seconds, pass ? "ok" : "FAIL");
+    }
+
+    // The estimation on its own: exact sweeps of every pole pair count, both ways
+    bool estimated = true;
+    for (int pole_pairs = MotorCalibration::MIN_POLE_PAIRS; pole_pairs <= MotorCalibration::MAX_POLE_PAIRS; pole_pairs++) {
+        for (int direction : {1, -1}) {
+            LineFit fit;
+            for (int i = 0; i < 1000; i++) {
+                fit.add(1000 + i * 0.01f, 3 + direction * i * 0.01f / pole_pairs);
+            }
+            bool cw = direction < 0;
+            uint8_t found = 0;
+            estimated &= MotorCalibration::estimatePolePairs(fit, cw, found) == MotorCalibration::Status::SUCCEEDED
+                && found == pole_pairs && cw == (direction > 0);
+        }
+    }
+    printf("%-40s %-15s  %s\n", "estimatePolePairs, exact sweeps", "", estimated ? "ok" : "FAIL");
+    ok &= estimated;
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
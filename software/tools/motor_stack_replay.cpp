@@ -0,0 +1,182 @@
+/**
+ * Runs the motor task's sensor and haptic stack on the host, fed by a ReplayBackend
+ * (firmware/src/replay_backend.h) through the same AngleSource as the firmware: turn counting, angle
+ * observer, idle governor and haptic controller, at the motor loop rate, on a simulated clock.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/motor_stack_replay.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o motor_stack_replay
+ *
+ * Usage:
+ *   motor_stack_replay [recording]
+ *
+ * A recording is a text file of raw 14-bit MT6701 readings, one per line, sampled at SAMPLE_HZ; they go
+ * through the driver's filter (firmware/src/mt6701_filter.h) as on the knob. Without one, the stream is
+ * synthetic: the knob turned through detents at varying speed, with sensor noise, then left at rest.
+ *
+ * The stack runs twice over the stream. Prints the time per stage and the detents crossed, and exits with
+ * 1 if the two runs differ in any torque or position.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "angle_source.h"
+#include "cycle_probe.h"
+#include "haptics/angle_observer.h"
+#include "haptics/haptic_controller.h"
+#include "haptics/idle_governor.h"
+#include "mt6701_filter.h"
+#include "replay_backend.h"
+
+// As the motor task's defaults (tasks/motor_task.h)
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t SAMPLE_HZ = 2000;
+static const uint32_t SENSOR_LATENCY_MICROS = 2000000 / SAMPLE_HZ;
+static const float OBSERVER_BANDWIDTH = 300;
+static const uint32_t IDLE_DELAY_MICROS = 2000 * 1000;
+static const float IDLE_WAKE_RAD = 0.3 * M_PI / 180;
+
+enum Stage { SENSOR, OBSERVER, GOVERNOR, HAPTICS, STAGE_COUNT };
+static const char* const STAGE_NAMES[STAGE_COUNT] = {"sensor", "observer", "governor", "haptics"};
+
+struct RunResult {
+    uint64_t checksum;
+    uint32_t iterations;
+    uint32_t position_steps;
+    CycleStats stages[STAGE_COUNT];
+};
+
+static std::vector<uint16_t> readRecording(const char* path) {
+    std::vector<uint16_t> readings;
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return readings;
+    }
+    unsigned int reading;
+    while (fscanf(file, "%u", &reading) == 1) {
+        readings.push_back(reading & 0x3FFF);
+    }
+    fclose(file);
+    return readings;
+}
+
+static std::vector<uint16_t> synthesize() {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 2);
+    std::vector<uint16_t> readings;
+    double counts = 5000;
+    for (uint32_t i = 0; i < 10 * SAMPLE_HZ; i++) {
+        double t = (double)i / SAMPLE_HZ;
+        // Turning back and forth for 6 s, up to 3 turns/s, then resting
+        double turns_per_second = t < 6 ? 3 * sin(2 * M_PI * t / 3) * fabs(sin(2 * M_PI * t)) : 0;
+        counts += turns_per_second * MT6701::COUNTS_PER_TURN / SAMPLE_HZ;
+        int64_t count = llround(counts + noise(rng)) % MT6701::COUNTS_PER_TURN;
+        readings.push_back((uint16_t)(count < 0 ? count + MT6701::COUNTS_PER_TURN : count));
+    }
+    return readings;
+}
+
+static void hash(uint64_t& checksum, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+static void run(const std::vector<ReplaySample>& samples, RunResult& result) {
+    result = {};
+    result.checksum = 14695981039346656037ull;
+
+    PB_SmartKnobConfig config = {};
+    config.min_position = 0;
+    config.max_position = -1;
+    config.position_width_radians = 10 * M_PI / 180;
+    config.detent_strength_unit = 1;
+    config.endstop_strength_unit = 1;
+    config.snap_point = 1.1;
+
+    AngleSource<ReplayBackend> source(samples);
+    source.init();
+    AngleObserver observer;
+    observer.setBandwidth(OBSERVER_BANDWIDTH);
+    HapticController<FloatPolicy> controller;
+    TorquePid& pid = controller.pid();
+    pid.output_ramp = 10000;
+    pid.limit = 10;
+    IdleGovernor governor;
+
+    const uint32_t period = 1000000 / LOOP_HZ;
+    uint32_t now = samples.front().micros;
+    source.backend().setTime(now);
+    source.update();
+    observer.reset(source.angle(), source.sampleMicros());
+    controller.begin(observer.angle());
+    controller.setConfig(config, observer.angle());
+    governor.begin(IDLE_DELAY_MICROS, IDLE_WAKE_RAD, now);
+
+    while (!source.backend().finished()) {
+        now += period;
+        result.iterations++;
+        {
+            CycleProbe probe(result.stages[SENSOR]);
+            source.backend().setTime(now);
+            source.update();
+        }
+        {
+            CycleProbe probe(result.stages[OBSERVER]);
+            observer.update(source.angle(), source.sampleMicros() - SENSOR_LATENCY_MICROS);
+        }
+        {
+            CycleProbe probe(result.stages[GOVERNOR]);
+            governor.update(now, source.angle(), controller.idle(), false);
+        }
+        HapticOutput output;
+        {
+            CycleProbe probe(result.stages[HAPTICS]);
+            output = controller.update({observer.predictAngle(now + period), observer.velocity(), now});
+        }
+        result.position_steps += output.position_steps < 0 ? -output.position_steps : output.position_steps;
+        hash(result.checksum, &output.torque, sizeof(output.torque));
+        hash(result.checksum, &output.current_position, sizeof(output.current_position));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<uint16_t> readings = argc > 1 ? readRecording(argv[1]) : synthesize();
+    if (readings.empty()) {
+        fprintf(stderr, "No readings in %s\n", argv[1]);
+        return 1;
+    }
+
+    // As the MT6701 driver: every reading through its filter, timestamped at the sampling rate
+    std::vector<ReplaySample> samples;
+    MT6701Filter filter;
+    for (size_t i = 0; i < readings.size(); i++) {
+        filter.add(readings[i]);
+        samples.push_back({(uint32_t)(1000 + i * 1000000 / SAMPLE_HZ), filter.angle()});
+    }
+
+    static RunResult first, second;
+    run(samples, first);
+    run(samples, second);
+
+    printf("%zu readings (%.1f s), %u iterations at %u Hz, %u detents crossed\n",
+        readings.size(), (double)readings.size() / SAMPLE_HZ, first.iterations, LOOP_HZ, first.position_steps);
+    printf("%-10s %10s %10s %10s\n", "ns", "avg", "p99", "max");
+    const float ticks_per_nano = CycleClock::ticksPerMicro() / 1000;
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const CycleStats& stage = first.stages[i];
+        printf("%-10s %10.0f %10.0f %10.0f\n", STAGE_NAMES[i],
+            stage.meanTicks() / ticks_per_nano, stage.percentileTicks(0.99) / ticks_per_nano, stage.maxTicks() / ticks_per_nano);
+    }
+
+    bool ok = first.checksum == second.checksum && first.iterations == second.iterations;
+    printf("runs %s (checksum %016llx)\n", ok ? "identical" : "DIFFER", (unsigned long long)first.checksum);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+ * Compares the MT6701 driver's integer filter (firmware/src/mt6701_filter.h) with the unit-vector EWMA
+ * it replaced (cosf/sinf per reading, atan2f per call), and measures both.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/mt6701_filter_check.cpp -o mt6701_filter_check
+ *
+ * Usage:
+ *   mt6701_filter_check [recording...]
+ *
+ * A recording is a text file of raw 14-bit readings, one per line, as sampled by the driver. Besides
+ * the recordings, both filters run on synthetic streams at the sampling rate: sweeps from a crawl to a
+ * flick in both directions across the wrap, a knob oscillating in a detent, sensor noise at rest, and
+ * steps. Exits with 1 if the outputs differ by more than MAX_DIFFERENCE_COUNTS on any stream, or if the
+ * filter's angle reaches 2PI while settling onto the wrap.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fast_trig.h"
+#include "mt6701_filter.h"
+
+static const double SAMPLE_HZ = 2000;
+static const double COUNT_RAD = 2 * M_PI / MT6701::COUNTS_PER_TURN;
+// Up to a flick of 20 turns/s and steps of 10 degrees at 2 kHz. The vector average lags a fast sweep
+// slightly less (its phase isn't linear in the step), by 1.6 counts at 20 turns/s.
+static const double MAX_DIFFERENCE_COUNTS = 2;
+// The vector average starts from zero rather than the first reading, so it catches up faster at first
+static const size_t STARTUP_READINGS = 20;
+static const size_t BENCH_READINGS = 1 << 16;
+static const int BENCH_ROUNDS = 200;
+
+// The driver's filter before: an EWMA of the angle as a unit vector
+class VectorFilter {
+    public:
+        void add(uint16_t count) {
+            float new_angle = (float)count * 2 * M_PI / 16384;
+            float new_x = cosf(new_angle);
+            float new_y = sinf(new_angle);
+            x_ = new_x * 0.4f + x_ * (1 - 0.4f);
+            y_ = new_y * 0.4f + y_ * (1 - 0.4f);
+        }
+
+        float angle() const {
+            float rad = -atan2f(y_, x_);
+            if (rad < 0) {
+                rad += 2 * M_PI;
+            }
+            return rad;
+        }
+
+    private:
+        float x_ = 0;
+        float y_ = 0;
+};
+
+// As VectorFilter, with the fast trigonometry it used last
+class FastVectorFilter {
+    public:
+        void add(uint16_t count) {
+            float new_x, new_y;
+            fastSinCos((float)count * FastTrig::TWO_PI / 16384, new_y, new_x);
+            x_ = new_x * 0.4f + x_ * (1 - 0.4f);
+            y_ = new_y * 0.4f + y_ * (1 - 0.4f);
+        }
+
+        float angle() const {
+            float rad = -fastAtan2(y_, x_);
+            if (rad < 0) {
+                rad += FastTrig::TWO_PI;
+            }
+            return rad;
+        }
+
+    private:
+        float x_ = 0;
+        float y_ = 0;
+};
+
+static uint16_t toCount(double counts) {
+    int64_t count = llround(counts) % MT6701::COUNTS_PER_TURN;
+    return (uint16_t)(count < 0 ? count + MT6701::COUNTS_PER_TURN : count);
+}
+
+// Largest difference between the filters' outputs, in counts, past the start-up transient
+static double compare(const std::vector<uint16_t>& readings) {
+    VectorFilter reference;
+    MT6701Filter filter;
+    double max_difference = 0;
+    for (size_t i = 0; i < readings.size(); i++) {
+        reference.add(readings[i]);
+        filter.add(readings[i]);
+        if (i >= STARTUP_READINGS) {
+            max_difference = fmax(max_difference, fabs(remainder((double)filter.angle() - reference.angle(), 2 * M_PI)) / COUNT_RAD);
+        }
+    }
+    return max_difference;
+}
+
+static bool report(const std::string& name, const std::vector<uint16_t>& readings) {
+    double difference = compare(readings);
+    bool pass = difference <= MAX_DIFFERENCE_COUNTS;
+    printf("%-44s %8zu readings, max difference %.3f counts  %s\n", name.c_str(), readings.size(), difference, pass ? "ok" : "FAIL");
+    return pass;
+}
+
+static std::vector<uint16_t> synthesize(double seconds, std::function<double(double)> counts_at, double noise_counts, std::mt19937& rng) {
+    std::normal_distribution<double> noise(0, noise_counts);
+    std::vector<uint16_t> readings;
+    for (size_t i = 0; i < seconds * SAMPLE_HZ; i++) {
+        readings.push_back(toCount(counts_at(i / SAMPLE_HZ) + (noise_counts > 0 ? noise(rng) : 0)));
+    }
+    return readings;
+}
+
+static bool readRecording(const char* path, std::vector<uint16_t>& readings) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    unsigned int reading;
+    while (fscanf(file, "%u", &reading) == 1) {
+        readings.push_back(reading & 0x3FFF);
+    }
+    fclose(file);
+    return true;
+}
+
+// Nanoseconds per reading of adding every reading and reading the angle calls_per_reading times
+template <typename Filter>
+static double timeFilter(const std::vector<uint16_t>& readings, int calls_per_reading) {
+    Filter filter;
+    float sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (uint16_t reading : readings) {
+            filter.add(reading);
+            for (int i = 0; i < calls_per_reading; i++) {
+                sum += filter.angle();
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    // Keeps the calls from being optimized away
+    if (sum == 12345.678f) {
+        printf("\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double)BENCH_ROUNDS * readings.size());
+}
+
+int main(int argc, char** argv) {
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        std::vector<uint16_t> readings;
+        if (!readRecording(argv[i], readings)) {
+            fprintf(stderr, "Can't read %s\n", argv[i]);
+            return 1;
+        }
+        ok &= report(std::string("recording ") + argv[i], readings);
+    }
+
+    std::mt19937 rng(1);
+    const double turn = MT6701::COUNTS_PER_TURN;
+    for (double turns_per_second : {0.01, 0.3, 2.0, 8.0, 20.0}) {
+        for (int direction = -1; direction <= 1; direction += 2) {
+            char name[64];
+            snprintf(name, sizeof(name), "sweep %+.2f turns/s", direction * turns_per_second);
+            ok &= report(name, synthesize(2, [&](double t) { return 9000 + direction * turns_per_second * turn * t; }, 0, rng));
+            snprintf(name, sizeof(name), "sweep %+.2f turns/s, noise 2 counts", direction * turns_per_second);
+            ok &= report(name, synthesize(2, [&](double t) { return 9000 + direction * turns_per_second * turn * t; }, 2, rng));
+        }
+    }
+    // Oscillating around a detent at the wrap, as after a release
+    ok &= report("oscillation +-3 deg at 30 Hz across the wrap", synthesize(2, [&](double t) {
+        return turn * 3 / 360 * sin(2 * M_PI * 30 * t) * exp(-2 * t);
+    }, 1, rng));
+    ok &= report("rest at the wrap, noise 3 counts", synthesize(5, [](double) { return 0; }, 3, rng));
+    std::vector<uint16_t> steps;
+    for (double degrees : {1.0, 2.0, 5.0, 10.0, -10.0, -5.0, -2.0, -1.0}) {
+        for (int i = 0; i < 50; i++) {
+            steps.push_back(toCount(i < 25 ? 0 : turn * degrees / 360));
+        }
+    }
+    ok &= report("steps of 1 to 10 deg, both ways", steps);
+
+    // Settling onto 0 from just past it, the average ends a few units short of the wrap: the angle stays below 2PI
+    uint32_t at_two_pi = 0;
+    float max_angle = 0;
+    for (uint16_t start = 1; start < 64; start++) {
+        MT6701Filter filter;
+        filter.add(start);
+        for (int i = 0; i < 200; i++) {
+            filter.add(0);
+            at_two_pi += filter.angle() >= 2 * (float)M_PI;
+            max_angle = fmaxf(max_angle, filter.angle());
+        }
+    }
+    printf("%-44s %8u readings at 2PI, max angle %.7f  %s\n", "settling onto the wrap", at_two_pi, max_angle, at_two_pi == 0 ? "ok" : "FAIL");
+    ok &= at_two_pi == 0;
+
+    std::vector<uint16_t> readings = synthesize(BENCH_READINGS / SAMPLE_HZ, [&](double t) { return 3 * turn * t; }, 2, rng);
+    printf("\n%-24s %12s %12s %12s\n", "ns per reading", "vector libm", "vector fast", "integer");
+    for (int calls : {1, 4}) {
+        char name[64];
+        snprintf(name, sizeof(name), "add + %d angle call%s", calls, calls > 1 ? "s" : "");
+        printf("%-24s %12.2f %12.2f %12.2f\n", name,
+            timeFilter<VectorFilter>(readings, calls),
+            timeFilter<FastVectorFilter>(readings, calls),
+            timeFilter<MT6701Filter>(readings, calls));
+    }
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
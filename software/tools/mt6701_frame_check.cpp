@@ -0,0 +1,233 @@
+/**
+ * Checks the MT6701 driver's hardware-free layer (firmware/src/mt6701_frame.h and mt6701_filter.h) with
+ * synthetic frames, and the frame queue between the SPI interrupt and the motor loop with two threads.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -pthread -Ifirmware/src software/tools/mt6701_frame_check.cpp -o mt6701_frame_check
+ *
+ * Usage:
+ *   mt6701_frame_check
+ *
+ * Checks that:
+ *  - the table CRC6 matches a bitwise CRC (x^6 + x + 1) over every 18-bit data word
+ *  - every reading and status survives encode/decode, and every single- and double-bit error of a frame
+ *    is detected
+ *  - an all-ones frame is stuck, and so is an all-zero frame (which passes the CRC) unless the previous
+ *    valid reading was near 0
+ *  - the filter follows a sweep across the wrap with the lag of its group delay, without a glitch at the
+ *    wrap, and settles after a step
+ *  - timestamped frames pushed at the sampling rate by one thread and drained in bursts by another are
+ *    received in order, or counted as dropped
+ * Exits with 1 if any of these fails.
+ */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "mt6701_filter.h"
+#include "mt6701_frame.h"
+#include "spsc_queue.h"
+
+#include "tool_check.h"
+
+// As the driver (mt6701_sensor.h)
+static const uint16_t FRAME_QUEUE_SIZE = 32;
+static const uint32_t SAMPLE_HZ = 2000;
+
+// CRC of the data bits MSB first, polynomial x^6 + x + 1, initial value 0
+static uint8_t bitwiseCrc6(uint32_t data, uint8_t bits) {
+    uint8_t crc = 0;
+    for (int i = bits - 1; i >= 0; i--) {
+        uint8_t feedback = ((crc >> 5) ^ (data >> i)) & 1;
+        crc = (crc << 1) & 0x3F;
+        if (feedback) {
+            crc ^= 0x03;
+        }
+    }
+    return crc;
+}
+
+// Difference between two angles, wrapped into [-PI, PI]
+static double angleError(double a, double b) {
+    return remainder(a - b, 2 * M_PI);
+}
+
+static double countsToDriverAngle(double counts) {
+    double angle = -counts * 2 * M_PI / MT6701::COUNTS_PER_TURN;
+    return angle < 0 ? angle + 2 * M_PI : angle;
+}
+
+static bool checkCrc() {
+    bool ok = true;
+    uint32_t mismatches = 0;
+    for (uint32_t data = 0; data < (1 << 18); data++) {
+        mismatches += MT6701::crc6(data) != bitwiseCrc6(data, 18);
+    }
+    ok &= check(mismatches == 0, "CRC6 table matches bitwise CRC, all 2^18 data words");
+
+    uint32_t bad_roundtrips = 0;
+    for (uint32_t count = 0; count < MT6701::COUNTS_PER_TURN; count++) {
+        for (uint8_t field = 0; field < 3; field++) {
+            for (uint8_t flags = 0; flags < 4; flags++) {
+                MT6701FieldStatus field_status = (MT6701FieldStatus)field;
+                MT6701Reading reading = MT6701::decode(MT6701::encode(count, field_status, flags & 1, flags & 2), count);
+                bad_roundtrips += !reading.valid() || reading.count != count || reading.field_status != field_status
+                    || reading.push != (bool)(flags & 1) || reading.loss_of_track != (bool)(flags & 2);
+            }
+        }
+    }
+    ok &= check(bad_roundtrips == 0, "encode/decode round trip, all readings and statuses");
+
+    uint32_t undetected_single = 0;
+    uint32_t undetected_double = 0;
+    for (uint32_t count = 0; count < MT6701::COUNTS_PER_TURN; count++) {
+        uint32_t frame = MT6701::encode(count);
+        for (uint8_t i = 0; i < 24; i++) {
+            undetected_single += MT6701::decode(frame ^ (1u << i)).valid();
+            for (uint8_t j = i + 1; j < 24; j++) {
+                undetected_double += MT6701::decode(frame ^ (1u << i) ^ (1u << j)).valid();
+            }
+        }
+    }
+    ok &= check(undetected_single == 0, "single-bit errors detected, all readings");
+    ok &= check(undetected_double == 0, "double-bit errors detected, all readings");
+    // A line stuck low passes the CRC (CRC6 of zero data is zero); only a knob at 0 makes it a reading
+    const int32_t near_zero = MT6701::ZERO_FRAME_COUNTS, far = MT6701::ZERO_FRAME_COUNTS + 1;
+    ok &= check(MT6701::decode(0).stuck && !MT6701::decode(0).valid() && MT6701::decode(0, far).stuck
+        && MT6701::decode(0, MT6701::COUNTS_PER_TURN - far).stuck, "all-zero frame stuck, without a valid reading near 0 before");
+    ok &= check(MT6701::decode(0, 0).valid() && MT6701::decode(0, near_zero).valid()
+        && MT6701::decode(0, MT6701::COUNTS_PER_TURN - near_zero).valid() && MT6701::decode(0, 3).count == 0,
+        "all-zero frame read as 0 next to a valid reading near 0");
+    ok &= check(MT6701::decode(MT6701::FRAME_MASK).stuck && MT6701::decode(MT6701::FRAME_MASK, 0).stuck
+        && MT6701::decode(MT6701::FRAME_MASK, MT6701::COUNTS_PER_TURN - 1).stuck, "all-ones frame stuck, wherever the knob was");
+    uint8_t stuck_flags = MT6701::healthFlags(MT6701::decode(0)) | MT6701::healthFlags(MT6701::decode(MT6701::FRAME_MASK));
+    ok &= check(stuck_flags == SensorHealth::STUCK_FRAME, "stuck frames only flag STUCK_FRAME");
+    return ok;
+}
+
+static bool checkFilter() {
+    bool ok = true;
+    const double group_delay = (1 - MT6701Filter::ALPHA) / MT6701Filter::ALPHA;
+
+    // Sweep at a constant rate for three turns, both ways, crossing the wrap
+    for (int direction = -1; direction <= 1; direction += 2) {
+        const double counts_per_sample = direction * 7.3;
+        MT6701Filter filter;
+        double max_lag_error = 0;
+        double max_step = 0;
+        double previous = 0;
+        for (uint32_t i = 0; i < 3 * MT6701::COUNTS_PER_TURN / 7.3; i++) {
+            double counts = 100 + i * counts_per_sample;
+            int32_t count = (int32_t)lround(counts) % MT6701::COUNTS_PER_TURN;
+            filter.add((uint16_t)(count < 0 ? count + MT6701::COUNTS_PER_TURN : count));
+            double angle = filter.angle();
+            // Past the start-up transient, the output trails the input by the group delay
+            if (i > 50) {
+                double expected = countsToDriverAngle(counts - group_delay * counts_per_sample);
+                max_lag_error = fmax(max_lag_error, fabs(angleError(angle, expected)));
+                max_step = fmax(max_step, fabs(angleError(angle, previous)));
+            }
+            previous = angle;
+        }
+        const double per_sample = 7.3 * 2 * M_PI / MT6701::COUNTS_PER_TURN;
+        char what[96];
+        snprintf(what, sizeof(what), "sweep %s: lag %.2f samples (error %.2g rad), largest step %.2f samples",
+            direction > 0 ? "up" : "down", group_delay, max_lag_error, max_step / per_sample);
+        // Rounding to counts, plus the curvature of the vector average at this rate
+        ok &= check(max_lag_error < 2 * M_PI / MT6701::COUNTS_PER_TURN && max_step < 1.1 * per_sample, what);
+    }
+
+    // Step of a quarter turn: within 5% after log(0.05) / log(1 - ALPHA) = 6 samples
+    MT6701Filter filter;
+    for (int i = 0; i < 100; i++) {
+        filter.add(1000);
+    }
+    int settled_after = -1;
+    for (int i = 1; i <= 20 && settled_after < 0; i++) {
+        filter.add(1000 + MT6701::COUNTS_PER_TURN / 4);
+        double remaining = fabs(angleError(filter.angle(), countsToDriverAngle(1000 + MT6701::COUNTS_PER_TURN / 4)));
+        if (remaining < 0.05 * M_PI / 2) {
+            settled_after = i;
+        }
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "quarter-turn step settles to 5%% after %d samples", settled_after);
+    ok &= check(settled_after > 0 && settled_after <= 6, what);
+    return ok;
+}
+
+static bool checkQueue() {
+    static SpscQueue<MT6701Frame, FRAME_QUEUE_SIZE> frames;
+    std::atomic<uint32_t> dropped = 0;
+    std::atomic<bool> sampling = true;
+    const uint32_t samples = SAMPLE_HZ * 2;
+    const auto start = std::chrono::steady_clock::now();
+    auto micros = [&] {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // The SPI interrupt: a frame per sample period, every 50th with a bad CRC
+    std::thread sampler([&] {
+        auto next = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < samples; i++) {
+            uint32_t bits = MT6701::encode(i % MT6701::COUNTS_PER_TURN);
+            if (i % 50 == 0) {
+                bits ^= 1;
+            }
+            if (!frames.push({bits, micros()})) {
+                dropped++;
+            }
+            next += std::chrono::microseconds(1000000 / SAMPLE_HZ);
+            std::this_thread::sleep_until(next);
+        }
+        sampling = false;
+    });
+
+    // The motor loop: mostly at 2 kHz, sometimes stalled for longer than the queue lasts
+    bool in_order = true;
+    uint32_t received = 0, crc_errors = 0, last_micros = 0, max_burst = 0;
+    int32_t last_count = MT6701::NO_COUNT;
+    auto drain = [&] {
+        MT6701Frame frame;
+        uint32_t burst = 0;
+        while (frames.pop(frame)) {
+            MT6701Reading reading = MT6701::decode(frame.bits, last_count);
+            if (!reading.valid()) {
+                crc_errors++;
+            } else {
+                in_order &= last_count == MT6701::NO_COUNT || reading.count > last_count || reading.count == 0;
+                last_count = reading.count;
+            }
+            in_order &= frame.micros >= last_micros;
+            last_micros = frame.micros;
+            received++;
+            burst++;
+        }
+        max_burst = burst > max_burst ? burst : max_burst;
+    };
+    for (uint32_t tick = 0; sampling; tick++) {
+        drain();
+        std::this_thread::sleep_for(std::chrono::microseconds(tick % 500 == 499 ? 30000 : 500));
+    }
+    sampler.join();
+    drain();
+
+    bool ok = check(in_order, "frames received in order, with ordered timestamps");
+    char what[96];
+    snprintf(what, sizeof(what), "%u frames: %u received (%u CRC errors), %u dropped, up to %u at once",
+        samples, received, crc_errors, dropped.load(), max_burst);
+    ok &= check(received + dropped == samples && crc_errors <= samples / 50 && max_burst <= FRAME_QUEUE_SIZE, what);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= checkCrc();
+    ok &= checkFilter();
+    ok &= checkQueue();
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/**
+ * Soak test of the haptic controller's multi-turn angle handling (firmware/src/haptics/turn_angle.h):
+ * spins a simulated knob through 10^6 revolutions and checks, at checkpoints along the way, that the
+ * detents are as precise as after the first turn.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/multi_turn_soak.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o multi_turn_soak
+ *
+ * Usage:
+ *   multi_turn_soak [revolutions]
+ *
+ * The knob angle is simulated in double precision and fed to the controller the way the motor task
+ * does, as whole turns plus a float angle within the turn. At each checkpoint the knob is swept
+ * slowly across a few detents, and the sweep is checked against the controller's own detents:
+ *  - the angle between consecutive snaps matches the position width
+ *  - sub_position_unit follows the angle linearly between the snaps, without coarse steps
+ *  - the positions counted since the start (plus the sub-position) match the angle turned, so the
+ *    detents haven't drifted
+ * Exits with 1 if any of these is off by more than the tolerance of the numeric policy.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "haptics/haptic_controller.h"
+
+static const double TWO_PI = 2 * M_PI;
+static const uint32_t LOOP_MICROS = 500;
+// Spin rate between checkpoints: fast, but within the snaps one update may take
+static const int UPDATES_PER_TURN = 40;
+// Step of the slow sweep at a checkpoint, about the resolution of the angle sensors
+static const double SWEEP_STEP_RAD = 2e-5;
+static const int SWEEP_POSITIONS = 4;
+
+struct Soak {
+    const char* name;
+    PB_SmartKnobConfig config;
+};
+
+static PB_SmartKnobConfig unbounded(float width_degrees) {
+    PB_SmartKnobConfig config = {};
+    config.min_position = 0;
+    config.max_position = -1;
+    config.position_width_radians = width_degrees * M_PI / 180;
+    config.detent_strength_unit = 1;
+    config.endstop_strength_unit = 1;
+    config.snap_point = 0.5;
+    return config;
+}
+
+static PB_SmartKnobConfig infiniteScroll(float width_degrees, int32_t positions) {
+    PB_SmartKnobConfig config = unbounded(width_degrees);
+    config.max_position = positions - 1;
+    config.infinite_scroll = true;
+    return config;
+}
+
+// Sensor reading of the simulated angle, as MotorTask::sensorAngle() provides it
+static TurnAngle sensorAngle(double angle) {
+    double turns = floor(angle / TWO_PI);
+    return TurnAngle{(int32_t)turns, (float)(angle - turns * TWO_PI)}.normalized();
+}
+
+template <typename Policy>
+static bool soak(const Soak& soak, uint64_t revolutions) {
+    // The controller's lattice, in the units it computes in: its turn and position width differ from the
+    // exact values by the rounding of the numeric policy, which is a fixed scale, not a loss of precision
+    const double turn = Policy::toFloat(Policy::fromFloat(TurnAngle::TURN));
+    const double width = Policy::toFloat(Policy::fromFloat(soak.config.position_width_radians));
+    const double tolerance = std::is_same<Policy, FloatPolicy>::value ? 2e-6 : 4e-5;
+    // Angle the controller sees for the simulated angle
+    auto seen = [&](double angle) {
+        TurnAngle a = sensorAngle(angle);
+        return a.turns * turn + Policy::toFloat(Policy::fromFloat(a.radians));
+    };
+
+    HapticController<Policy> controller;
+    double angle = 0.5;
+    uint32_t now = 0;
+    controller.begin(sensorAngle(angle));
+    controller.setConfig(soak.config, sensorAngle(angle));
+    const double start = seen(angle);
+    int64_t steps = 0;
+
+    HapticOutput output = {};
+    double updated_angle = angle;
+    auto update = [&](double velocity) {
+        updated_angle = angle;
+        output = controller.update({sensorAngle(angle), (float)velocity, now += LOOP_MICROS});
+        steps += output.position_steps;
+    };
+
+    bool ok = true;
+    uint64_t turned = 0;
+    for (uint64_t checkpoint = 1; ; checkpoint *= 10) {
+        uint64_t target = checkpoint > revolutions ? revolutions : checkpoint;
+        double velocity = TWO_PI / UPDATES_PER_TURN / (LOOP_MICROS * 1e-6);
+        for (; turned < target; turned++) {
+            for (int i = 0; i < UPDATES_PER_TURN; i++) {
+                angle += TWO_PI / UPDATES_PER_TURN;
+                update(velocity);
+            }
+        }
+
+        // Sweep slowly across a few positions (fast enough not to trigger the idle correction)
+        double worst_width = 0, worst_sub = 0, worst_sub_step = 0;
+        double previous_snap = NAN, center = NAN;
+        float previous_sub = NAN;
+        double sweep_end = angle + SWEEP_POSITIONS * width;
+        for (; angle < sweep_end; angle += SWEEP_STEP_RAD) {
+            update(1);
+            double at = seen(angle);
+            if (output.position_steps != 0) {
+                if (output.position_steps != 1) {
+                    fprintf(stderr, "%s: %d steps at once in a slow sweep\n", soak.name, output.position_steps);
+                    ok = false;
+                }
+                if (!std::isnan(previous_snap)) {
+                    worst_width = fmax(worst_width, fabs(at - previous_snap - width));
+                }
+                previous_snap = at;
+                // With a snap point of 0.5, the new detent center is half a position past the snap
+                center = at + width / 2;
+                previous_sub = NAN;
+            } else if (!std::isnan(center)) {
+                double expected = (at - center) / width;
+                worst_sub = fmax(worst_sub, fabs(output.sub_position_unit - expected) * width);
+                if (!std::isnan(previous_sub)) {
+                    worst_sub_step = fmax(worst_sub_step, fabs(output.sub_position_unit - previous_sub) * width);
+                }
+                previous_sub = output.sub_position_unit;
+            }
+        }
+
+        // Positions counted since the start against the angle turned, in positions
+        double count_error = fabs((double)steps + output.sub_position_unit - (seen(updated_angle) - start) / width);
+        // The sweep steps the angle by SWEEP_STEP_RAD, so snaps are only seen to within that
+        bool pass = worst_width <= SWEEP_STEP_RAD + tolerance && worst_sub <= SWEEP_STEP_RAD + tolerance
+            && worst_sub_step <= SWEEP_STEP_RAD + tolerance && count_error * width <= tolerance;
+        printf("%-6s %-28s %9llu %12.3g %12.3g %12.3g %12.3g  %s\n",
+            Policy::NAME, soak.name, (unsigned long long)turned, worst_width, worst_sub, worst_sub_step, count_error,
+            pass ? "ok" : "FAIL");
+        ok &= pass;
+
+        if (target == revolutions) {
+            return ok;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t revolutions = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    const Soak SOAKS[] = {
+        {"unbounded, 1 deg", unbounded(1)},
+        {"unbounded, 7.3 deg", unbounded(7.3)},
+        {"infinite scroll 0-99, 2 deg", infiniteScroll(2, 100)},
+    };
+
+    printf("%-6s %-28s %9s %12s %12s %12s %12s\n",
+        "policy", "config", "turns", "width err", "sub err", "sub step", "count err");
+    bool ok = true;
+    for (const Soak& s : SOAKS) {
+        ok &= soak<FloatPolicy>(s, revolutions);
+        ok &= soak<FixedQ16Policy>(s, revolutions);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+/**
+ * Reports the accuracy of the haptic controller's numeric policies (firmware/src/haptics/numeric_policy.h)
+ * against the float reference, and their cost in cycles per call.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -Ifirmware/src -Ithirdparty/nanopb software/tools/numeric_policy_report.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o numeric_policy_report
+ *
+ * Usage:
+ *   numeric_policy_report
+ *
+ * Accuracy, as the largest error of each policy:
+ *  - per operation, against double precision: conversion of angles up to 16 turns, the ratio of an angle
+ *    to position widths from 0.5 to 60 degrees, and an EWMA step
+ *  - per config, against HapticController<FloatPolicy> on the same input, while the knob sweeps across all
+ *    positions with noise: iterations where the position differs, and the torque and sub-position while
+ *    both agree on the position
+ * The position width is rounded to a whole Q16.16 LSB (1.5e-5 rad), and the detent center moves by the
+ * rounded width on every snap, so it drifts from the float one by up to half an LSB per position crossed.
+ * The bounds are that drift plus a few LSB of rounding, times the detent PID's gain for the torque; a snap
+ * may come an iteration or two earlier or later, but never more.
+ * Cost, in cycles per call of each operation and of a controller update: CPU cycles where the host has
+ * a cycle counter (x86 TSC), otherwise nanoseconds. Host cycles only compare the policies with each other;
+ * the board's FPU decides which one is faster on the knob.
+ *
+ * Exits with 1 if a policy exceeds the accuracy its resolution allows (see below).
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "haptics/haptic_controller.h"
+
+#include "tool_check.h"
+
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t SWEEPS = 4;
+static const uint32_t BENCH_CALLS = 1 << 22;
+// Largest errors of the operations: a Q16.16 LSB is 1.5e-5 rad, and a few of them are lost in products
+// and conversions; a ratio error is in units of the width it is taken of, so it grows for narrow widths
+static const double LSB_RAD = 1 / FixedQ16Policy::ONE;
+static const double ANGLE_BOUND = LSB_RAD;
+static const double RATIO_BOUND = 2e-3;
+static const double EWMA_BOUND = 4 * LSB_RAD;
+// Rounding of the controller's angles besides the drift of the detent center
+static const double CONTROLLER_ROUNDING_RAD = 4 * LSB_RAD;
+// Iterations by which a snap may come earlier or later
+static const uint32_t MAX_SNAP_SHIFT = 2;
+
+struct Config {
+    const char* name;
+    int32_t min_position;
+    int32_t max_position;
+    float width_degrees;
+    float detent_strength_unit;
+    float snap_point;
+    float snap_point_bias;
+};
+
+// Representative of DemoPage's configs
+static const Config CONFIGS[] = {
+    {"Fine, with detents", 0, 255, 1, 1, 1.1, 0},
+    {"Coarse, strong detents", 0, 31, 8.225806452, 2, 1.1, 0},
+    {"On/off", 0, 1, 60, 1, 0.55, 0},
+    {"Return-to-center with detents", -6, 6, 60, 1, 0.55, 0.4},
+    {"Unbounded", 0, -1, 10, 1, 1.1, 0},
+};
+
+struct OperationErrors {
+    double angle;
+    double ratio;
+    double ewma;
+};
+
+template <typename Policy>
+static OperationErrors operationErrors() {
+    OperationErrors errors = {};
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> angle(-16 * 2 * M_PI, 16 * 2 * M_PI);
+    std::uniform_real_distribution<double> width_degrees(0.5, 60);
+    std::uniform_real_distribution<double> unit(-1.5, 1.5);
+    std::uniform_real_distribution<double> alpha(0, 0.01);
+    for (int i = 0; i < 1000000; i++) {
+        float a = angle(rng);
+        errors.angle = std::max(errors.angle, fabs(Policy::toFloat(Policy::fromFloat(a)) - (double)a));
+
+        float width = width_degrees(rng) * M_PI / 180;
+        float within = unit(rng) * width;
+        typename Policy::angle_t w = Policy::fromFloat(width);
+        errors.ratio = std::max(errors.ratio, fabs(Policy::ratio(Policy::fromFloat(within), w, Policy::inverse(w)) - (double)within / width));
+
+        float target = within + width * unit(rng);
+        float k = alpha(rng);
+        double expected = (double)within + ((double)target - within) * k;
+        errors.ewma = std::max(errors.ewma, fabs(Policy::toFloat(Policy::ewma(Policy::fromFloat(within), Policy::fromFloat(target), k)) - expected));
+    }
+    return errors;
+}
+
+template <typename Policy>
+static void operationCosts(double costs[3]) {
+    std::vector<float> angles(4096);
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> angle(-1, 1);
+    for (float& a : angles) {
+        a = angle(rng);
+    }
+    typename Policy::angle_t width = Policy::fromFloat(0.1f);
+    typename Policy::inverse_t inverse = Policy::inverse(width);
+    costs[0] = cyclesPerCall(BENCH_CALLS, [&](uint32_t i) { return (float)Policy::fromFloat(angles[i & 4095]); });
+    costs[1] = cyclesPerCall(BENCH_CALLS, [&](uint32_t i) { return Policy::ratio(Policy::fromFloat(angles[i & 4095]), width, inverse); });
+    typename Policy::angle_t state = 0;
+    costs[2] = cyclesPerCall(BENCH_CALLS, [&](uint32_t i) {
+        state = Policy::ewma(state, Policy::fromFloat(angles[i & 4095]), 0.001f);
+        return (float)state;
+    });
+}
+
+static PB_SmartKnobConfig toConfig(const Config& c) {
+    PB_SmartKnobConfig config = {};
+    config.min_position = c.min_position;
+    config.max_position = c.max_position;
+    config.position_width_radians = c.width_degrees * M_PI / 180;
+    config.detent_strength_unit = c.detent_strength_unit;
+    config.endstop_strength_unit = 1;
+    config.snap_point = c.snap_point;
+    config.snap_point_bias = c.snap_point_bias;
+    return config;
+}
+
+struct Input {
+    TurnAngle angle;
+    float velocity;
+};
+
+// Sweeps across all positions and past both ends, with noise, slow enough to stay below the torque cutoff
+static std::vector<Input> sweep(const PB_SmartKnobConfig& config) {
+    std::mt19937 rng(3);
+    const float width = config.position_width_radians;
+    int32_t positions = config.max_position >= config.min_position ? config.max_position - config.min_position + 1 : 100;
+    const float step = std::min(width * 0.2f, 0.01f);
+    std::normal_distribution<float> noise(0, 0.0005f);
+    std::vector<Input> inputs;
+    float angle = 0;
+    for (uint32_t s = 0; s < SWEEPS; s++) {
+        for (; angle < (positions + 2) * width; angle += step) {
+            inputs.push_back({TurnAngle{0, angle + noise(rng)}.normalized(), step * LOOP_HZ});
+        }
+        for (; angle > -2 * width; angle -= step) {
+            inputs.push_back({TurnAngle{0, angle + noise(rng)}.normalized(), -step * LOOP_HZ});
+        }
+    }
+    return inputs;
+}
+
+template <typename Policy>
+static void start(HapticController<Policy>& controller, const PB_SmartKnobConfig& config) {
+    controller.pid().output_ramp = 10000;
+    controller.begin({0, 0});
+    controller.setConfig(config, {0, 0});
+}
+
+int main() {
+    bool ok = true;
+
+    const OperationErrors float_errors = operationErrors<FloatPolicy>();
+    const OperationErrors fixed_errors = operationErrors<FixedQ16Policy>();
+    double float_costs[3], fixed_costs[3];
+    operationCosts<FloatPolicy>(float_costs);
+    operationCosts<FixedQ16Policy>(fixed_costs);
+    const char* const OPERATIONS[3] = {"angle (rad)", "ratio (unit)", "ewma (rad)"};
+    const double float_error[3] = {float_errors.angle, float_errors.ratio, float_errors.ewma};
+    const double fixed_error[3] = {fixed_errors.angle, fixed_errors.ratio, fixed_errors.ewma};
+    const double bounds[3] = {ANGLE_BOUND, RATIO_BOUND, EWMA_BOUND};
+
+    printf("%-14s %12s %12s %10s %10s %10s\n", "operation", "max error", "max error", "bound", "cycles", "cycles");
+    printf("%-14s %12s %12s %10s %10s %10s  (%s)\n", "", FloatPolicy::NAME, FixedQ16Policy::NAME, "", FloatPolicy::NAME, FixedQ16Policy::NAME, CYCLE_UNIT);
+    for (int i = 0; i < 3; i++) {
+        bool pass = float_error[i] <= bounds[i] && fixed_error[i] <= bounds[i];
+        ok &= pass;
+        printf("%-14s %12.3g %12.3g %10.3g %10.1f %10.1f  %s\n", OPERATIONS[i], float_error[i], fixed_error[i], bounds[i],
+            float_costs[i], fixed_costs[i], pass ? "ok" : "FAIL");
+    }
+
+    printf("\n%-30s %10s %10s %10s %10s %10s %9s %9s %9s\n", "config", "iterations", "drift rad", "torque err",
+        "sub-pos err", "positions", "shift", FloatPolicy::NAME, FixedQ16Policy::NAME);
+    for (const Config& c : CONFIGS) {
+        const PB_SmartKnobConfig config = toConfig(c);
+        const std::vector<Input> inputs = sweep(config);
+        static HapticController<FloatPolicy> reference;
+        static HapticController<FixedQ16Policy> fixed;
+        reference = HapticController<FloatPolicy>();
+        fixed = HapticController<FixedQ16Policy>();
+        start(reference, config);
+        start(fixed, config);
+
+        double torque_error = 0, sub_position_error = 0;
+        uint32_t position_mismatches = 0, mismatch_run = 0, max_mismatch_run = 0;
+        int32_t farthest = 0;
+        uint32_t now = 0;
+        bool agreed = true;
+        for (const Input& input : inputs) {
+            now += 1000000 / LOOP_HZ;
+            HapticOutput expected = reference.update({input.angle, input.velocity, now});
+            HapticOutput output = fixed.update({input.angle, input.velocity, now});
+            bool agree = output.current_position == expected.current_position;
+            // The iteration after a snap that differed still has the derivative kick of the snap
+            if (agree && agreed) {
+                torque_error = std::max(torque_error, (double)fabsf(output.torque - expected.torque));
+                sub_position_error = std::max(sub_position_error, (double)fabsf(output.sub_position_unit - expected.sub_position_unit));
+            }
+            position_mismatches += !agree;
+            mismatch_run = agree ? 0 : mismatch_run + 1;
+            max_mismatch_run = std::max(max_mismatch_run, mismatch_run);
+            farthest = std::max(farthest, abs(expected.current_position));
+            agreed = agree;
+        }
+        const float width = config.position_width_radians;
+        const double drift = fabs(FixedQ16Policy::toFloat(FixedQ16Policy::fromFloat(width)) - (double)width) * (farthest + 1);
+        const double angle_bound = drift + CONTROLLER_ROUNDING_RAD;
+        // The torque is P times the angle error, plus D times the change of that error over an iteration
+        const float p = 4 * std::max(config.detent_strength_unit, config.endstop_strength_unit);
+        const double torque_bound = (p + 2 * reference.pid().D * LOOP_HZ) * angle_bound;
+
+        start(reference, config);
+        start(fixed, config);
+        now = 0;
+        double float_cost = cyclesPerCall(BENCH_CALLS, [&](uint32_t i) {
+            const Input& input = inputs[i % inputs.size()];
+            return reference.update({input.angle, input.velocity, now += 1000000 / LOOP_HZ}).torque;
+        });
+        now = 0;
+        double fixed_cost = cyclesPerCall(BENCH_CALLS, [&](uint32_t i) {
+            const Input& input = inputs[i % inputs.size()];
+            return fixed.update({input.angle, input.velocity, now += 1000000 / LOOP_HZ}).torque;
+        });
+
+        bool pass = torque_error <= torque_bound && sub_position_error <= angle_bound / width && max_mismatch_run <= MAX_SNAP_SHIFT;
+        ok &= pass;
+        printf("%-30s %10zu %10.3g %10.3g %10.3g %10u %9u %9.1f %9.1f  %s\n", c.name, inputs.size(), drift, torque_error,
+            sub_position_error, position_mismatches, max_mismatch_run, float_cost, fixed_cost, pass ? "ok" : "FAIL");
+    }
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/**
+ * End-to-end check of the position events (firmware/src/position_events.h): a knob spun fast through the
+ * haptic controller, whose position changes a producer thread queues as the motor task does, drained by a
+ * slower consumer thread as the interface task does.
+ *
+ * Build (from the repository root; the nanopb submodule provides pb.h):
+ *   g++ -std=gnu++17 -O2 -pthread -Ifirmware/src -Ithirdparty/nanopb software/tools/position_event_sim.cpp \
+ *     firmware/src/haptics/haptic_controller.cpp firmware/src/haptics/detent_config.cpp \
+ *     firmware/src/haptics/torque_profile.cpp firmware/src/haptics/detent_index.cpp \
+ *     firmware/src/haptics/position_map.cpp -o position_event_sim
+ *
+ * Usage:
+ *   position_event_sim
+ *
+ * The producer turns the shaft at a constant speed for a few seconds, then holds it, updating the controller
+ * at the motor loop rate and publishing a PositionEvent for every update that moved the position; paced to
+ * real time, or as fast as it can, which outruns the consumer. The consumer wakes up every few hundred
+ * microseconds to a few milliseconds, so unpaced, the queue fills up and events are merged. It
+ * counts the steps as the host's PB_SmartKnobState.position_steps, and the position as VolumePage does.
+ * For 20 rev/s through 2.4 degree detents (3000 positions a second, 6 per loop iteration), in both directions,
+ * with either numeric policy, across an infinite scroll wrap, and 30 rev/s through 1 degree detents,
+ * checks that:
+ *  - the steps the consumer counted are the steps the controller took: no step is lost
+ *  - the steps add up to the controller's change of position (modulo the range for an infinite scroll)
+ *  - the page's position ends at the controller's
+ *  - during the spin, the shaft never gets further than the snap point from the detent center, so the
+ *    position keeps up with the shaft
+ * Exits with 1 if any of these fails.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "haptics/haptic_controller.h"
+#include "position_events.h"
+
+// As the motor task's default
+static const uint32_t LOOP_HZ = 2000;
+static const uint32_t CONFIG_GENERATION = 2;
+static const float SNAP_POINT = 1.1;
+
+struct Case {
+    const char* name;
+    float width_degrees;
+    bool infinite_scroll;
+    double revolutions_per_second;
+    double spin_seconds;
+    uint32_t consumer_sleep_micros;
+    // Run the producer at the motor loop rate in real time
+    bool paced;
+};
+
+struct Outcome {
+    int64_t produced_steps = 0;
+    int64_t consumed_steps = 0;
+    uint32_t events = 0;
+    int32_t final_position = 0;
+    int32_t page_position = 0;
+    // Largest distance of the shaft from the detent center, in positions
+    double max_lag = 0;
+};
+
+template <typename Policy>
+static Outcome run(const Case& c) {
+    PB_SmartKnobConfig config = {};
+    config.min_position = 0;
+    // Unbounded, unless an infinite scroll over 10 positions
+    config.max_position = c.infinite_scroll ? 9 : -1;
+    config.infinite_scroll = c.infinite_scroll;
+    config.position_width_radians = c.width_degrees * M_PI / 180;
+    config.detent_strength_unit = 1;
+    config.endstop_strength_unit = 1;
+    config.snap_point = SNAP_POINT;
+
+    HapticController<Policy> controller;
+    controller.begin({0, 0});
+    controller.setConfig(config, {0, 0});
+    PositionEventQueue events;
+    Outcome outcome;
+
+    // The interface task: the host's step count, and the position as a page counts it from the events
+    std::atomic<bool> done = false;
+    std::thread consumer([&] {
+        PositionEvent event;
+        bool has_position = false;
+        while (true) {
+            bool finished = done.load();
+            bool any = false;
+            while (events.read(event)) {
+                if (!has_position) {
+                    outcome.page_position = event.old_position;
+                    has_position = true;
+                }
+                outcome.page_position += event.steps;
+                outcome.consumed_steps += event.steps;
+                outcome.events++;
+                any = true;
+            }
+            if (finished && !any) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(c.consumer_sleep_micros));
+        }
+    });
+
+    // The motor task
+    const double velocity = c.revolutions_per_second * 2 * M_PI;
+    const uint32_t period_micros = 1000000 / LOOP_HZ;
+    const uint32_t spin_iterations = c.spin_seconds * LOOP_HZ;
+    uint32_t now_micros = 1000;
+    double angle = 0;
+    auto next_iteration = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < spin_iterations + 2 * LOOP_HZ; i++) {
+        now_micros += period_micros;
+        bool spinning = i < spin_iterations;
+        if (spinning) {
+            angle += velocity / LOOP_HZ;
+        }
+        double turns = floor(angle / (2 * M_PI));
+        TurnAngle shaft = {(int32_t)turns, (float)(angle - turns * 2 * M_PI)};
+        int32_t previous_position = controller.currentPosition();
+        HapticOutput output = controller.update({shaft, spinning ? (float)velocity : 0.f, now_micros});
+        if (output.position_steps != 0) {
+            events.publish({
+                .timestamp_micros = now_micros,
+                .old_position = previous_position,
+                .new_position = output.current_position,
+                .steps = output.position_steps,
+                .velocity = spinning ? (float)velocity : 0.f,
+                .config_generation = CONFIG_GENERATION,
+            });
+            outcome.produced_steps += output.position_steps;
+        }
+        events.flush();
+        if (spinning) {
+            double lag = fabs(controller.frameAngle(shaft) - controller.detentCenter()) / config.position_width_radians;
+            outcome.max_lag = std::max(outcome.max_lag, lag);
+        }
+        if (c.paced) {
+            next_iteration += std::chrono::microseconds(period_micros);
+            std::this_thread::sleep_until(next_iteration);
+        } else if (i % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    // The motor loop keeps flushing; wait for a pending event to fit
+    for (int i = 0; i < 1000; i++) {
+        events.flush();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    done = true;
+    consumer.join();
+
+    outcome.final_position = controller.currentPosition();
+    return outcome;
+}
+
+int main() {
+    const Case cases[] = {
+        {"20 rev/s, 2.4 deg, in real time", 2.4f, false, 20, 1, 200, true},
+        {"20 rev/s, 2.4 deg", 2.4f, false, 20, 3, 200, false},
+        {"20 rev/s backwards, 2.4 deg", 2.4f, false, -20, 3, 200, false},
+        {"20 rev/s, 2.4 deg, slow consumer", 2.4f, false, 20, 3, 2000, false},
+        {"20 rev/s, 2.4 deg, infinite scroll", 2.4f, true, 20, 3, 1000, false},
+        {"30 rev/s, 1 deg", 1.0f, false, 30, 2, 500, false},
+    };
+
+    bool ok = true;
+    printf("%-36s %-7s %9s %9s %7s %8s %8s %5s\n", "case", "policy", "produced", "consumed", "events", "position", "page", "lag");
+    for (const Case& c : cases) {
+        for (int fixed = 0; fixed < 2; fixed++) {
+            Outcome outcome = fixed ? run<FixedQ16Policy>(c) : run<FloatPolicy>(c);
+            // Positions the controller moved from its start at 0
+            int64_t moved = c.infinite_scroll ? ((outcome.produced_steps % 10) + 10) % 10 : outcome.produced_steps;
+            bool pass = outcome.consumed_steps == outcome.produced_steps && moved == outcome.final_position
+                && (c.infinite_scroll || outcome.page_position == outcome.final_position) && outcome.max_lag <= SNAP_POINT + 0.01;
+            ok &= pass;
+            printf("%-36s %-7s %9lld %9lld %7u %8d %8d %5.2f  %s\n", c.name, fixed ? "Q16" : "float",
+                (long long)outcome.produced_steps, (long long)outcome.consumed_steps, outcome.events,
+                outcome.final_position, outcome.page_position, outcome.max_lag, pass ? "ok" : "FAIL");
+        }
+    }
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/**
+ * Measures the position map of the firmware (firmware/src/haptics/position_map.h): the cost of
+ * finding the position at an angle, which the haptic loop does whenever the knob leaves its
+ * position, for every curve at 16 to 256 positions and in both numeric policies.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/position_map_bench.cpp firmware/src/haptics/position_map.cpp -o position_map_bench
+ *
+ * Usage:
+ *   position_map_bench
+ *
+ * Angles are either random over the whole range (a worst case for the branch predictor and
+ * cache) or a slow sweep, as when turning the knob. The uniform column is the division that finds
+ * the position for uniform detents. Timings are of the host, not the ESP32, so only compare them
+ * with each other.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "haptics/position_map.h"
+
+static const size_t LOOKUPS = 20000000;
+static const float AVERAGE_WIDTH = 1.5 * M_PI / 180;
+
+struct Curve {
+    const char* name;
+    PositionMapCurve curve;
+};
+
+static const float SEGMENT_WIDTHS[] = {4, 1, 1, 4};
+
+static const Curve CURVES[] = {
+    {"power 2", {PositionCurve::POWER, 2, nullptr, 0}},
+    {"power 0.5", {PositionCurve::POWER, 0.5, nullptr, 0}},
+    {"log 20", {PositionCurve::LOGARITHMIC, 20, nullptr, 0}},
+    {"piecewise 4:1:1:4", {PositionCurve::PIECEWISE, 0, SEGMENT_WIDTHS, 4}},
+};
+
+// Returns nanoseconds per call of lookup over the given probe angles
+template <typename T, typename Lookup>
+static double timeLookups(const std::vector<T>& probes, Lookup lookup) {
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        sum += lookup(probes[i & (probes.size() - 1)]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    // Keeps the lookups from being optimized away
+    if (sum == UINT64_MAX) {
+        printf("\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / LOOKUPS;
+}
+
+template <typename Policy>
+static bool bench(const char* policy_name, const Curve& curve, uint16_t count, std::mt19937& rng) {
+    using angle_t = typename Policy::angle_t;
+    static PositionMap<Policy> map;
+    if (!map.build(curve.curve, count, AVERAGE_WIDTH, 0.5, 0, 0, false)) {
+        fprintf(stderr, "Failed to build %s with %u positions\n", curve.name, count);
+        return false;
+    }
+
+    // Verify against a linear scan over the position extents
+    const float first_edge = -Policy::toFloat(map.width(0)) / 2;
+    const float last_edge = Policy::toFloat(map.center(count - 1)) + Policy::toFloat(map.width(count - 1)) / 2;
+    for (float angle = first_edge - 0.01f; angle < last_edge + 0.01f; angle += 1e-4f) {
+        angle_t a = Policy::fromFloat(angle);
+        uint16_t expected = 0;
+        while (expected + 1 < count && a >= map.center(expected) + map.width(expected) / 2) {
+            expected++;
+        }
+        // Boundaries are rounded once, extents per position, so allow a neighbour right at a boundary
+        uint16_t found = map.find(a);
+        if (found != expected && fabsf(Policy::toFloat(map.center(expected) + map.width(expected) / 2 - a)) > 1e-4f
+                && fabsf(Policy::toFloat(map.center(expected) - map.width(expected) / 2 - a)) > 1e-4f) {
+            fprintf(stderr, "Mismatch at %f rad (%s, %u positions): %u instead of %u\n", angle, curve.name, count, found, expected);
+            return false;
+        }
+    }
+
+    std::vector<angle_t> random(4096);
+    std::uniform_real_distribution<float> any(first_edge, last_edge);
+    for (angle_t& a : random) {
+        a = Policy::fromFloat(any(rng));
+    }
+    // A sweep covers the range back and forth over the probes, a few probes per position
+    std::vector<angle_t> sweep(4096);
+    for (size_t i = 0; i < sweep.size(); i++) {
+        float u = i < sweep.size() / 2 ? 2.0f * i / sweep.size() : 2.0f - 2.0f * i / sweep.size();
+        sweep[i] = Policy::fromFloat(first_edge + u * (last_edge - first_edge));
+    }
+
+    double random_ns = timeLookups(random, [&](angle_t a) { return map.find(a); });
+    double sweep_ns = timeLookups(sweep, [&](angle_t a) { return map.find(a); });
+    const typename Policy::inverse_t inverse = Policy::inverse(Policy::fromFloat(AVERAGE_WIDTH));
+    double uniform_ns = timeLookups(random, [&](angle_t a) {
+        return (int32_t)floorf(Policy::ratio(a, Policy::fromFloat(AVERAGE_WIDTH), inverse) + 0.5f);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    map.build(curve.curve, count, AVERAGE_WIDTH, 0.5, 0, 0, false);
+    double build_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-6s %-18s %9u %10.2f %10.2f %10.2f %10.1f\n",
+        policy_name, curve.name, count, random_ns, sweep_ns, uniform_ns, build_us);
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    printf("%-6s %-18s %9s %10s %10s %10s %10s\n",
+        "policy", "curve", "positions", "random ns", "sweep ns", "uniform ns", "build us");
+
+    for (const Curve& curve : CURVES) {
+        for (uint16_t count : {16, 64, 256}) {
+            if (!bench<FloatPolicy>("float", curve, count, rng) || !bench<FixedQ16Policy>("q16", curve, count, rng)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
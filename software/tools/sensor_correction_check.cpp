@@ -0,0 +1,170 @@
+/**
+ * Checks the sensor angle correction (firmware/src/sensor_correction.h): the fit of its harmonics to
+ * synthetic sensor errors, the accuracy of its lookup table, and the cost of a lookup.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/sensor_correction_check.cpp firmware/src/sensor_correction.cpp \
+ *     -o sensor_correction_check
+ *
+ * Usage:
+ *   sensor_correction_check
+ *
+ * Each case is a sensor error made of known harmonics (an eccentric magnet is the first, sensor
+ * nonlinearity the higher ones), sampled evenly over whole revolutions as the motor calibration does,
+ * with a constant offset and the reading's noise and 14-bit quantization added. Checks that:
+ *  - SensorCorrectionFit recovers every coefficient within a few times the noise left after averaging
+ *  - the correction built from the fit leaves at most a few percent of the error, beyond the quantization
+ *  - the table lookup matches the series evaluated directly within its interpolation error
+ *  - a fit without samples fails, and without a correction set the raw angle passes through
+ * Prints the cost per lookup, in CPU cycles where the host has a cycle counter (x86 TSC), otherwise in
+ * nanoseconds, of the table and of evaluating the series directly. Host cycles only compare the two.
+ * Exits with 1 if any of these fails.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "sensor_correction.h"
+
+#include "tool_check.h"
+
+#include "tool_check.h"
+
+static const uint8_t HARMONICS = SensorCorrection::MAX_HARMONICS;
+static const double COUNT_RAD = 2 * M_PI / 16384;
+static const uint32_t BENCH_CALLS = 1 << 24;
+// Largest error left by the correction, as a fraction of the error without it
+static const double MAX_RESIDUAL_FRACTION = 0.05;
+
+struct Case {
+    const char* name;
+    // Coefficients of the error, k = 1..HARMONICS
+    float cos_coefficients[HARMONICS];
+    float sin_coefficients[HARMONICS];
+    double offset;
+    double noise;
+    // Whole revolutions sampled, and samples per revolution
+    uint32_t revolutions;
+    uint32_t samples_per_revolution;
+};
+
+static double seriesError(const Case& c, double angle) {
+    double error = 0;
+    for (uint8_t k = 1; k <= HARMONICS; k++) {
+        error += c.cos_coefficients[k - 1] * cos(k * angle) + c.sin_coefficients[k - 1] * sin(k * angle);
+    }
+    return error;
+}
+
+// Cycles per call of f, over raw angles stepping around the turn
+template <typename F>
+static double cyclesPerLookup(F f) {
+    float angle = 0.1f;
+    return cyclesPerCall(BENCH_CALLS, [&](uint32_t) {
+        float result = f(angle);
+        angle += 0.000613f;
+        if (angle >= 2 * (float)M_PI) {
+            angle -= 2 * (float)M_PI;
+        }
+        return result;
+    });
+}
+
+int main() {
+    char what[128];
+    bool ok = true;
+    const double deg = 180 / M_PI;
+
+    // Angles in radians: 0.02 rad of eccentricity is about 1.1 degrees
+    const Case cases[] = {
+        {"eccentric magnet", {0.02f, 0, 0, 0}, {0.01f, 0, 0, 0}, 0, 0.0005, 1, 10000},
+        {"eccentricity and 2nd harmonic", {0.02f, 0.004f, 0, 0}, {-0.01f, 0.008f, 0, 0}, 0.3, 0.0005, 1, 10000},
+        {"all harmonics, offset", {0.015f, -0.006f, 0.003f, 0.001f}, {0.01f, 0.004f, -0.002f, 0.0015f}, -1.2, 0.0005, 2, 6000},
+        {"all harmonics, noisy sensor", {0.015f, -0.006f, 0.003f, 0.001f}, {0.01f, 0.004f, -0.002f, 0.0015f}, 0, 0.002, 2, 6000},
+        {"no error", {0, 0, 0, 0}, {0, 0, 0, 0}, 0.5, 0.0005, 1, 10000},
+    };
+    std::mt19937 rng(1);
+    for (const Case& c : cases) {
+        std::normal_distribution<double> noise(0, c.noise);
+        std::uniform_real_distribution<double> start_angle(0, 2 * M_PI);
+        SensorCorrectionFit fit;
+        const uint32_t samples = c.revolutions * c.samples_per_revolution;
+        const double start = start_angle(rng);
+        for (uint32_t i = 0; i < samples; i++) {
+            // Raw reading at an evenly spaced angle, and its error against the commanded angle
+            double raw = fmod(start + 2 * M_PI * i / c.samples_per_revolution, 2 * M_PI);
+            double measured = floor((raw + seriesError(c, raw) + noise(rng)) / COUNT_RAD) * COUNT_RAD;
+            fit.add((float)raw, (float)(measured - raw + c.offset));
+        }
+        float cos_fit[HARMONICS], sin_fit[HARMONICS];
+        fit.solve(cos_fit, sin_fit);
+        double coefficient_error = 0;
+        for (uint8_t k = 0; k < HARMONICS; k++) {
+            coefficient_error = fmax(coefficient_error, fabs(cos_fit[k] - c.cos_coefficients[k]));
+            coefficient_error = fmax(coefficient_error, fabs(sin_fit[k] - c.sin_coefficients[k]));
+        }
+        // The noise and quantization averaged over the samples, a few standard deviations of it
+        const double noise_left = 4 * sqrt(2.0 * (c.noise * c.noise + COUNT_RAD * COUNT_RAD / 12) / samples);
+        snprintf(what, sizeof(what), "%s: coefficients within %.2g rad (bound %.2g)", c.name, coefficient_error, noise_left);
+        ok &= check(fit.count() == samples && coefficient_error < noise_left, what);
+
+        // Corrected readings over a revolution, without noise, against the true angle
+        SensorCorrection correction;
+        correction.set(cos_fit, sin_fit, HARMONICS);
+        double before = 0, after = 0;
+        for (uint32_t i = 0; i < 3600; i++) {
+            double angle = 2 * M_PI * i / 3600;
+            double raw = fmod(angle + seriesError(c, angle) + 2 * M_PI, 2 * M_PI);
+            before = fmax(before, fabs(remainder(raw - angle, 2 * M_PI)));
+            after = fmax(after, fabs(remainder(correction.apply((float)raw) - angle, 2 * M_PI)));
+        }
+        snprintf(what, sizeof(what), "%s: max error %.3f deg before, %.4f deg after", c.name, before * deg, after * deg);
+        ok &= check(after <= MAX_RESIDUAL_FRACTION * before + noise_left + COUNT_RAD, what);
+    }
+
+    // The table against the series it is built from: linear interpolation is off by at most
+    // h^2/8 times the largest second derivative, which for harmonic k of amplitude A is A*k^2
+    const Case& full = cases[2];
+    SensorCorrection correction;
+    correction.set(full.cos_coefficients, full.sin_coefficients, HARMONICS);
+    const double step = 2 * M_PI / SensorCorrection::TABLE_SIZE;
+    double interpolation_bound = 0;
+    for (uint8_t k = 1; k <= HARMONICS; k++) {
+        interpolation_bound += hypot(full.cos_coefficients[k - 1], full.sin_coefficients[k - 1]) * k * k * step * step / 8;
+    }
+    // Plus float rounding of angles near 2PI
+    interpolation_bound += 4e-7;
+    double table_error = 0, series_max = 0;
+    for (uint32_t i = 0; i <= 100000; i++) {
+        float raw = std::min((float)(2 * M_PI * i / 100000), 2 * (float)M_PI);
+        float direct = raw - SensorCorrection::error(full.cos_coefficients, full.sin_coefficients, HARMONICS, raw);
+        table_error = fmax(table_error, fabs(remainderf(correction.apply(raw) - direct, 2 * (float)M_PI)));
+        series_max = fmax(series_max, fabs(seriesError(full, raw)));
+    }
+    snprintf(what, sizeof(what), "table against the series: %.2g rad (bound %.2g), max error %.4f of %.4f rad",
+        table_error, interpolation_bound, correction.maxError(), series_max);
+    ok &= check(table_error <= interpolation_bound && correction.maxError() <= series_max + 1e-6
+        && correction.maxError() > 0.99 * series_max, what);
+
+    SensorCorrectionFit empty;
+    float unused[HARMONICS];
+    SensorCorrection disabled;
+    ok &= check(!empty.solve(unused, unused) && !disabled.enabled() && disabled.apply(1.25f) == 1.25f,
+        "no samples: no fit; no correction: raw angle passes through");
+
+    double none = cyclesPerLookup([](float a) { return a; });
+    double table = cyclesPerLookup([&](float a) { return correction.apply(a); });
+    double series = cyclesPerLookup([&](float a) {
+        float corrected = a - SensorCorrection::error(full.cos_coefficients, full.sin_coefficients, HARMONICS, a);
+        return corrected < 0 ? corrected + 2 * (float)M_PI : corrected;
+    });
+    printf("\n%-34s %10s\n", "per lookup", CYCLE_UNIT);
+    printf("%-34s %10.1f\n", "loop alone", none);
+    printf("%-34s %10.1f\n", "table (apply)", table);
+    printf("%-34s %10.1f\n", "series, 4 harmonics", series);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
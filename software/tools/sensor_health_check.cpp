@@ -0,0 +1,277 @@
+/**
+ * Checks the sensor health accounting (firmware/src/sensor_health.h) with synthetic MT6701 frames, sent
+ * through the driver's decoding (firmware/src/mt6701_frame.h) as MT6701Sensor::processFrame() does, and
+ * measures its cost per reading.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/sensor_health_check.cpp -o sensor_health_check
+ *
+ * Usage:
+ *   sensor_health_check
+ *
+ * Frames arrive at the sampling rate, each followed by a motor loop iteration half a period later. The
+ * stream is clean, then flags field strength and loss of track, fails CRCs and reads all zeros or all ones
+ * here and there, then has a burst of CRC errors, a silence of the sensor and a burst of all-zero frames (the
+ * data line stuck low); the clock starts right before the wrap of micros(). Checks that:
+ *  - every window reports exactly the readings, flags and stale iterations that were injected into it,
+ *    and the totals add up; a reading with a bad CRC only counts as a CRC error, whatever it flags, and an
+ *    all-zero or all-ones frame only as stuck, though all zeros passes the CRC
+ *  - the torque is gated on exactly the iterations whose latest valid reading is older than the threshold,
+ *    so that a burst of CRC errors or stuck frames stops the motor like a silent sensor does
+ *  - a reading newer than the iteration counts as fresh, and nothing is reported before the first window
+ *  - every report says whether the driver reports its readings, as set before begin(), so that a sensor
+ *    without one (the MAQ430, the TLV493D) doesn't pass for a healthy one
+ * Exits with 1 if any of these fails.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "mt6701_frame.h"
+#include "sensor_health.h"
+
+#include "tool_check.h"
+
+// As the firmware's defaults (mt6701_frame.h, sensor_health.h)
+static const uint32_t SAMPLE_PERIOD_MICROS = 1000000 / 2000;
+static const uint32_t WINDOW_MICROS = SK_SENSOR_HEALTH_WINDOW_MILLIS * 1000;
+static const uint32_t STALE_MICROS = SK_SENSOR_STALE_MICROS;
+static const uint32_t START_MICROS = 0xFFFFFFFFu - 1500000;
+static const uint32_t BENCH_READINGS = 1 << 22;
+
+enum class FrameKind {
+    GOOD,
+    CRC_ERROR,
+    FIELD_TOO_WEAK,
+    FIELD_TOO_STRONG,
+    LOSS_OF_TRACK,
+    WEAK_AND_LOSS,
+    CRC_ERROR_WEAK, // Flags a weak field, but fails its CRC
+    STUCK_LOW,      // All zeros, which passes the CRC
+    STUCK_HIGH,     // All ones
+    MISSING,        // The sensor didn't answer
+};
+
+static bool sameCounts(const SensorHealthCounts& a, const SensorHealthCounts& b) {
+    return memcmp(&a, &b, sizeof(SensorHealthCounts)) == 0;
+}
+
+/**
+ * The driver and the motor loop around a SensorHealth, with the counts expected from what was injected
+ * kept alongside.
+ */
+class Simulation {
+    public:
+        Simulation() : now_(START_MICROS), sample_micros_(START_MICROS), expected_valid_micros_(START_MICROS) {
+            health_.setReadingsReported(true);
+            health_.begin(now_, WINDOW_MICROS, STALE_MICROS);
+            initial_report_ = health_.report();
+        }
+
+        // One sample period: the frame (if any), then a motor loop iteration
+        void step(FrameKind kind, uint16_t count) {
+            if (kind != FrameKind::MISSING) {
+                receive(kind, count);
+            }
+
+            uint32_t loop_micros = now_ + SAMPLE_PERIOD_MICROS / 2;
+            bool fresh = health_.checkAge(sample_micros_, loop_micros);
+            uint32_t expected_age = loop_micros - expected_valid_micros_;
+            bool expected_stale = expected_age > STALE_MICROS;
+            if (fresh == expected_stale) {
+                gate_mismatches_++;
+            }
+            expected_.max_age_micros = expected_age > expected_.max_age_micros ? expected_age : expected_.max_age_micros;
+            expected_.stale_iterations += expected_stale;
+            if (health_.update(loop_micros)) {
+                reports_.push_back(health_.report());
+                expected_windows_.push_back(expected_);
+                expected_ = {};
+            }
+            now_ += SAMPLE_PERIOD_MICROS;
+        }
+
+        const std::vector<SensorHealthReport>& reports() const { return reports_; }
+        const std::vector<SensorHealthCounts>& expectedWindows() const { return expected_windows_; }
+        const SensorHealthReport& initialReport() const { return initial_report_; }
+        uint32_t gateMismatches() const { return gate_mismatches_; }
+
+    private:
+        SensorHealth health_;
+        uint32_t now_;
+        // As MT6701Sensor::sampleMicros(): when the latest valid frame was received
+        uint32_t sample_micros_;
+        int32_t last_count_ = MT6701::NO_COUNT;
+
+        uint32_t expected_valid_micros_;
+        SensorHealthCounts expected_ = {};
+        std::vector<SensorHealthCounts> expected_windows_;
+        std::vector<SensorHealthReport> reports_;
+        SensorHealthReport initial_report_;
+        uint32_t gate_mismatches_ = 0;
+
+        void receive(FrameKind kind, uint16_t count) {
+            MT6701FieldStatus field = MT6701FieldStatus::NORMAL;
+            if (kind == FrameKind::FIELD_TOO_WEAK || kind == FrameKind::WEAK_AND_LOSS || kind == FrameKind::CRC_ERROR_WEAK) {
+                field = MT6701FieldStatus::TOO_WEAK;
+            } else if (kind == FrameKind::FIELD_TOO_STRONG) {
+                field = MT6701FieldStatus::TOO_STRONG;
+            }
+            bool loss = kind == FrameKind::LOSS_OF_TRACK || kind == FrameKind::WEAK_AND_LOSS;
+            uint32_t bits = MT6701::encode(count, field, false, loss);
+            bool corrupt = kind == FrameKind::CRC_ERROR || kind == FrameKind::CRC_ERROR_WEAK;
+            if (corrupt) {
+                // A bit of the angle flipped on the wire
+                bits ^= 1 << 15;
+            }
+            bool stuck = kind == FrameKind::STUCK_LOW || kind == FrameKind::STUCK_HIGH;
+            if (stuck) {
+                bits = kind == FrameKind::STUCK_LOW ? 0 : MT6701::FRAME_MASK;
+            }
+
+            // As MT6701Sensor::processFrame()
+            MT6701Reading reading = MT6701::decode(bits, last_count_);
+            health_.recordSample(MT6701::healthFlags(reading));
+            if (reading.valid()) {
+                sample_micros_ = now_;
+                last_count_ = reading.count;
+            }
+
+            expected_.samples++;
+            if (stuck) {
+                expected_.stuck_frames++;
+                return;
+            }
+            if (corrupt) {
+                expected_.crc_errors++;
+                return;
+            }
+            expected_valid_micros_ = now_;
+            expected_.field_too_weak += field == MT6701FieldStatus::TOO_WEAK;
+            expected_.field_too_strong += field == MT6701FieldStatus::TOO_STRONG;
+            expected_.loss_of_track += loss;
+        }
+};
+
+static FrameKind scatteredFault(uint32_t i) {
+    switch (i % 50) {
+        case 0: return FrameKind::CRC_ERROR;
+        case 10: return FrameKind::FIELD_TOO_WEAK;
+        case 20: return FrameKind::FIELD_TOO_STRONG;
+        case 25: return FrameKind::STUCK_LOW;
+        case 30: return FrameKind::LOSS_OF_TRACK;
+        case 35: return FrameKind::STUCK_HIGH;
+        case 40: return FrameKind::WEAK_AND_LOSS;
+        case 45: return FrameKind::CRC_ERROR_WEAK;
+        default: return FrameKind::GOOD;
+    }
+}
+
+static bool checkWindows() {
+    // Frames with a bad CRC, frames missing altogether, then all-zero frames
+    const uint32_t CRC_BURST = 20;
+    const uint32_t SILENCE = 30;
+    const uint32_t STUCK_BURST = 30;
+
+    Simulation simulation;
+    uint32_t i = 0;
+    auto run = [&](uint32_t frames, FrameKind (*kind)(uint32_t)) {
+        for (uint32_t end = i + frames; i < end; i++) {
+            // Clear of count 0, where a good frame can be all zeros (mt6701_frame_check covers that)
+            simulation.step(kind(i), (uint16_t)(100 + i * 37 % 16000));
+        }
+    };
+    run(2000, [](uint32_t) { return FrameKind::GOOD; });
+    run(1000, scatteredFault);
+    run(1000, [](uint32_t) { return FrameKind::GOOD; });
+    run(CRC_BURST, [](uint32_t) { return FrameKind::CRC_ERROR; });
+    run(1980, [](uint32_t) { return FrameKind::GOOD; });
+    run(SILENCE, [](uint32_t) { return FrameKind::MISSING; });
+    run(1970, [](uint32_t) { return FrameKind::GOOD; });
+    run(STUCK_BURST, [](uint32_t) { return FrameKind::STUCK_LOW; });
+    run(3970, [](uint32_t) { return FrameKind::GOOD; });
+
+    bool ok = true;
+    const SensorHealthReport& initial = simulation.initialReport();
+    ok &= check(initial.window_micros == 0 && sameCounts(initial.total, {}), "nothing reported before the first window");
+    bool all_reported = initial.readings_reported;
+    for (const SensorHealthReport& report : simulation.reports()) {
+        all_reported &= report.readings_reported;
+    }
+    ok &= check(all_reported, "with the driver reporting its readings, every report says so");
+
+    const std::vector<SensorHealthReport>& reports = simulation.reports();
+    const std::vector<SensorHealthCounts>& expected = simulation.expectedWindows();
+    char what[128];
+    snprintf(what, sizeof(what), "%u frames: %zu windows", i, reports.size());
+    ok &= check(reports.size() == 5, what);
+
+    SensorHealthCounts total = {};
+    for (size_t w = 0; w < reports.size(); w++) {
+        const SensorHealthCounts& counts = reports[w].window;
+        total.add(expected[w]);
+        snprintf(what, sizeof(what), "window %zu (%u us): %u readings, %u CRC, %u stuck, %u/%u field, %u loss, age %u, %u stale",
+            w, reports[w].window_micros, counts.samples, counts.crc_errors, counts.stuck_frames, counts.field_too_strong, counts.field_too_weak,
+            counts.loss_of_track, counts.max_age_micros, counts.stale_iterations);
+        bool window_ok = sameCounts(counts, expected[w]) && sameCounts(reports[w].total, total)
+            && reports[w].window_micros >= WINDOW_MICROS && reports[w].window_micros < WINDOW_MICROS + SAMPLE_PERIOD_MICROS;
+        ok &= check(window_ok, what);
+    }
+
+    // The reading goes stale once the last valid one is older than STALE_MICROS: at the iteration half a
+    // period after the (STALE_MICROS / SAMPLE_PERIOD_MICROS)th frame that didn't bring one, until the
+    // iteration after the next valid frame
+    uint32_t stale_per_gap = STALE_MICROS / SAMPLE_PERIOD_MICROS - 1;
+    uint32_t expected_stale = (CRC_BURST - stale_per_gap) + (SILENCE - stale_per_gap) + (STUCK_BURST - stale_per_gap);
+    snprintf(what, sizeof(what), "torque gated on %u iterations (%u expected), %u mismatches",
+        total.stale_iterations, expected_stale, simulation.gateMismatches());
+    ok &= check(total.stale_iterations == expected_stale && simulation.gateMismatches() == 0, what);
+    return ok;
+}
+
+static bool checkAgeEdges() {
+    SensorHealth health;
+    health.begin(1000, 1000, STALE_MICROS);
+    bool fresh = health.checkAge(1100, 1000);
+    bool at_threshold = health.checkAge(1000, 1000 + STALE_MICROS);
+    bool past_threshold = !health.checkAge(1000, 1001 + STALE_MICROS);
+    health.update(2000 + STALE_MICROS);
+    SensorHealthReport report = health.report();
+    bool ok = check(fresh && at_threshold && past_threshold && report.window.stale_iterations == 1
+        && report.window.max_age_micros == STALE_MICROS + 1 && report.stale,
+        "a reading newer than the iteration is fresh; stale only past the threshold");
+    // Only the age was checked, as for a sensor whose driver doesn't report its readings
+    ok &= check(!report.readings_reported && report.window.samples == 0, "without a driver reporting readings, the report says so");
+    return ok;
+}
+
+static void bench() {
+    SensorHealth health;
+    health.begin(0);
+    std::vector<uint8_t> flags(4096);
+    for (size_t i = 0; i < flags.size(); i++) {
+        flags[i] = MT6701::healthFlags(MT6701::decode(scatteredFault(i) == FrameKind::CRC_ERROR ? 1 : MT6701::encode(i)));
+    }
+    uint32_t now = 0;
+    uint32_t fresh = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_READINGS; i++) {
+        health.recordSample(flags[i & 4095]);
+        fresh += health.checkAge(now, now + 250);
+        health.update(now);
+        now += SAMPLE_PERIOD_MICROS;
+    }
+    double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("per reading and iteration: %.1f ns (%u fresh)\n", nanos / BENCH_READINGS, fresh);
+}
+
+int main() {
+    bool ok = true;
+    ok &= checkWindows();
+    ok &= checkAgeEdges();
+    bench();
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
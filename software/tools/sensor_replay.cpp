@@ -0,0 +1,301 @@
+/**
+ * Replays a raw sensor capture (SensorCaptureFrames, as written by software/python/sensor_capture.py)
+ * through the MT6701 driver's decoding, CRC check and filter (firmware/src/mt6701_frame.h and
+ * mt6701_filter.h), exactly as the driver processes the frames, and reports on the sensor and the filter.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/sensor_replay.cpp -o sensor_replay
+ *
+ * Usage:
+ *   sensor_replay [-t <trace>] [-b <baseline trace>] <capture file>
+ *
+ * Options:
+ *   -t <trace>           write the replay as CSV, one row per frame: the frame, its decoding and the
+ *                        filtered angle (radians, in the driver's direction) after it
+ *   -b <baseline trace>  compare the filtered angles with a trace written by another build of this tool
+ *                        from the same capture, to A/B a change of the filter on recorded data
+ *
+ * Prints:
+ *  - the sampling: rate, and the jitter and gaps of the interval between frames
+ *  - the sensor's status: CRC errors, stuck frames (all zeros or all ones), field strength warnings, loss of track
+ *  - noise of the raw and filtered angle, estimated from second differences (so turning at a steady
+ *    speed isn't counted as noise), in counts (1/16384 turn)
+ *  - lag of the filter behind the raw readings while the knob turns, from a least-squares fit
+ *
+ * Replaying the same capture always gives the same trace, so two builds can be compared row by row.
+ * Exits with 1 if the capture can't be read, or if the trace differs from the baseline.
+ */
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "mt6701_filter.h"
+#include "mt6701_frame.h"
+#include "sensor_capture.h"
+
+// Intervals above this multiple of the mean are counted as gaps (missed samples)
+static const double GAP_INTERVALS = 1.5;
+// Velocity for the lag fit: central difference over this many frames each side, so noise hardly matters
+static const size_t VELOCITY_SPAN = 8;
+// Frames turning slower than this (counts/frame) are left out of the lag fit
+static const double MIN_LAG_VELOCITY = 0.5;
+// A filtered angle further than this from the baseline's counts as a difference (the traces print 7 decimals)
+static const double MAX_BASELINE_DIFFERENCE_RAD = 1e-6;
+
+struct ReplayRow {
+    SensorCaptureFrame frame;
+    MT6701Reading reading;
+    float angle;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s [-t trace] [-b baseline] capture\n", argv0);
+}
+
+static bool readCapture(const char* path, std::vector<SensorCaptureFrame>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "Can't open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    SensorCaptureFrame frame;
+    size_t read;
+    while ((read = fread(&frame, 1, sizeof(frame), f)) == sizeof(frame)) {
+        frames.push_back(frame);
+    }
+    fclose(f);
+    if (read != 0) {
+        fprintf(stderr, "Warning: ignoring %zu trailing bytes (a partial frame)\n", read);
+    }
+    return true;
+}
+
+// As MT6701Sensor::processFrame(): valid readings go through the filter, others only count as errors
+static std::vector<ReplayRow> replay(const std::vector<SensorCaptureFrame>& frames) {
+    std::vector<ReplayRow> rows;
+    rows.reserve(frames.size());
+    MT6701Filter filter;
+    int32_t last_count = MT6701::NO_COUNT;
+    for (const SensorCaptureFrame& frame : frames) {
+        MT6701Reading reading = MT6701::decode(frame.raw, last_count);
+        if (reading.valid()) {
+            filter.add(reading.count);
+            last_count = reading.count;
+        }
+        rows.push_back({frame, reading, filter.angle()});
+    }
+    return rows;
+}
+
+static bool writeTrace(const std::vector<ReplayRow>& rows, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+        fprintf(stderr, "Can't write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(f, "frame,time_micros,raw,crc_ok,count,field_status,loss_of_track,push,angle\n");
+    for (size_t i = 0; i < rows.size(); i++) {
+        const ReplayRow& row = rows[i];
+        // The difference is taken in uint32_t, so it stays correct across a wrap of the microsecond counter
+        int32_t time_micros = (int32_t)(row.frame.micros - rows[0].frame.micros);
+        fprintf(f, "%zu,%d,%06x,%d,%u,%u,%d,%d,%.7f\n",
+            i, time_micros, row.frame.raw & 0xFFFFFF, row.reading.valid(), row.reading.count,
+            (unsigned)row.reading.field_status, row.reading.loss_of_track, row.reading.push, row.angle);
+    }
+    fclose(f);
+    return true;
+}
+
+// Filtered angles of a trace written by writeTrace()
+static bool readTraceAngles(const char* path, std::vector<double>& angles) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "Can't open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[256];
+    if (fgets(line, sizeof(line), f) == nullptr) {
+        fclose(f);
+        return true;
+    }
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        const char* last = strrchr(line, ',');
+        if (last != nullptr) {
+            angles.push_back(atof(last + 1));
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Continues a sequence of angles in counts across the wrap, from the previous unwrapped value
+static double unwrap(double counts, double previous) {
+    double step = remainder(counts - previous, MT6701::COUNTS_PER_TURN);
+    return previous + step;
+}
+
+// White noise estimate: the second difference of white noise of standard deviation s has variance 6 s^2
+static double secondDifferenceNoise(const std::vector<double>& values) {
+    if (values.size() < 3) {
+        return 0;
+    }
+    double sum = 0;
+    for (size_t i = 2; i < values.size(); i++) {
+        double d2 = values[i] - 2 * values[i - 1] + values[i - 2];
+        sum += d2 * d2;
+    }
+    return sqrt(sum / (values.size() - 2) / 6);
+}
+
+static void printSampling(const std::vector<ReplayRow>& rows) {
+    size_t intervals = rows.size() - 1;
+    double sum = 0, sum_squares = 0;
+    uint32_t min_interval = UINT32_MAX, max_interval = 0;
+    for (size_t i = 1; i < rows.size(); i++) {
+        uint32_t interval = rows[i].frame.micros - rows[i - 1].frame.micros;
+        sum += interval;
+        sum_squares += (double)interval * interval;
+        min_interval = interval < min_interval ? interval : min_interval;
+        max_interval = interval > max_interval ? interval : max_interval;
+    }
+    double mean = sum / intervals;
+    double jitter = sqrt(fmax(0, sum_squares / intervals - mean * mean));
+    size_t gaps = 0;
+    for (size_t i = 1; i < rows.size(); i++) {
+        if (rows[i].frame.micros - rows[i - 1].frame.micros > GAP_INTERVALS * mean) {
+            gaps++;
+        }
+    }
+    printf("sampling:  %.1f Hz over %.3f s; interval %.1f us (jitter %.1f, min %u, max %u), %zu gaps\n",
+        1e6 / mean, sum / 1e6, mean, jitter, min_interval, max_interval, gaps);
+}
+
+static void printStatus(const std::vector<ReplayRow>& rows) {
+    size_t crc_errors = 0, stuck = 0, too_strong = 0, too_weak = 0, loss_of_track = 0;
+    for (const ReplayRow& row : rows) {
+        if (!row.reading.valid()) {
+            stuck += row.reading.stuck;
+            crc_errors += !row.reading.stuck;
+            continue;
+        }
+        too_strong += row.reading.field_status == MT6701FieldStatus::TOO_STRONG;
+        too_weak += row.reading.field_status == MT6701FieldStatus::TOO_WEAK;
+        loss_of_track += row.reading.loss_of_track;
+    }
+    printf("status:    %zu CRC errors (%.3f%%), %zu stuck frames; of the valid frames, field too strong %zu, too weak %zu, loss of track %zu\n",
+        crc_errors, 100.0 * crc_errors / rows.size(), stuck, too_strong, too_weak, loss_of_track);
+}
+
+static void printFilter(const std::vector<ReplayRow>& rows, double mean_interval) {
+    // Raw and filtered angle of every valid frame (the filter only moves on those), unwrapped, in counts
+    // in the direction of the readings (the filter's angle runs opposite)
+    std::vector<double> raw, filtered;
+    for (const ReplayRow& row : rows) {
+        if (!row.reading.valid()) {
+            continue;
+        }
+        double filtered_counts = -row.angle / (2 * M_PI) * MT6701::COUNTS_PER_TURN;
+        if (raw.empty()) {
+            raw.push_back(row.reading.count);
+            filtered.push_back(unwrap(filtered_counts, row.reading.count));
+        } else {
+            raw.push_back(unwrap(row.reading.count, raw.back()));
+            filtered.push_back(unwrap(filtered_counts, filtered.back()));
+        }
+    }
+    printf("noise:     raw %.3f counts, filtered %.3f counts (second differences)\n",
+        secondDifferenceNoise(raw), secondDifferenceNoise(filtered));
+
+    // Lag L, in frames, minimizing sum((raw - filtered - L * velocity)^2) over the frames in motion
+    double error_velocity = 0, velocity_squares = 0;
+    size_t moving = 0;
+    for (size_t i = VELOCITY_SPAN; i + VELOCITY_SPAN < raw.size(); i++) {
+        double velocity = (raw[i + VELOCITY_SPAN] - raw[i - VELOCITY_SPAN]) / (2 * VELOCITY_SPAN);
+        if (fabs(velocity) < MIN_LAG_VELOCITY) {
+            continue;
+        }
+        error_velocity += (raw[i] - filtered[i]) * velocity;
+        velocity_squares += velocity * velocity;
+        moving++;
+    }
+    if (moving == 0) {
+        printf("lag:       - (the knob didn't turn)\n");
+        return;
+    }
+    double lag = error_velocity / velocity_squares;
+    printf("lag:       %.2f frames, %.0f us (fit over %zu frames in motion)\n", lag, lag * mean_interval, moving);
+}
+
+static bool compareBaseline(const std::vector<ReplayRow>& rows, const char* path) {
+    std::vector<double> baseline;
+    if (!readTraceAngles(path, baseline)) {
+        return false;
+    }
+    if (baseline.size() != rows.size()) {
+        printf("baseline:  %zu rows, but the replay has %zu; not the same capture?\n", baseline.size(), rows.size());
+        return false;
+    }
+    double max_difference = 0, sum_squares = 0;
+    size_t differing = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        double difference = fabs(remainder(rows[i].angle - baseline[i], 2 * M_PI));
+        max_difference = fmax(max_difference, difference);
+        sum_squares += difference * difference;
+        differing += difference > MAX_BASELINE_DIFFERENCE_RAD;
+    }
+    const double counts_per_rad = MT6701::COUNTS_PER_TURN / (2 * M_PI);
+    printf("baseline:  %zu of %zu filtered angles differ; max %.3f counts, rms %.3f counts\n",
+        differing, rows.size(), max_difference * counts_per_rad, sqrt(sum_squares / rows.size()) * counts_per_rad);
+    return differing == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* trace_path = nullptr;
+    const char* baseline_path = nullptr;
+    const char* capture_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-t") == 0 && has_value) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (argv[i][0] == '-' || capture_path != nullptr) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            capture_path = argv[i];
+        }
+    }
+    if (capture_path == nullptr) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<SensorCaptureFrame> frames;
+    if (!readCapture(capture_path, frames)) {
+        return 1;
+    }
+    if (frames.size() < 2) {
+        fprintf(stderr, "%zu frames in %s; nothing to replay\n", frames.size(), capture_path);
+        return 1;
+    }
+
+    std::vector<ReplayRow> rows = replay(frames);
+    printf("%zu frames\n", rows.size());
+    printSampling(rows);
+    printStatus(rows);
+    double mean_interval = (double)(uint32_t)(rows.back().frame.micros - rows.front().frame.micros) / (rows.size() - 1);
+    printFilter(rows, mean_interval);
+
+    if (trace_path != nullptr && !writeTrace(rows, trace_path)) {
+        return 1;
+    }
+    if (baseline_path != nullptr && !compareBaseline(rows, baseline_path)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * Stress test of the motor loop telemetry ring (firmware/src/telemetry_buffer.h) on the host: a producer
+ * thread records a frame per loop iteration, as the motor task does, while the consumer arms one capture
+ * after the other and drains it, as the serial protocol does.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -pthread -Ifirmware/src software/tools/telemetry_buffer_stress.cpp -o telemetry_buffer_stress
+ *
+ * Usage:
+ *   telemetry_buffer_stress [captures]
+ *
+ * Captures cycle through the triggers, with random lengths, pre-trigger history and decimation; some are
+ * cancelled midway, and some are drained slowly so that the ring fills up. Every field of a frame is derived
+ * from its iteration number, so torn or misplaced frames show. Checks that:
+ *  - frames arrive in order, intact, and with consecutive indices within the capture
+ *  - each capture holds exactly one trigger frame, which meets its trigger, after at most pre_trigger frames
+ *  - consecutive frames are decimation iterations apart, unless flagged as following a gap
+ *  - every frame of a capture is either read or counted as dropped
+ * Exits with 1 if any of these fails.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "telemetry_buffer.h"
+
+// The producer notifies a config change every CONFIG_PERIOD iterations and spins fast every VELOCITY_PERIOD
+static const uint32_t CONFIG_PERIOD = 37;
+static const uint32_t VELOCITY_PERIOD = 1000;
+static const float VELOCITY_THRESHOLD = 10;
+// Frames per read, as a TelemetryChunk
+static const uint16_t CHUNK_FRAMES = 8;
+
+static TelemetryFrame makeFrame(uint32_t iteration) {
+    TelemetryFrame frame = {};
+    frame.timestamp_micros = iteration;
+    frame.angle = iteration * 0.5f;
+    frame.velocity = iteration % VELOCITY_PERIOD == 0 ? 50 : 0;
+    frame.target = -(float)(iteration % 4096);
+    frame.torque = -(float)iteration;
+    frame.position = (int32_t)iteration;
+    frame.loop_micros = (uint16_t)iteration;
+    frame.flags = TelemetryFrame::HAPTIC;
+    return frame;
+}
+
+static bool intact(const TelemetryFrame& frame) {
+    TelemetryFrame expected = makeFrame(frame.timestamp_micros);
+    return frame.angle == expected.angle && frame.velocity == expected.velocity && frame.target == expected.target
+        && frame.torque == expected.torque && frame.position == expected.position && frame.loop_micros == expected.loop_micros
+        && (frame.flags & TelemetryFrame::HAPTIC) != 0;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t captures = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500;
+
+    static TelemetryBuffer buffer;
+    std::atomic<bool> producing = true;
+    std::thread producer([&] {
+        uint32_t iteration = 0;
+        while (producing.load(std::memory_order_relaxed)) {
+            if (iteration % CONFIG_PERIOD == 0) {
+                buffer.notifyConfigChange();
+            }
+            if (buffer.active()) {
+                buffer.record(makeFrame(iteration));
+            }
+            iteration++;
+            if (iteration % 64 == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::mt19937 rng(1);
+    bool ok = true;
+    uint64_t frames_read = 0, frames_dropped = 0;
+    uint32_t cancelled = 0, with_gaps = 0;
+    for (uint32_t n = 0; n < captures; n++) {
+        TelemetryCapture capture = {
+            .trigger = (TelemetryTrigger)(n % 3),
+            .frames = (uint32_t)(1 + rng() % 3000),
+            .pre_trigger = (uint16_t)(rng() % 600),
+            .decimation = (uint16_t)(rng() % 4),
+            .velocity_threshold = VELOCITY_THRESHOLD,
+        };
+        const uint32_t decimation = capture.decimation > 1 ? capture.decimation : 1;
+        while (!buffer.arm(capture)) {
+            std::this_thread::yield();
+        }
+        const bool cancel = n % 11 == 0;
+        const bool slow = n % 3 == 0;
+
+        std::vector<TelemetryFrame> frames;
+        uint32_t next_index = 0, dropped = 0;
+        uint8_t chunk[CHUNK_FRAMES * sizeof(TelemetryFrame)];
+        while (true) {
+            uint32_t first;
+            uint16_t count = buffer.read(chunk, CHUNK_FRAMES, first);
+            if (count > 0) {
+                if (first != next_index) {
+                    fprintf(stderr, "capture %u: frame %u read after %u\n", n, first, next_index);
+                    ok = false;
+                }
+                next_index = first + count;
+                for (uint16_t i = 0; i < count; i++) {
+                    TelemetryFrame frame;
+                    memcpy(&frame, chunk + i * sizeof(TelemetryFrame), sizeof(frame));
+                    frames.push_back(frame);
+                }
+            }
+            if (cancel && frames.size() > 5) {
+                buffer.cancel();
+            }
+            if (count < CHUNK_FRAMES && buffer.finish(dropped)) {
+                break;
+            }
+            if (slow) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        int32_t trigger = -1;
+        bool gap = false;
+        for (size_t i = 0; i < frames.size(); i++) {
+            const TelemetryFrame& frame = frames[i];
+            if (!intact(frame)) {
+                fprintf(stderr, "capture %u: frame %zu torn\n", n, i);
+                ok = false;
+            }
+            if (frame.flags & TelemetryFrame::TRIGGER) {
+                if (trigger >= 0) {
+                    fprintf(stderr, "capture %u: second trigger at frame %zu\n", n, i);
+                    ok = false;
+                }
+                trigger = i;
+            }
+            gap |= (frame.flags & TelemetryFrame::GAP) != 0;
+            uint32_t step = i > 0 ? frame.timestamp_micros - frames[i - 1].timestamp_micros : decimation;
+            if ((int32_t)step <= 0 || (step != decimation && !(frame.flags & TelemetryFrame::GAP))) {
+                fprintf(stderr, "capture %u: frame %zu %u iterations after the previous one, decimation %u\n", n, i, step, decimation);
+                ok = false;
+            }
+        }
+        cancelled += cancel;
+        with_gaps += gap;
+        frames_read += frames.size();
+        frames_dropped += dropped;
+        if (cancel) {
+            continue;
+        }
+
+        bool triggered = false;
+        if (trigger >= 0) {
+            const TelemetryFrame& frame = frames[trigger];
+            switch (capture.trigger) {
+                case TelemetryTrigger::IMMEDIATE:
+                    triggered = trigger == 0;
+                    break;
+                case TelemetryTrigger::CONFIG_CHANGE:
+                    // A change noticed on a skipped iteration triggers the next recorded one
+                    triggered = frame.timestamp_micros % CONFIG_PERIOD < decimation;
+                    break;
+                case TelemetryTrigger::VELOCITY:
+                    triggered = frame.velocity >= VELOCITY_THRESHOLD;
+                    break;
+            }
+        }
+        if (!triggered || (uint32_t)trigger > capture.pre_trigger || frames.size() + dropped != capture.frames + trigger) {
+            fprintf(stderr, "capture %u: trigger %u at frame %d of %zu read, %u dropped, for %u frames and %u before\n", n,
+                (uint8_t)capture.trigger, trigger, frames.size(), dropped, capture.frames, capture.pre_trigger);
+            ok = false;
+        }
+    }
+    producing = false;
+    producer.join();
+
+    printf("%u captures (%u cancelled, %u with gaps): %llu frames read, %llu dropped\n", captures, cancelled, with_gaps,
+        (unsigned long long)frames_read, (unsigned long long)frames_dropped);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+/**
+ * Decodes a motor loop telemetry capture (raw TelemetryFrames, as written by
+ * software/python/telemetry_capture.py) into CSV or columnar files, using the frame layout from the
+ * firmware (firmware/src/telemetry_buffer.h).
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/telemetry_decode.cpp -o telemetry_decode
+ *
+ * Usage:
+ *   telemetry_decode [-c <directory>] <capture file>
+ *   telemetry_decode --self-check
+ *
+ * Options:
+ *   -c <directory>  write one file per column instead of CSV: <name>.<type> holding the raw
+ *                   little-endian values (f32, i32, u32 or u8; e.g. numpy.fromfile(path, '<f4')),
+ *                   plus columns.csv listing the name, type and row count of each
+ *   --self-check    decode a synthetic capture (trigger across a wrap of micros(), dropped frames, a
+ *                   partial frame at the end) through both outputs and check them; exits with 1 on failure
+ *
+ * Without -c, CSV is written to stdout, one row per frame. Times are relative to the frame the
+ * capture was triggered by; velocity is in rad/s, angles in radians, torque in motor torque units.
+ */
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "telemetry_buffer.h"
+
+#include "tool_check.h"
+
+struct Column {
+    const char* name;
+    const char* type;
+    size_t size;
+    // Appends the column's value of a frame, in the column type's little-endian representation
+    void (*append)(const TelemetryFrame& frame, int32_t relative_micros, std::vector<uint8_t>& out);
+};
+
+template <typename T>
+static void appendValue(T value, std::vector<uint8_t>& out) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static const Column COLUMNS[] = {
+    {"time_micros", "i32", 4, [](const TelemetryFrame&, int32_t t, std::vector<uint8_t>& out) { appendValue<int32_t>(t, out); }},
+    {"angle", "f32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<float>(f.angle, out); }},
+    {"velocity", "f32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<float>(f.velocity, out); }},
+    {"target", "f32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<float>(f.target, out); }},
+    {"torque", "f32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<float>(f.torque, out); }},
+    {"position", "i32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<int32_t>(f.position, out); }},
+    {"loop_micros", "u32", 4, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<uint32_t>(f.loop_micros, out); }},
+    {"flags", "u8", 1, [](const TelemetryFrame& f, int32_t, std::vector<uint8_t>& out) { appendValue<uint8_t>(f.flags, out); }},
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s [-c directory] capture\n       %s --self-check\n", argv0, argv0);
+}
+
+static bool readCapture(const char* path, std::vector<TelemetryFrame>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "Can't open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    TelemetryFrame frame;
+    size_t read;
+    while ((read = fread(&frame, 1, sizeof(frame), f)) == sizeof(frame)) {
+        frames.push_back(frame);
+    }
+    fclose(f);
+    if (read != 0) {
+        fprintf(stderr, "Warning: ignoring %zu trailing bytes (a partial frame; was the capture written with a different frame layout?)\n", read);
+    }
+    return true;
+}
+
+static int32_t triggerMicros(const std::vector<TelemetryFrame>& frames) {
+    for (const TelemetryFrame& frame : frames) {
+        if (frame.flags & TelemetryFrame::TRIGGER) {
+            return frame.timestamp_micros;
+        }
+    }
+    return frames.empty() ? 0 : frames[0].timestamp_micros;
+}
+
+static void writeCsv(const std::vector<TelemetryFrame>& frames, FILE* out) {
+    uint32_t trigger_micros = triggerMicros(frames);
+    fprintf(out, "frame,time_micros,angle,velocity,target,torque,position,loop_micros,haptic,trigger,gap,calibrating\n");
+    for (size_t i = 0; i < frames.size(); i++) {
+        const TelemetryFrame& f = frames[i];
+        // The difference is taken in uint32_t, so it stays correct across a wrap of the microsecond counter
+        int32_t time_micros = (int32_t)(f.timestamp_micros - trigger_micros);
+        fprintf(out, "%zu,%d,%.6f,%.4f,%.6f,%.5f,%d,%u,%d,%d,%d,%d\n",
+            i, time_micros, f.angle, f.velocity, f.target, f.torque, f.position, f.loop_micros,
+            (f.flags & TelemetryFrame::HAPTIC) != 0,
+            (f.flags & TelemetryFrame::TRIGGER) != 0,
+            (f.flags & TelemetryFrame::GAP) != 0,
+            (f.flags & TelemetryFrame::CALIBRATING) != 0);
+    }
+}
+
+static bool writeColumns(const std::vector<TelemetryFrame>& frames, const std::string& directory) {
+    uint32_t trigger_micros = triggerMicros(frames);
+    std::string schema_path = directory + "/columns.csv";
+    FILE* schema = fopen(schema_path.c_str(), "w");
+    if (schema == nullptr) {
+        fprintf(stderr, "Can't write %s: %s\n", schema_path.c_str(), strerror(errno));
+        return false;
+    }
+    fprintf(schema, "name,type,rows\n");
+
+    std::vector<uint8_t> values;
+    for (const Column& column : COLUMNS) {
+        values.clear();
+        values.reserve(frames.size() * column.size);
+        for (const TelemetryFrame& frame : frames) {
+            column.append(frame, (int32_t)(frame.timestamp_micros - trigger_micros), values);
+        }
+
+        std::string path = directory + "/" + column.name + "." + column.type;
+        FILE* f = fopen(path.c_str(), "wb");
+        if (f == nullptr || fwrite(values.data(), 1, values.size(), f) != values.size()) {
+            fprintf(stderr, "Can't write %s: %s\n", path.c_str(), strerror(errno));
+            if (f != nullptr) {
+                fclose(f);
+            }
+            fclose(schema);
+            return false;
+        }
+        fclose(f);
+        fprintf(schema, "%s,%s,%zu\n", column.name, column.type, frames.size());
+    }
+    fclose(schema);
+    return true;
+}
+
+template <typename T>
+static std::vector<T> readValues(const std::string& path) {
+    std::vector<T> values;
+    FILE* f = fopen(path.c_str(), "rb");
+    T value;
+    while (f != nullptr && fread(&value, sizeof(T), 1, f) == 1) {
+        values.push_back(value);
+    }
+    if (f != nullptr) {
+        fclose(f);
+    }
+    return values;
+}
+
+static int selfCheck() {
+    // Triggered 16 us before micros() wraps, with frames dropped before the last one
+    const uint32_t times[] = {0xFFFFFE70u, 0xFFFFFF38u, 0xFFFFFFF0u, 0x000000B8u, 0x00000248u};
+    const uint8_t flags[] = {0, TelemetryFrame::HAPTIC, TelemetryFrame::HAPTIC | TelemetryFrame::TRIGGER,
+        TelemetryFrame::CALIBRATING, TelemetryFrame::HAPTIC | TelemetryFrame::GAP};
+    const int32_t expected_times[] = {-384, -184, 0, 200, 600};
+    const size_t count = sizeof(times) / sizeof(times[0]);
+    std::vector<TelemetryFrame> written;
+    for (size_t i = 0; i < count; i++) {
+        TelemetryFrame frame = {};
+        frame.timestamp_micros = times[i];
+        frame.angle = 0.25f * i - 0.5f;
+        frame.velocity = 10.5f * i;
+        frame.target = -0.125f * i;
+        frame.torque = 0.5f - 0.25f * i;
+        frame.position = (int32_t)i - 2;
+        frame.loop_micros = (uint16_t)(100 + i);
+        frame.flags = flags[i];
+        written.push_back(frame);
+    }
+
+    char directory[] = "/tmp/telemetry_decode.XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        fprintf(stderr, "Can't create a temporary directory: %s\n", strerror(errno));
+        return 1;
+    }
+    const std::string capture_path = std::string(directory) + "/capture.bin";
+    FILE* capture = fopen(capture_path.c_str(), "wb");
+    const uint8_t partial[5] = {};
+    bool ok = capture != nullptr && fwrite(written.data(), sizeof(TelemetryFrame), count, capture) == count
+        && fwrite(partial, 1, sizeof(partial), capture) == sizeof(partial);
+    if (capture != nullptr) {
+        fclose(capture);
+    }
+
+    std::vector<TelemetryFrame> frames;
+    ok &= check(readCapture(capture_path.c_str(), frames) && frames.size() == count
+        && memcmp(frames.data(), written.data(), count * sizeof(TelemetryFrame)) == 0,
+        "capture: every whole frame read back, the partial one ignored");
+
+    // CSV, parsed back
+    FILE* csv = tmpfile();
+    writeCsv(frames, csv);
+    rewind(csv);
+    char line[256];
+    bool header = fgets(line, sizeof(line), csv) != nullptr && strncmp(line, "frame,time_micros,", 18) == 0;
+    size_t rows = 0;
+    bool csv_match = true;
+    while (fgets(line, sizeof(line), csv) != nullptr) {
+        size_t frame;
+        int32_t time_micros, position;
+        float angle, velocity, target, torque;
+        unsigned loop_micros;
+        int haptic, trigger, gap, calibrating;
+        if (sscanf(line, "%zu,%d,%f,%f,%f,%f,%d,%u,%d,%d,%d,%d", &frame, &time_micros, &angle, &velocity, &target, &torque,
+                &position, &loop_micros, &haptic, &trigger, &gap, &calibrating) != 12 || frame != rows || frame >= count) {
+            csv_match = false;
+            break;
+        }
+        const TelemetryFrame& f = written[frame];
+        csv_match &= time_micros == expected_times[frame] && angle == f.angle && velocity == f.velocity && target == f.target
+            && torque == f.torque && position == f.position && loop_micros == f.loop_micros
+            && haptic == ((f.flags & TelemetryFrame::HAPTIC) != 0) && trigger == ((f.flags & TelemetryFrame::TRIGGER) != 0)
+            && gap == ((f.flags & TelemetryFrame::GAP) != 0) && calibrating == ((f.flags & TelemetryFrame::CALIBRATING) != 0);
+        rows++;
+    }
+    fclose(csv);
+    ok &= check(header && csv_match && rows == count, "CSV: times relative to the trigger across the wrap, values and flags");
+
+    // Columns, read back
+    bool columns_written = writeColumns(frames, directory);
+    std::vector<int32_t> column_times = readValues<int32_t>(std::string(directory) + "/time_micros.i32");
+    std::vector<float> column_angles = readValues<float>(std::string(directory) + "/angle.f32");
+    std::vector<uint32_t> column_loop_micros = readValues<uint32_t>(std::string(directory) + "/loop_micros.u32");
+    std::vector<uint8_t> column_flags = readValues<uint8_t>(std::string(directory) + "/flags.u8");
+    bool columns_match = column_times.size() == count && column_angles.size() == count
+        && column_loop_micros.size() == count && column_flags.size() == count;
+    for (size_t i = 0; columns_match && i < count; i++) {
+        columns_match = column_times[i] == expected_times[i] && column_angles[i] == written[i].angle
+            && column_loop_micros[i] == written[i].loop_micros && column_flags[i] == written[i].flags;
+    }
+    size_t schema_rows = 0;
+    FILE* schema = fopen((std::string(directory) + "/columns.csv").c_str(), "r");
+    while (schema != nullptr && fgets(line, sizeof(line), schema) != nullptr) {
+        char name[32], type[8];
+        size_t column_rows;
+        if (sscanf(line, "%31[^,],%7[^,],%zu", name, type, &column_rows) == 3) {
+            columns_match &= strcmp(name, COLUMNS[schema_rows].name) == 0 && strcmp(type, COLUMNS[schema_rows].type) == 0
+                && column_rows == count;
+            schema_rows++;
+        }
+    }
+    if (schema != nullptr) {
+        fclose(schema);
+    }
+    ok &= check(columns_written && columns_match && schema_rows == sizeof(COLUMNS) / sizeof(COLUMNS[0]),
+        "columns: raw values and columns.csv");
+
+    // No trigger: times are relative to the first frame
+    std::vector<TelemetryFrame> untriggered(frames.begin() + 3, frames.end());
+    ok &= check(triggerMicros(untriggered) == (int32_t)times[3], "no trigger: times relative to the first frame");
+
+    for (const Column& column : COLUMNS) {
+        unlink((std::string(directory) + "/" + column.name + "." + column.type).c_str());
+    }
+    unlink((std::string(directory) + "/columns.csv").c_str());
+    unlink(capture_path.c_str());
+    rmdir(directory);
+
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const char* column_directory = nullptr;
+    const char* capture_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--self-check") == 0 && argc == 2) {
+            return selfCheck();
+        } else if (strcmp(argv[i], "-c") == 0 && has_value) {
+            column_directory = argv[++i];
+        } else if (argv[i][0] == '-' || capture_path != nullptr) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            capture_path = argv[i];
+        }
+    }
+    if (capture_path == nullptr) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<TelemetryFrame> frames;
+    if (!readCapture(capture_path, frames)) {
+        return 1;
+    }
+
+    size_t gaps = 0;
+    for (const TelemetryFrame& frame : frames) {
+        if (frame.flags & TelemetryFrame::GAP) {
+            gaps++;
+        }
+    }
+    fprintf(stderr, "%zu frames", frames.size());
+    if (gaps > 0) {
+        fprintf(stderr, ", frames were dropped before %zu of them (the host didn't keep up)", gaps);
+    }
+    fprintf(stderr, "\n");
+
+    if (column_directory != nullptr) {
+        return writeColumns(frames, column_directory) ? 0 : 1;
+    }
+    writeCsv(frames, stdout);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/**
+ * Helpers shared by the host tools in software/tools: the check line they print, and the cycle counter
+ * the benchmarks time with.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+// Prints a check line, what followed by ok or FAIL, and returns pass
+inline bool check(bool pass, const char* what) {
+    printf("%-80s %s\n", what, pass ? "ok" : "FAIL");
+    return pass;
+}
+
+// CPU cycles where the host has a cycle counter (x86 TSC), otherwise nanoseconds. Host cycles only compare
+// implementations with each other; they say little about the ESP32's.
+#if defined(__x86_64__) || defined(__i386__)
+static const char* const CYCLE_UNIT = "cycles";
+inline uint64_t cycles() { return __rdtsc(); }
+#else
+static const char* const CYCLE_UNIT = "ns";
+inline uint64_t cycles() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// Cycles per call of f(i), for i from 0 to calls - 1; f returns a float, summed so the calls aren't optimized away
+template <typename F>
+double cyclesPerCall(uint32_t calls, F f) {
+    float sum = 0;
+    uint64_t start = cycles();
+    for (uint32_t i = 0; i < calls; i++) {
+        sum += f(i);
+    }
+    uint64_t end = cycles();
+    if (sum == 12345.678f) {
+        printf("\n");
+    }
+    return (double)(end - start) / calls;
+}
@@ -0,0 +1,115 @@
+/**
+ * Renders the detent torque curve of a SmartKnobConfig.detent_torque_profile as CSV, using the
+ * same interpolation code as the firmware (firmware/src/haptics/torque_profile.cpp).
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Ifirmware/src software/tools/torque_profile_render.cpp \
+ *       firmware/src/haptics/torque_profile.cpp -o torque_profile_render
+ *
+ * Usage:
+ *   torque_profile_render [options] [sample ...]
+ *
+ * Options:
+ *   -s <strength>   detent_strength_unit the samples are scaled by (default 1)
+ *   -p <preset>     use a built-in profile instead of samples: sine, sawtooth, notch, ramp
+ *   -n <count>      number of samples for presets (default 32)
+ *   -r <positions>  render range, in positions around the detent center (default 1.5)
+ *   -d <steps>      output points per position (default 100)
+ *
+ * Output is "sub_position_unit,torque" per line on stdout; the samples in use are printed to
+ * stderr in proto text format, so a preset can be pasted into a config.
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "haptics/torque_profile.h"
+
+static bool preset(const char* name, int count, std::vector<float>& samples) {
+    samples.clear();
+    for (int i = 0; i < count; i++) {
+        float x = -0.5f + (float)i / count;
+        float value;
+        if (strcmp(name, "sine") == 0) {
+            // Smooth restoring torque towards the detent center
+            value = -sinf(2 * M_PI * x);
+        } else if (strcmp(name, "sawtooth") == 0) {
+            // Linear restoring torque that flips abruptly halfway between detents
+            value = -2 * x;
+        } else if (strcmp(name, "notch") == 0) {
+            // Free rotation with a short, strong notch around the detent center
+            value = fabsf(x) < 0.15f ? -sinf(M_PI * x / 0.15f) : 0;
+        } else if (strcmp(name, "ramp") == 0) {
+            // Asymmetric: easy to turn towards higher positions, hard towards lower ones
+            value = x < 0 ? 0.3f : -1.5f * x;
+        } else {
+            return false;
+        }
+        samples.push_back(value);
+    }
+    return true;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s [-s strength] [-p sine|sawtooth|notch|ramp] [-n count] [-r positions] [-d steps] [sample ...]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    float strength = 1;
+    const char* preset_name = nullptr;
+    int preset_count = TorqueProfile::MAX_SAMPLES;
+    float range = 1.5;
+    int steps_per_position = 100;
+    std::vector<float> samples;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-s") == 0 && has_value) {
+            strength = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && has_value) {
+            preset_name = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && has_value) {
+            preset_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && has_value) {
+            range = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && has_value) {
+            steps_per_position = atoi(argv[++i]);
+        } else if (argv[i][0] == '-' && (argv[i][1] < '0' || argv[i][1] > '9') && argv[i][1] != '.') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            samples.push_back(atof(argv[i]));
+        }
+    }
+
+    if (preset_name != nullptr) {
+        if (preset_count < 1 || preset_count > TorqueProfile::MAX_SAMPLES || !preset(preset_name, preset_count, samples)) {
+            fprintf(stderr, "Unknown preset or bad sample count (1-%u)\n", TorqueProfile::MAX_SAMPLES);
+            return 1;
+        }
+    }
+    if (samples.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (samples.size() > TorqueProfile::MAX_SAMPLES) {
+        fprintf(stderr, "Warning: %zu samples given, the firmware only uses the first %u\n", samples.size(), TorqueProfile::MAX_SAMPLES);
+    }
+
+    TorqueProfile profile;
+    profile.set(samples.data(), samples.size(), strength);
+
+    for (uint8_t i = 0; i < profile.count(); i++) {
+        fprintf(stderr, "detent_torque_profile: %g\n", samples[i]);
+    }
+
+    printf("sub_position_unit,torque\n");
+    int steps = (int)(range * steps_per_position);
+    for (int i = -steps; i <= steps; i++) {
+        float sub_position_unit = (float)i / steps_per_position;
+        printf("%.4f,%.6f\n", sub_position_unit, profile(sub_position_unit));
+    }
+    return 0;
+}